@@ -0,0 +1,110 @@
+"""
+Request throughput of the risk engine from concurrent Python threads.
+
+Each thread repeatedly handles a risk request: either the full wrapper path (pydantic models,
+list conversion, native simulation, result unpacking) or run_simulation on one engine shared by
+all threads. Native simulation releases the GIL either way; the Python work around it only runs
+in parallel on a free-threaded interpreter. Run once under each build and compare:
+
+    python3.13  benchmarks/bench_threaded_throughput.py
+    python3.13t benchmarks/bench_threaded_throughput.py
+
+OpenMP is pinned to one thread per call so the request threads are the only parallelism.
+Output is CSV on stdout.
+
+Usage: bench_threaded_throughput.py [assets=20] [simulations=2000] [seconds=2] [max_threads=cpu count]
+"""
+
+import os
+
+os.environ.setdefault("OMP_NUM_THREADS", "1")
+
+import sys
+import threading
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "python"))
+
+import risk_engine_cpp
+from risk_wrapper import PortfolioAsset, RiskEngineWrapper
+
+
+def make_portfolio(n):
+    assets = [
+        PortfolioAsset(
+            asset_name=f"A{i}",
+            weight=1.0 / n,
+            expected_return=0.04 + 0.08 * i / n,
+            volatility=0.15 + 0.20 * i / n,
+        )
+        for i in range(n)
+    ]
+    correlation = [[1.0 if i == j else 0.4 for j in range(n)] for i in range(n)]
+    return assets, correlation
+
+
+def to_cpp_asset(asset):
+    cpp_asset = risk_engine_cpp.PortfolioAsset()
+    cpp_asset.asset_name = asset.asset_name
+    cpp_asset.weight = asset.weight
+    cpp_asset.expected_return = asset.expected_return
+    cpp_asset.volatility = asset.volatility
+    return cpp_asset
+
+
+def measure(handle_request, num_threads, seconds):
+    """Requests per second completed by num_threads threads over the time window"""
+    counts = [0] * num_threads
+    start = threading.Barrier(num_threads + 1)
+    stop = threading.Event()
+
+    def worker(k):
+        start.wait()
+        while not stop.is_set():
+            handle_request()
+            counts[k] += 1
+
+    threads = [threading.Thread(target=worker, args=(k,)) for k in range(num_threads)]
+    for thread in threads:
+        thread.start()
+    start.wait()
+    began = time.perf_counter()
+    time.sleep(seconds)
+    stop.set()
+    for thread in threads:
+        thread.join()
+    return sum(counts) / (time.perf_counter() - began)
+
+
+def main():
+    assets_count = int(sys.argv[1]) if len(sys.argv) > 1 else 20
+    simulations = int(sys.argv[2]) if len(sys.argv) > 2 else 2000
+    seconds = float(sys.argv[3]) if len(sys.argv) > 3 else 2.0
+    max_threads = int(sys.argv[4]) if len(sys.argv) > 4 else (os.cpu_count() or 1)
+
+    assets, correlation = make_portfolio(assets_count)
+    wrapper = RiskEngineWrapper(num_simulations=simulations, time_horizon_days=1)
+    engine = risk_engine_cpp.MonteCarloRiskEngine(
+        [to_cpp_asset(a) for a in assets], correlation, simulations, 1.0 / 252.0)
+
+    workloads = {
+        "wrapper": lambda: wrapper.calculate_risk_metrics(assets, correlation),
+        "shared_engine": engine.run_simulation,
+    }
+
+    gil_enabled = sys._is_gil_enabled() if hasattr(sys, "_is_gil_enabled") else True
+    print(f"# python={sys.version.split()[0]} gil={'enabled' if gil_enabled else 'disabled'} "
+          f"assets={assets_count} simulations={simulations} seconds={seconds}")
+    print("workload,threads,requests_per_second,speedup")
+    thread_counts = sorted({1, 2, 4, 8, 16, max_threads} & set(range(1, max_threads + 1)))
+    for name, handle_request in workloads.items():
+        handle_request()  # warm up
+        baseline = None
+        for num_threads in thread_counts:
+            rate = measure(handle_request, num_threads, seconds)
+            baseline = baseline or rate
+            print(f"{name},{num_threads},{rate:.1f},{rate / baseline:.2f}", flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,11 +1,39 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/numpy.h>
+#include <pybind11/functional.h>
 #include "montecarlo.h"
+#include "optimizer.h"
+#include "rebalance.h"
+#include "streaming.h"
+#include "realized_covariance.h"
+#include "linalg.h"
+#include "validation.h"
+#include "lifecycle.h"
+#include "factor_cache.h"
+#include "snapshot.h"
+#include "huge_pages.h"
+#include "position_store.h"
+#include "performance.h"
+#include "sentiment.h"
 
 namespace py = pybind11;
 
+// Joining the service threads may wait on a subscriber callback that needs the GIL
+struct StreamingServiceDeleter {
+    void operator()(StreamingRiskService* service) const {
+        py::gil_scoped_release release;
+        delete service;
+    }
+};
+
+// Engine runs and queries only read shared state and the mutating methods lock, so the module is
+// declared safe for free-threaded interpreters (PEP 703) instead of re-enabling the GIL on import
+#if PYBIND11_VERSION_HEX >= 0x020D0000
+PYBIND11_MODULE(risk_engine_cpp, m, py::mod_gil_not_used()) {
+#else
 PYBIND11_MODULE(risk_engine_cpp, m) {
+#endif
     m.doc() = "Monte Carlo Risk Engine with VaR and CVaR calculations";
 
     // Bind PortfolioAsset struct
@@ -31,7 +59,26 @@ PYBIND11_MODULE(risk_engine_cpp, m) {
         .def_readwrite("cvar_99", &RiskMetrics::cvar_99)
         .def_readwrite("expected_return", &RiskMetrics::expected_return)
         .def_readwrite("portfolio_vol", &RiskMetrics::portfolio_vol)
+        .def_readwrite("tracking_error", &RiskMetrics::tracking_error)
+        .def_readwrite("active_var_95", &RiskMetrics::active_var_95)
+        .def_readwrite("active_var_99", &RiskMetrics::active_var_99)
+        .def_readwrite("analytic_active_var_95", &RiskMetrics::analytic_active_var_95)
+        .def_readwrite("analytic_active_var_99", &RiskMetrics::analytic_active_var_99)
+        .def_readwrite("pca_factors", &RiskMetrics::pca_factors)
+        .def_readwrite("pca_retained_variance", &RiskMetrics::pca_retained_variance)
+        .def_readwrite("pca_truncation_error", &RiskMetrics::pca_truncation_error)
+        .def_readwrite("var_95_std_error", &RiskMetrics::var_95_std_error)
+        .def_readwrite("var_99_std_error", &RiskMetrics::var_99_std_error)
+        .def_readwrite("cvar_95_std_error", &RiskMetrics::cvar_95_std_error)
+        .def_readwrite("cvar_99_std_error", &RiskMetrics::cvar_99_std_error)
+        .def_readwrite("liquidity_var_95", &RiskMetrics::liquidity_var_95)
+        .def_readwrite("liquidity_var_99", &RiskMetrics::liquidity_var_99)
+        .def_readwrite("liquidity_cvar_95", &RiskMetrics::liquidity_cvar_95)
+        .def_readwrite("liquidity_cvar_99", &RiskMetrics::liquidity_cvar_99)
+        .def_readwrite("liquidation_cost", &RiskMetrics::liquidation_cost)
+        .def_readwrite("liquidation_days", &RiskMetrics::liquidation_days)
         .def_readwrite("simulation_results", &RiskMetrics::simulation_results)
+        .def_readwrite("scenario_weights", &RiskMetrics::scenario_weights)
         .def("__repr__", [](const RiskMetrics &r) {
             return "<RiskMetrics VaR95=" + std::to_string(r.var_95) + 
                    " VaR99=" + std::to_string(r.var_99) +
@@ -39,6 +86,321 @@ PYBIND11_MODULE(risk_engine_cpp, m) {
                    " CVaR99=" + std::to_string(r.cvar_99) + ">";
         });
 
+    py::class_<LiquidityProfile>(m, "LiquidityProfile")
+        .def(py::init<>())
+        .def_readwrite("average_daily_volume", &LiquidityProfile::average_daily_volume)
+        .def_readwrite("portfolio_value", &LiquidityProfile::portfolio_value)
+        .def_readwrite("participation_rate", &LiquidityProfile::participation_rate)
+        .def_readwrite("impact_coefficient", &LiquidityProfile::impact_coefficient)
+        .def_readwrite("trading_days_per_year", &LiquidityProfile::trading_days_per_year);
+
+    // Bind scenario sampling controls
+    py::enum_<ScenarioRng>(m, "ScenarioRng")
+        .value("MERSENNE_TWISTER", ScenarioRng::MERSENNE_TWISTER)
+        .value("PHILOX", ScenarioRng::PHILOX);
+
+    py::class_<ScenarioSamplingSettings>(m, "ScenarioSamplingSettings")
+        .def(py::init<>())
+        .def_readwrite("rng", &ScenarioSamplingSettings::rng)
+        .def_readwrite("seed", &ScenarioSamplingSettings::seed)
+        .def_readwrite("num_strata", &ScenarioSamplingSettings::num_strata)
+        .def_readwrite("tail_fraction", &ScenarioSamplingSettings::tail_fraction)
+        .def_readwrite("tail_allocation", &ScenarioSamplingSettings::tail_allocation)
+        .def_readwrite("standard_errors", &ScenarioSamplingSettings::standard_errors);
+
+    // Bind multi-step path simulation
+    py::enum_<PathSampler>(m, "PathSampler")
+        .value("PSEUDO_RANDOM", PathSampler::PSEUDO_RANDOM)
+        .value("SOBOL", PathSampler::SOBOL);
+
+    py::class_<PathSimulationSettings>(m, "PathSimulationSettings")
+        .def(py::init<>())
+        .def_readwrite("num_paths", &PathSimulationSettings::num_paths)
+        .def_readwrite("num_steps", &PathSimulationSettings::num_steps)
+        .def_readwrite("horizon", &PathSimulationSettings::horizon)
+        .def_readwrite("sampler", &PathSimulationSettings::sampler)
+        .def_readwrite("brownian_bridge", &PathSimulationSettings::brownian_bridge)
+        .def_readwrite("seed", &PathSimulationSettings::seed);
+
+    py::class_<PathRiskMetrics>(m, "PathRiskMetrics")
+        .def(py::init<>())
+        .def_readwrite("expected_return", &PathRiskMetrics::expected_return)
+        .def_readwrite("var_95", &PathRiskMetrics::var_95)
+        .def_readwrite("cvar_95", &PathRiskMetrics::cvar_95)
+        .def_readwrite("expected_max_drawdown", &PathRiskMetrics::expected_max_drawdown)
+        .def_readwrite("max_drawdown_95", &PathRiskMetrics::max_drawdown_95)
+        .def_readwrite("probability_of_loss", &PathRiskMetrics::probability_of_loss)
+        .def_readwrite("path_returns", &PathRiskMetrics::path_returns)
+        .def_readwrite("max_drawdowns", &PathRiskMetrics::max_drawdowns)
+        .def_readwrite("regime_occupancy", &PathRiskMetrics::regime_occupancy)
+        .def("__repr__", [](const PathRiskMetrics &r) {
+            return "<PathRiskMetrics VaR95=" + std::to_string(r.var_95) +
+                   " E[MaxDD]=" + std::to_string(r.expected_max_drawdown) + ">";
+        });
+
+    // Bind multilevel Monte Carlo
+    py::enum_<PathMetric>(m, "PathMetric")
+        .value("MAX_DRAWDOWN", PathMetric::MAX_DRAWDOWN)
+        .value("TERMINAL_WEALTH", PathMetric::TERMINAL_WEALTH)
+        .value("SHORTFALL", PathMetric::SHORTFALL);
+
+    py::class_<MultilevelSettings>(m, "MultilevelSettings")
+        .def(py::init<>())
+        .def_readwrite("target_rmse", &MultilevelSettings::target_rmse)
+        .def_readwrite("base_steps", &MultilevelSettings::base_steps)
+        .def_readwrite("refinement", &MultilevelSettings::refinement)
+        .def_readwrite("min_levels", &MultilevelSettings::min_levels)
+        .def_readwrite("max_levels", &MultilevelSettings::max_levels)
+        .def_readwrite("pilot_samples", &MultilevelSettings::pilot_samples)
+        .def_readwrite("seed", &MultilevelSettings::seed);
+
+    py::class_<MultilevelResult>(m, "MultilevelResult")
+        .def(py::init<>())
+        .def_readwrite("estimate", &MultilevelResult::estimate)
+        .def_readwrite("standard_error", &MultilevelResult::standard_error)
+        .def_readwrite("bias_estimate", &MultilevelResult::bias_estimate)
+        .def_readwrite("converged", &MultilevelResult::converged)
+        .def_readwrite("samples", &MultilevelResult::samples)
+        .def_readwrite("level_means", &MultilevelResult::level_means)
+        .def_readwrite("level_variances", &MultilevelResult::level_variances)
+        .def_readwrite("level_costs", &MultilevelResult::level_costs)
+        .def_readwrite("total_cost", &MultilevelResult::total_cost)
+        .def_readwrite("single_level_cost", &MultilevelResult::single_level_cost)
+        .def("__repr__", [](const MultilevelResult &r) {
+            return "<MultilevelResult estimate=" + std::to_string(r.estimate) +
+                   " levels=" + std::to_string(r.samples.size()) + ">";
+        });
+
+    // Bind option instrument layer
+    py::enum_<OptionRevaluation>(m, "OptionRevaluation")
+        .value("DELTA_GAMMA", OptionRevaluation::DELTA_GAMMA)
+        .value("FULL", OptionRevaluation::FULL);
+
+    py::class_<EuropeanOption>(m, "EuropeanOption")
+        .def(py::init<>())
+        .def_readwrite("name", &EuropeanOption::name)
+        .def_readwrite("underlying", &EuropeanOption::underlying)
+        .def_readwrite("is_call", &EuropeanOption::is_call)
+        .def_readwrite("spot", &EuropeanOption::spot)
+        .def_readwrite("strike", &EuropeanOption::strike)
+        .def_readwrite("maturity", &EuropeanOption::maturity)
+        .def_readwrite("volatility", &EuropeanOption::volatility)
+        .def_readwrite("rate", &EuropeanOption::rate)
+        .def_readwrite("quantity", &EuropeanOption::quantity)
+        .def("__repr__", [](const EuropeanOption &o) {
+            return "<EuropeanOption name='" + o.name + "' " + (o.is_call ? "call" : "put") +
+                   " strike=" + std::to_string(o.strike) +
+                   " maturity=" + std::to_string(o.maturity) +
+                   " quantity=" + std::to_string(o.quantity) + ">";
+        });
+
+    py::class_<OptionGreeks>(m, "OptionGreeks")
+        .def(py::init<>())
+        .def_readwrite("price", &OptionGreeks::price)
+        .def_readwrite("delta", &OptionGreeks::delta)
+        .def_readwrite("gamma", &OptionGreeks::gamma)
+        .def_readwrite("vega", &OptionGreeks::vega)
+        .def_readwrite("theta", &OptionGreeks::theta);
+
+    m.def("black_scholes_greeks", &blackScholesGreeks,
+          py::arg("option"),
+          "Black-Scholes price and Greeks of a European option");
+    m.def("black_scholes_greeks_batch", &blackScholesGreeksBatch,
+          py::arg("options"),
+          "Black-Scholes prices and Greeks for a list of European options");
+
+    // Bind fixed income layer
+    py::class_<BondPosition>(m, "BondPosition")
+        .def(py::init<>())
+        .def_readwrite("name", &BondPosition::name)
+        .def_readwrite("weight", &BondPosition::weight)
+        .def_readwrite("maturity", &BondPosition::maturity)
+        .def_readwrite("yield_to_maturity", &BondPosition::yield_to_maturity)
+        .def_readwrite("duration", &BondPosition::duration)
+        .def_readwrite("convexity", &BondPosition::convexity)
+        .def_readwrite("key_rate_durations", &BondPosition::key_rate_durations)
+        .def("__repr__", [](const BondPosition &b) {
+            return "<BondPosition name='" + b.name + "' weight=" + std::to_string(b.weight) +
+                   " duration=" + std::to_string(b.duration) + ">";
+        });
+
+    py::class_<YieldCurveFactorModel>(m, "YieldCurveFactorModel")
+        .def(py::init<>())
+        .def_readwrite("factor_volatilities", &YieldCurveFactorModel::factor_volatilities)
+        .def_readwrite("factor_correlation", &YieldCurveFactorModel::factor_correlation)
+        .def_readwrite("asset_correlation", &YieldCurveFactorModel::asset_correlation)
+        .def_readwrite("decay", &YieldCurveFactorModel::decay)
+        .def_readwrite("key_rate_tenors", &YieldCurveFactorModel::key_rate_tenors)
+        .def_readwrite("bonds", &YieldCurveFactorModel::bonds);
+
+    m.def("nelson_siegel_loadings", &nelsonSiegelLoadings,
+          py::arg("tenor"), py::arg("decay"),
+          "Level, slope and curvature loadings of a yield shock at the given tenor");
+
+    py::enum_<CorrelationIssue>(m, "CorrelationIssue")
+        .value("NONE", CorrelationIssue::NONE)
+        .value("SHAPE", CorrelationIssue::SHAPE)
+        .value("NOT_FINITE", CorrelationIssue::NOT_FINITE)
+        .value("OUT_OF_RANGE", CorrelationIssue::OUT_OF_RANGE)
+        .value("DIAGONAL", CorrelationIssue::DIAGONAL)
+        .value("ASYMMETRIC", CorrelationIssue::ASYMMETRIC)
+        .value("NOT_POSITIVE_DEFINITE", CorrelationIssue::NOT_POSITIVE_DEFINITE);
+
+    py::class_<CorrelationCheck>(m, "CorrelationCheck")
+        .def(py::init<>())
+        .def_readonly("issue", &CorrelationCheck::issue)
+        .def_readonly("row", &CorrelationCheck::row)
+        .def_readonly("column", &CorrelationCheck::column)
+        .def_readonly("value", &CorrelationCheck::value)
+        .def_readonly("message", &CorrelationCheck::message)
+        .def_property_readonly("valid", &CorrelationCheck::valid)
+        .def("__repr__", [](const CorrelationCheck &c) {
+            return c.valid() ? std::string("<CorrelationCheck valid>") : "<CorrelationCheck " + c.message + ">";
+        });
+
+    m.def("check_correlation_matrix",
+          [](const std::vector<std::vector<double>>& matrix, size_t expected_size,
+             double symmetry_tolerance, double diagonal_tolerance) {
+              return checkCorrelationMatrix(matrix, expected_size, symmetry_tolerance, diagonal_tolerance);
+          },
+          py::arg("matrix"),
+          py::arg("expected_size"),
+          py::arg("symmetry_tolerance") = 1e-6,
+          py::arg("diagonal_tolerance") = 1e-6,
+          py::call_guard<py::gil_scoped_release>(),
+          "Shape, finiteness, range, diagonal, symmetry and positive-definiteness check fused with Cholesky");
+
+    m.def("symmetric_eigen",
+          [](const std::vector<std::vector<double>>& matrix, size_t num_vectors) {
+              size_t n = matrix.size();
+              std::vector<double> flat(n * n);
+              for (size_t i = 0; i < n; ++i) {
+                  if (matrix[i].size() != n) {
+                      throw std::invalid_argument("Matrix must be square");
+                  }
+                  for (size_t j = 0; j < n; ++j) {
+                      if (std::abs(matrix[i][j] - matrix[j][i]) > 1e-10) {
+                          throw std::invalid_argument("Matrix must be symmetric");
+                      }
+                      flat[i * n + j] = matrix[i][j];
+                  }
+              }
+              std::vector<double> eigenvalues, eigenvectors;
+              {
+                  py::gil_scoped_release release;
+                  if (n > 0 && !symmetricEigen(flat, n, eigenvalues, eigenvectors, num_vectors)) {
+                      throw std::runtime_error("Eigenvalue iteration did not converge");
+                  }
+              }
+              size_t k = std::min(num_vectors, n);
+              std::vector<std::vector<double>> vectors(n, std::vector<double>(k));
+              for (size_t i = 0; i < n; ++i) {
+                  for (size_t j = 0; j < k; ++j) {
+                      vectors[i][j] = eigenvectors[i * k + j];
+                  }
+              }
+              return py::make_tuple(eigenvalues, vectors);
+          },
+          py::arg("matrix"),
+          py::arg("num_vectors"),
+          "Eigenvalues (descending) and the leading eigenvectors (as columns) of a symmetric matrix");
+
+    py::enum_<MixingDistribution>(m, "MixingDistribution")
+        .value("STUDENT_T", MixingDistribution::STUDENT_T)
+        .value("REGIME", MixingDistribution::REGIME)
+        .value("JUMP", MixingDistribution::JUMP);
+
+    py::class_<ConditionalTailSettings>(m, "ConditionalTailSettings")
+        .def(py::init<>())
+        .def_readwrite("mixing", &ConditionalTailSettings::mixing)
+        .def_readwrite("num_draws", &ConditionalTailSettings::num_draws)
+        .def_readwrite("degrees_of_freedom", &ConditionalTailSettings::degrees_of_freedom)
+        .def_readwrite("jump_intensity", &ConditionalTailSettings::jump_intensity)
+        .def_readwrite("jump_mean", &ConditionalTailSettings::jump_mean)
+        .def_readwrite("jump_volatility", &ConditionalTailSettings::jump_volatility)
+        .def_readwrite("seed", &ConditionalTailSettings::seed);
+
+    py::class_<ConditionalTailMetrics>(m, "ConditionalTailMetrics")
+        .def(py::init<>())
+        .def_readwrite("var_95", &ConditionalTailMetrics::var_95)
+        .def_readwrite("var_99", &ConditionalTailMetrics::var_99)
+        .def_readwrite("cvar_95", &ConditionalTailMetrics::cvar_95)
+        .def_readwrite("cvar_99", &ConditionalTailMetrics::cvar_99)
+        .def_readwrite("var_95_std_error", &ConditionalTailMetrics::var_95_std_error)
+        .def_readwrite("var_99_std_error", &ConditionalTailMetrics::var_99_std_error)
+        .def_readwrite("cvar_95_std_error", &ConditionalTailMetrics::cvar_95_std_error)
+        .def_readwrite("cvar_99_std_error", &ConditionalTailMetrics::cvar_99_std_error)
+        .def_readwrite("expected_return", &ConditionalTailMetrics::expected_return)
+        .def_readwrite("portfolio_vol", &ConditionalTailMetrics::portfolio_vol)
+        .def_readwrite("component_means", &ConditionalTailMetrics::component_means)
+        .def_readwrite("component_vols", &ConditionalTailMetrics::component_vols)
+        .def("__repr__", [](const ConditionalTailMetrics &r) {
+            return "<ConditionalTailMetrics VaR99=" + std::to_string(r.var_99) +
+                   " CVaR99=" + std::to_string(r.cvar_99) + ">";
+        });
+
+    py::class_<GaussianHMM>(m, "GaussianHMM")
+        .def(py::init<>())
+        .def_readwrite("initial_probabilities", &GaussianHMM::initial_probabilities)
+        .def_readwrite("transition", &GaussianHMM::transition)
+        .def_readwrite("means", &GaussianHMM::means)
+        .def_readwrite("covariances", &GaussianHMM::covariances)
+        .def_readwrite("periods_per_year", &GaussianHMM::periods_per_year)
+        .def_property_readonly("num_regimes", &GaussianHMM::numRegimes);
+
+    py::class_<HmmFitSettings>(m, "HmmFitSettings")
+        .def(py::init<>())
+        .def_readwrite("num_regimes", &HmmFitSettings::num_regimes)
+        .def_readwrite("max_iterations", &HmmFitSettings::max_iterations)
+        .def_readwrite("tolerance", &HmmFitSettings::tolerance)
+        .def_readwrite("restarts", &HmmFitSettings::restarts)
+        .def_readwrite("regularization", &HmmFitSettings::regularization)
+        .def_readwrite("periods_per_year", &HmmFitSettings::periods_per_year)
+        .def_readwrite("seed", &HmmFitSettings::seed);
+
+    py::class_<HmmFitResult>(m, "HmmFitResult")
+        .def(py::init<>())
+        .def_readwrite("model", &HmmFitResult::model)
+        .def_readwrite("log_likelihood", &HmmFitResult::log_likelihood)
+        .def_readwrite("iterations", &HmmFitResult::iterations)
+        .def_readwrite("converged", &HmmFitResult::converged)
+        .def_readwrite("regime_probabilities", &HmmFitResult::regime_probabilities)
+        .def("__repr__", [](const HmmFitResult &r) {
+            return "<HmmFitResult regimes=" + std::to_string(r.model.numRegimes()) +
+                   " log_likelihood=" + std::to_string(r.log_likelihood) + ">";
+        });
+
+    m.def("fit_gaussian_hmm", &fitGaussianHMM,
+          py::arg("returns"),
+          py::arg("settings") = HmmFitSettings(),
+          py::call_guard<py::gil_scoped_release>(),
+          "Baum-Welch fit of a Gaussian hidden Markov model to a T x n return history");
+
+    py::class_<BlockCorrelationModel>(m, "BlockCorrelationModel")
+        .def(py::init<>())
+        .def_readwrite("blocks", &BlockCorrelationModel::blocks)
+        .def_readwrite("block_correlations", &BlockCorrelationModel::block_correlations)
+        .def_readwrite("cross_loadings", &BlockCorrelationModel::cross_loadings);
+
+    m.def("detect_block_structure", &detectBlockStructure,
+          py::arg("correlation_matrix"),
+          py::arg("threshold"),
+          py::arg("cross_rank") = 0,
+          py::call_guard<py::gil_scoped_release>(),
+          "Split a dense correlation matrix into sector blocks plus cross_rank common factors");
+
+    // Bind TrackingErrorResult struct
+    py::class_<TrackingErrorResult>(m, "TrackingErrorResult")
+        .def(py::init<>())
+        .def_readwrite("weights", &TrackingErrorResult::weights)
+        .def_readwrite("tracking_error", &TrackingErrorResult::tracking_error)
+        .def_readwrite("turnover", &TrackingErrorResult::turnover)
+        .def_readwrite("iterations", &TrackingErrorResult::iterations)
+        .def("__repr__", [](const TrackingErrorResult &r) {
+            return "<TrackingErrorResult tracking_error=" + std::to_string(r.tracking_error) +
+                   " turnover=" + std::to_string(r.turnover) + ">";
+        });
+
     // Bind MonteCarloRiskEngine class
     py::class_<MonteCarloRiskEngine>(m, "MonteCarloRiskEngine")
         .def(py::init<const std::vector<PortfolioAsset>&, 
@@ -48,8 +410,27 @@ PYBIND11_MODULE(risk_engine_cpp, m) {
              py::arg("correlation_matrix"), 
              py::arg("simulations") = 100000,
              py::arg("time_horizon") = 1.0/252.0)
+        .def(py::init<const std::vector<PortfolioAsset>&,
+                      const BlockCorrelationModel&,
+                      int, double>(),
+             py::arg("assets"),
+             py::arg("correlation_model"),
+             py::arg("simulations") = 100000,
+             py::arg("time_horizon") = 1.0/252.0)
         .def("run_simulation", &MonteCarloRiskEngine::runSimulation,
+             py::call_guard<py::gil_scoped_release>(),
              "Run Monte Carlo simulation and calculate risk metrics")
+        .def("simulate_paths", &MonteCarloRiskEngine::simulatePaths,
+             py::arg("settings"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Simulate multi-step portfolio paths (pseudo-random or Sobol, optional Brownian bridge)")
+        .def("estimate_path_metric", &MonteCarloRiskEngine::estimatePathMetric,
+             py::arg("metric"),
+             py::arg("horizon"),
+             py::arg("settings") = MultilevelSettings(),
+             py::arg("shortfall_target") = 1.0,
+             py::call_guard<py::gil_scoped_release>(),
+             "Multilevel Monte Carlo estimate of a path metric to a target RMSE")
         .def("set_num_simulations", &MonteCarloRiskEngine::setNumSimulations,
              py::arg("simulations"),
              "Set number of Monte Carlo simulations")
@@ -61,7 +442,58 @@ PYBIND11_MODULE(risk_engine_cpp, m) {
              "Update portfolio assets")
         .def("update_correlation_matrix", &MonteCarloRiskEngine::updateCorrelationMatrix,
              py::arg("correlation_matrix"),
-             "Update correlation matrix");
+             "Update correlation matrix")
+        .def("set_option_positions", &MonteCarloRiskEngine::setOptionPositions,
+             py::arg("options"),
+             py::arg("portfolio_value"),
+             py::arg("mode") = OptionRevaluation::FULL,
+             "Set option positions revalued on every scenario (delta-gamma or full Black-Scholes)")
+        .def("set_liquidity_profile", &MonteCarloRiskEngine::setLiquidityProfile,
+             py::arg("profile"),
+             "Add liquidity-adjusted VaR from daily volumes (empty volumes remove it)")
+        .def("set_scenario_sampling", &MonteCarloRiskEngine::setScenarioSampling,
+             py::arg("settings"),
+             "Select the random stream and stratification along the portfolio loss direction")
+        .def("set_yield_curve_model", &MonteCarloRiskEngine::setYieldCurveModel,
+             py::arg("model"),
+             "Set the bond book and its yield curve factors (an empty bond list removes it)")
+        .def("set_sentiment_factor", &MonteCarloRiskEngine::setSentimentFactor,
+             py::arg("model"),
+             "Add a common sentiment shock and drift tilts to the scenarios (empty loadings remove it)")
+        .def("set_factor_simulation", &MonteCarloRiskEngine::setFactorSimulation,
+             py::arg("retained_variance"),
+             py::arg("max_factors") = 0,
+             "Simulate on principal components retaining this share of variance (0 = full Cholesky)")
+        .def("estimate_conditional_tail", &MonteCarloRiskEngine::estimateConditionalTail,
+             py::arg("settings") = ConditionalTailSettings(),
+             py::call_guard<py::gil_scoped_release>(),
+             "Conditional Monte Carlo VaR/CVaR of a Gaussian mixture: simulate the mixing variable only")
+        .def("set_regime_model", &MonteCarloRiskEngine::setRegimeModel,
+             py::arg("model"),
+             py::arg("start_probabilities") = std::vector<double>(),
+             "Evolve a hidden-Markov regime along simulated paths (a model without regimes removes it)")
+        .def("set_benchmark_weights", &MonteCarloRiskEngine::setBenchmarkWeights,
+             py::arg("weights"),
+             "Set benchmark weights for active risk (empty list clears the benchmark)")
+        .def("calculate_tracking_error", &MonteCarloRiskEngine::calculateTrackingError,
+             py::arg("weights"),
+             "Ex-ante tracking error of the given weights against the benchmark")
+        .def("calculate_tracking_errors", &MonteCarloRiskEngine::calculateTrackingErrors,
+             py::arg("account_weights"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Ex-ante tracking errors for a batch of accounts")
+        .def("minimize_tracking_error", &MonteCarloRiskEngine::minimizeTrackingError,
+             py::arg("current_weights"),
+             py::arg("max_turnover"),
+             py::arg("max_weight") = 1.0,
+             py::call_guard<py::gil_scoped_release>(),
+             "Minimize tracking error subject to a turnover limit")
+        .def("minimize_tracking_error_batch", &MonteCarloRiskEngine::minimizeTrackingErrorBatch,
+             py::arg("current_weights"),
+             py::arg("max_turnover"),
+             py::arg("max_weight") = 1.0,
+             py::call_guard<py::gil_scoped_release>(),
+             "Minimize tracking error for a batch of accounts");
 
     // Helper function to create PortfolioAsset from Python dict
     m.def("create_portfolio_asset", [](const std::string& name, double weight, 
@@ -82,7 +514,13 @@ PYBIND11_MODULE(risk_engine_cpp, m) {
              const std::vector<double>& volatilities,
              const std::vector<std::vector<double>>& correlation_matrix,
              int num_simulations = 100000,
-             double time_horizon = 1.0/252.0) {
+             double time_horizon = 1.0/252.0,
+             const std::vector<double>& benchmark_weights = std::vector<double>(),
+             double pca_retained_variance = 0.0,
+             const std::vector<double>& average_daily_volume = std::vector<double>(),
+             double portfolio_value = 0.0,
+             const std::vector<double>& sentiment_loadings = std::vector<double>(),
+             const std::vector<double>& sentiment_drift = std::vector<double>()) {
               
               if (asset_names.size() != weights.size() || 
                   weights.size() != expected_returns.size() ||
@@ -101,6 +539,20 @@ PYBIND11_MODULE(risk_engine_cpp, m) {
               }
               
               MonteCarloRiskEngine engine(assets, correlation_matrix, num_simulations, time_horizon);
+              engine.setBenchmarkWeights(benchmark_weights);
+              engine.setFactorSimulation(pca_retained_variance);
+              if (!average_daily_volume.empty()) {
+                  LiquidityProfile profile;
+                  profile.average_daily_volume = average_daily_volume;
+                  profile.portfolio_value = portfolio_value;
+                  engine.setLiquidityProfile(profile);
+              }
+              if (!sentiment_loadings.empty()) {
+                  SentimentFactorModel sentiment;
+                  sentiment.loadings = sentiment_loadings;
+                  sentiment.drift_tilt = sentiment_drift;
+                  engine.setSentimentFactor(sentiment);
+              }
               return engine.runSimulation();
           },
           py::arg("asset_names"),
@@ -110,5 +562,585 @@ PYBIND11_MODULE(risk_engine_cpp, m) {
           py::arg("correlation_matrix"),
           py::arg("num_simulations") = 100000,
           py::arg("time_horizon") = 1.0/252.0,
+          py::arg("benchmark_weights") = std::vector<double>(),
+          py::arg("pca_retained_variance") = 0.0,
+          py::arg("average_daily_volume") = std::vector<double>(),
+          py::arg("portfolio_value") = 0.0,
+          py::arg("sentiment_loadings") = std::vector<double>(),
+          py::arg("sentiment_drift") = std::vector<double>(),
+          py::call_guard<py::gil_scoped_release>(),
           "Calculate portfolio risk metrics from Python lists");
-}
\ No newline at end of file
+
+    // Bind cardinality-constrained optimizer
+    py::class_<CardinalityConstraints>(m, "CardinalityConstraints")
+        .def(py::init<>())
+        .def_readwrite("max_assets", &CardinalityConstraints::max_assets)
+        .def_readwrite("min_weight", &CardinalityConstraints::min_weight)
+        .def_readwrite("max_weight", &CardinalityConstraints::max_weight)
+        .def_readwrite("risk_aversion", &CardinalityConstraints::risk_aversion)
+        .def_readwrite("portfolio_value", &CardinalityConstraints::portfolio_value)
+        .def_readwrite("time_limit_seconds", &CardinalityConstraints::time_limit_seconds)
+        .def_readwrite("relative_gap", &CardinalityConstraints::relative_gap);
+
+    py::class_<OptimizationResult>(m, "OptimizationResult")
+        .def(py::init<>())
+        .def_readwrite("weights", &OptimizationResult::weights)
+        .def_readwrite("quantities", &OptimizationResult::quantities)
+        .def_readwrite("cash_residual", &OptimizationResult::cash_residual)
+        .def_readwrite("objective", &OptimizationResult::objective)
+        .def_readwrite("lower_bound", &OptimizationResult::lower_bound)
+        .def_readwrite("expected_return", &OptimizationResult::expected_return)
+        .def_readwrite("portfolio_vol", &OptimizationResult::portfolio_vol)
+        .def_readwrite("nodes_explored", &OptimizationResult::nodes_explored)
+        .def_readwrite("proven_optimal", &OptimizationResult::proven_optimal)
+        .def_readwrite("timed_out", &OptimizationResult::timed_out)
+        .def_readwrite("rounded", &OptimizationResult::rounded)
+        .def("__repr__", [](const OptimizationResult &r) {
+            return "<OptimizationResult objective=" + std::to_string(r.objective) +
+                   " lower_bound=" + std::to_string(r.lower_bound) +
+                   " nodes=" + std::to_string(r.nodes_explored) +
+                   " optimal=" + (r.proven_optimal ? std::string("True") : std::string("False")) + ">";
+        });
+
+    py::class_<CardinalityConstrainedOptimizer>(m, "CardinalityConstrainedOptimizer")
+        .def(py::init<const std::vector<double>&,
+                      const std::vector<double>&,
+                      const std::vector<std::vector<double>>&,
+                      const std::vector<double>&,
+                      const std::vector<double>&>(),
+             py::arg("expected_returns"),
+             py::arg("volatilities"),
+             py::arg("correlation_matrix"),
+             py::arg("prices") = std::vector<double>(),
+             py::arg("lot_sizes") = std::vector<double>())
+        .def("optimize", &CardinalityConstrainedOptimizer::optimize,
+             py::arg("constraints"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Solve the cardinality- and lot-constrained mean-variance problem by branch-and-bound");
+
+    // Bind turnover- and cost-aware rebalancing solver
+    py::class_<RebalanceCosts>(m, "RebalanceCosts")
+        .def(py::init<>())
+        .def_readwrite("linear", &RebalanceCosts::linear)
+        .def_readwrite("impact", &RebalanceCosts::impact)
+        .def_readwrite("no_trade", &RebalanceCosts::no_trade);
+
+    py::class_<RebalanceSettings>(m, "RebalanceSettings")
+        .def(py::init<>())
+        .def_readwrite("risk_aversion", &RebalanceSettings::risk_aversion)
+        .def_readwrite("turnover_penalty", &RebalanceSettings::turnover_penalty)
+        .def_readwrite("max_weight", &RebalanceSettings::max_weight)
+        .def_readwrite("rho", &RebalanceSettings::rho)
+        .def_readwrite("max_iterations", &RebalanceSettings::max_iterations)
+        .def_readwrite("tolerance", &RebalanceSettings::tolerance);
+
+    py::class_<RebalanceState>(m, "RebalanceState")
+        .def(py::init<>())
+        .def_readwrite("z", &RebalanceState::z)
+        .def_readwrite("u", &RebalanceState::u);
+
+    py::class_<RebalanceResult>(m, "RebalanceResult")
+        .def(py::init<>())
+        .def_readwrite("weights", &RebalanceResult::weights)
+        .def_readwrite("trades", &RebalanceResult::trades)
+        .def_readwrite("objective", &RebalanceResult::objective)
+        .def_readwrite("transaction_cost", &RebalanceResult::transaction_cost)
+        .def_readwrite("turnover", &RebalanceResult::turnover)
+        .def_readwrite("iterations", &RebalanceResult::iterations)
+        .def_readwrite("converged", &RebalanceResult::converged)
+        .def("__repr__", [](const RebalanceResult &r) {
+            return "<RebalanceResult turnover=" + std::to_string(r.turnover) +
+                   " transaction_cost=" + std::to_string(r.transaction_cost) +
+                   " iterations=" + std::to_string(r.iterations) + ">";
+        });
+
+    py::class_<RebalanceSolver>(m, "RebalanceSolver")
+        .def(py::init<const std::vector<double>&,
+                      const std::vector<double>&,
+                      const std::vector<std::vector<double>>&,
+                      const RebalanceCosts&,
+                      const RebalanceSettings&>(),
+             py::arg("expected_returns"),
+             py::arg("volatilities"),
+             py::arg("correlation_matrix"),
+             py::arg("costs"),
+             py::arg("settings") = RebalanceSettings())
+        .def("solve", &RebalanceSolver::solve,
+             py::arg("current_weights"),
+             py::arg("state"),
+             "Rebalance one account; state carries the warm start across days")
+        .def("solve_batch", [](const RebalanceSolver& solver,
+                               const std::vector<std::vector<double>>& current_weights,
+                               std::vector<RebalanceState*> states) {
+                 if (states.size() != current_weights.size()) {
+                     throw std::invalid_argument("One state is required per account");
+                 }
+                 std::vector<RebalanceState> working(states.size());
+                 for (size_t i = 0; i < states.size(); ++i) {
+                     working[i] = *states[i];
+                 }
+                 std::vector<RebalanceResult> results;
+                 {
+                     py::gil_scoped_release release;
+                     results = solver.solveBatch(current_weights, working);
+                 }
+                 for (size_t i = 0; i < states.size(); ++i) {
+                     *states[i] = std::move(working[i]);
+                 }
+                 return results;
+             },
+             py::arg("current_weights"),
+             py::arg("states"),
+             "Rebalance many accounts in parallel, updating each account's warm-start state")
+        .def("update_expected_returns", &RebalanceSolver::updateExpectedReturns,
+             py::arg("expected_returns"),
+             "Update expected returns without refactoring the system");
+
+    // Bind realized covariance estimator
+    py::enum_<RealizedCovarianceMethod>(m, "RealizedCovarianceMethod")
+        .value("REFRESH_TIME", RealizedCovarianceMethod::REFRESH_TIME)
+        .value("PRE_AVERAGED", RealizedCovarianceMethod::PRE_AVERAGED);
+
+    py::class_<RealizedCovarianceSettings>(m, "RealizedCovarianceSettings")
+        .def(py::init<>())
+        .def_readwrite("method", &RealizedCovarianceSettings::method)
+        .def_readwrite("pre_averaging_window", &RealizedCovarianceSettings::pre_averaging_window)
+        .def_readwrite("annualization", &RealizedCovarianceSettings::annualization)
+        .def_readwrite("min_eigenvalue", &RealizedCovarianceSettings::min_eigenvalue)
+        .def_readwrite("min_shrinkage", &RealizedCovarianceSettings::min_shrinkage);
+
+    py::class_<RealizedCovarianceResult>(m, "RealizedCovarianceResult")
+        .def(py::init<>())
+        .def_readwrite("covariance", &RealizedCovarianceResult::covariance)
+        .def_readwrite("correlation", &RealizedCovarianceResult::correlation)
+        .def_readwrite("volatilities", &RealizedCovarianceResult::volatilities)
+        .def_readwrite("shrinkage", &RealizedCovarianceResult::shrinkage)
+        .def_readwrite("observations", &RealizedCovarianceResult::observations);
+
+    py::class_<RealizedCovarianceEstimator>(m, "RealizedCovarianceEstimator")
+        .def(py::init<size_t, const RealizedCovarianceSettings&>(),
+             py::arg("num_assets"),
+             py::arg("settings") = RealizedCovarianceSettings())
+        .def("add_bar", &RealizedCovarianceEstimator::addBar,
+             py::arg("prices"),
+             "Add a bar of prices (NaN for assets that did not trade)")
+        .def("add_bars", &RealizedCovarianceEstimator::addBars,
+             py::arg("bars"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Add many bars of prices")
+        .def("add_tick", &RealizedCovarianceEstimator::addTick,
+             py::arg("asset"), py::arg("price"),
+             "Add an asynchronous trade price")
+        .def("num_observations", &RealizedCovarianceEstimator::numObservations,
+             "Refresh-time synchronized returns in the current window")
+        .def("estimate", &RealizedCovarianceEstimator::estimate,
+             py::call_guard<py::gil_scoped_release>(),
+             "Annualized covariance with a positive definite correlation matrix")
+        .def("reset", &RealizedCovarianceEstimator::reset,
+             "Start a new estimation window")
+        .def("serialize", [](const RealizedCovarianceEstimator &e) {
+                 std::vector<uint8_t> bytes = e.serialize();
+                 return py::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+             },
+             "Settings and window state as bytes, restorable with deserialize")
+        .def_static("deserialize", [](const py::bytes &data) {
+                 std::string bytes = data;
+                 return RealizedCovarianceEstimator::deserialize(
+                     reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+             },
+             py::arg("data"),
+             "Estimator restored from serialize() output");
+
+    // Bind real-time streaming risk service
+    py::class_<PriceTick>(m, "PriceTick")
+        .def(py::init<>())
+        .def(py::init([](uint32_t asset, double price, uint64_t timestamp) {
+                 return PriceTick{asset, price, timestamp};
+             }),
+             py::arg("asset"), py::arg("price"), py::arg("timestamp") = 0)
+        .def_readwrite("asset", &PriceTick::asset)
+        .def_readwrite("price", &PriceTick::price)
+        .def_readwrite("timestamp", &PriceTick::timestamp);
+
+    py::class_<StreamingRiskConfig>(m, "StreamingRiskConfig")
+        .def(py::init<>())
+        .def_readwrite("confidence", &StreamingRiskConfig::confidence)
+        .def_readwrite("horizon", &StreamingRiskConfig::horizon)
+        .def_readwrite("queue_capacity", &StreamingRiskConfig::queue_capacity)
+        .def_readwrite("mc_simulations", &StreamingRiskConfig::mc_simulations)
+        .def_readwrite("mc_refresh_seconds", &StreamingRiskConfig::mc_refresh_seconds)
+        .def_readwrite("mc_portfolios_per_refresh", &StreamingRiskConfig::mc_portfolios_per_refresh);
+
+    py::class_<PortfolioRiskSnapshot>(m, "PortfolioRiskSnapshot")
+        .def(py::init<>())
+        .def_readwrite("value", &PortfolioRiskSnapshot::value)
+        .def_readwrite("delta_normal_var", &PortfolioRiskSnapshot::delta_normal_var)
+        .def_readwrite("monte_carlo_var", &PortfolioRiskSnapshot::monte_carlo_var)
+        .def_readwrite("monte_carlo_valid", &PortfolioRiskSnapshot::monte_carlo_valid)
+        .def_readwrite("updates", &PortfolioRiskSnapshot::updates)
+        .def("__repr__", [](const PortfolioRiskSnapshot &r) {
+            return "<PortfolioRiskSnapshot value=" + std::to_string(r.value) +
+                   " delta_normal_var=" + std::to_string(r.delta_normal_var) + ">";
+        });
+
+    py::class_<RiskAlert>(m, "RiskAlert")
+        .def(py::init<>())
+        .def_readwrite("portfolio", &RiskAlert::portfolio)
+        .def_readwrite("var", &RiskAlert::var)
+        .def_readwrite("threshold", &RiskAlert::threshold)
+        .def_readwrite("breached", &RiskAlert::breached);
+
+    py::class_<StreamingRiskStats>(m, "StreamingRiskStats")
+        .def(py::init<>())
+        .def_readwrite("ticks_received", &StreamingRiskStats::ticks_received)
+        .def_readwrite("ticks_dropped", &StreamingRiskStats::ticks_dropped)
+        .def_readwrite("ticks_processed", &StreamingRiskStats::ticks_processed)
+        .def_readwrite("batches", &StreamingRiskStats::batches)
+        .def_readwrite("mc_refreshes", &StreamingRiskStats::mc_refreshes);
+
+    py::class_<StreamingRiskService, std::unique_ptr<StreamingRiskService, StreamingServiceDeleter>>(
+        m, "StreamingRiskService")
+        .def(py::init<const std::vector<double>&, const std::vector<double>&,
+                      const std::vector<std::vector<double>>&, const std::vector<double>&,
+                      const StreamingRiskConfig&>(),
+             py::arg("expected_returns"),
+             py::arg("volatilities"),
+             py::arg("correlation_matrix"),
+             py::arg("initial_prices"),
+             py::arg("config") = StreamingRiskConfig())
+        .def("add_portfolio", &StreamingRiskService::addPortfolio,
+             py::arg("quantities"),
+             "Register a portfolio by units held per asset; returns its id")
+        .def("set_positions", &StreamingRiskService::setPositions,
+             py::arg("portfolio"), py::arg("quantities"),
+             "Replace a portfolio's positions")
+        .def("push_tick", &StreamingRiskService::pushTick,
+             py::arg("asset"), py::arg("price"), py::arg("timestamp") = 0,
+             "Enqueue a price tick; returns False if it was dropped")
+        .def("push_ticks", &StreamingRiskService::pushTicks,
+             py::arg("ticks"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Enqueue many price ticks; returns the number accepted")
+        .def("subscribe", &StreamingRiskService::subscribe,
+             py::arg("portfolio"), py::arg("threshold"), py::arg("callback"),
+             "Call back when the portfolio's delta-normal VaR crosses the threshold")
+        .def("start", &StreamingRiskService::start,
+             py::call_guard<py::gil_scoped_release>(),
+             "Start the tick consumer and background Monte Carlo threads")
+        .def("stop", &StreamingRiskService::stop,
+             py::call_guard<py::gil_scoped_release>(),
+             "Stop the background threads after applying queued ticks")
+        .def("is_running", &StreamingRiskService::isRunning)
+        .def("process_pending", &StreamingRiskService::processPending,
+             py::call_guard<py::gil_scoped_release>(),
+             "Apply queued ticks on the calling thread (service must be stopped)")
+        .def("refresh_monte_carlo", &StreamingRiskService::refreshMonteCarlo,
+             py::arg("max_portfolios"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Revalue up to max_portfolios portfolios by Monte Carlo, round robin")
+        .def("get_risk", &StreamingRiskService::getRisk,
+             py::arg("portfolio"),
+             "Current risk snapshot of one portfolio")
+        .def("get_all_risk", &StreamingRiskService::getAllRisk,
+             "Current risk snapshots of all portfolios")
+        .def("get_stats", &StreamingRiskService::getStats,
+             "Ingestion and refresh counters");
+
+    // Bind process lifecycle hooks for pre-forking servers
+    py::class_<RuntimeStatus>(m, "RuntimeStatus")
+        .def_readonly("pid", &RuntimeStatus::pid)
+        .def_readonly("initialized", &RuntimeStatus::initialized)
+        .def_readonly("preload", &RuntimeStatus::preload)
+        .def_readonly("forked_child", &RuntimeStatus::forked_child)
+        .def_readonly("inherited_pool", &RuntimeStatus::inherited_pool)
+        .def_readonly("num_threads", &RuntimeStatus::num_threads)
+        .def_readonly("sobol_dimensions", &RuntimeStatus::sobol_dimensions)
+        .def("__repr__", [](const RuntimeStatus &s) {
+            return "<RuntimeStatus pid=" + std::to_string(s.pid) +
+                   " num_threads=" + std::to_string(s.num_threads) +
+                   " forked_child=" + (s.forked_child ? std::string("True") : std::string("False")) +
+                   " inherited_pool=" + (s.inherited_pool ? std::string("True") : std::string("False")) + ">";
+        });
+
+    m.def("initialize_runtime",
+          [](int num_threads, bool preload) {
+              RuntimeSettings settings;
+              settings.num_threads = num_threads;
+              settings.preload = preload;
+              return initializeRuntime(settings);
+          },
+          py::arg("num_threads") = 0,
+          py::arg("preload") = false,
+          "Install the at-fork handlers; preload=True keeps a forking master single-threaded");
+
+    m.def("warmup_runtime",
+          [](size_t sobol_dimensions) {
+              WarmupSettings settings;
+              settings.sobol_dimensions = sobol_dimensions;
+              return warmupRuntime(settings);
+          },
+          py::arg("sobol_dimensions") = WarmupSettings().sobol_dimensions,
+          py::call_guard<py::gil_scoped_release>(),
+          "Build the shared read-only tables before forking workers");
+
+    m.def("shutdown_runtime", &shutdownRuntime,
+          "Release the shared tables and reset the thread settings");
+
+    m.def("runtime_status", &runtimeStatus,
+          "Thread and fork state of this process");
+
+    // Bind large buffer memory settings
+    py::enum_<HugePageMode>(m, "HugePageMode")
+        .value("OFF", HugePageMode::OFF)
+        .value("TRANSPARENT", HugePageMode::TRANSPARENT)
+        .value("EXPLICIT", HugePageMode::EXPLICIT);
+
+    py::class_<MemorySettings>(m, "MemorySettings")
+        .def(py::init<>())
+        .def_readwrite("huge_pages", &MemorySettings::huge_pages)
+        .def_readwrite("streaming_stores", &MemorySettings::streaming_stores);
+
+    py::class_<MemoryStats>(m, "MemoryStats")
+        .def_readonly("huge_page_size", &MemoryStats::huge_page_size)
+        .def_readonly("mapped_bytes", &MemoryStats::mapped_bytes)
+        .def_readonly("explicit_bytes", &MemoryStats::explicit_bytes)
+        .def_readonly("transparent_bytes", &MemoryStats::transparent_bytes);
+
+    m.def("set_memory_settings", &setMemorySettings,
+          py::arg("settings"),
+          "Huge page mode and streaming stores for scenario and result buffers allocated afterwards");
+    m.def("memory_settings", &memorySettings,
+          "Current large buffer settings");
+    m.def("memory_stats", &memoryStats,
+          "Live large buffer mappings and how many are huge page backed");
+
+    // Bind warm-state snapshots for fast cold starts
+    m.def("factor_cache_bytes", &factorCacheBytes,
+          "Bytes of cached correlation factorizations");
+    m.def("set_factor_cache_capacity", &setFactorCacheCapacity,
+          py::arg("bytes"),
+          "Evict the oldest cached factorizations beyond this many bytes");
+    m.def("clear_factor_cache", &clearFactorCache,
+          "Drop every cached correlation factorization");
+
+    py::class_<SnapshotInfo>(m, "SnapshotInfo")
+        .def_readonly("version", &SnapshotInfo::version)
+        .def_readonly("bytes", &SnapshotInfo::bytes)
+        .def_readonly("sobol_dimensions", &SnapshotInfo::sobol_dimensions)
+        .def_readonly("factorizations", &SnapshotInfo::factorizations)
+        .def_readonly("models", &SnapshotInfo::models)
+        .def_readonly("estimators", &SnapshotInfo::estimators)
+        .def("__repr__", [](const SnapshotInfo &s) {
+            return "<SnapshotInfo version=" + std::to_string(s.version) +
+                   " bytes=" + std::to_string(s.bytes) +
+                   " factorizations=" + std::to_string(s.factorizations) + ">";
+        });
+
+    py::class_<SnapshotWriter>(m, "SnapshotWriter")
+        .def(py::init<>())
+        .def("add_process_caches", &SnapshotWriter::addProcessCaches,
+             "Include the Sobol direction table and every cached factorization")
+        .def("add_model", &SnapshotWriter::addModel,
+             py::arg("key"), py::arg("model"),
+             "Include a fitted regime model under a key of at most 31 characters")
+        .def("add_estimator", &SnapshotWriter::addEstimator,
+             py::arg("key"), py::arg("estimator"),
+             "Include a realized covariance estimator under a key of at most 31 characters")
+        .def("write", &SnapshotWriter::write,
+             py::arg("path"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Atomically write the snapshot file");
+
+    py::class_<Snapshot>(m, "Snapshot")
+        .def(py::init<const std::string&>(),
+             py::arg("path"),
+             "Map a snapshot file read-only and verify it")
+        .def("info", &Snapshot::info)
+        .def("install_process_caches", &Snapshot::installProcessCaches,
+             "Serve the Sobol table and cached factorizations from the mapped file")
+        .def("model", &Snapshot::model, py::arg("key"))
+        .def("estimator", &Snapshot::estimator, py::arg("key"));
+
+    // Bind in-memory position and price store
+    py::enum_<AssetType>(m, "AssetType")
+        .value("STOCK", AssetType::STOCK)
+        .value("BOND", AssetType::BOND)
+        .value("CRYPTO", AssetType::CRYPTO)
+        .value("REIT", AssetType::REIT)
+        .value("CASH", AssetType::CASH)
+        .value("COMMODITY", AssetType::COMMODITY);
+
+    m.def("parse_asset_type", &parseAssetType, py::arg("name"),
+          "AssetType from an assets.type value such as 'stock' (case-insensitive)");
+    m.def("asset_type_name", &assetTypeName, py::arg("type"));
+
+    py::class_<PositionRecord>(m, "PositionRecord")
+        .def(py::init<>())
+        .def(py::init([](int64_t asset_id, int64_t portfolio_id, const std::string& symbol,
+                         AssetType type, double quantity, double purchase_price) {
+                 return PositionRecord{asset_id, portfolio_id, symbol, type, quantity, purchase_price};
+             }),
+             py::arg("asset_id"), py::arg("portfolio_id"), py::arg("symbol"), py::arg("type"),
+             py::arg("quantity"), py::arg("purchase_price"))
+        .def_readwrite("asset_id", &PositionRecord::asset_id)
+        .def_readwrite("portfolio_id", &PositionRecord::portfolio_id)
+        .def_readwrite("symbol", &PositionRecord::symbol)
+        .def_readwrite("type", &PositionRecord::type)
+        .def_readwrite("quantity", &PositionRecord::quantity)
+        .def_readwrite("purchase_price", &PositionRecord::purchase_price);
+
+    py::class_<PriceRecord>(m, "PriceRecord")
+        .def(py::init<>())
+        .def(py::init([](int64_t asset_id, double price, const std::string& price_date) {
+                 return PriceRecord{asset_id, price, price_date};
+             }),
+             py::arg("asset_id"), py::arg("price"), py::arg("price_date") = "")
+        .def_readwrite("asset_id", &PriceRecord::asset_id)
+        .def_readwrite("price", &PriceRecord::price)
+        .def_readwrite("price_date", &PriceRecord::price_date);
+
+    py::class_<PortfolioValuation>(m, "PortfolioValuation")
+        .def_readonly("portfolio_id", &PortfolioValuation::portfolio_id)
+        .def_readonly("total_value", &PortfolioValuation::total_value)
+        .def_readonly("asset_ids", &PortfolioValuation::asset_ids)
+        .def_readonly("symbols", &PortfolioValuation::symbols)
+        .def_readonly("values", &PortfolioValuation::values)
+        .def_readonly("weights", &PortfolioValuation::weights)
+        .def_readonly("allocation", &PortfolioValuation::allocation)
+        .def("__repr__", [](const PortfolioValuation &v) {
+            return "<PortfolioValuation portfolio_id=" + std::to_string(v.portfolio_id) +
+                   " total_value=" + std::to_string(v.total_value) +
+                   " positions=" + std::to_string(v.asset_ids.size()) + ">";
+        });
+
+    py::class_<PositionStoreStats>(m, "PositionStoreStats")
+        .def_readonly("positions", &PositionStoreStats::positions)
+        .def_readonly("portfolios", &PositionStoreStats::portfolios)
+        .def_readonly("priced_positions", &PositionStoreStats::priced_positions)
+        .def_readonly("memory_bytes", &PositionStoreStats::memory_bytes)
+        .def("__repr__", [](const PositionStoreStats &s) {
+            return "<PositionStoreStats positions=" + std::to_string(s.positions) +
+                   " portfolios=" + std::to_string(s.portfolios) +
+                   " priced_positions=" + std::to_string(s.priced_positions) + ">";
+        });
+
+    py::class_<PositionStore>(m, "PositionStore")
+        .def(py::init<>())
+        .def("load_positions", &PositionStore::loadPositions,
+             py::arg("positions"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Replace every position, keeping the prices of assets still held")
+        .def("load_prices", &PositionStore::loadPrices,
+             py::arg("prices"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Apply price ticks in bulk; returns how many were applied")
+        .def("load_snapshot", &PositionStore::loadSnapshot,
+             py::arg("positions"), py::arg("prices"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Replace every position and apply prices atomically; returns how many prices were applied")
+        .def("refresh_assets", &PositionStore::refreshAssets,
+             py::arg("asset_ids"), py::arg("positions"), py::arg("prices"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Upsert, reprice and drop the listed assets atomically; returns how many were removed")
+        .def("upsert_position", &PositionStore::upsertPosition, py::arg("position"))
+        .def("remove_position", &PositionStore::removePosition, py::arg("asset_id"))
+        .def("update_price", &PositionStore::updatePrice, py::arg("price"),
+             "False if the asset is unknown or the price is older than the stored one")
+        .def("value_portfolios", &PositionStore::valuePortfolios,
+             py::arg("portfolio_ids") = std::vector<int64_t>(),
+             py::call_guard<py::gil_scoped_release>(),
+             "Values, position weights and type allocation of many portfolios in one pass")
+        .def("price", &PositionStore::price, py::arg("asset_id"))
+        .def("stats", &PositionStore::stats)
+        .def("clear", &PositionStore::clear);
+
+    // Bind batched performance measurement and attribution
+    py::class_<ValueHistories>(m, "ValueHistories")
+        .def(py::init<>())
+        .def_readwrite("offsets", &ValueHistories::offsets)
+        .def_readwrite("times", &ValueHistories::times)
+        .def_readwrite("values", &ValueHistories::values)
+        .def_readwrite("flows", &ValueHistories::flows);
+
+    py::class_<IrrSettings>(m, "IrrSettings")
+        .def(py::init<>())
+        .def_readwrite("max_iterations", &IrrSettings::max_iterations)
+        .def_readwrite("tolerance", &IrrSettings::tolerance)
+        .def_readwrite("max_log_rate", &IrrSettings::max_log_rate);
+
+    py::class_<PerformanceResult>(m, "PerformanceResult")
+        .def_readonly("time_weighted_return", &PerformanceResult::time_weighted_return)
+        .def_readonly("annualized_twr", &PerformanceResult::annualized_twr)
+        .def_readonly("money_weighted_return", &PerformanceResult::money_weighted_return)
+        .def_readonly("years", &PerformanceResult::years)
+        .def_readonly("irr_iterations", &PerformanceResult::irr_iterations)
+        .def_readonly("irr_converged", &PerformanceResult::irr_converged)
+        .def("__repr__", [](const PerformanceResult &r) {
+            return "<PerformanceResult twr=" + std::to_string(r.time_weighted_return) +
+                   " irr=" + std::to_string(r.money_weighted_return) +
+                   " years=" + std::to_string(r.years) + ">";
+        });
+
+    m.def("measure_performance", &measurePerformance,
+          py::arg("histories"), py::arg("settings") = IrrSettings(),
+          py::call_guard<py::gil_scoped_release>(),
+          "Time-weighted and money-weighted returns of every portfolio in the histories");
+
+    py::class_<AttributionInputs>(m, "AttributionInputs")
+        .def(py::init<>())
+        .def_readwrite("num_classes", &AttributionInputs::num_classes)
+        .def_readwrite("offsets", &AttributionInputs::offsets)
+        .def_readwrite("portfolio_weights", &AttributionInputs::portfolio_weights)
+        .def_readwrite("portfolio_returns", &AttributionInputs::portfolio_returns)
+        .def_readwrite("benchmark_weights", &AttributionInputs::benchmark_weights)
+        .def_readwrite("benchmark_returns", &AttributionInputs::benchmark_returns);
+
+    py::class_<AttributionResult>(m, "AttributionResult")
+        .def_readonly("allocation", &AttributionResult::allocation)
+        .def_readonly("selection", &AttributionResult::selection)
+        .def_readonly("interaction", &AttributionResult::interaction)
+        .def_readonly("portfolio_return", &AttributionResult::portfolio_return)
+        .def_readonly("benchmark_return", &AttributionResult::benchmark_return)
+        .def_readonly("excess_return", &AttributionResult::excess_return);
+
+    m.def("attribute_performance", &attributePerformance,
+          py::arg("inputs"),
+          py::call_guard<py::gil_scoped_release>(),
+          "Brinson-Fachler allocation, selection and interaction per class, Carino-linked over periods");
+
+    py::class_<SentimentFactorModel>(m, "SentimentFactorModel")
+        .def(py::init<>())
+        .def_readwrite("loadings", &SentimentFactorModel::loadings)
+        .def_readwrite("asset_correlation", &SentimentFactorModel::asset_correlation)
+        .def_readwrite("drift_tilt", &SentimentFactorModel::drift_tilt);
+
+    py::class_<SentimentHistories>(m, "SentimentHistories")
+        .def(py::init<>())
+        .def_readwrite("score_offsets", &SentimentHistories::score_offsets)
+        .def_readwrite("score_days", &SentimentHistories::score_days)
+        .def_readwrite("scores", &SentimentHistories::scores)
+        .def_readwrite("price_offsets", &SentimentHistories::price_offsets)
+        .def_readwrite("price_days", &SentimentHistories::price_days)
+        .def_readwrite("prices", &SentimentHistories::prices);
+
+    py::class_<SentimentCalibrationSettings>(m, "SentimentCalibrationSettings")
+        .def(py::init<>())
+        .def_readwrite("min_observations", &SentimentCalibrationSettings::min_observations)
+        .def_readwrite("drift_shrinkage", &SentimentCalibrationSettings::drift_shrinkage);
+
+    py::class_<SentimentCalibration>(m, "SentimentCalibration")
+        .def_readonly("model", &SentimentCalibration::model)
+        .def_readonly("residual_volatility", &SentimentCalibration::residual_volatility)
+        .def_readonly("r_squared", &SentimentCalibration::r_squared)
+        .def_readonly("current_sentiment", &SentimentCalibration::current_sentiment)
+        .def_readonly("observations", &SentimentCalibration::observations)
+        .def_readonly("drift_slope", &SentimentCalibration::drift_slope)
+        .def_readonly("drift_t_stat", &SentimentCalibration::drift_t_stat)
+        .def_readonly("market_correlation", &SentimentCalibration::market_correlation)
+        .def_readonly("num_intervals", &SentimentCalibration::num_intervals);
+
+    m.def("calibrate_sentiment_factors", &calibrateSentimentFactors,
+          py::arg("histories"), py::arg("settings") = SentimentCalibrationSettings(),
+          py::call_guard<py::gil_scoped_release>(),
+          "Sentiment loadings, residual vols and drift tilts of every ticker from score and price histories");
+}
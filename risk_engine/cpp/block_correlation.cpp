@@ -0,0 +1,249 @@
+#include "block_correlation.h"
+#include "linalg.h"
+#include "lifecycle.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+size_t findRoot(std::vector<size_t>& parent, size_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+} // namespace
+
+BlockCorrelationFactor::BlockCorrelationFactor(const BlockCorrelationModel& model, size_t num_assets)
+    : n(num_assets), rank(0), blocks(model.blocks) {
+
+    if (n == 0) {
+        throw std::invalid_argument("Number of assets must be positive");
+    }
+    if (model.block_correlations.size() != blocks.size()) {
+        throw std::invalid_argument("Need one correlation matrix per block");
+    }
+    std::vector<char> seen(n, 0);
+    for (const auto& block : blocks) {
+        if (block.empty()) {
+            throw std::invalid_argument("Blocks cannot be empty");
+        }
+        for (size_t asset : block) {
+            if (asset >= n || seen[asset]) {
+                throw std::invalid_argument("Every asset must belong to exactly one block");
+            }
+            seen[asset] = 1;
+        }
+    }
+    if (std::find(seen.begin(), seen.end(), 0) != seen.end()) {
+        throw std::invalid_argument("Every asset must belong to exactly one block");
+    }
+
+    if (!model.cross_loadings.empty()) {
+        if (model.cross_loadings.size() != n) {
+            throw std::invalid_argument("Cross loadings need one row per asset");
+        }
+        rank = model.cross_loadings[0].size();
+        loadings.assign(n * rank, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            if (model.cross_loadings[i].size() != rank) {
+                throw std::invalid_argument("Cross loading rows must have equal length");
+            }
+            std::copy(model.cross_loadings[i].begin(), model.cross_loadings[i].end(), &loadings[i * rank]);
+        }
+    }
+
+    // Residual B_k - F_k F_k' of each block, factored independently
+    factors.resize(blocks.size());
+    std::vector<std::string> errors(blocks.size());
+    #pragma omp parallel for schedule(dynamic) num_threads(parallelThreads())
+    for (long k = 0; k < static_cast<long>(blocks.size()); ++k) {
+        const auto& members = blocks[k];
+        const auto& corr = model.block_correlations[k];
+        size_t b = members.size();
+        if (corr.size() != b) {
+            errors[k] = "Block correlation size must match its number of assets";
+            continue;
+        }
+        std::vector<double> residual(b * b);
+        for (size_t a = 0; a < b && errors[k].empty(); ++a) {
+            if (corr[a].size() != b) {
+                errors[k] = "Block correlation size must match its number of assets";
+                break;
+            }
+            if (corr[a][a] < 0.99 || corr[a][a] > 1.01) {
+                errors[k] = "Diagonal elements of correlation matrix should be 1";
+                break;
+            }
+            const double* fa = rank > 0 ? &loadings[members[a] * rank] : nullptr;
+            for (size_t c = 0; c < b; ++c) {
+                if (std::abs(corr[a][c] - corr[c][a]) > 1e-10) {
+                    errors[k] = "Correlation matrix must be symmetric";
+                    break;
+                }
+                double common = 0.0;
+                if (rank > 0) {
+                    const double* fc = &loadings[members[c] * rank];
+                    for (size_t j = 0; j < rank; ++j) common += fa[j] * fc[j];
+                }
+                residual[a * b + c] = corr[a][c] - common;
+            }
+        }
+        if (!errors[k].empty()) continue;
+        if (!choleskyFactor(residual, b)) {
+            errors[k] = "Block " + std::to_string(k) +
+                        " is not positive definite after removing its cross-block factors";
+            continue;
+        }
+        factors[k] = std::move(residual);
+    }
+    for (const auto& error : errors) {
+        if (!error.empty()) throw std::invalid_argument(error);
+    }
+}
+
+size_t BlockCorrelationFactor::storedValues() const {
+    size_t total = loadings.size();
+    for (const auto& factor : factors) total += factor.size();
+    return total;
+}
+
+void BlockCorrelationFactor::correlate(const double* z, double* out) const {
+    const double* residual = z + rank;
+    for (size_t i = 0; i < n; ++i) {
+        double common = 0.0;
+        const double* f = rank > 0 ? &loadings[i * rank] : nullptr;
+        for (size_t j = 0; j < rank; ++j) common += f[j] * z[j];
+        out[i] = common;
+    }
+    for (size_t k = 0; k < blocks.size(); ++k) {
+        const auto& members = blocks[k];
+        const double* l = factors[k].data();
+        size_t b = members.size();
+        for (size_t a = 0; a < b; ++a) {
+            const double* row = l + a * b;
+            double sum = 0.0;
+            for (size_t c = 0; c <= a; ++c) {
+                sum += row[c] * residual[members[c]];
+            }
+            out[members[a]] += sum;
+        }
+    }
+}
+
+std::vector<double> BlockCorrelationFactor::pullBack(const std::vector<double>& x) const {
+    if (x.size() != n) {
+        throw std::invalid_argument("Vector size must match the number of assets");
+    }
+    std::vector<double> a(rank + n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < rank; ++j) {
+            a[j] += x[i] * loadings[i * rank + j];
+        }
+    }
+    for (size_t k = 0; k < blocks.size(); ++k) {
+        const auto& members = blocks[k];
+        const double* l = factors[k].data();
+        size_t b = members.size();
+        for (size_t r = 0; r < b; ++r) {
+            double xr = x[members[r]];
+            for (size_t c = 0; c <= r; ++c) {
+                a[rank + members[c]] += l[r * b + c] * xr;
+            }
+        }
+    }
+    return a;
+}
+
+double BlockCorrelationFactor::quadraticForm(const std::vector<double>& x) const {
+    std::vector<double> a = pullBack(x);
+    double sum = 0.0;
+    for (double v : a) sum += v * v;
+    return sum;
+}
+
+BlockCorrelationModel detectBlockStructure(const std::vector<std::vector<double>>& correlation,
+                                           double threshold, size_t cross_rank) {
+    size_t n = correlation.size();
+    if (n == 0) {
+        throw std::invalid_argument("Correlation matrix cannot be empty");
+    }
+    if (threshold < 0.0) {
+        throw std::invalid_argument("Threshold must be non-negative");
+    }
+    if (cross_rank >= n) {
+        throw std::invalid_argument("Cross rank must be smaller than the number of assets");
+    }
+    std::vector<double> flat(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        if (correlation[i].size() != n) {
+            throw std::invalid_argument("Correlation matrix must be square");
+        }
+        std::copy(correlation[i].begin(), correlation[i].end(), &flat[i * n]);
+    }
+
+    // Leading principal components carry the cross-block (market, style) correlation
+    std::vector<double> loadings(n * cross_rank, 0.0);
+    if (cross_rank > 0) {
+        std::vector<double> eigenvalues, eigenvectors;
+        if (!symmetricEigen(flat, n, eigenvalues, eigenvectors, cross_rank)) {
+            throw std::invalid_argument("Eigendecomposition of the correlation matrix did not converge");
+        }
+        for (size_t j = 0; j < cross_rank; ++j) {
+            double scale = std::sqrt(std::max(eigenvalues[j], 0.0));
+            for (size_t i = 0; i < n; ++i) {
+                loadings[i * cross_rank + j] = eigenvectors[i * cross_rank + j] * scale;
+            }
+        }
+    }
+
+    // Connected components of the residual correlation graph
+    std::vector<size_t> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (size_t i = 0; i < n; ++i) {
+        const double* fi = &loadings[i * cross_rank];
+        for (size_t j = i + 1; j < n; ++j) {
+            double common = 0.0;
+            const double* fj = &loadings[j * cross_rank];
+            for (size_t k = 0; k < cross_rank; ++k) common += fi[k] * fj[k];
+            if (std::abs(flat[i * n + j] - common) > threshold) {
+                size_t ri = findRoot(parent, i), rj = findRoot(parent, j);
+                if (ri != rj) parent[std::max(ri, rj)] = std::min(ri, rj);
+            }
+        }
+    }
+
+    BlockCorrelationModel model;
+    std::vector<size_t> block_of_root(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        size_t root = findRoot(parent, i);
+        if (block_of_root[root] == n) {
+            block_of_root[root] = model.blocks.size();
+            model.blocks.emplace_back();
+        }
+        model.blocks[block_of_root[root]].push_back(i);
+    }
+    for (const auto& members : model.blocks) {
+        size_t b = members.size();
+        std::vector<std::vector<double>> block(b, std::vector<double>(b));
+        for (size_t a = 0; a < b; ++a) {
+            for (size_t c = 0; c < b; ++c) {
+                block[a][c] = flat[members[a] * n + members[c]];
+            }
+        }
+        model.block_correlations.push_back(std::move(block));
+    }
+    if (cross_rank > 0) {
+        model.cross_loadings.assign(n, std::vector<double>(cross_rank));
+        for (size_t i = 0; i < n; ++i) {
+            std::copy(&loadings[i * cross_rank], &loadings[i * cross_rank] + cross_rank,
+                      model.cross_loadings[i].begin());
+        }
+    }
+    return model;
+}
@@ -0,0 +1,53 @@
+#ifndef BLOCK_CORRELATION_H
+#define BLOCK_CORRELATION_H
+
+#include <vector>
+#include <cstddef>
+
+// Correlation made of sector blocks plus low-rank cross terms: assets i, j in the same block
+// correlate as given by the block; across blocks their correlation is F_i . F_j.
+struct BlockCorrelationModel {
+    std::vector<std::vector<size_t>> blocks;                          // Asset indices of each block
+    std::vector<std::vector<std::vector<double>>> block_correlations; // Within-block correlation (unit diagonal)
+    std::vector<std::vector<double>> cross_loadings;                  // n x r cross-block loadings (empty = independent blocks)
+};
+
+// Factor of a block correlation model: z = (f, e) with r common normals f and one residual normal
+// per asset maps to F f + blockdiag(L_k) e, where L_k L_k' = B_k - F_k F_k'. Storage and work per
+// scenario are O(sum b_k^2 + n r) instead of O(n^2).
+class BlockCorrelationFactor {
+private:
+    size_t n;
+    size_t rank;
+    std::vector<std::vector<size_t>> blocks;
+    std::vector<std::vector<double>> factors; // Row-major lower-triangular residual factor per block
+    std::vector<double> loadings;             // n x rank row-major cross loadings
+
+public:
+    BlockCorrelationFactor(const BlockCorrelationModel& model, size_t num_assets);
+
+    size_t numAssets() const { return n; }
+    size_t numFactors() const { return rank; }
+    size_t numBlocks() const { return blocks.size(); }
+    size_t normalsPerScenario() const { return rank + n; }
+
+    // Doubles held by the factor (the dense Cholesky factor would hold n^2)
+    size_t storedValues() const;
+
+    // z: numFactors() common normals followed by one residual normal per asset; out: n correlated normals
+    void correlate(const double* z, double* out) const;
+
+    // a with x . correlate(z) = a . z, i.e. (F'x, L_k' x_k for each block)
+    std::vector<double> pullBack(const std::vector<double>& x) const;
+
+    // x' C x
+    double quadraticForm(const std::vector<double>& x) const;
+};
+
+// Detect block structure in a dense correlation matrix: the leading cross_rank principal
+// components become cross loadings, and assets whose remaining correlation exceeds threshold
+// (transitively) share a block. Cross-block entries are then reproduced within threshold.
+BlockCorrelationModel detectBlockStructure(const std::vector<std::vector<double>>& correlation,
+                                           double threshold, size_t cross_rank = 0);
+
+#endif // BLOCK_CORRELATION_H
@@ -0,0 +1,81 @@
+#include "brownian_bridge.h"
+#include <cmath>
+#include <stdexcept>
+
+BrownianBridge::BrownianBridge(size_t num_steps)
+    : steps(num_steps), bridge_index(num_steps), left_index(num_steps), right_index(num_steps),
+      left_weight(num_steps), right_weight(num_steps), std_dev(num_steps) {
+
+    if (steps == 0) {
+        throw std::invalid_argument("Number of steps must be positive");
+    }
+
+    // Path point k sits at time k + 1; point `steps - 1` is the terminal value
+    std::vector<char> constructed(steps, 0);
+    constructed[steps - 1] = 1;
+    bridge_index[0] = steps - 1;
+    left_index[0] = right_index[0] = 0;
+    left_weight[0] = right_weight[0] = 0.0;
+    std_dev[0] = std::sqrt(static_cast<double>(steps));
+
+    for (size_t i = 1, j = 0; i < steps; ++i) {
+        while (constructed[j]) ++j;           // First gap
+        size_t k = j;
+        while (!constructed[k]) ++k;          // Its right end
+        size_t l = j + ((k - 1 - j) >> 1);    // Midpoint
+        constructed[l] = 1;
+
+        double t_left = static_cast<double>(j); // Time of point j - 1 (0 for the origin)
+        double t_mid = static_cast<double>(l + 1);
+        double t_right = static_cast<double>(k + 1);
+        bridge_index[i] = l;
+        left_index[i] = j;
+        right_index[i] = k;
+        left_weight[i] = (t_right - t_mid) / (t_right - t_left);
+        right_weight[i] = (t_mid - t_left) / (t_right - t_left);
+        std_dev[i] = std::sqrt((t_mid - t_left) * (t_right - t_mid) / (t_right - t_left));
+
+        j = k + 1;
+        if (j >= steps) j = 0;
+    }
+}
+
+void BrownianBridge::transform(const double* normals, double* increments, size_t num_paths) const {
+    // Build the path levels W(t_k) in place, one row of paths at a time
+    double* terminal = increments + (steps - 1) * num_paths;
+    double scale = std_dev[0];
+    #pragma omp simd
+    for (size_t p = 0; p < num_paths; ++p) {
+        terminal[p] = scale * normals[p];
+    }
+
+    for (size_t i = 1; i < steps; ++i) {
+        double* mid = increments + bridge_index[i] * num_paths;
+        const double* right = increments + right_index[i] * num_paths;
+        const double* z = normals + i * num_paths;
+        double wr = right_weight[i], sd = std_dev[i];
+        if (left_index[i] == 0) {
+            #pragma omp simd
+            for (size_t p = 0; p < num_paths; ++p) {
+                mid[p] = wr * right[p] + sd * z[p];
+            }
+        } else {
+            const double* left = increments + (left_index[i] - 1) * num_paths;
+            double wl = left_weight[i];
+            #pragma omp simd
+            for (size_t p = 0; p < num_paths; ++p) {
+                mid[p] = wl * left[p] + wr * right[p] + sd * z[p];
+            }
+        }
+    }
+
+    // Levels to increments, last step first
+    for (size_t k = steps - 1; k > 0; --k) {
+        double* row = increments + k * num_paths;
+        const double* previous = row - num_paths;
+        #pragma omp simd
+        for (size_t p = 0; p < num_paths; ++p) {
+            row[p] -= previous[p];
+        }
+    }
+}
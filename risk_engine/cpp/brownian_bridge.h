@@ -0,0 +1,31 @@
+#ifndef BROWNIAN_BRIDGE_H
+#define BROWNIAN_BRIDGE_H
+
+#include <vector>
+#include <cstddef>
+
+// Brownian bridge construction over equally spaced steps. The first input normal sets the
+// terminal value, the next ones fill midpoints by bisection, so the leading (best distributed)
+// QMC dimensions carry most of the path variance. Output increments are iid standard normal
+// for iid standard normal input, so the construction can also be used with pseudo-random draws.
+class BrownianBridge {
+private:
+    size_t steps;
+    std::vector<size_t> bridge_index;  // Path point constructed by the i-th normal
+    std::vector<size_t> left_index;    // Left neighbour + 1 (0 = path origin)
+    std::vector<size_t> right_index;   // Right neighbour already constructed
+    std::vector<double> left_weight;
+    std::vector<double> right_weight;
+    std::vector<double> std_dev;       // Conditional standard deviation of the bridged point
+
+public:
+    explicit BrownianBridge(size_t num_steps);
+
+    size_t numSteps() const { return steps; }
+
+    // Step-major layout for both buffers: element [k * num_paths + p] is normal k of path p.
+    // `increments` receives the unit-variance Brownian increments of each step (may not alias `normals`).
+    void transform(const double* normals, double* increments, size_t num_paths) const;
+};
+
+#endif // BROWNIAN_BRIDGE_H
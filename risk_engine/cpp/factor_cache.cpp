@@ -0,0 +1,120 @@
+#include "factor_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
+namespace {
+
+// Default budget: a few hundred typical universes, or one 5000-asset factor
+const size_t kDefaultCapacityBytes = size_t(256) << 20;
+
+std::deque<CachedFactor> entries; // Oldest first
+size_t cached_bytes = 0;
+size_t capacity_bytes = kDefaultCapacityBytes;
+
+inline uint64_t rotateLeft(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t finalize(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    return x ^ (x >> 33);
+}
+
+size_t entryBytes(size_t n) {
+    return n * n * sizeof(double);
+}
+
+void evictToCapacity() {
+    while (cached_bytes > capacity_bytes && !entries.empty()) {
+        cached_bytes -= entryBytes(entries.front().size);
+        entries.pop_front();
+    }
+}
+
+} // namespace
+
+MatrixFingerprint fingerprintMatrix(const std::vector<std::vector<double>>& matrix) {
+    // Two independently mixed 64-bit lanes over the raw bits and the shape
+    uint64_t h1 = 0x9e3779b97f4a7c15ULL ^ matrix.size();
+    uint64_t h2 = 0x632be59bd9b4e019ULL + matrix.size();
+    for (const auto& row : matrix) {
+        h1 = rotateLeft(h1 ^ (row.size() * 0x87c37b91114253d5ULL), 27) * 0x4cf5ad432745937fULL;
+        h2 = rotateLeft(h2 + row.size(), 31) * 0x87c37b91114253d5ULL;
+        for (double value : row) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            h1 = rotateLeft(h1 ^ (bits * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
+            h2 = rotateLeft(h2 + (bits * 0x4cf5ad432745937fULL), 29) * 0x87c37b91114253d5ULL + h1;
+        }
+    }
+    return {finalize(h1 ^ rotateLeft(h2, 17)), finalize(h2 + h1)};
+}
+
+bool lookupFactor(const MatrixFingerprint& fingerprint, size_t n, std::vector<std::vector<double>>& factor) {
+    std::shared_ptr<const double> lower;
+    {
+        std::lock_guard<std::mutex> lock(factorCacheMutex());
+        for (const auto& entry : entries) {
+            if (entry.fingerprint == fingerprint && entry.size == n) {
+                lower = entry.lower;
+                break;
+            }
+        }
+    }
+    if (!lower) return false;
+    factor.assign(n, std::vector<double>(n, 0.0));
+    for (size_t i = 0; i < n; ++i) {
+        std::copy(lower.get() + i * n, lower.get() + i * n + i + 1, factor[i].begin());
+    }
+    return true;
+}
+
+void storeFactor(const MatrixFingerprint& fingerprint, const std::vector<std::vector<double>>& factor) {
+    size_t n = factor.size();
+    auto values = std::make_shared<std::vector<double>>(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        std::copy(factor[i].begin(), factor[i].begin() + i + 1, values->begin() + i * n);
+    }
+    storeFactor({fingerprint, n, std::shared_ptr<const double>(values, values->data())});
+}
+
+void storeFactor(const CachedFactor& entry) {
+    std::lock_guard<std::mutex> lock(factorCacheMutex());
+    for (const auto& existing : entries) {
+        if (existing.fingerprint == entry.fingerprint && existing.size == entry.size) return;
+    }
+    entries.push_back(entry);
+    cached_bytes += entryBytes(entry.size);
+    evictToCapacity();
+}
+
+void setFactorCacheCapacity(size_t bytes) {
+    std::lock_guard<std::mutex> lock(factorCacheMutex());
+    capacity_bytes = bytes;
+    evictToCapacity();
+}
+
+std::vector<CachedFactor> cachedFactors() {
+    std::lock_guard<std::mutex> lock(factorCacheMutex());
+    return std::vector<CachedFactor>(entries.begin(), entries.end());
+}
+
+size_t factorCacheBytes() {
+    std::lock_guard<std::mutex> lock(factorCacheMutex());
+    return cached_bytes;
+}
+
+void clearFactorCache() {
+    std::lock_guard<std::mutex> lock(factorCacheMutex());
+    entries.clear();
+    cached_bytes = 0;
+}
+
+std::mutex& factorCacheMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
@@ -0,0 +1,46 @@
+#ifndef FACTOR_CACHE_H
+#define FACTOR_CACHE_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// Process-wide cache of validated correlation Cholesky factors, keyed by a 128-bit fingerprint of
+// the matrix bits. Engines built on a matrix seen before skip the O(n^3) check and factorization
+// and only pay the O(n^2) fingerprint and copy. Entries are immutable and shared, so they can
+// also point into a read-only snapshot mapping.
+
+struct MatrixFingerprint {
+    uint64_t high;
+    uint64_t low;
+
+    bool operator==(const MatrixFingerprint& other) const { return high == other.high && low == other.low; }
+};
+
+struct CachedFactor {
+    MatrixFingerprint fingerprint;
+    size_t size;                       // n
+    std::shared_ptr<const double> lower; // n x n row-major lower-triangular factor
+};
+
+MatrixFingerprint fingerprintMatrix(const std::vector<std::vector<double>>& matrix);
+
+// Copy the cached factor into `factor` (n rows of length n); false on a miss
+bool lookupFactor(const MatrixFingerprint& fingerprint, size_t n, std::vector<std::vector<double>>& factor);
+
+void storeFactor(const MatrixFingerprint& fingerprint, const std::vector<std::vector<double>>& factor);
+void storeFactor(const CachedFactor& entry);
+
+// Oldest entries are evicted beyond this many bytes of factors
+void setFactorCacheCapacity(size_t bytes);
+
+std::vector<CachedFactor> cachedFactors();
+size_t factorCacheBytes();
+void clearFactorCache();
+
+// Guards the cache; held across fork() by the runtime's at-fork handlers
+std::mutex& factorCacheMutex();
+
+#endif // FACTOR_CACHE_H
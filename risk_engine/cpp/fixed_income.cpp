@@ -0,0 +1,85 @@
+#include "fixed_income.h"
+#include <cmath>
+#include <stdexcept>
+
+std::vector<double> nelsonSiegelLoadings(double tenor, double decay) {
+    std::vector<double> loadings(kYieldCurveFactors);
+    double x = tenor / decay;
+    double slope = x < 1e-8 ? 1.0 - 0.5 * x : (1.0 - std::exp(-x)) / x;
+    loadings[0] = 1.0;
+    loadings[1] = slope;
+    loadings[2] = slope - std::exp(-x);
+    return loadings;
+}
+
+BondBookExposure aggregateBondExposure(const YieldCurveFactorModel& model, size_t num_assets) {
+    if (model.factor_volatilities.size() != kYieldCurveFactors) {
+        throw std::invalid_argument("Yield curve model needs level, slope and curvature volatilities");
+    }
+    if (model.factor_correlation.size() != kYieldCurveFactors) {
+        throw std::invalid_argument("Yield curve factor correlation must be 3x3");
+    }
+    for (size_t k = 0; k < kYieldCurveFactors; ++k) {
+        if (model.factor_volatilities[k] < 0.0) {
+            throw std::invalid_argument("Yield curve factor volatilities must be non-negative");
+        }
+        if (model.factor_correlation[k].size() != kYieldCurveFactors) {
+            throw std::invalid_argument("Yield curve factor correlation must be 3x3");
+        }
+    }
+    if (model.asset_correlation.size() != num_assets) {
+        throw std::invalid_argument("Asset-factor correlation must have one row per portfolio asset");
+    }
+    for (const auto& row : model.asset_correlation) {
+        if (row.size() != kYieldCurveFactors) {
+            throw std::invalid_argument("Asset-factor correlation rows must have 3 entries");
+        }
+    }
+    if (model.decay <= 0.0) {
+        throw std::invalid_argument("Nelson-Siegel decay must be positive");
+    }
+
+    std::vector<std::vector<double>> key_rate_loadings;
+    for (double tenor : model.key_rate_tenors) {
+        key_rate_loadings.push_back(nelsonSiegelLoadings(tenor, model.decay));
+    }
+
+    BondBookExposure book;
+    book.weight = 0.0;
+    book.carry = 0.0;
+    book.exposure.assign(kYieldCurveFactors, 0.0);
+    book.curvature.assign(kYieldCurveFactors * kYieldCurveFactors, 0.0);
+
+    // O(bonds) aggregation; the simulation never sees individual bonds
+    for (const auto& bond : model.bonds) {
+        if (bond.maturity <= 0.0) {
+            throw std::invalid_argument("Bond maturity must be positive");
+        }
+        std::vector<double> own = nelsonSiegelLoadings(bond.maturity, model.decay);
+        std::vector<double> first_order(kYieldCurveFactors, 0.0);
+        if (!bond.key_rate_durations.empty()) {
+            if (bond.key_rate_durations.size() != model.key_rate_tenors.size()) {
+                throw std::invalid_argument("Key-rate durations must match the model's key-rate tenors");
+            }
+            for (size_t t = 0; t < key_rate_loadings.size(); ++t) {
+                for (size_t k = 0; k < kYieldCurveFactors; ++k) {
+                    first_order[k] += bond.key_rate_durations[t] * key_rate_loadings[t][k];
+                }
+            }
+        } else {
+            for (size_t k = 0; k < kYieldCurveFactors; ++k) {
+                first_order[k] = bond.duration * own[k];
+            }
+        }
+
+        book.weight += bond.weight;
+        book.carry += bond.weight * bond.yield_to_maturity;
+        for (size_t k = 0; k < kYieldCurveFactors; ++k) {
+            book.exposure[k] += bond.weight * first_order[k];
+            for (size_t l = 0; l < kYieldCurveFactors; ++l) {
+                book.curvature[k * kYieldCurveFactors + l] += bond.weight * bond.convexity * own[k] * own[l];
+            }
+        }
+    }
+    return book;
+}
@@ -0,0 +1,44 @@
+#ifndef FIXED_INCOME_H
+#define FIXED_INCOME_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// Level, slope and curvature of a Nelson-Siegel yield curve
+const size_t kYieldCurveFactors = 3;
+
+struct BondPosition {
+    std::string name;          // Position identifier
+    double weight;             // Portfolio weight
+    double maturity;           // Years to maturity, locates the bond on the curve
+    double yield_to_maturity;  // Annual yield, earned as carry over the horizon
+    double duration;           // Modified duration
+    double convexity;          // Convexity
+    std::vector<double> key_rate_durations; // Optional, one per model key-rate tenor; replaces duration
+};
+
+struct YieldCurveFactorModel {
+    std::vector<double> factor_volatilities;             // Annual vol of level/slope/curvature shocks (yield units)
+    std::vector<std::vector<double>> factor_correlation; // 3 x 3 correlation between curve factors
+    std::vector<std::vector<double>> asset_correlation;  // n x 3 correlation of each portfolio asset with the factors
+    double decay;                                        // Nelson-Siegel decay time in years
+    std::vector<double> key_rate_tenors;                 // Tenors for key-rate durations (may be empty)
+    std::vector<BondPosition> bonds;
+};
+
+// Book-level exposure: bond P&L = carry * T - exposure' f + 0.5 f' curvature f for factor shocks f
+struct BondBookExposure {
+    double weight;                  // Total bond weight
+    double carry;                   // Weighted annual yield
+    std::vector<double> exposure;   // 3 first-order factor sensitivities
+    std::vector<double> curvature;  // 3 x 3 row-major second-order sensitivities
+};
+
+// Nelson-Siegel loadings (1, slope, curvature) of a yield shock at the given tenor
+std::vector<double> nelsonSiegelLoadings(double tenor, double decay);
+
+// Validates the model against a portfolio of n assets and collapses the bonds into one exposure
+BondBookExposure aggregateBondExposure(const YieldCurveFactorModel& model, size_t num_assets);
+
+#endif // FIXED_INCOME_H
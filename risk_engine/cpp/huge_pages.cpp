@@ -0,0 +1,164 @@
+#include "huge_pages.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+#if defined(__SSE2__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const size_t kHugePageSize = size_t(2) << 20;
+
+enum class Backing { REGULAR, TRANSPARENT, EXPLICIT };
+
+std::atomic<int> huge_page_mode(static_cast<int>(HugePageMode::TRANSPARENT));
+std::atomic<bool> streaming_stores(true);
+
+std::mutex mappings_mutex;
+std::unordered_map<void*, Backing> mappings;
+size_t mapped_bytes = 0;
+size_t explicit_bytes = 0;
+size_t transparent_bytes = 0;
+
+size_t mappingLength(size_t bytes) {
+    return (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+}
+
+#ifndef _WIN32
+// Over-map by one huge page and trim, so the mapping starts on a huge page boundary
+void* mapAligned(size_t length) {
+    void* raw = mmap(nullptr, length + kHugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return nullptr;
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (start + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    if (aligned > start) munmap(raw, aligned - start);
+    size_t tail = start + length + kHugePageSize - (aligned + length);
+    if (tail > 0) munmap(reinterpret_cast<void*>(aligned + length), tail);
+    return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+} // namespace
+
+MemorySettings::MemorySettings() : huge_pages(HugePageMode::TRANSPARENT), streaming_stores(true) {}
+
+void setMemorySettings(const MemorySettings& settings) {
+    huge_page_mode = static_cast<int>(settings.huge_pages);
+    streaming_stores = settings.streaming_stores;
+}
+
+MemorySettings memorySettings() {
+    MemorySettings settings;
+    settings.huge_pages = static_cast<HugePageMode>(huge_page_mode.load());
+    settings.streaming_stores = streaming_stores;
+    return settings;
+}
+
+MemoryStats memoryStats() {
+    std::lock_guard<std::mutex> lock(mappings_mutex);
+    MemoryStats stats;
+    stats.huge_page_size = kHugePageSize;
+    stats.mapped_bytes = mapped_bytes;
+    stats.explicit_bytes = explicit_bytes;
+    stats.transparent_bytes = transparent_bytes;
+    return stats;
+}
+
+void* allocateLarge(size_t bytes) {
+#ifdef _WIN32
+    return ::operator new(bytes);
+#else
+    if (bytes < kHugePageSize) {
+        return ::operator new(bytes);
+    }
+    size_t length = mappingLength(bytes);
+    HugePageMode mode = static_cast<HugePageMode>(huge_page_mode.load());
+    Backing backing = Backing::REGULAR;
+    void* pointer = nullptr;
+#ifdef MAP_HUGETLB
+    if (mode == HugePageMode::EXPLICIT) {
+        pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (pointer == MAP_FAILED) {
+            pointer = nullptr;
+        } else {
+            backing = Backing::EXPLICIT;
+        }
+    }
+#endif
+    if (!pointer) {
+        pointer = mapAligned(length);
+        if (!pointer) {
+            throw std::bad_alloc();
+        }
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+        if (mode == HugePageMode::OFF) {
+            madvise(pointer, length, MADV_NOHUGEPAGE);
+        } else if (madvise(pointer, length, MADV_HUGEPAGE) == 0) {
+            backing = Backing::TRANSPARENT;
+        }
+#endif
+    }
+
+    std::lock_guard<std::mutex> lock(mappings_mutex);
+    mappings.emplace(pointer, backing);
+    mapped_bytes += length;
+    if (backing == Backing::EXPLICIT) explicit_bytes += length;
+    if (backing == Backing::TRANSPARENT) transparent_bytes += length;
+    return pointer;
+#endif
+}
+
+void releaseLarge(void* pointer, size_t bytes) {
+#ifdef _WIN32
+    (void)bytes;
+    ::operator delete(pointer);
+#else
+    if (bytes < kHugePageSize) {
+        ::operator delete(pointer);
+        return;
+    }
+    size_t length = mappingLength(bytes);
+    {
+        std::lock_guard<std::mutex> lock(mappings_mutex);
+        auto it = mappings.find(pointer);
+        if (it != mappings.end()) {
+            mapped_bytes -= length;
+            if (it->second == Backing::EXPLICIT) explicit_bytes -= length;
+            if (it->second == Backing::TRANSPARENT) transparent_bytes -= length;
+            mappings.erase(it);
+        }
+    }
+    munmap(pointer, length);
+#endif
+}
+
+void streamCopy(double* dst, const double* src, size_t count) {
+#if defined(__SSE2__) && defined(__x86_64__)
+    if (streaming_stores.load(std::memory_order_relaxed)) {
+        size_t i = 0;
+        auto streamOne = [](double* to, double value) {
+            long long bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            _mm_stream_si64(reinterpret_cast<long long*>(to), bits);
+        };
+#ifdef __AVX__
+        for (; i < count && (reinterpret_cast<uintptr_t>(dst + i) & 31) != 0; ++i) streamOne(dst + i, src[i]);
+        for (; i + 4 <= count; i += 4) _mm256_stream_pd(dst + i, _mm256_loadu_pd(src + i));
+#else
+        for (; i < count && (reinterpret_cast<uintptr_t>(dst + i) & 15) != 0; ++i) streamOne(dst + i, src[i]);
+        for (; i + 2 <= count; i += 2) _mm_stream_pd(dst + i, _mm_loadu_pd(src + i));
+#endif
+        for (; i < count; ++i) streamOne(dst + i, src[i]);
+        _mm_sfence();
+        return;
+    }
+#endif
+    std::copy(src, src + count, dst);
+}
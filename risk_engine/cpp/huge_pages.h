@@ -0,0 +1,88 @@
+#ifndef HUGE_PAGES_H
+#define HUGE_PAGES_H
+
+#include <vector>
+#include <limits>
+#include <new>
+#include <cstddef>
+#include <utility>
+
+// Backing store for the engine's large per-scenario buffers. Allocations of at least one huge page
+// get their own 2 MB aligned mapping that the kernel can back with huge pages, so a 10M-scenario
+// result vector spans a few dozen TLB entries instead of tens of thousands. Results are produced
+// in cache-resident blocks and copied out with non-temporal stores, which write around the cache
+// and leave the Cholesky factor and generator state in it.
+
+enum class HugePageMode {
+    OFF,         // Regular pages, and transparent huge pages declined for these buffers
+    TRANSPARENT, // madvise(MADV_HUGEPAGE): the kernel promotes the mapping when it can
+    EXPLICIT     // MAP_HUGETLB from the reserved pool, falling back to TRANSPARENT when it is empty
+};
+
+struct MemorySettings {
+    HugePageMode huge_pages;
+    bool streaming_stores; // Non-temporal copies of completed result blocks
+
+    MemorySettings();
+};
+
+struct MemoryStats {
+    size_t huge_page_size;    // Alignment and granularity of the large mappings
+    size_t mapped_bytes;      // Live large allocations
+    size_t explicit_bytes;    // ... taken from the reserved huge page pool
+    size_t transparent_bytes; // ... advised for transparent huge pages
+};
+
+// Process-wide; applies to buffers allocated afterwards
+void setMemorySettings(const MemorySettings& settings);
+MemorySettings memorySettings();
+MemoryStats memoryStats();
+
+// Below one huge page these fall through to operator new/delete
+void* allocateLarge(size_t bytes);
+void releaseLarge(void* pointer, size_t bytes);
+
+// dst[0, count) = src[0, count), bypassing the cache when streaming stores are enabled.
+// Fenced before returning, so the data is visible to other threads after the next barrier.
+void streamCopy(double* dst, const double* src, size_t count);
+
+template <typename T>
+struct HugePageAllocator {
+    using value_type = T;
+
+    HugePageAllocator() = default;
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(allocateLarge(n * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t n) { releaseLarge(pointer, n * sizeof(T)); }
+
+    // Default- rather than value-initialize, so sizing a buffer does not touch its pages: they are
+    // first faulted in by the worker threads that fill them
+    template <typename U>
+    void construct(U* pointer) { ::new (static_cast<void*>(pointer)) U; }
+
+    template <typename U, typename... Args>
+    void construct(U* pointer, Args&&... args) {
+        ::new (static_cast<void*>(pointer)) U(std::forward<Args>(args)...);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return true; }
+
+template <typename T, typename U>
+bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return false; }
+
+// Vector for buffers sized by the number of scenarios or paths. LargeVector<double>(n) leaves the
+// elements unset; every caller overwrites all of them.
+template <typename T>
+using LargeVector = std::vector<T, HugePageAllocator<T>>;
+
+#endif // HUGE_PAGES_H
@@ -0,0 +1,98 @@
+#include "instruments.h"
+#include "vecmath.h"
+#include "lifecycle.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+void validateOption(const EuropeanOption& option) {
+    if (option.spot <= 0.0 || option.strike <= 0.0) {
+        throw std::invalid_argument("Option spot and strike must be positive");
+    }
+    if (option.volatility <= 0.0) {
+        throw std::invalid_argument("Option volatility must be positive");
+    }
+    if (option.maturity < 0.0) {
+        throw std::invalid_argument("Option maturity cannot be negative");
+    }
+}
+
+} // namespace
+
+OptionGreeks blackScholesGreeks(const EuropeanOption& option) {
+    validateOption(option);
+    OptionGreeks greeks;
+    double tau = option.maturity;
+    if (tau <= 0.0) {
+        // Expired: intrinsic value, step delta
+        double intrinsic = option.is_call ? option.spot - option.strike : option.strike - option.spot;
+        greeks.price = std::max(intrinsic, 0.0);
+        greeks.delta = intrinsic > 0.0 ? (option.is_call ? 1.0 : -1.0) : 0.0;
+        greeks.gamma = greeks.vega = greeks.theta = 0.0;
+        return greeks;
+    }
+
+    double sqrt_tau = std::sqrt(tau);
+    double sigma_sqrt_tau = option.volatility * sqrt_tau;
+    double d1 = (std::log(option.spot / option.strike) +
+                 (option.rate + 0.5 * option.volatility * option.volatility) * tau) / sigma_sqrt_tau;
+    double d2 = d1 - sigma_sqrt_tau;
+    double discount = std::exp(-option.rate * tau);
+    double density = vecmath::normPdf(d1);
+
+    greeks.gamma = density / (option.spot * sigma_sqrt_tau);
+    greeks.vega = option.spot * density * sqrt_tau;
+    double decay = -option.spot * density * option.volatility / (2.0 * sqrt_tau);
+    if (option.is_call) {
+        greeks.price = option.spot * vecmath::normCdf(d1) - option.strike * discount * vecmath::normCdf(d2);
+        greeks.delta = vecmath::normCdf(d1);
+        greeks.theta = decay - option.rate * option.strike * discount * vecmath::normCdf(d2);
+    } else {
+        greeks.price = option.strike * discount * vecmath::normCdf(-d2) - option.spot * vecmath::normCdf(-d1);
+        greeks.delta = vecmath::normCdf(d1) - 1.0;
+        greeks.theta = decay + option.rate * option.strike * discount * vecmath::normCdf(-d2);
+    }
+    return greeks;
+}
+
+void blackScholesPriceBatch(const EuropeanOption& option, const double* spots, size_t count,
+                            double time_to_expiry, double* prices) {
+    if (time_to_expiry <= 0.0) {
+        double sign = option.is_call ? 1.0 : -1.0;
+        for (size_t p = 0; p < count; ++p) {
+            prices[p] = std::max(sign * (spots[p] - option.strike), 0.0);
+        }
+        return;
+    }
+
+    const double sigma_sqrt_tau = option.volatility * std::sqrt(time_to_expiry);
+    const double drift = (option.rate + 0.5 * option.volatility * option.volatility) * time_to_expiry;
+    const double inv_sigma_sqrt_tau = 1.0 / sigma_sqrt_tau;
+    const double inv_strike = 1.0 / option.strike;
+    const double discounted_strike = option.strike * std::exp(-option.rate * time_to_expiry);
+    // Put prices use Phi(-d) = 1 - Phi(d) folded into a sign flip of the arguments
+    const double sign = option.is_call ? 1.0 : -1.0;
+
+    #pragma omp simd
+    for (size_t p = 0; p < count; ++p) {
+        double spot = spots[p] > 1e-300 ? spots[p] : 1e-300;
+        double d1 = (vecmath::log(spot * inv_strike) + drift) * inv_sigma_sqrt_tau;
+        double d2 = d1 - sigma_sqrt_tau;
+        prices[p] = sign * (spot * vecmath::normCdf(sign * d1) -
+                            discounted_strike * vecmath::normCdf(sign * d2));
+    }
+}
+
+std::vector<OptionGreeks> blackScholesGreeksBatch(const std::vector<EuropeanOption>& options) {
+    for (const auto& option : options) {
+        validateOption(option);
+    }
+    std::vector<OptionGreeks> greeks(options.size());
+    #pragma omp parallel for schedule(static) if (options.size() > 1024) num_threads(parallelThreads())
+    for (long k = 0; k < static_cast<long>(options.size()); ++k) {
+        greeks[k] = blackScholesGreeks(options[k]);
+    }
+    return greeks;
+}
@@ -0,0 +1,43 @@
+#ifndef INSTRUMENTS_H
+#define INSTRUMENTS_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+struct EuropeanOption {
+    std::string name;      // Position identifier
+    size_t underlying;     // Index of the underlying asset in the portfolio
+    bool is_call;          // Call (true) or put (false)
+    double spot;           // Current price of the underlying
+    double strike;         // Strike price
+    double maturity;       // Time to expiry in years
+    double volatility;     // Implied volatility
+    double rate;           // Continuously compounded risk-free rate
+    double quantity;       // Number of options held (negative for short positions)
+};
+
+struct OptionGreeks {
+    double price;
+    double delta;
+    double gamma;
+    double vega;
+    double theta; // Per year
+};
+
+enum class OptionRevaluation {
+    DELTA_GAMMA,  // Second-order Taylor expansion in the underlying plus time decay
+    FULL          // Black-Scholes repricing on every scenario
+};
+
+// Price and Greeks of a single option
+OptionGreeks blackScholesGreeks(const EuropeanOption& option);
+
+// Vectorized pricing of one option across many spots at a common time to expiry
+void blackScholesPriceBatch(const EuropeanOption& option, const double* spots, size_t count,
+                            double time_to_expiry, double* prices);
+
+// Greeks for many options (parallel across options)
+std::vector<OptionGreeks> blackScholesGreeksBatch(const std::vector<EuropeanOption>& options);
+
+#endif // INSTRUMENTS_H
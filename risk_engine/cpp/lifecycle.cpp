@@ -0,0 +1,129 @@
+#include "lifecycle.h"
+#include "sobol.h"
+#include "factor_cache.h"
+#include <atomic>
+#include <mutex>
+#include <omp.h>
+#include <stdexcept>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::mutex runtime_mutex;                 // Serializes settings changes and warmup
+std::atomic<bool> initialized(false);
+std::atomic<bool> preloading(false);
+std::atomic<bool> forked_child(false);
+std::atomic<bool> inherited_pool(false);
+std::atomic<bool> pool_started(false);    // A team of more than one thread has run in this process
+std::atomic<int> configured_threads(0);
+std::once_flag fork_handlers;
+
+#ifndef _WIN32
+// Only the forking thread survives in the child, so no other thread may hold these locks
+void prepareFork() {
+    runtime_mutex.lock();
+    SobolSequence::directionMutex().lock();
+    factorCacheMutex().lock();
+}
+
+void resumeParent() {
+    factorCacheMutex().unlock();
+    SobolSequence::directionMutex().unlock();
+    runtime_mutex.unlock();
+}
+
+void resumeChild() {
+    factorCacheMutex().unlock();
+    SobolSequence::directionMutex().unlock();
+    runtime_mutex.unlock();
+    forked_child = true;
+    preloading = false;
+    if (pool_started) {
+        // The parent's pool threads are gone but the runtime still counts them
+        inherited_pool = true;
+    }
+}
+#endif
+
+void installForkHandlers() {
+#ifndef _WIN32
+    std::call_once(fork_handlers, [] { pthread_atfork(prepareFork, resumeParent, resumeChild); });
+#endif
+}
+
+long processId() {
+#ifdef _WIN32
+    return static_cast<long>(_getpid());
+#else
+    return static_cast<long>(getpid());
+#endif
+}
+
+} // namespace
+
+WarmupSettings::WarmupSettings() : sobol_dimensions(SobolSequence::kMaxDimensions) {}
+
+RuntimeStatus initializeRuntime(const RuntimeSettings& settings) {
+    if (settings.num_threads < 0) {
+        throw std::invalid_argument("Number of threads must be non-negative");
+    }
+    installForkHandlers();
+    {
+        std::lock_guard<std::mutex> lock(runtime_mutex);
+        if (settings.preload && pool_started) {
+            throw std::invalid_argument("Preload mode must be set before the first parallel region");
+        }
+        configured_threads = settings.num_threads;
+        preloading = settings.preload;
+        initialized = true;
+    }
+    return runtimeStatus();
+}
+
+RuntimeStatus warmupRuntime(const WarmupSettings& settings) {
+    {
+        std::lock_guard<std::mutex> lock(runtime_mutex);
+        SobolSequence::precomputeDirections(settings.sobol_dimensions);
+    }
+    return runtimeStatus();
+}
+
+void shutdownRuntime() {
+    std::lock_guard<std::mutex> lock(runtime_mutex);
+    SobolSequence::releaseDirections();
+    clearFactorCache();
+    configured_threads = 0;
+    preloading = false;
+    initialized = false;
+}
+
+RuntimeStatus runtimeStatus() {
+    RuntimeStatus status;
+    status.pid = processId();
+    status.initialized = initialized;
+    status.preload = preloading;
+    status.forked_child = forked_child;
+    status.inherited_pool = inherited_pool;
+    status.num_threads = preloading || inherited_pool ? 1
+                       : configured_threads > 0 ? configured_threads.load() : omp_get_max_threads();
+    status.sobol_dimensions = SobolSequence::precomputedDimensions();
+    return status;
+}
+
+int parallelThreads() {
+    if (preloading.load(std::memory_order_relaxed) || inherited_pool.load(std::memory_order_relaxed)) {
+        return 1;
+    }
+    installForkHandlers();
+    int threads = configured_threads.load(std::memory_order_relaxed);
+    if (threads <= 0) threads = omp_get_max_threads();
+    if (threads > 1 && !pool_started.load(std::memory_order_relaxed)) {
+        pool_started = true;
+    }
+    return threads;
+}
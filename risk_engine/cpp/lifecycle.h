@@ -0,0 +1,49 @@
+#ifndef LIFECYCLE_H
+#define LIFECYCLE_H
+
+#include <cstddef>
+
+// Process lifecycle of the native engine under pre-forking servers (gunicorn --preload and similar).
+// GNU OpenMP's worker pool does not survive fork(): a child whose parent already ran a parallel
+// team deadlocks in its first multi-threaded region. Every parallel region in the engine asks
+// parallelThreads() for its team size, which the at-fork handlers use to keep children safe.
+
+struct RuntimeSettings {
+    int num_threads; // OpenMP threads per parallel region (0 = the OpenMP default)
+    bool preload;    // Master that forks workers: run single-threaded so no pool exists at fork time
+
+    RuntimeSettings() : num_threads(0), preload(false) {}
+};
+
+struct WarmupSettings {
+    size_t sobol_dimensions; // Rows of the shared Sobol direction table to build (0 = skip)
+
+    WarmupSettings();
+};
+
+struct RuntimeStatus {
+    long pid;
+    bool initialized;       // initializeRuntime was called and not shut down since
+    bool preload;           // Parallel regions held to one thread until the next fork
+    bool forked_child;      // Process was forked after the runtime's handlers were installed
+    bool inherited_pool;    // The parent had started OpenMP threads, so regions here run single-threaded
+    int num_threads;        // Team size the next parallel region will use
+    size_t sobol_dimensions; // Sobol direction rows shared from the warmup (or built since)
+};
+
+// Install the at-fork handlers and apply the thread settings; callable again to change them.
+// Preload mode must be requested before this process runs its first multi-threaded region.
+RuntimeStatus initializeRuntime(const RuntimeSettings& settings = RuntimeSettings());
+
+// Build the process-wide read-only tables now, so workers forked afterwards share the pages
+RuntimeStatus warmupRuntime(const WarmupSettings& settings = WarmupSettings());
+
+// Drop the shared tables and cached factors and return to default thread settings (the handlers stay installed)
+void shutdownRuntime();
+
+RuntimeStatus runtimeStatus();
+
+// Team size for the engine's parallel regions
+int parallelThreads();
+
+#endif // LIFECYCLE_H
@@ -0,0 +1,370 @@
+#include "linalg.h"
+#include "lifecycle.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+bool choleskyFactor(std::vector<double>& a, size_t n) {
+    for (size_t j = 0; j < n; ++j) {
+        double* row_j = &a[j * n];
+        double diagonal = row_j[j];
+        for (size_t k = 0; k < j; ++k) {
+            diagonal -= row_j[k] * row_j[k];
+        }
+        if (!(diagonal > 0.0)) {
+            return false;
+        }
+        double pivot = std::sqrt(diagonal);
+        row_j[j] = pivot;
+
+        for (size_t i = j + 1; i < n; ++i) {
+            double* row_i = &a[i * n];
+            double sum = row_i[j];
+            for (size_t k = 0; k < j; ++k) {
+                sum -= row_i[k] * row_j[k];
+            }
+            row_i[j] = sum / pivot;
+        }
+        for (size_t k = j + 1; k < n; ++k) {
+            row_j[k] = 0.0;
+        }
+    }
+    return true;
+}
+
+void choleskySolve(const std::vector<double>& l, size_t n, std::vector<double>& b) {
+    // Forward substitution L y = b
+    for (size_t i = 0; i < n; ++i) {
+        const double* row = &l[i * n];
+        double sum = b[i];
+        for (size_t k = 0; k < i; ++k) {
+            sum -= row[k] * b[k];
+        }
+        b[i] = sum / row[i];
+    }
+    // Back substitution L' x = y
+    for (size_t i = n; i-- > 0;) {
+        double sum = b[i];
+        for (size_t k = i + 1; k < n; ++k) {
+            sum -= l[k * n + i] * b[k];
+        }
+        b[i] = sum / l[i * n + i];
+    }
+}
+
+void matrixVectorProduct(const std::vector<double>& a, size_t n,
+                         const std::vector<double>& x, std::vector<double>& out) {
+    for (size_t i = 0; i < n; ++i) {
+        const double* row = &a[i * n];
+        double sum = 0.0;
+        for (size_t j = 0; j < n; ++j) {
+            sum += row[j] * x[j];
+        }
+        out[i] = sum;
+    }
+}
+
+namespace {
+
+// Reduces the symmetric matrix to tridiagonal form T = Q' A Q with Householder reflections.
+// Row k of `reflectors` holds the unit Householder vector of step k (acting on rows k+1..n-1).
+void tridiagonalize(std::vector<double> work, size_t n, std::vector<double>& d,
+                    std::vector<double>& e, std::vector<double>& reflectors) {
+    d.assign(n, 0.0);
+    e.assign(n, 0.0);
+    reflectors.assign(n * n, 0.0);
+    std::vector<double> v(n), w(n);
+    for (size_t k = 0; k + 2 < n; ++k) {
+        size_t m = n - k - 1;
+        size_t offset = k + 1;
+        double norm = 0.0;
+        for (size_t i = 0; i < m; ++i) {
+            v[i] = work[(offset + i) * n + k];
+            norm += v[i] * v[i];
+        }
+        norm = std::sqrt(norm);
+        d[k] = work[k * n + k];
+        double alpha = v[0] > 0.0 ? -norm : norm;
+        e[k] = alpha;
+        v[0] -= alpha;
+        double v_norm = 0.0;
+        for (size_t i = 0; i < m; ++i) v_norm += v[i] * v[i];
+        v_norm = std::sqrt(v_norm);
+        if (v_norm == 0.0) continue;
+        for (size_t i = 0; i < m; ++i) {
+            v[i] /= v_norm;
+            reflectors[k * n + i] = v[i];
+        }
+
+        // w = 2 B v, q = w - (v'w) v, B <- B - v q' - q v' on the trailing block
+        #pragma omp parallel for schedule(static) if (m > 256) num_threads(parallelThreads())
+        for (long i = 0; i < static_cast<long>(m); ++i) {
+            const double* row = &work[(offset + i) * n + offset];
+            double sum = 0.0;
+            #pragma omp simd reduction(+:sum)
+            for (size_t j = 0; j < m; ++j) sum += row[j] * v[j];
+            w[i] = 2.0 * sum;
+        }
+        double vw = 0.0;
+        for (size_t i = 0; i < m; ++i) vw += v[i] * w[i];
+        for (size_t i = 0; i < m; ++i) w[i] -= vw * v[i];
+        #pragma omp parallel for schedule(static) if (m > 256) num_threads(parallelThreads())
+        for (long i = 0; i < static_cast<long>(m); ++i) {
+            double* row = &work[(offset + i) * n + offset];
+            double vi = v[i], wi = w[i];
+            #pragma omp simd
+            for (size_t j = 0; j < m; ++j) row[j] -= vi * w[j] + wi * v[j];
+        }
+    }
+    if (n >= 2) {
+        d[n - 2] = work[(n - 2) * n + n - 2];
+        e[n - 2] = work[(n - 1) * n + n - 2];
+    }
+    d[n - 1] = work[(n - 1) * n + n - 1];
+    e[n - 1] = 0.0;
+}
+
+// Implicit QL on the tridiagonal (d, e); d receives the eigenvalues. When z is given, the rotations
+// of each sweep are recorded and applied to its rows in parallel.
+bool tridiagonalQL(std::vector<double>& d, std::vector<double>& e, size_t n, std::vector<double>* z) {
+    std::vector<size_t> rot_index;
+    std::vector<double> rot_c, rot_s;
+    const double eps = std::numeric_limits<double>::epsilon();
+    for (size_t l = 0; l < n; ++l) {
+        int iterations = 0;
+        size_t m;
+        do {
+            for (m = l; m + 1 < n; ++m) {
+                double dd = std::abs(d[m]) + std::abs(d[m + 1]);
+                if (std::abs(e[m]) <= eps * dd) break;
+            }
+            if (m == l) break;
+            if (++iterations > 60) return false;
+
+            double g = (d[l + 1] - d[l]) / (2.0 * e[l]);
+            double r = std::hypot(g, 1.0);
+            g = d[m] - d[l] + e[l] / (g + (g >= 0.0 ? r : -r));
+            double s = 1.0, c = 1.0, p = 0.0;
+            bool deflated = false;
+            rot_index.clear();
+            rot_c.clear();
+            rot_s.clear();
+            for (size_t i = m; i-- > l;) {
+                double f = s * e[i];
+                double b = c * e[i];
+                r = std::hypot(f, g);
+                e[i + 1] = r;
+                if (r == 0.0) {
+                    d[i + 1] -= p;
+                    e[m] = 0.0;
+                    deflated = true;
+                    break;
+                }
+                s = f / r;
+                c = g / r;
+                g = d[i + 1] - p;
+                r = (d[i] - g) * s + 2.0 * c * b;
+                p = s * r;
+                d[i + 1] = g + p;
+                g = c * r - b;
+                if (z) {
+                    rot_index.push_back(i);
+                    rot_c.push_back(c);
+                    rot_s.push_back(s);
+                }
+            }
+            if (!deflated) {
+                d[l] -= p;
+                e[l] = g;
+                e[m] = 0.0;
+            }
+
+            if (z) {
+                size_t num_rotations = rot_index.size();
+                std::vector<double>& zm = *z;
+                #pragma omp parallel for schedule(static) if (n > 256) num_threads(parallelThreads())
+                for (long row = 0; row < static_cast<long>(n); ++row) {
+                    double* zr = &zm[row * n];
+                    for (size_t t = 0; t < num_rotations; ++t) {
+                        size_t i = rot_index[t];
+                        double f = zr[i + 1];
+                        zr[i + 1] = rot_s[t] * zr[i] + rot_c[t] * f;
+                        zr[i] = rot_c[t] * zr[i] - rot_s[t] * f;
+                    }
+                }
+            }
+        } while (m != l);
+    }
+    return true;
+}
+
+// Eigenvectors of the tridiagonal (d, e) for the given eigenvalues by inverse iteration, with
+// Gram-Schmidt against earlier vectors of the same cluster. Column j of the row-major n x k output.
+void tridiagonalInverseIteration(const std::vector<double>& d, const std::vector<double>& e, size_t n,
+                                 const std::vector<double>& lambdas, std::vector<double>& vectors) {
+    size_t k = lambdas.size();
+    vectors.assign(n * k, 0.0);
+    double norm = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        norm = std::max(norm, std::abs(d[i]) + std::abs(e[i]) + (i > 0 ? std::abs(e[i - 1]) : 0.0));
+    }
+    const double eps = std::numeric_limits<double>::epsilon();
+    double tiny = std::max(eps * norm, std::numeric_limits<double>::min());
+    double cluster = 1e-3 * norm;
+
+    std::vector<double> diag(n), sup(n), sup2(n), mult(n), x(n), y(n);
+    std::vector<char> swapped(n);
+    size_t cluster_start = 0;
+    for (size_t j = 0; j < k; ++j) {
+        if (j > 0 && std::abs(lambdas[j] - lambdas[j - 1]) > cluster) cluster_start = j;
+
+        // LU with partial pivoting of T - lambda I
+        std::vector<double> a(n), b(n, 0.0);
+        for (size_t i = 0; i < n; ++i) a[i] = d[i] - lambdas[j];
+        for (size_t i = 0; i + 1 < n; ++i) b[i] = e[i];
+        for (size_t i = 0; i + 1 < n; ++i) {
+            double c = e[i];
+            if (std::abs(a[i]) >= std::abs(c)) {
+                if (a[i] == 0.0) a[i] = tiny;
+                mult[i] = c / a[i];
+                diag[i] = a[i];
+                sup[i] = b[i];
+                sup2[i] = 0.0;
+                a[i + 1] -= mult[i] * b[i];
+                swapped[i] = 0;
+            } else {
+                mult[i] = a[i] / c;
+                diag[i] = c;
+                sup[i] = a[i + 1];
+                sup2[i] = b[i + 1];
+                a[i + 1] = b[i] - mult[i] * a[i + 1];
+                b[i + 1] = -mult[i] * b[i + 1];
+                swapped[i] = 1;
+            }
+        }
+        diag[n - 1] = a[n - 1] == 0.0 ? tiny : a[n - 1];
+        for (size_t i = 0; i < n; ++i) {
+            if (std::abs(diag[i]) < tiny) diag[i] = diag[i] < 0.0 ? -tiny : tiny;
+        }
+
+        // Deterministic, non-degenerate start vector
+        for (size_t i = 0; i < n; ++i) x[i] = 1.0 + 0.5 * std::sin(static_cast<double>(i * (j + 1)) + 0.3);
+
+        for (int iteration = 0; iteration < 4; ++iteration) {
+            y = x;
+            for (size_t i = 0; i + 1 < n; ++i) {
+                if (swapped[i]) std::swap(y[i], y[i + 1]);
+                y[i + 1] -= mult[i] * y[i];
+            }
+            for (size_t i = n; i-- > 0;) {
+                double sum = y[i];
+                if (i + 1 < n) sum -= sup[i] * y[i + 1];
+                if (i + 2 < n) sum -= sup2[i] * y[i + 2];
+                y[i] = sum / diag[i];
+            }
+            for (size_t q = cluster_start; q < j; ++q) {
+                double dot = 0.0;
+                for (size_t i = 0; i < n; ++i) dot += vectors[i * k + q] * y[i];
+                for (size_t i = 0; i < n; ++i) y[i] -= dot * vectors[i * k + q];
+            }
+            double y_norm = 0.0;
+            for (double v : y) y_norm += v * v;
+            y_norm = std::sqrt(y_norm);
+            for (size_t i = 0; i < n; ++i) x[i] = y[i] / y_norm;
+        }
+        for (size_t i = 0; i < n; ++i) vectors[i * k + j] = x[i];
+    }
+}
+
+} // namespace
+
+namespace {
+
+// Shared driver: choose_vectors sees the descending eigenvalues and returns how many vectors to form
+template <typename Chooser>
+bool eigenDecompose(const std::vector<double>& a, size_t n, std::vector<double>& eigenvalues,
+                    std::vector<double>& eigenvectors, Chooser choose_vectors) {
+    std::vector<double> d, e, reflectors;
+    tridiagonalize(a, n, d, e, reflectors);
+
+    // A few leading vectors: eigenvalues only, then O(n) inverse iteration per vector.
+    // Most of the spectrum: repeat QL accumulating the rotations instead.
+    std::vector<double> values = d, off = e, z;
+    if (!tridiagonalQL(values, off, n, nullptr)) {
+        return false;
+    }
+    std::vector<double> sorted = values;
+    std::sort(sorted.begin(), sorted.end(), std::greater<double>());
+    size_t num_vectors = std::min(choose_vectors(sorted), n);
+    bool accumulate = 4 * num_vectors > n;
+    if (accumulate) {
+        values = d;
+        off = e;
+        z.assign(n * n, 0.0);
+        for (size_t i = 0; i < n; ++i) z[i * n + i] = 1.0;
+        if (!tridiagonalQL(values, off, n, &z)) {
+            return false;
+        }
+    }
+
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&values](size_t x, size_t y) { return values[x] > values[y]; });
+    eigenvalues.resize(n);
+    for (size_t i = 0; i < n; ++i) eigenvalues[i] = values[order[i]];
+
+    if (accumulate) {
+        eigenvectors.assign(n * num_vectors, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < num_vectors; ++j) {
+                eigenvectors[i * num_vectors + j] = z[i * n + order[j]];
+            }
+        }
+    } else {
+        std::vector<double> wanted(eigenvalues.begin(), eigenvalues.begin() + num_vectors);
+        tridiagonalInverseIteration(d, e, n, wanted, eigenvectors);
+    }
+
+    // Back-transform X = H_0 H_1 ... H_{n-3} Z, each wanted column independently
+    #pragma omp parallel for schedule(dynamic) if (num_vectors > 1 && n > 128) num_threads(parallelThreads())
+    for (long j = 0; j < static_cast<long>(num_vectors); ++j) {
+        for (size_t k = n >= 2 ? n - 2 : 0; k-- > 0;) {
+            const double* h = &reflectors[k * n];
+            size_t m = n - k - 1;
+            double dot = 0.0;
+            for (size_t i = 0; i < m; ++i) dot += h[i] * eigenvectors[(k + 1 + i) * num_vectors + j];
+            if (dot == 0.0) continue;
+            dot *= 2.0;
+            for (size_t i = 0; i < m; ++i) eigenvectors[(k + 1 + i) * num_vectors + j] -= dot * h[i];
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool symmetricEigen(const std::vector<double>& a, size_t n, std::vector<double>& eigenvalues,
+                    std::vector<double>& eigenvectors, size_t num_vectors) {
+    return eigenDecompose(a, n, eigenvalues, eigenvectors,
+                          [num_vectors](const std::vector<double>&) { return num_vectors; });
+}
+
+size_t principalComponents(const std::vector<double>& a, size_t n, double variance_fraction,
+                           size_t max_components, std::vector<double>& eigenvalues,
+                           std::vector<double>& eigenvectors) {
+    size_t chosen = 0;
+    bool converged = eigenDecompose(a, n, eigenvalues, eigenvectors,
+        [&](const std::vector<double>& values) {
+            double total = 0.0;
+            for (double v : values) total += std::max(v, 0.0);
+            double retained = 0.0;
+            size_t limit = max_components > 0 ? std::min(max_components, n) : n;
+            while (chosen < limit && retained < variance_fraction * total) {
+                retained += std::max(values[chosen], 0.0);
+                ++chosen;
+            }
+            return std::max<size_t>(chosen, 1);
+        });
+    return converged ? std::max<size_t>(chosen, 1) : 0;
+}
@@ -0,0 +1,32 @@
+#ifndef LINALG_H
+#define LINALG_H
+
+#include <vector>
+#include <cstddef>
+
+// Dense helpers on row-major n x n matrices stored in a flat vector
+
+// In-place Cholesky factorization A = L L'. On success the lower triangle holds L and the
+// strict upper triangle is zeroed. Returns false if a non-positive pivot is encountered.
+bool choleskyFactor(std::vector<double>& a, size_t n);
+
+// Solves L L' x = b in place given the factor produced by choleskyFactor
+void choleskySolve(const std::vector<double>& l, size_t n, std::vector<double>& b);
+
+// out = A x
+void matrixVectorProduct(const std::vector<double>& a, size_t n,
+                         const std::vector<double>& x, std::vector<double>& out);
+
+// Eigendecomposition of a symmetric matrix: Householder tridiagonalization followed by implicit
+// QL. Eigenvalues are returned in descending order; eigenvectors holds the leading num_vectors
+// eigenvectors as columns of a row-major n x num_vectors matrix. Returns false if QL does not converge.
+bool symmetricEigen(const std::vector<double>& a, size_t n, std::vector<double>& eigenvalues,
+                    std::vector<double>& eigenvectors, size_t num_vectors);
+
+// Leading eigenpairs of a symmetric positive semi-definite matrix covering variance_fraction of its
+// trace (at most max_components, 0 = no cap). Returns the number of components, 0 if QL fails.
+size_t principalComponents(const std::vector<double>& a, size_t n, double variance_fraction,
+                           size_t max_components, std::vector<double>& eigenvalues,
+                           std::vector<double>& eigenvectors);
+
+#endif // LINALG_H
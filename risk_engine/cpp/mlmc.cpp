@@ -0,0 +1,137 @@
+#include "mlmc.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Weak-order exponent from a log-linear fit of |E[P_l - P_{l-1}]| over levels 1..L
+double fitDecayRate(const std::vector<double>& means, double refinement) {
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    size_t points = 0;
+    for (size_t l = 1; l < means.size(); ++l) {
+        if (means[l] <= 0.0) continue;
+        double x = static_cast<double>(l);
+        double y = std::log(means[l]) / std::log(refinement);
+        sx += x; sy += y; sxx += x * x; sxy += x * y;
+        ++points;
+    }
+    if (points < 2) return 0.5;
+    double slope = (points * sxy - sx * sy) / (points * sxx - sx * sx);
+    return std::max(0.5, -slope);
+}
+
+} // namespace
+
+MultilevelResult runMultilevel(const LevelSampler& sampler, const MultilevelSettings& settings) {
+    if (!(settings.target_rmse > 0.0)) {
+        throw std::invalid_argument("Target RMSE must be positive");
+    }
+    if (settings.base_steps == 0 || settings.refinement < 2) {
+        throw std::invalid_argument("Need at least one base step and a refinement factor of 2 or more");
+    }
+    if (settings.min_levels < 2 || settings.max_levels < settings.min_levels) {
+        throw std::invalid_argument("Level bounds must satisfy 2 <= min_levels <= max_levels");
+    }
+    if (settings.pilot_samples < 2) {
+        throw std::invalid_argument("Need at least two pilot samples per level");
+    }
+
+    double refinement = static_cast<double>(settings.refinement);
+    double variance_budget = 0.5 * settings.target_rmse * settings.target_rmse;
+    size_t levels = settings.min_levels;
+    std::vector<LevelSums> sums;
+    std::vector<size_t> samples, extra;
+    std::vector<double> costs, means, variances;
+    uint64_t stream = 0;
+
+    auto addLevel = [&]() {
+        size_t l = sums.size();
+        double fine = static_cast<double>(settings.base_steps) * std::pow(refinement, static_cast<double>(l));
+        costs.push_back(l == 0 ? fine : fine + fine / refinement);
+        sums.push_back(LevelSums{0.0, 0.0, 0.0, 0.0});
+        samples.push_back(0);
+        extra.push_back(settings.pilot_samples);
+        means.push_back(0.0);
+        variances.push_back(0.0);
+    };
+    for (size_t l = 0; l < levels; ++l) addLevel();
+
+    MultilevelResult result;
+    result.converged = false;
+    result.bias_estimate = 0.0;
+    while (true) {
+        // Draw the outstanding samples, then refresh the level statistics
+        for (size_t l = 0; l < levels; ++l) {
+            if (extra[l] == 0) continue;
+            LevelSums batch = sampler(l, extra[l], stream++);
+            sums[l].sum += batch.sum;
+            sums[l].sum_squares += batch.sum_squares;
+            sums[l].fine_sum += batch.fine_sum;
+            sums[l].fine_sum_squares += batch.fine_sum_squares;
+            samples[l] += extra[l];
+            extra[l] = 0;
+        }
+        for (size_t l = 0; l < levels; ++l) {
+            double count = static_cast<double>(samples[l]);
+            means[l] = sums[l].sum / count;
+            variances[l] = std::max(0.0, sums[l].sum_squares / count - means[l] * means[l]);
+        }
+
+        // Optimal allocation N_l = sqrt(V_l / C_l) * sum_k sqrt(V_k C_k) / variance budget
+        double weight = 0.0;
+        for (size_t l = 0; l < levels; ++l) {
+            weight += std::sqrt(variances[l] * costs[l]);
+        }
+        bool pending = false;
+        for (size_t l = 0; l < levels; ++l) {
+            double target = std::ceil(std::sqrt(variances[l] / costs[l]) * weight / variance_budget);
+            if (target > static_cast<double>(samples[l])) {
+                extra[l] = static_cast<size_t>(target) - samples[l];
+                // Ignore top-ups under 1% of what the level already has
+                if (extra[l] * 100 > samples[l]) pending = true; else extra[l] = 0;
+            }
+        }
+        if (pending) continue;
+
+        // Richardson-style bias estimate from the two finest corrections
+        std::vector<double> magnitudes(levels);
+        for (size_t l = 0; l < levels; ++l) magnitudes[l] = std::abs(means[l]);
+        double alpha = fitDecayRate(magnitudes, refinement);
+        double ratio = std::pow(refinement, alpha);
+        double bias = std::max(magnitudes[levels - 1], magnitudes[levels - 2] / ratio) / (ratio - 1.0);
+        result.bias_estimate = bias;
+        if (bias <= settings.target_rmse / std::sqrt(2.0)) {
+            result.converged = true;
+            break;
+        }
+        if (levels == settings.max_levels) break;
+        addLevel();
+        ++levels;
+    }
+
+    result.estimate = 0.0;
+    double estimator_variance = 0.0;
+    result.total_cost = 0.0;
+    for (size_t l = 0; l < levels; ++l) {
+        result.estimate += means[l];
+        estimator_variance += variances[l] / static_cast<double>(samples[l]);
+        result.total_cost += costs[l] * static_cast<double>(samples[l]);
+    }
+    result.standard_error = std::sqrt(estimator_variance);
+
+    // Plain Monte Carlo at the finest resolution with the same variance budget
+    const LevelSums& finest = sums[levels - 1];
+    double count = static_cast<double>(samples[levels - 1]);
+    double fine_mean = finest.fine_sum / count;
+    double fine_variance = std::max(0.0, finest.fine_sum_squares / count - fine_mean * fine_mean);
+    double fine_steps = static_cast<double>(settings.base_steps) *
+                        std::pow(refinement, static_cast<double>(levels - 1));
+    result.single_level_cost = std::ceil(fine_variance / variance_budget) * fine_steps;
+
+    result.samples = samples;
+    result.level_means = means;
+    result.level_variances = variances;
+    result.level_costs = costs;
+    return result;
+}
@@ -0,0 +1,50 @@
+#ifndef MLMC_H
+#define MLMC_H
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+struct MultilevelSettings {
+    double target_rmse;    // Root-mean-square error target, split evenly between bias and variance
+    size_t base_steps;     // Time steps on level 0
+    size_t refinement;     // Step multiplier between consecutive levels
+    size_t min_levels;     // Levels sampled before the bias test is applied
+    size_t max_levels;     // Hard cap on levels
+    size_t pilot_samples;  // Samples drawn on a level before its variance is trusted
+    uint64_t seed;         // 0 = random seed
+
+    MultilevelSettings()
+        : target_rmse(1e-3), base_steps(4), refinement(2), min_levels(3), max_levels(12),
+          pilot_samples(2000), seed(0) {}
+};
+
+struct MultilevelResult {
+    double estimate;                    // Sum of the level means
+    double standard_error;              // Statistical error of the estimate
+    double bias_estimate;               // Extrapolated discretization bias of the finest level
+    bool converged;                     // False when max_levels was hit before the bias test passed
+    std::vector<size_t> samples;        // Samples per level
+    std::vector<double> level_means;    // Mean of P_l - P_{l-1} (P_0 on level 0)
+    std::vector<double> level_variances; // Variance of P_l - P_{l-1}
+    std::vector<double> level_costs;    // Time steps simulated per sample (fine plus coarse)
+    double total_cost;                  // Time steps simulated in total
+    double single_level_cost;           // Steps plain Monte Carlo on the finest level would need
+};
+
+// Coupled draws on one level: sums of Y = P_l - P_{l-1} (P_{-1} = 0) and of the fine P_l.
+// `stream` is unique per call so that samplers can derive independent, reproducible seeds.
+struct LevelSums {
+    double sum;
+    double sum_squares;
+    double fine_sum;
+    double fine_sum_squares;
+};
+using LevelSampler = std::function<LevelSums(size_t level, size_t samples, uint64_t stream)>;
+
+// Giles (2008) adaptive multilevel Monte Carlo: per-level sample counts N_l proportional to
+// sqrt(V_l / C_l), new levels added until the extrapolated bias drops below target_rmse / sqrt(2).
+MultilevelResult runMultilevel(const LevelSampler& sampler, const MultilevelSettings& settings);
+
+#endif // MLMC_H
@@ -1,38 +1,316 @@
 #include "montecarlo.h"
+#include "projections.h"
+#include "linalg.h"
+#include "sobol.h"
+#include "brownian_bridge.h"
+#include "vecmath.h"
+#include "philox.h"
+#include "validation.h"
+#include "lifecycle.h"
+#include "factor_cache.h"
+#include "huge_pages.h"
+#include "reduction.h"
 #include <algorithm>
 #include <cmath>
 #include <omp.h>
 #include <stdexcept>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <mutex>
+
+namespace {
+
+// Runs and queries share the engine state; setters replace it exclusively
+using ReadLock = std::shared_lock<std::shared_mutex>;
+using WriteLock = std::unique_lock<std::shared_mutex>;
+
+// Correlation input tolerances: asymmetry beyond rounding, diagonal within 1%
+const double kSymmetryTolerance = 1e-10;
+const double kDiagonalTolerance = 0.01;
+
+// Scenarios generated per RNG/transform/revaluation pass
+const size_t kScenarioBlock = 256;
+
+// Cap on normals held per pass, so very wide universes use shorter blocks
+const size_t kScenarioBlockValues = 1 << 18;
+
+// Paths simulated together by simulatePaths; rows of this length are the SIMD lanes
+const size_t kPathBlock = 64;
+
+// Coupled samples per RNG stream in estimatePathMetric
+const size_t kMultilevelBlock = 256;
+
+// Broadie-Glasserman-Kou continuity correction beta = -zeta(1/2) / sqrt(2 pi)
+const double kMonitoringShift = 0.5825971579390106;
+
+struct TailEstimate {
+    double var;
+    double cvar;
+    double var_std_error;
+    double cvar_std_error;
+};
+
+// VaR/CVaR of the loss -r when scenarios [begin[s], begin[s+1]) sample stratum s of probability
+// mass[s]. Standard errors use the within-stratum variances: the quantile's through the tail
+// probability and a kernel density at the quantile, the CVaR's through E[(L - VaR)^+].
+TailEstimate stratifiedTailEstimate(const LargeVector<double>& returns, const std::vector<size_t>& begin,
+                                    const std::vector<double>& mass, double confidence) {
+    size_t num = returns.size();
+    size_t strata = mass.size();
+    double alpha = 1.0 - confidence;
+    
+    std::vector<std::pair<double, double>> sorted(num);
+    for (size_t s = 0; s < strata; ++s) {
+        double weight = mass[s] / static_cast<double>(begin[s + 1] - begin[s]);
+        for (size_t k = begin[s]; k < begin[s + 1]; ++k) {
+            sorted[k] = std::make_pair(returns[k], weight);
+        }
+    }
+    std::array<double, 2> moments = chunkedSums<2>(num, [&sorted](size_t first, size_t last) {
+        std::array<double, 2> sums = {0.0, 0.0};
+        for (size_t k = first; k < last; ++k) {
+            double r = sorted[k].first, weight = sorted[k].second;
+            sums[0] += weight * r;
+            sums[1] += weight * r * r;
+        }
+        return sums;
+    });
+    double mean = moments[0], second = moments[1];
+    std::sort(sorted.begin(), sorted.end());
+    double cumulative = 0.0;
+    size_t index = 0;
+    while (index + 1 < num && cumulative + sorted[index].second < alpha) {
+        cumulative += sorted[index].second;
+        ++index;
+    }
+    double quantile = sorted[index].first;
+    
+    TailEstimate estimate;
+    estimate.var = -quantile;
+    double tail_variance = 0.0, excess_variance = 0.0, excess_mean = 0.0;
+    for (size_t s = 0; s < strata; ++s) {
+        double count = static_cast<double>(begin[s + 1] - begin[s]);
+        const double* r = returns.data() + begin[s];
+        std::array<double, 3> sums = chunkedSums<3>(begin[s + 1] - begin[s], [r, quantile](size_t first, size_t last) {
+            std::array<double, 3> chunk = {0.0, 0.0, 0.0}; // Count below the quantile, excess, excess^2
+            for (size_t k = first; k < last; ++k) {
+                double shortfall = std::max(quantile - r[k], 0.0);
+                chunk[0] += r[k] <= quantile ? 1.0 : 0.0;
+                chunk[1] += shortfall;
+                chunk[2] += shortfall * shortfall;
+            }
+            return chunk;
+        });
+        double below = sums[0], excess = sums[1], excess_squares = sums[2];
+        double f = below / count, e = excess / count;
+        excess_mean += mass[s] * e;
+        tail_variance += mass[s] * mass[s] * f * (1.0 - f) / count;
+        excess_variance += mass[s] * mass[s] * std::max(excess_squares / count - e * e, 0.0) / count;
+    }
+    estimate.cvar = estimate.var + excess_mean / alpha;
+    estimate.cvar_std_error = std::sqrt(excess_variance) / alpha;
+    
+    // Gaussian kernel density of the return at the quantile, Silverman bandwidth
+    double sd = std::sqrt(std::max(second - mean * mean, 0.0));
+    double bandwidth = 1.06 * sd * std::pow(static_cast<double>(num), -0.2);
+    double density = 0.0;
+    if (bandwidth > 0.0) {
+        density = chunkedSums<1>(num, [&sorted, quantile, bandwidth](size_t first, size_t last) {
+            double sum = 0.0;
+            for (size_t k = first; k < last; ++k) {
+                double u = (quantile - sorted[k].first) / bandwidth;
+                sum += sorted[k].second * vecmath::normPdf(u) / bandwidth;
+            }
+            return std::array<double, 1>{sum};
+        })[0];
+    }
+    estimate.var_std_error = density > 0.0 ? std::sqrt(tail_variance) / density : 0.0;
+    return estimate;
+}
+
+// Loss at the confidence level from returns already sorted ascending, as calculateVaR
+double sortedVaR(const LargeVector<double>& sorted, double confidence) {
+    size_t index = std::min(static_cast<size_t>((1.0 - confidence) * sorted.size()), sorted.size() - 1);
+    return -sorted[index];
+}
+
+// Liquidity-adjusted portfolio return as an affine map of the simulated horizon asset returns
+struct LiquidityAdjustment {
+    std::vector<double> weights; // Per-asset multiplier on the horizon return
+    double offset;               // Extra drift over the longer horizons, net of impact cost
+    double cost;                 // Impact cost of the full exit
+    std::vector<double> days;    // Unwind time of each position in trading days
+};
+
+// A position sold in equal slices over D days carries the variance of (D + 1)(2D + 1) / 6D days of
+// full holding and the drift of (D + 1) / 2 days; neither horizon drops below the VaR horizon. With
+// r_i = mu_i T + sigma_i sqrt(T) e_i, rescaling by sqrt(V_i / T) gives the V_i-horizon shock.
+LiquidityAdjustment liquidityAdjustment(const std::vector<PortfolioAsset>& portfolio,
+                                        const LiquidityProfile& profile, double horizon) {
+    size_t n = portfolio.size();
+    double days_per_year = profile.trading_days_per_year;
+    double horizon_days = horizon * days_per_year;
+    LiquidityAdjustment adjustment;
+    adjustment.weights.resize(n);
+    adjustment.days.resize(n);
+    adjustment.offset = 0.0;
+    adjustment.cost = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const PortfolioAsset& asset = portfolio[i];
+        double position = std::abs(asset.weight) * profile.portfolio_value;
+        double volume = profile.average_daily_volume[i];
+        double days = std::max(1.0, position / (profile.participation_rate * volume));
+        double variance_days = std::max(horizon_days, (days + 1.0) * (2.0 * days + 1.0) / (6.0 * days));
+        double drift_days = std::max(horizon_days, 0.5 * (days + 1.0));
+        double scale = std::sqrt(variance_days / horizon_days);
+        double impact = profile.impact_coefficient * asset.volatility / std::sqrt(days_per_year) *
+                        std::sqrt(position / volume);
+        adjustment.weights[i] = asset.weight * scale;
+        adjustment.offset += asset.weight * asset.expected_return * (drift_days / days_per_year - scale * horizon);
+        adjustment.cost += std::abs(asset.weight) * impact;
+        adjustment.days[i] = days;
+    }
+    adjustment.offset -= adjustment.cost;
+    return adjustment;
+}
+
+// Mixing draws per seeded block in the conditional estimator
+const size_t kMixingBlock = 4096;
+
+// VaR/CVaR of the loss -r when r is an equal-weight mixture of N(means[j], vols[j]^2). The VaR solves
+// the mixture tail equation by safeguarded Newton; the CVaR is VaR + E[(L - VaR)^+] / alpha with each
+// component's excess in closed form. Standard errors come from the spread of the per-component terms.
+TailEstimate mixtureTailEstimate(const std::vector<double>& means, const std::vector<double>& vols,
+                                 double confidence) {
+    size_t num = means.size();
+    double alpha = 1.0 - confidence;
+    const double* m = means.data();
+    const double* s = vols.data();
+    
+    // Tail probability P(L >= x) and its negative slope, the loss density
+    auto tail = [&](double x, double& density) {
+        std::array<double, 2> sums = chunkedSums<2>(num, [m, s, x](size_t first, size_t last) {
+            double probability = 0.0, pdf = 0.0;
+            #pragma omp simd reduction(+:probability, pdf)
+            for (size_t j = first; j < last; ++j) {
+                double z = (-x - m[j]) / s[j];
+                probability += vecmath::normCdf(z);
+                pdf += vecmath::normPdf(z) / s[j];
+            }
+            return std::array<double, 2>{probability, pdf};
+        });
+        density = sums[1] / num;
+        return sums[0] / num;
+    };
+    
+    double lo = std::numeric_limits<double>::infinity(), hi = -lo;
+    for (size_t j = 0; j < num; ++j) {
+        lo = std::min(lo, -m[j] - 10.0 * s[j]);
+        hi = std::max(hi, -m[j] + 10.0 * s[j]);
+    }
+    double x = 0.5 * (lo + hi), density = 0.0;
+    double gap_lo = 1.0 - alpha, gap_hi = -alpha; // Tail probability is ~1 at lo and ~0 at hi
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        double gap = tail(x, density) - alpha;
+        if (gap > 0.0) {
+            lo = x;
+            gap_lo = gap;
+        } else {
+            hi = x;
+            gap_hi = gap;
+        }
+        // Newton, else false position: a root next to a bracket end is found without bisecting down to it
+        double next = density > 0.0 ? x + gap / density : lo;
+        if (!(next > lo && next < hi)) next = lo + (hi - lo) * gap_lo / (gap_lo - gap_hi);
+        if (!(next > lo && next < hi)) next = 0.5 * (lo + hi);
+        if (std::abs(next - x) <= 1e-14 * std::max(1.0, std::abs(x)) || hi - lo <= 1e-15) {
+            x = next;
+            break;
+        }
+        x = next;
+    }
+    tail(x, density);
+    
+    std::array<double, 4> sums = chunkedSums<4>(num, [m, s, x](size_t first, size_t last) {
+        double probability_sum = 0.0, probability_squares = 0.0, excess_sum = 0.0, excess_squares = 0.0;
+        #pragma omp simd reduction(+:probability_sum, probability_squares, excess_sum, excess_squares)
+        for (size_t j = first; j < last; ++j) {
+            // Loss ~ N(-m, s^2): P(L >= x) and E[(L - x)^+]
+            double z = (-x - m[j]) / s[j];
+            double probability = vecmath::normCdf(z);
+            double excess = (-m[j] - x) * probability + s[j] * vecmath::normPdf(z);
+            probability_sum += probability;
+            probability_squares += probability * probability;
+            excess_sum += excess;
+            excess_squares += excess * excess;
+        }
+        return std::array<double, 4>{probability_sum, probability_squares, excess_sum, excess_squares};
+    });
+    double probability_sum = sums[0], probability_squares = sums[1], excess_sum = sums[2], excess_squares = sums[3];
+    double count = static_cast<double>(num);
+    double probability_mean = probability_sum / count, excess_mean = excess_sum / count;
+    double probability_variance = std::max(probability_squares / count - probability_mean * probability_mean, 0.0);
+    double excess_variance = std::max(excess_squares / count - excess_mean * excess_mean, 0.0);
+    
+    TailEstimate estimate;
+    estimate.var = x;
+    estimate.cvar = x + excess_mean / alpha;
+    estimate.var_std_error = density > 0.0 ? std::sqrt(probability_variance / count) / density : 0.0;
+    estimate.cvar_std_error = std::sqrt(excess_variance / count) / alpha;
+    return estimate;
+}
+
+// Validated Cholesky factor of a correlation matrix. Only matrices that passed the check are cached,
+// so a fingerprint hit skips both the validation and the O(n^3) factorization.
+std::vector<std::vector<double>> validatedFactor(const std::vector<std::vector<double>>& matrix, size_t n) {
+    std::vector<std::vector<double>> factor;
+    MatrixFingerprint fingerprint = fingerprintMatrix(matrix);
+    if (lookupFactor(fingerprint, n, factor)) {
+        return factor;
+    }
+    CorrelationCheck check = checkCorrelationMatrix(matrix, n, kSymmetryTolerance, kDiagonalTolerance, &factor);
+    if (!check.valid()) {
+        throw std::invalid_argument(check.message);
+    }
+    storeFactor(fingerprint, factor);
+    return factor;
+}
+
+} // namespace
 
 MonteCarloRiskEngine::MonteCarloRiskEngine(const std::vector<PortfolioAsset>& assets,
                                          const std::vector<std::vector<double>>& corr_matrix,
                                          int simulations,
                                          double horizon) 
     : portfolio(assets), correlation_matrix(corr_matrix), 
-      num_simulations(simulations), time_horizon(horizon) {
+      num_simulations(simulations), time_horizon(horizon),
+      option_revaluation(OptionRevaluation::FULL), portfolio_value(0.0),
+      bond_book(), num_curve_factors(0), num_sentiment_factors(0), pca_variance_target(0.0), pca_max_factors(0),
+      num_pca_factors(0), pca_retained_variance(1.0) {
     
     // Validate inputs
     if (portfolio.empty()) {
         throw std::invalid_argument("Portfolio cannot be empty");
     }
     
-    if (correlation_matrix.size() != portfolio.size() || 
-        correlation_matrix[0].size() != portfolio.size()) {
-        throw std::invalid_argument("Correlation matrix dimensions must match portfolio size");
-    }
-    
-    // Validate correlation matrix is symmetric and positive definite (basic check)
-    for (size_t i = 0; i < correlation_matrix.size(); ++i) {
-        for (size_t j = 0; j < correlation_matrix[i].size(); ++j) {
-            if (std::abs(correlation_matrix[i][j] - correlation_matrix[j][i]) > 1e-10) {
-                throw std::invalid_argument("Correlation matrix must be symmetric");
-            }
-        }
-        if (correlation_matrix[i][i] < 0.99 || correlation_matrix[i][i] > 1.01) {
-            throw std::invalid_argument("Diagonal elements of correlation matrix should be 1");
-        }
+    // Shape, symmetry, range, unit diagonal and positive definiteness, fused with the factorization
+    cholesky_factor = validatedFactor(correlation_matrix, portfolio.size());
+}
+
+MonteCarloRiskEngine::MonteCarloRiskEngine(const std::vector<PortfolioAsset>& assets,
+                                         const BlockCorrelationModel& correlation_model,
+                                         int simulations,
+                                         double horizon)
+    : portfolio(assets), num_simulations(simulations), time_horizon(horizon),
+      option_revaluation(OptionRevaluation::FULL), portfolio_value(0.0),
+      bond_book(), num_curve_factors(0), num_sentiment_factors(0), pca_variance_target(0.0), pca_max_factors(0),
+      num_pca_factors(0), pca_retained_variance(1.0) {
+
+    if (portfolio.empty()) {
+        throw std::invalid_argument("Portfolio cannot be empty");
     }
+    block_correlation = std::make_shared<const BlockCorrelationFactor>(correlation_model, portfolio.size());
 }
 
 std::vector<std::vector<double>> MonteCarloRiskEngine::choleskyDecomposition(
@@ -61,41 +339,373 @@ std::vector<std::vector<double>> MonteCarloRiskEngine::choleskyDecomposition(
     return L;
 }
 
-std::vector<double> MonteCarloRiskEngine::generateCorrelatedReturns(
-    std::mt19937& gen, const std::vector<std::vector<double>>& cholesky) {
+std::vector<std::vector<double>> MonteCarloRiskEngine::jointCholeskyFactor(
+    const std::vector<std::vector<double>>& correlation) {
+    if (num_curve_factors == 0 && num_sentiment_factors == 0) {
+        return choleskyDecomposition(correlation);
+    }
     
-    std::normal_distribution<double> normal_dist(0.0, 1.0);
+    // [[C, X], [X', C_f]]: the leading block of its factor is the factor of C, so
+    // equity-only consumers of cholesky_factor are unaffected by the extra rows.
+    // The sentiment shock is the last row, uncorrelated with the curve factors.
     size_t n = portfolio.size();
+    size_t dims = n + num_curve_factors + num_sentiment_factors;
+    std::vector<std::vector<double>> augmented(dims, std::vector<double>(dims, 0.0));
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            augmented[i][j] = correlation[i][j];
+        }
+        for (size_t k = 0; k < num_curve_factors; ++k) {
+            augmented[i][n + k] = augmented[n + k][i] = yield_curve.asset_correlation[i][k];
+        }
+    }
+    for (size_t k = 0; k < num_curve_factors; ++k) {
+        for (size_t l = 0; l < num_curve_factors; ++l) {
+            augmented[n + k][n + l] = yield_curve.factor_correlation[k][l];
+        }
+    }
+    if (num_sentiment_factors > 0) {
+        size_t s = n + num_curve_factors;
+        for (size_t i = 0; i < n; ++i) {
+            augmented[i][s] = augmented[s][i] = sentiment.asset_correlation[i];
+        }
+        augmented[s][s] = 1.0;
+    }
+    
+    std::vector<std::vector<double>> factor = choleskyDecomposition(augmented);
+    for (size_t i = 0; i < dims; ++i) {
+        if (!(factor[i][i] > 0.0)) {
+            throw std::invalid_argument("Joint asset and factor correlation is not positive definite");
+        }
+    }
+    return factor;
+}
+
+void MonteCarloRiskEngine::refreshCholeskyFactor() {
+    cholesky_factor = jointCholeskyFactor(correlation_matrix);
+}
+
+void MonteCarloRiskEngine::refreshPrincipalComponents() {
+    num_pca_factors = 0;
+    pca_retained_variance = 1.0;
+    pca_loadings.clear();
+    pca_residual_vol.clear();
+    if (pca_variance_target <= 0.0) return;
     
-    // Generate independent normal random variables
-    std::vector<double> independent(n);
+    size_t n = portfolio.size();
+    std::vector<double> flat(n * n), eigenvalues, eigenvectors;
     for (size_t i = 0; i < n; ++i) {
-        independent[i] = normal_dist(gen);
+        for (size_t j = 0; j < n; ++j) {
+            flat[i * n + j] = correlation_matrix[i][j];
+        }
+    }
+    size_t k = principalComponents(flat, n, pca_variance_target, pca_max_factors, eigenvalues, eigenvectors);
+    if (k == 0) {
+        throw std::invalid_argument("Eigendecomposition of the correlation matrix did not converge");
     }
     
-    // Transform to correlated returns
-    std::vector<double> correlated_returns(n);
+    double trace = 0.0, retained = 0.0;
+    for (size_t j = 0; j < n; ++j) trace += std::max(eigenvalues[j], 0.0);
+    pca_loadings.assign(n * k, 0.0);
+    pca_residual_vol.assign(n, 0.0);
+    for (size_t j = 0; j < k; ++j) {
+        double lambda = std::max(eigenvalues[j], 0.0);
+        retained += lambda;
+        double scale = std::sqrt(lambda);
+        for (size_t i = 0; i < n; ++i) {
+            pca_loadings[i * k + j] = eigenvectors[i * k + j] * scale;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        double explained = 0.0;
+        for (size_t j = 0; j < k; ++j) {
+            explained += pca_loadings[i * k + j] * pca_loadings[i * k + j];
+        }
+        pca_residual_vol[i] = std::sqrt(std::max(1.0 - explained, 0.0));
+    }
+    num_pca_factors = k;
+    pca_retained_variance = trace > 0.0 ? retained / trace : 1.0;
+}
+
+size_t MonteCarloRiskEngine::normalsPerScenario() const {
+    if (block_correlation) return block_correlation->normalsPerScenario();
+    size_t n = portfolio.size();
+    return num_pca_factors > 0 ? num_pca_factors + n : n + num_curve_factors + num_sentiment_factors;
+}
+
+std::vector<double> MonteCarloRiskEngine::equityShockLoadings() const {
+    size_t n = portfolio.size();
+    std::vector<double> exposure(n);
+    for (size_t i = 0; i < n; ++i) {
+        exposure[i] = portfolio[i].weight * portfolio[i].volatility;
+    }
+    if (block_correlation) {
+        return block_correlation->pullBack(exposure);
+    }
+    std::vector<double> loadings(n, 0.0);
     for (size_t i = 0; i < n; ++i) {
-        correlated_returns[i] = portfolio[i].expected_return * time_horizon;
-        double volatility_component = 0.0;
         for (size_t j = 0; j <= i; ++j) {
-            volatility_component += cholesky[i][j] * independent[j];
+            loadings[j] += exposure[i] * cholesky_factor[i][j];
         }
-        correlated_returns[i] += portfolio[i].volatility * std::sqrt(time_horizon) * volatility_component;
     }
+    return loadings;
+}
+
+std::vector<double> MonteCarloRiskEngine::linearExposure() const {
+    // Linear return exposure per unit asset shock, including option deltas, the bond book and sentiment
+    size_t n = portfolio.size();
+    std::vector<double> effective_weights(n);
+    for (size_t i = 0; i < n; ++i) {
+        effective_weights[i] = portfolio[i].weight;
+    }
+    for (size_t k = 0; k < option_positions.size(); ++k) {
+        const EuropeanOption& option = option_positions[k];
+        effective_weights[option.underlying] += option.quantity * option_greeks[k].delta * option.spot /
+                                                portfolio_value;
+    }
+    std::vector<double> exposure(n + num_curve_factors + num_sentiment_factors, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        exposure[i] = effective_weights[i] * portfolio[i].volatility;
+    }
+    for (size_t k = 0; k < num_curve_factors; ++k) {
+        exposure[n + k] = -bond_book.exposure[k] * yield_curve.factor_volatilities[k];
+    }
+    for (size_t i = 0; i < n && num_sentiment_factors > 0; ++i) {
+        exposure[n + num_curve_factors] += effective_weights[i] * sentiment.loadings[i];
+    }
+    return exposure;
+}
+
+std::vector<double> MonteCarloRiskEngine::lossDirection() const {
+    size_t n = portfolio.size();
+    std::vector<double> exposure = linearExposure();
     
-    return correlated_returns;
+    // Pull the exposure back into normal space: return = sqrt(T) a'z
+    size_t dims = normalsPerScenario();
+    std::vector<double> a(dims, 0.0);
+    if (block_correlation) {
+        a = block_correlation->pullBack(exposure);
+    } else if (num_pca_factors > 0) {
+        size_t k = num_pca_factors;
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < k; ++j) {
+                a[j] += exposure[i] * pca_loadings[i * k + j];
+            }
+            a[k + i] = exposure[i] * pca_residual_vol[i];
+        }
+    } else {
+        for (size_t i = 0; i < dims; ++i) {
+            for (size_t j = 0; j <= i; ++j) {
+                a[j] += exposure[i] * cholesky_factor[i][j];
+            }
+        }
+    }
+    double norm = 0.0;
+    for (double v : a) norm += v * v;
+    norm = std::sqrt(norm);
+    if (norm == 0.0) {
+        a.assign(dims, 0.0);
+        a[0] = 1.0;
+        norm = 1.0;
+    }
+    for (double& v : a) v /= norm;
+    return a;
 }
 
-double MonteCarloRiskEngine::calculatePortfolioReturn(const std::vector<double>& asset_returns) {
-    double portfolio_return = 0.0;
-    for (size_t i = 0; i < portfolio.size(); ++i) {
-        portfolio_return += portfolio[i].weight * asset_returns[i];
+MonteCarloRiskEngine::ScenarioPlan MonteCarloRiskEngine::planScenarios(size_t num_scenarios) const {
+    ScenarioPlan plan;
+    plan.key = 0;
+    if (sampling.rng == ScenarioRng::PHILOX) {
+        std::random_device seed_source;
+        plan.key = sampling.seed != 0 ? sampling.seed : (uint64_t(seed_source()) << 32) | seed_source();
+    }
+    size_t strata = sampling.num_strata;
+    if (strata == 0) {
+        return plan;
+    }
+    if (num_scenarios < 2 * strata) {
+        throw std::invalid_argument("Need at least two scenarios per stratum");
+    }
+    
+    // Loss-side strata come first (low values of the return coordinate)
+    size_t tail_strata = 0;
+    if (sampling.tail_allocation > 0.0) {
+        double rounded = std::round(sampling.tail_fraction * static_cast<double>(strata));
+        tail_strata = std::min(strata - 1, std::max<size_t>(1, static_cast<size_t>(rounded)));
     }
-    return portfolio_return;
+    std::vector<double>& stratum_mass = plan.stratum_mass;
+    std::vector<size_t>& stratum_begin = plan.stratum_begin;
+    stratum_mass.assign(strata, 1.0 / static_cast<double>(strata));
+    stratum_begin.assign(strata + 1, 0);
+    double share = 0.0;
+    for (size_t s = 0; s < strata; ++s) {
+        if (tail_strata == 0) {
+            share += 1.0 / static_cast<double>(strata);
+        } else if (s < tail_strata) {
+            share += sampling.tail_allocation / static_cast<double>(tail_strata);
+        } else {
+            share += (1.0 - sampling.tail_allocation) / static_cast<double>(strata - tail_strata);
+        }
+        stratum_begin[s + 1] = std::min(num_scenarios,
+            static_cast<size_t>(std::llround(share * static_cast<double>(num_scenarios))));
+    }
+    stratum_begin[strata] = num_scenarios;
+    for (size_t s = 0; s < strata; ++s) {
+        if (stratum_begin[s + 1] < stratum_begin[s] + 2) {
+            throw std::invalid_argument("Stratum allocation leaves fewer than two scenarios in a stratum");
+        }
+    }
+    plan.loss_direction = lossDirection();
+    return plan;
 }
 
-double MonteCarloRiskEngine::calculateVaR(std::vector<double>& returns, double confidence_level) {
+void MonteCarloRiskEngine::generateScenarioBlock(std::mt19937& gen, const ScenarioPlan& plan,
+                                                 size_t first, size_t count,
+                                                 std::vector<double>& normals,
+                                                 std::vector<double>& returns,
+                                                 std::vector<double>& factor_shocks) const {
+    std::normal_distribution<double> normal_dist(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
+    size_t n = portfolio.size();
+    size_t dims = normalsPerScenario();
+    bool philox_stream = sampling.rng == ScenarioRng::PHILOX;
+    
+    // Generate independent normal random variables for the whole block
+    if (philox_stream) {
+        for (size_t p = 0; p < count; ++p) {
+            philox::normals(plan.key, first + p, dims, &normals[p * dims]);
+        }
+    } else {
+        for (size_t k = 0; k < count * dims; ++k) {
+            normals[k] = normal_dist(gen);
+        }
+    }
+    
+    // Replace the coordinate along the loss direction with a draw from the scenario's stratum
+    if (!plan.stratum_mass.empty()) {
+        const std::vector<size_t>& stratum_begin = plan.stratum_begin;
+        size_t strata = plan.stratum_mass.size();
+        size_t s = std::upper_bound(stratum_begin.begin(), stratum_begin.end(), first) - stratum_begin.begin() - 1;
+        const double* u = plan.loss_direction.data();
+        for (size_t p = 0; p < count; ++p) {
+            while (first + p >= stratum_begin[s + 1]) ++s;
+            double uniform = philox_stream ? philox::uniform(plan.key, first + p, dims) : uniform_dist(gen);
+            double xi = vecmath::normInv((static_cast<double>(s) + uniform) / static_cast<double>(strata));
+            double* z = &normals[p * dims];
+            double projection = 0.0;
+            for (size_t d = 0; d < dims; ++d) {
+                projection += u[d] * z[d];
+            }
+            double shift = xi - projection;
+            #pragma omp simd
+            for (size_t d = 0; d < dims; ++d) {
+                z[d] += shift * u[d];
+            }
+        }
+    }
+    
+    double sqrt_horizon = std::sqrt(time_horizon);
+    if (block_correlation) {
+        // Common factors and per-block residual factors; each block's factor stays in cache
+        for (size_t p = 0; p < count; ++p) {
+            double* row = &returns[p * n];
+            block_correlation->correlate(&normals[p * dims], row);
+            for (size_t i = 0; i < n; ++i) {
+                row[i] = portfolio[i].expected_return * time_horizon +
+                         portfolio[i].volatility * sqrt_horizon * row[i];
+            }
+        }
+        return;
+    }
+    if (num_pca_factors > 0) {
+        // k common factors followed by n idiosyncratic shocks per scenario
+        size_t k = num_pca_factors;
+        for (size_t p = 0; p < count; ++p) {
+            const double* f = &normals[p * dims];
+            const double* eps = f + k;
+            double* row = &returns[p * n];
+            for (size_t i = 0; i < n; ++i) {
+                const double* b = &pca_loadings[i * k];
+                double volatility_component = pca_residual_vol[i] * eps[i];
+                for (size_t j = 0; j < k; ++j) {
+                    volatility_component += b[j] * f[j];
+                }
+                row[i] = portfolio[i].expected_return * time_horizon +
+                         portfolio[i].volatility * sqrt_horizon * volatility_component;
+            }
+        }
+        return;
+    }
+    
+    // Transform to correlated returns, one scenario row at a time
+    size_t sentiment_row = n + num_curve_factors;
+    for (size_t p = 0; p < count; ++p) {
+        const double* z = &normals[p * dims];
+        double* row = &returns[p * n];
+        for (size_t i = 0; i < n; ++i) {
+            const double* l = cholesky_factor[i].data();
+            double volatility_component = 0.0;
+            for (size_t j = 0; j <= i; ++j) {
+                volatility_component += l[j] * z[j];
+            }
+            row[i] = portfolio[i].expected_return * time_horizon +
+                     portfolio[i].volatility * sqrt_horizon * volatility_component;
+        }
+        if (num_sentiment_factors > 0) {
+            const double* l = cholesky_factor[sentiment_row].data();
+            double shock = 0.0;
+            for (size_t j = 0; j <= sentiment_row; ++j) {
+                shock += l[j] * z[j];
+            }
+            shock *= sqrt_horizon;
+            #pragma omp simd
+            for (size_t i = 0; i < n; ++i) {
+                row[i] += sentiment.drift_tilt[i] * time_horizon + sentiment.loadings[i] * shock;
+            }
+        }
+        // Driftless yield curve factor shocks from the trailing rows of the joint factor
+        for (size_t k = 0; k < num_curve_factors; ++k) {
+            const double* l = cholesky_factor[n + k].data();
+            double shock = 0.0;
+            for (size_t j = 0; j <= n + k; ++j) {
+                shock += l[j] * z[j];
+            }
+            factor_shocks[p * num_curve_factors + k] = yield_curve.factor_volatilities[k] * sqrt_horizon * shock;
+        }
+    }
+}
+
+void MonteCarloRiskEngine::revalueOptionsBlock(const std::vector<double>& returns, size_t count,
+                                               double* block_returns,
+                                               std::vector<double>& spots,
+                                               std::vector<double>& prices) const {
+    size_t n = portfolio.size();
+    for (size_t k = 0; k < option_positions.size(); ++k) {
+        const EuropeanOption& option = option_positions[k];
+        const OptionGreeks& greeks = option_greeks[k];
+        double scale = option.quantity / portfolio_value;
+        
+        if (option_revaluation == OptionRevaluation::FULL) {
+            for (size_t p = 0; p < count; ++p) {
+                spots[p] = option.spot * (1.0 + returns[p * n + option.underlying]);
+            }
+            blackScholesPriceBatch(option, spots.data(), count,
+                                   option.maturity - time_horizon, prices.data());
+            #pragma omp simd
+            for (size_t p = 0; p < count; ++p) {
+                block_returns[p] += scale * (prices[p] - greeks.price);
+            }
+        } else {
+            double decay = greeks.theta * time_horizon;
+            for (size_t p = 0; p < count; ++p) {
+                double move = option.spot * returns[p * n + option.underlying];
+                block_returns[p] += scale * (greeks.delta * move + 0.5 * greeks.gamma * move * move + decay);
+            }
+        }
+    }
+}
+
+double MonteCarloRiskEngine::calculateVaR(LargeVector<double>& returns, double confidence_level) const {
     if (returns.empty()) {
         throw std::invalid_argument("Returns vector cannot be empty");
     }
@@ -110,21 +720,24 @@ double MonteCarloRiskEngine::calculateVaR(std::vector<double>& returns, double c
     return -returns[index];
 }
 
-double MonteCarloRiskEngine::calculateCVaR(const std::vector<double>& returns, 
-                                          double confidence_level, double var_value) {
+double MonteCarloRiskEngine::calculateCVaR(const LargeVector<double>& returns, 
+                                          double confidence_level, double var_value) const {
     if (returns.empty()) {
         throw std::invalid_argument("Returns vector cannot be empty");
     }
     
-    double sum = 0.0;
-    int count = 0;
-    
-    for (double ret : returns) {
-        if (-ret >= var_value) { // Loss greater than VaR
-            sum += ret;
-            count++;
+    // Sum and count of the returns whose loss is at least the VaR
+    std::array<double, 2> tail = chunkedSums<2>(returns.size(), [&returns, var_value](size_t first, size_t last) {
+        std::array<double, 2> sums = {0.0, 0.0};
+        for (size_t k = first; k < last; ++k) {
+            if (-returns[k] >= var_value) {
+                sums[0] += returns[k];
+                sums[1] += 1.0;
+            }
         }
-    }
+        return sums;
+    });
+    double sum = tail[0], count = tail[1];
     
     if (count == 0) {
         return var_value; // If no losses exceed VaR, CVaR equals VaR
@@ -133,64 +746,755 @@ double MonteCarloRiskEngine::calculateCVaR(const std::vector<double>& returns,
     return -(sum / count); // CVaR is negative of average of tail losses
 }
 
-RiskMetrics MonteCarloRiskEngine::runSimulation() {
-    std::vector<double> portfolio_returns(num_simulations);
-    
-    // Cholesky decomposition for correlation
-    auto cholesky = choleskyDecomposition(correlation_matrix);
+RiskMetrics MonteCarloRiskEngine::runSimulation() const {
+    ReadLock lock(state_mutex);
+    LargeVector<double> portfolio_returns(num_simulations);
+    bool has_benchmark = !benchmark_weights.empty();
+    LargeVector<double> active_returns(has_benchmark ? num_simulations : 0);
+    bool liquidity_adjusted = !liquidity.average_daily_volume.empty();
+    LargeVector<double> liquidity_returns(liquidity_adjusted ? num_simulations : 0);
+    LiquidityAdjustment liquidity_map;
+    if (liquidity_adjusted) {
+        liquidity_map = liquidityAdjustment(portfolio, liquidity, time_horizon);
+    }
+    const double* liquidity_weights = liquidity_map.weights.data();
     
     // Calculate expected portfolio return and volatility
     double expected_portfolio_return = 0.0;
     for (const auto& asset : portfolio) {
         expected_portfolio_return += asset.weight * asset.expected_return;
     }
+    expected_portfolio_return += bond_book.carry;
+    for (size_t i = 0; i < portfolio.size() && num_sentiment_factors > 0; ++i) {
+        expected_portfolio_return += portfolio[i].weight * sentiment.drift_tilt[i];
+    }
     
     // Portfolio volatility calculation (simplified for demonstration)
     double portfolio_variance = 0.0;
-    for (size_t i = 0; i < portfolio.size(); ++i) {
-        for (size_t j = 0; j < portfolio.size(); ++j) {
-            portfolio_variance += portfolio[i].weight * portfolio[j].weight * 
-                                portfolio[i].volatility * portfolio[j].volatility * 
-                                correlation_matrix[i][j];
+    if (block_correlation) {
+        for (double b : equityShockLoadings()) portfolio_variance += b * b;
+    } else {
+        for (size_t i = 0; i < portfolio.size(); ++i) {
+            for (size_t j = 0; j < portfolio.size(); ++j) {
+                portfolio_variance += portfolio[i].weight * portfolio[j].weight * 
+                                    portfolio[i].volatility * portfolio[j].volatility * 
+                                    correlation_matrix[i][j];
+            }
+        }
+    }
+    // First-order bond exposure: the book loads -exposure_k * vol_k on curve factor k
+    std::vector<double> factor_loadings(num_curve_factors);
+    for (size_t k = 0; k < num_curve_factors; ++k) {
+        factor_loadings[k] = -bond_book.exposure[k] * yield_curve.factor_volatilities[k];
+    }
+    for (size_t k = 0; k < num_curve_factors; ++k) {
+        for (size_t i = 0; i < portfolio.size(); ++i) {
+            portfolio_variance += 2.0 * portfolio[i].weight * portfolio[i].volatility *
+                                  factor_loadings[k] * yield_curve.asset_correlation[i][k];
+        }
+        for (size_t l = 0; l < num_curve_factors; ++l) {
+            portfolio_variance += factor_loadings[k] * factor_loadings[l] * yield_curve.factor_correlation[k][l];
+        }
+    }
+    if (num_sentiment_factors > 0) {
+        // The shock is uncorrelated with the curve factors by construction
+        double sentiment_loading = 0.0;
+        for (size_t i = 0; i < portfolio.size(); ++i) {
+            sentiment_loading += portfolio[i].weight * sentiment.loadings[i];
+        }
+        for (size_t i = 0; i < portfolio.size(); ++i) {
+            portfolio_variance += 2.0 * portfolio[i].weight * portfolio[i].volatility *
+                                  sentiment_loading * sentiment.asset_correlation[i];
         }
+        portfolio_variance += sentiment_loading * sentiment_loading;
     }
     double portfolio_volatility = std::sqrt(portfolio_variance);
     
-    // Parallel Monte Carlo simulation using OpenMP
-    #pragma omp parallel
+    // Stratification plan and Philox key for this run
+    bool stratified = sampling.num_strata > 0;
+    ScenarioPlan plan = planScenarios(static_cast<size_t>(num_simulations));
+    
+    // Parallel Monte Carlo simulation using OpenMP, in blocks of scenarios
+    size_t n = portfolio.size();
+    size_t dims = normalsPerScenario();
+    double bond_carry = bond_book.carry * time_horizon;
+    size_t block_size = std::max<size_t>(1, std::min(kScenarioBlock, kScenarioBlockValues / dims));
+    long num_blocks = (static_cast<long>(num_simulations) + block_size - 1) / block_size;
+    #pragma omp parallel num_threads(parallelThreads())
     {
         // Each thread gets its own random number generator with unique seed
         std::mt19937 gen(std::random_device{}() + omp_get_thread_num());
+        std::vector<double> normals(block_size * dims), asset_returns(block_size * n);
+        std::vector<double> factor_shocks(block_size * num_curve_factors);
+        std::vector<double> spots(block_size), prices(block_size);
+        std::vector<double> linear_returns(liquidity_adjusted ? block_size : 0);
+        // Results stay in cache while the block is built, then are streamed out once
+        std::vector<double> block_returns(block_size), block_active(has_benchmark ? block_size : 0);
+        std::vector<double> block_liquidity(liquidity_adjusted ? block_size : 0);
         
-        #pragma omp for
-        for (int sim = 0; sim < num_simulations; ++sim) {
-            auto asset_returns = generateCorrelatedReturns(gen, cholesky);
-            portfolio_returns[sim] = calculatePortfolioReturn(asset_returns);
+        #pragma omp for schedule(static)
+        for (long block = 0; block < num_blocks; ++block) {
+            size_t first = static_cast<size_t>(block) * block_size;
+            size_t count = std::min(block_size, static_cast<size_t>(num_simulations) - first);
+            generateScenarioBlock(gen, plan, first, count, normals, asset_returns, factor_shocks);
+            
+            for (size_t p = 0; p < count; ++p) {
+                const double* row = &asset_returns[p * n];
+                double portfolio_return = 0.0;
+                double benchmark_return = 0.0;
+                double bond_return = 0.0;
+                for (size_t i = 0; i < n; ++i) {
+                    portfolio_return += portfolio[i].weight * row[i];
+                }
+                if (num_curve_factors > 0) {
+                    // Book-level duration/convexity: cost is independent of the number of bonds
+                    const double* f = &factor_shocks[p * num_curve_factors];
+                    bond_return = bond_carry;
+                    for (size_t k = 0; k < num_curve_factors; ++k) {
+                        double second_order = 0.0;
+                        for (size_t l = 0; l < num_curve_factors; ++l) {
+                            second_order += bond_book.curvature[k * num_curve_factors + l] * f[l];
+                        }
+                        bond_return += f[k] * (0.5 * second_order - bond_book.exposure[k]);
+                    }
+                    portfolio_return += bond_return;
+                }
+                block_returns[p] = portfolio_return;
+                if (liquidity_adjusted) {
+                    // Bonds are treated as liquid within the VaR horizon
+                    double adjusted = liquidity_map.offset + bond_return;
+                    #pragma omp simd reduction(+:adjusted)
+                    for (size_t i = 0; i < n; ++i) {
+                        adjusted += liquidity_weights[i] * row[i];
+                    }
+                    block_liquidity[p] = adjusted;
+                }
+                if (has_benchmark) {
+                    for (size_t i = 0; i < n; ++i) {
+                        benchmark_return += benchmark_weights[i] * row[i];
+                    }
+                    block_active[p] = portfolio_return - benchmark_return;
+                }
+            }
+            
+            if (!option_positions.empty()) {
+                if (liquidity_adjusted) {
+                    std::copy_n(block_returns.begin(), count, linear_returns.begin());
+                }
+                revalueOptionsBlock(asset_returns, count, block_returns.data(), spots, prices);
+                if (liquidity_adjusted) {
+                    // Option P&L over the VaR horizon carries over unchanged
+                    for (size_t p = 0; p < count; ++p) {
+                        block_liquidity[p] += block_returns[p] - linear_returns[p];
+                    }
+                }
+            }
+            
+            streamCopy(&portfolio_returns[first], block_returns.data(), count);
+            if (liquidity_adjusted) streamCopy(&liquidity_returns[first], block_liquidity.data(), count);
+            if (has_benchmark) streamCopy(&active_returns[first], block_active.data(), count);
         }
     }
     
-    // Create a copy for VaR calculation (sorts the vector)
-    auto returns_copy = portfolio_returns;
-    
     // Calculate risk metrics
     RiskMetrics metrics;
     metrics.expected_return = expected_portfolio_return;
     metrics.portfolio_vol = portfolio_volatility;
-    metrics.var_95 = calculateVaR(returns_copy, 0.95);
     
-    returns_copy = portfolio_returns; // Reset for 99% VaR
-    metrics.var_99 = calculateVaR(returns_copy, 0.99);
+    // Plain Monte Carlo is one stratum holding every scenario
+    std::vector<size_t> begin = stratified ? plan.stratum_begin : std::vector<size_t>{0, portfolio_returns.size()};
+    std::vector<double> mass = stratified ? plan.stratum_mass : std::vector<double>{1.0};
+    // The weighted sort and kernel density behind the standard errors cost about as much as the
+    // simulation itself, so plain runs only pay for them on request; liquidity-adjusted metrics
+    // carry no standard errors and never take that path outside stratified runs
+    TailEstimate tail_95 = {0.0, 0.0, 0.0, 0.0}, tail_99 = {0.0, 0.0, 0.0, 0.0};
+    if (stratified || sampling.standard_errors) {
+        tail_95 = stratifiedTailEstimate(portfolio_returns, begin, mass, 0.95);
+        tail_99 = stratifiedTailEstimate(portfolio_returns, begin, mass, 0.99);
+    }
+    if (stratified) {
+        metrics.var_95 = tail_95.var;
+        metrics.var_99 = tail_99.var;
+        metrics.cvar_95 = tail_95.cvar;
+        metrics.cvar_99 = tail_99.cvar;
+    } else {
+        // One sorted copy serves both quantiles; the results keep scenario order
+        auto sorted_returns = portfolio_returns;
+        metrics.var_95 = calculateVaR(sorted_returns, 0.95);
+        metrics.var_99 = sortedVaR(sorted_returns, 0.99);
+        
+        metrics.cvar_95 = calculateCVaR(portfolio_returns, 0.95, metrics.var_95);
+        metrics.cvar_99 = calculateCVaR(portfolio_returns, 0.99, metrics.var_99);
+    }
+    metrics.var_95_std_error = tail_95.var_std_error;
+    metrics.var_99_std_error = tail_99.var_std_error;
+    metrics.cvar_95_std_error = tail_95.cvar_std_error;
+    metrics.cvar_99_std_error = tail_99.cvar_std_error;
+    
+    metrics.liquidity_var_95 = 0.0;
+    metrics.liquidity_var_99 = 0.0;
+    metrics.liquidity_cvar_95 = 0.0;
+    metrics.liquidity_cvar_99 = 0.0;
+    metrics.liquidation_cost = 0.0;
+    if (liquidity_adjusted) {
+        // Same estimator as the unadjusted metrics, so an identity adjustment reproduces them exactly
+        if (stratified) {
+            TailEstimate liquidity_95 = stratifiedTailEstimate(liquidity_returns, begin, mass, 0.95);
+            TailEstimate liquidity_99 = stratifiedTailEstimate(liquidity_returns, begin, mass, 0.99);
+            metrics.liquidity_var_95 = liquidity_95.var;
+            metrics.liquidity_var_99 = liquidity_99.var;
+            metrics.liquidity_cvar_95 = liquidity_95.cvar;
+            metrics.liquidity_cvar_99 = liquidity_99.cvar;
+        } else {
+            auto sorted_liquidity = liquidity_returns;
+            metrics.liquidity_var_95 = calculateVaR(sorted_liquidity, 0.95);
+            metrics.liquidity_var_99 = sortedVaR(sorted_liquidity, 0.99);
+            metrics.liquidity_cvar_95 = calculateCVaR(liquidity_returns, 0.95, metrics.liquidity_var_95);
+            metrics.liquidity_cvar_99 = calculateCVaR(liquidity_returns, 0.99, metrics.liquidity_var_99);
+        }
+        metrics.liquidation_cost = liquidity_map.cost;
+        metrics.liquidation_days = std::move(liquidity_map.days);
+    }
     
-    metrics.cvar_95 = calculateCVaR(portfolio_returns, 0.95, metrics.var_95);
-    metrics.cvar_99 = calculateCVaR(portfolio_returns, 0.99, metrics.var_99);
+    // Benchmark-relative metrics
+    metrics.tracking_error = 0.0;
+    metrics.active_var_95 = 0.0;
+    metrics.active_var_99 = 0.0;
+    metrics.analytic_active_var_95 = 0.0;
+    metrics.analytic_active_var_99 = 0.0;
+    metrics.pca_factors = static_cast<int>(num_pca_factors);
+    metrics.pca_retained_variance = pca_retained_variance;
+    metrics.pca_truncation_error = 0.0;
+    if (num_pca_factors > 0) {
+        // Linear variance under the simulated correlation B B' + diag(residual^2) versus the full one.
+        // Factor simulation excludes the curve and sentiment factors, so the asset rows are the book.
+        size_t k = num_pca_factors;
+        std::vector<double> exposure = linearExposure();
+        std::vector<double> factor_exposure(k, 0.0);
+        double full_variance = 0.0, truncated_variance = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double x = exposure[i];
+            for (size_t j = 0; j < n; ++j) {
+                full_variance += x * exposure[j] * correlation_matrix[i][j];
+            }
+            for (size_t j = 0; j < k; ++j) {
+                factor_exposure[j] += x * pca_loadings[i * k + j];
+            }
+            truncated_variance += x * x * pca_residual_vol[i] * pca_residual_vol[i];
+        }
+        for (double e : factor_exposure) truncated_variance += e * e;
+        metrics.pca_truncation_error = vecmath::normInv(0.99) * std::sqrt(time_horizon) *
+            std::abs(std::sqrt(truncated_variance) - std::sqrt(std::max(full_variance, 0.0)));
+    }
+    if (has_benchmark) {
+        std::vector<double> weights(portfolio.size());
+        double expected_active_return = 0.0;
+        for (size_t i = 0; i < portfolio.size(); ++i) {
+            weights[i] = portfolio[i].weight;
+            expected_active_return += (weights[i] - benchmark_weights[i]) * portfolio[i].expected_return;
+        }
+        expected_active_return *= time_horizon;
+        metrics.tracking_error = trackingError(weights);
+        metrics.analytic_active_var_95 = 1.6448536269514722 * metrics.tracking_error - expected_active_return;
+        metrics.analytic_active_var_99 = 2.3263478740408408 * metrics.tracking_error - expected_active_return;
+        if (stratified) {
+            metrics.active_var_95 = stratifiedTailEstimate(active_returns, begin, mass, 0.95).var;
+            metrics.active_var_99 = stratifiedTailEstimate(active_returns, begin, mass, 0.99).var;
+        } else {
+            metrics.active_var_95 = calculateVaR(active_returns, 0.95);
+            metrics.active_var_99 = sortedVaR(active_returns, 0.99);
+        }
+    }
     
     // Store simulation results
     metrics.simulation_results = std::move(portfolio_returns);
+    if (stratified) {
+        metrics.scenario_weights.resize(metrics.simulation_results.size());
+        for (size_t s = 0; s < mass.size(); ++s) {
+            double weight = mass[s] / static_cast<double>(begin[s + 1] - begin[s]);
+            std::fill(metrics.scenario_weights.begin() + begin[s], metrics.scenario_weights.begin() + begin[s + 1], weight);
+        }
+    }
     
     return metrics;
 }
 
+PathRiskMetrics MonteCarloRiskEngine::simulatePaths(const PathSimulationSettings& settings) const {
+    ReadLock lock(state_mutex);
+    if (settings.num_paths <= 0) {
+        throw std::invalid_argument("Number of paths must be positive");
+    }
+    if (settings.num_steps <= 0) {
+        throw std::invalid_argument("Number of steps must be positive");
+    }
+    if (settings.horizon <= 0.0) {
+        throw std::invalid_argument("Path horizon must be positive");
+    }
+    
+    // One normal per asset and step, or factors plus residuals under a block correlation model
+    size_t num_regimes = regime_model.numRegimes();
+    std::vector<double> loadings = num_regimes > 0 ? std::vector<double>(portfolio.size()) : equityShockLoadings();
+    size_t n = loadings.size();
+    size_t steps = static_cast<size_t>(settings.num_steps);
+    size_t num_paths = static_cast<size_t>(settings.num_paths);
+    size_t dims = steps * n;
+    bool sobol = settings.sampler == PathSampler::SOBOL;
+    if (sobol && dims > SobolSequence::kMaxDimensions) {
+        throw std::invalid_argument("Steps x assets exceeds the Sobol dimension limit");
+    }
+    
+    // Constant-mix step return m dt + sqrt(dt) b'eps, with b = L' (w * sigma) folding the
+    // Cholesky transform into the portfolio weights
+    double dt = settings.horizon / static_cast<double>(steps);
+    double sqrt_dt = std::sqrt(dt);
+    double drift = 0.0;
+    for (const auto& asset : portfolio) {
+        drift += asset.weight * asset.expected_return * dt;
+    }
+    for (double& b : loadings) b *= sqrt_dt;
+    
+    // Per-state drift and loadings (state-major within each normal); a single state without a
+    // regime model. Regime mode steps whole model periods and holds the regime within a step.
+    size_t num_states = std::max<size_t>(num_regimes, 1);
+    std::vector<double> state_drift(1, drift), state_loadings = loadings;
+    std::vector<double> transition_cdf, start_cdf;
+    if (num_regimes > 0) {
+        double periods = dt * regime_model.periods_per_year;
+        double whole_periods = std::round(periods);
+        if (whole_periods < 1.0 || std::abs(periods - whole_periods) > 1e-6 * whole_periods) {
+            throw std::invalid_argument("Regime simulation needs a whole number of model periods per step");
+        }
+        size_t K = num_regimes;
+        state_drift.assign(K, 0.0);
+        state_loadings.assign(n * K, 0.0);
+        for (size_t k = 0; k < K; ++k) {
+            const double* l = &regime_cholesky[k * n * n];
+            for (size_t i = 0; i < n; ++i) {
+                double w = portfolio[i].weight;
+                state_drift[k] += w * regime_model.means[k][i] * whole_periods;
+                for (size_t j = 0; j <= i; ++j) {
+                    state_loadings[j * K + k] += w * l[i * n + j] * std::sqrt(whole_periods);
+                }
+            }
+        }
+        std::vector<double> step_transition(K * K, 0.0), power(K * K);
+        for (size_t k = 0; k < K; ++k) step_transition[k * K + k] = 1.0;
+        for (size_t m = 0; m < static_cast<size_t>(whole_periods); ++m) {
+            for (size_t a = 0; a < K; ++a) {
+                for (size_t b = 0; b < K; ++b) {
+                    double sum = 0.0;
+                    for (size_t c = 0; c < K; ++c) sum += step_transition[a * K + c] * regime_model.transition[c][b];
+                    power[a * K + b] = sum;
+                }
+            }
+            step_transition.swap(power);
+        }
+        transition_cdf.resize(K * K);
+        start_cdf.resize(K);
+        for (size_t a = 0; a < K; ++a) {
+            std::partial_sum(&step_transition[a * K], &step_transition[(a + 1) * K], &transition_cdf[a * K]);
+        }
+        std::partial_sum(regime_start.begin(), regime_start.end(), start_cdf.begin());
+    }
+    auto drawState = [](const double* cdf, size_t count, double u) {
+        size_t k = 0;
+        while (k + 1 < count && u * cdf[count - 1] >= cdf[k]) ++k;
+        return static_cast<int>(k);
+    };
+    std::vector<size_t> occupancy(num_states, 0);
+    
+    BrownianBridge bridge(steps);
+    LargeVector<double> path_returns(num_paths), max_drawdowns(num_paths);
+    std::random_device seed_source;
+    uint64_t base_seed = settings.seed != 0 ? settings.seed : (uint64_t(seed_source()) << 32) | seed_source();
+    long num_blocks = static_cast<long>((num_paths + kPathBlock - 1) / kPathBlock);
+    
+    #pragma omp parallel num_threads(parallelThreads())
+    {
+        // Normals are step-major: row (k * n + i) holds level/step k of asset i for every path
+        std::vector<double> normals(dims * kPathBlock), increments(dims * kPathBlock);
+        std::vector<double> asset_levels(steps * kPathBlock), asset_increments(steps * kPathBlock);
+        std::vector<double> point(sobol ? dims : 0);
+        std::vector<double> wealth(kPathBlock), peak(kPathBlock), drawdown(kPathBlock), step_return(kPathBlock);
+        std::vector<int> state(kPathBlock, 0);
+        std::vector<size_t> local_occupancy(num_states, 0);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        std::unique_ptr<SobolSequence> sequence;
+        if (sobol) sequence.reset(new SobolSequence(dims, settings.seed));
+        std::normal_distribution<double> normal_dist(0.0, 1.0);
+        
+        #pragma omp for schedule(static)
+        for (long block = 0; block < num_blocks; ++block) {
+            size_t first = static_cast<size_t>(block) * kPathBlock;
+            size_t count = std::min(kPathBlock, num_paths - first);
+            
+            if (sobol) {
+                sequence->skipTo(first);
+                for (size_t p = 0; p < count; ++p) {
+                    sequence->next(point.data());
+                    double* u = point.data();
+                    #pragma omp simd
+                    for (size_t d = 0; d < dims; ++d) {
+                        u[d] = vecmath::normInv(u[d]);
+                    }
+                    for (size_t d = 0; d < dims; ++d) {
+                        normals[d * kPathBlock + p] = u[d];
+                    }
+                }
+            } else {
+                // Seeded per block so results do not depend on the thread count
+                std::seed_seq seq{static_cast<uint32_t>(base_seed), static_cast<uint32_t>(base_seed >> 32),
+                                  static_cast<uint32_t>(block)};
+                std::mt19937 gen(seq);
+                for (size_t p = 0; p < count; ++p) {
+                    for (size_t d = 0; d < dims; ++d) {
+                        normals[d * kPathBlock + p] = normal_dist(gen);
+                    }
+                }
+            }
+            for (size_t d = 0; d < dims; ++d) {
+                std::fill(normals.begin() + d * kPathBlock + count, normals.begin() + (d + 1) * kPathBlock, 0.0);
+            }
+            
+            const double* eps = normals.data();
+            if (settings.brownian_bridge) {
+                // Bridge levels 0..steps-1 of asset i into its step increments
+                for (size_t i = 0; i < n; ++i) {
+                    for (size_t k = 0; k < steps; ++k) {
+                        std::copy_n(&normals[(k * n + i) * kPathBlock], kPathBlock, &asset_levels[k * kPathBlock]);
+                    }
+                    bridge.transform(asset_levels.data(), asset_increments.data(), kPathBlock);
+                    for (size_t k = 0; k < steps; ++k) {
+                        std::copy_n(&asset_increments[k * kPathBlock], kPathBlock, &increments[(k * n + i) * kPathBlock]);
+                    }
+                }
+                eps = increments.data();
+            }
+            
+            // Regime draws come from their own stream so the normals match the static model's
+            std::seed_seq regime_seq{static_cast<uint32_t>(base_seed), static_cast<uint32_t>(base_seed >> 32),
+                                     static_cast<uint32_t>(block), 1u};
+            std::mt19937 regime_gen(regime_seq);
+            if (num_regimes > 0) {
+                for (size_t p = 0; p < kPathBlock; ++p) {
+                    state[p] = drawState(start_cdf.data(), num_regimes, uniform(regime_gen));
+                }
+            }
+            
+            std::fill(wealth.begin(), wealth.end(), 1.0);
+            std::fill(peak.begin(), peak.end(), 1.0);
+            std::fill(drawdown.begin(), drawdown.end(), 0.0);
+            for (size_t k = 0; k < steps; ++k) {
+                if (num_regimes == 0) {
+                    std::fill(step_return.begin(), step_return.end(), drift);
+                    for (size_t j = 0; j < n; ++j) {
+                        const double* z = eps + (k * n + j) * kPathBlock;
+                        double b = loadings[j];
+                        #pragma omp simd
+                        for (size_t p = 0; p < kPathBlock; ++p) {
+                            step_return[p] += b * z[p];
+                        }
+                    }
+                } else {
+                    const int* s = state.data();
+                    for (size_t p = 0; p < kPathBlock; ++p) step_return[p] = state_drift[s[p]];
+                    for (size_t j = 0; j < n; ++j) {
+                        const double* z = eps + (k * n + j) * kPathBlock;
+                        const double* b = &state_loadings[j * num_states];
+                        #pragma omp simd
+                        for (size_t p = 0; p < kPathBlock; ++p) {
+                            step_return[p] += b[s[p]] * z[p];
+                        }
+                    }
+                    for (size_t p = 0; p < count; ++p) ++local_occupancy[s[p]];
+                    for (size_t p = 0; p < kPathBlock; ++p) {
+                        state[p] = drawState(&transition_cdf[state[p] * num_regimes], num_regimes,
+                                             uniform(regime_gen));
+                    }
+                }
+                #pragma omp simd
+                for (size_t p = 0; p < kPathBlock; ++p) {
+                    double w = std::max(wealth[p] * (1.0 + step_return[p]), 0.0);
+                    double top = std::max(peak[p], w);
+                    wealth[p] = w;
+                    peak[p] = top;
+                    drawdown[p] = std::max(drawdown[p], 1.0 - w / top);
+                }
+            }
+            for (size_t p = 0; p < count; ++p) wealth[p] -= 1.0;
+            streamCopy(&path_returns[first], wealth.data(), count);
+            streamCopy(&max_drawdowns[first], drawdown.data(), count);
+        }
+        #pragma omp critical
+        for (size_t k = 0; k < num_states; ++k) occupancy[k] += local_occupancy[k];
+    }
+    
+    PathRiskMetrics metrics;
+    if (num_regimes > 0) {
+        metrics.regime_occupancy.resize(num_regimes);
+        for (size_t k = 0; k < num_regimes; ++k) {
+            metrics.regime_occupancy[k] = static_cast<double>(occupancy[k]) / (num_paths * steps);
+        }
+    }
+    std::array<double, 3> sums = chunkedSums<3>(num_paths, [&](size_t first, size_t last) {
+        std::array<double, 3> chunk = {0.0, 0.0, 0.0}; // Returns, drawdowns, losses
+        for (size_t p = first; p < last; ++p) {
+            chunk[0] += path_returns[p];
+            chunk[1] += max_drawdowns[p];
+            chunk[2] += path_returns[p] < 0.0 ? 1.0 : 0.0;
+        }
+        return chunk;
+    });
+    metrics.expected_return = sums[0] / num_paths;
+    metrics.expected_max_drawdown = sums[1] / num_paths;
+    metrics.probability_of_loss = sums[2] / num_paths;
+    
+    auto returns_copy = path_returns;
+    metrics.var_95 = calculateVaR(returns_copy, 0.95);
+    metrics.cvar_95 = calculateCVaR(path_returns, 0.95, metrics.var_95);
+    auto drawdowns_copy = max_drawdowns;
+    size_t index = std::min(static_cast<size_t>(0.95 * num_paths), num_paths - 1);
+    std::nth_element(drawdowns_copy.begin(), drawdowns_copy.begin() + index, drawdowns_copy.end());
+    metrics.max_drawdown_95 = drawdowns_copy[index];
+    
+    metrics.path_returns = std::move(path_returns);
+    metrics.max_drawdowns = std::move(max_drawdowns);
+    return metrics;
+}
+
+MultilevelResult MonteCarloRiskEngine::estimatePathMetric(PathMetric metric, double horizon,
+                                                          const MultilevelSettings& settings,
+                                                          double shortfall_target) const {
+    ReadLock lock(state_mutex);
+    if (horizon <= 0.0) {
+        throw std::invalid_argument("Path horizon must be positive");
+    }
+    
+    // Constant-mix wealth is driven by the one-dimensional Brownian motion b'B with
+    // b = L' (w * sigma), so each level needs one normal per fine step
+    double drift = 0.0;
+    for (const auto& asset : portfolio) {
+        drift += asset.weight * asset.expected_return;
+    }
+    double diffusion = 0.0;
+    for (double b : equityShockLoadings()) diffusion += b * b;
+    diffusion = std::sqrt(diffusion);
+    
+    std::random_device seed_source;
+    uint64_t base_seed = settings.seed != 0 ? settings.seed : (uint64_t(seed_source()) << 32) | seed_source();
+    size_t refinement = settings.refinement;
+    
+    // Discrete monitoring misses the peak and the trough between steps; the Broadie-Glasserman-Kou
+    // shift of 0.5826 sigma sqrt(h) on each end lifts the weak order of the drawdown from 1/2 to ~1
+    auto payoff = [&](double wealth, double drawdown, double step_vol) {
+        switch (metric) {
+            case PathMetric::MAX_DRAWDOWN:
+                if (drawdown <= 0.0 || drawdown >= 1.0) return drawdown;
+                return 1.0 - (1.0 - drawdown) * std::exp(-2.0 * kMonitoringShift * step_vol);
+            case PathMetric::TERMINAL_WEALTH: return wealth;
+            default: return std::max(shortfall_target - wealth, 0.0);
+        }
+    };
+    
+    LevelSampler sampler = [&](size_t level, size_t samples, uint64_t stream) {
+        size_t fine_steps = settings.base_steps;
+        for (size_t l = 0; l < level; ++l) fine_steps *= refinement;
+        double h = horizon / static_cast<double>(fine_steps);
+        double fine_drift = drift * h, coarse_drift = fine_drift * refinement;
+        double fine_vol = diffusion * std::sqrt(h);
+        double coarse_vol = fine_vol * std::sqrt(static_cast<double>(refinement));
+        long num_blocks = static_cast<long>((samples + kMultilevelBlock - 1) / kMultilevelBlock);
+        // One partial per seeded block, combined in a fixed tree so the sums do not depend on threads
+        std::vector<LevelSums> partials(num_blocks);
+        
+        #pragma omp parallel for schedule(static) num_threads(parallelThreads())
+        for (long block = 0; block < num_blocks; ++block) {
+            double sum = 0.0, sum_squares = 0.0, fine_sum = 0.0, fine_sum_squares = 0.0;
+            std::seed_seq seq{static_cast<uint32_t>(base_seed), static_cast<uint32_t>(base_seed >> 32),
+                              static_cast<uint32_t>(stream), static_cast<uint32_t>(level),
+                              static_cast<uint32_t>(block)};
+            std::mt19937 gen(seq);
+            std::normal_distribution<double> normal_dist(0.0, 1.0);
+            size_t first = static_cast<size_t>(block) * kMultilevelBlock;
+            size_t count = std::min(kMultilevelBlock, samples - first);
+            
+            for (size_t p = 0; p < count; ++p) {
+                double fine_wealth = 1.0, fine_peak = 1.0, fine_drawdown = 0.0;
+                double coarse_wealth = 1.0, coarse_peak = 1.0, coarse_drawdown = 0.0;
+                double coarse_shock = 0.0;
+                for (size_t k = 0; k < fine_steps; ++k) {
+                    double shock = fine_vol * normal_dist(gen);
+                    fine_wealth = std::max(fine_wealth * (1.0 + fine_drift + shock), 0.0);
+                    fine_peak = std::max(fine_peak, fine_wealth);
+                    fine_drawdown = std::max(fine_drawdown, 1.0 - fine_wealth / fine_peak);
+                    
+                    // The coarse path takes the sum of `refinement` fine increments as one step
+                    coarse_shock += shock;
+                    if (level > 0 && (k + 1) % refinement == 0) {
+                        coarse_wealth = std::max(coarse_wealth * (1.0 + coarse_drift + coarse_shock), 0.0);
+                        coarse_peak = std::max(coarse_peak, coarse_wealth);
+                        coarse_drawdown = std::max(coarse_drawdown, 1.0 - coarse_wealth / coarse_peak);
+                        coarse_shock = 0.0;
+                    }
+                }
+                double fine = payoff(fine_wealth, fine_drawdown, fine_vol);
+                double y = level > 0 ? fine - payoff(coarse_wealth, coarse_drawdown, coarse_vol) : fine;
+                sum += y;
+                sum_squares += y * y;
+                fine_sum += fine;
+                fine_sum_squares += fine * fine;
+            }
+            partials[block] = LevelSums{sum, sum_squares, fine_sum, fine_sum_squares};
+        }
+        return treeReduce(partials, [](const LevelSums& a, const LevelSums& b) {
+            return LevelSums{a.sum + b.sum, a.sum_squares + b.sum_squares, a.fine_sum + b.fine_sum,
+                             a.fine_sum_squares + b.fine_sum_squares};
+        });
+    };
+    
+    return runMultilevel(sampler, settings);
+}
+
+ConditionalTailMetrics MonteCarloRiskEngine::estimateConditionalTail(const ConditionalTailSettings& settings) const {
+    ReadLock lock(state_mutex);
+    if (settings.num_draws < 2) {
+        throw std::invalid_argument("Need at least two mixing draws");
+    }
+    if (settings.mixing == MixingDistribution::STUDENT_T && !(settings.degrees_of_freedom > 2.0)) {
+        throw std::invalid_argument("Student-t mixing needs more than two degrees of freedom");
+    }
+    if (settings.mixing == MixingDistribution::JUMP &&
+        (settings.jump_intensity < 0.0 || settings.jump_volatility < 0.0)) {
+        throw std::invalid_argument("Jump intensity and volatility must be non-negative");
+    }
+    size_t num_regimes = regime_model.numRegimes();
+    if (settings.mixing == MixingDistribution::REGIME && num_regimes == 0) {
+        throw std::invalid_argument("Regime mixing needs a regime model");
+    }
+    
+    // Gaussian horizon return of the equity portfolio
+    double base_mean = 0.0, base_variance = 0.0;
+    for (const auto& asset : portfolio) {
+        base_mean += asset.weight * asset.expected_return * time_horizon;
+    }
+    for (double b : equityShockLoadings()) base_variance += b * b * time_horizon;
+    
+    // Per-period regime drift and variance; the regime path covers the horizon's model periods
+    size_t periods = 0;
+    std::vector<double> regime_drift, regime_variance, transition_cdf, start_cdf;
+    if (settings.mixing == MixingDistribution::REGIME) {
+        double exact = time_horizon * regime_model.periods_per_year;
+        double whole = std::round(exact);
+        if (whole < 1.0 || std::abs(exact - whole) > 1e-6 * whole) {
+            throw std::invalid_argument("Regime mixing needs a horizon of whole model periods");
+        }
+        periods = static_cast<size_t>(whole);
+        size_t n = portfolio.size();
+        size_t K = num_regimes;
+        regime_drift.assign(K, 0.0);
+        regime_variance.assign(K, 0.0);
+        transition_cdf.resize(K * K);
+        start_cdf.resize(K);
+        for (size_t k = 0; k < K; ++k) {
+            for (size_t i = 0; i < n; ++i) {
+                double w = portfolio[i].weight;
+                regime_drift[k] += w * regime_model.means[k][i];
+                for (size_t j = 0; j < n; ++j) {
+                    regime_variance[k] += w * portfolio[j].weight * regime_model.covariances[k][i][j];
+                }
+            }
+            std::partial_sum(regime_model.transition[k].begin(), regime_model.transition[k].end(),
+                             &transition_cdf[k * K]);
+        }
+        std::partial_sum(regime_start.begin(), regime_start.end(), start_cdf.begin());
+    }
+    auto drawState = [](const double* cdf, size_t count, double u) {
+        size_t k = 0;
+        while (k + 1 < count && u * cdf[count - 1] >= cdf[k]) ++k;
+        return k;
+    };
+    
+    size_t num = settings.num_draws;
+    std::vector<double> means(num), vols(num);
+    std::random_device seed_source;
+    uint64_t base_seed = settings.seed != 0 ? settings.seed : (uint64_t(seed_source()) << 32) | seed_source();
+    double nu = settings.degrees_of_freedom;
+    double jumps_per_horizon = settings.jump_intensity * time_horizon;
+    long num_blocks = static_cast<long>((num + kMixingBlock - 1) / kMixingBlock);
+    
+    #pragma omp parallel for schedule(static) num_threads(parallelThreads())
+    for (long block = 0; block < num_blocks; ++block) {
+        // Seeded per block so results do not depend on the thread count
+        std::seed_seq seq{static_cast<uint32_t>(base_seed), static_cast<uint32_t>(base_seed >> 32),
+                          static_cast<uint32_t>(block)};
+        std::mt19937 gen(seq);
+        std::chi_squared_distribution<double> chi_squared(nu);
+        std::poisson_distribution<int> jumps(jumps_per_horizon);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        size_t first = static_cast<size_t>(block) * kMixingBlock;
+        size_t last = std::min(first + kMixingBlock, num);
+        for (size_t d = first; d < last; ++d) {
+            switch (settings.mixing) {
+                case MixingDistribution::STUDENT_T: {
+                    double scale = (nu - 2.0) / chi_squared(gen);
+                    means[d] = base_mean;
+                    vols[d] = std::sqrt(base_variance * scale);
+                    break;
+                }
+                case MixingDistribution::JUMP: {
+                    double count = jumps_per_horizon > 0.0 ? static_cast<double>(jumps(gen)) : 0.0;
+                    means[d] = base_mean + count * settings.jump_mean;
+                    vols[d] = std::sqrt(base_variance + count * settings.jump_volatility * settings.jump_volatility);
+                    break;
+                }
+                case MixingDistribution::REGIME: {
+                    size_t state = drawState(start_cdf.data(), num_regimes, uniform(gen));
+                    double mean = 0.0, variance = 0.0;
+                    for (size_t t = 0; t < periods; ++t) {
+                        mean += regime_drift[state];
+                        variance += regime_variance[state];
+                        state = drawState(&transition_cdf[state * num_regimes], num_regimes, uniform(gen));
+                    }
+                    means[d] = mean;
+                    vols[d] = std::sqrt(variance);
+                    break;
+                }
+            }
+        }
+    }
+    for (double v : vols) {
+        if (!(v > 0.0)) {
+            throw std::invalid_argument("Conditional return volatility must be positive");
+        }
+    }
+    
+    ConditionalTailMetrics metrics;
+    TailEstimate tail_95 = mixtureTailEstimate(means, vols, 0.95);
+    TailEstimate tail_99 = mixtureTailEstimate(means, vols, 0.99);
+    metrics.var_95 = tail_95.var;
+    metrics.var_99 = tail_99.var;
+    metrics.cvar_95 = tail_95.cvar;
+    metrics.cvar_99 = tail_99.cvar;
+    metrics.var_95_std_error = tail_95.var_std_error;
+    metrics.var_99_std_error = tail_99.var_std_error;
+    metrics.cvar_95_std_error = tail_95.cvar_std_error;
+    metrics.cvar_99_std_error = tail_99.cvar_std_error;
+    
+    // Law of total variance over the mixing draws
+    double mean_sum = 0.0, second_sum = 0.0;
+    for (size_t d = 0; d < num; ++d) {
+        mean_sum += means[d];
+        second_sum += vols[d] * vols[d] + means[d] * means[d];
+    }
+    metrics.expected_return = mean_sum / num;
+    metrics.portfolio_vol = std::sqrt(std::max(second_sum / num - metrics.expected_return * metrics.expected_return, 0.0));
+    metrics.component_means = std::move(means);
+    metrics.component_vols = std::move(vols);
+    return metrics;
+}
+
 void MonteCarloRiskEngine::setNumSimulations(int simulations) {
+    WriteLock lock(state_mutex);
     if (simulations <= 0) {
         throw std::invalid_argument("Number of simulations must be positive");
     }
@@ -198,6 +1502,7 @@ void MonteCarloRiskEngine::setNumSimulations(int simulations) {
 }
 
 void MonteCarloRiskEngine::setTimeHorizon(double horizon) {
+    WriteLock lock(state_mutex);
     if (horizon <= 0) {
         throw std::invalid_argument("Time horizon must be positive");
     }
@@ -205,16 +1510,487 @@ void MonteCarloRiskEngine::setTimeHorizon(double horizon) {
 }
 
 void MonteCarloRiskEngine::updatePortfolio(const std::vector<PortfolioAsset>& assets) {
+    WriteLock lock(state_mutex);
     if (assets.empty()) {
         throw std::invalid_argument("Portfolio cannot be empty");
     }
+    bool resized = assets.size() != portfolio.size();
+    if (resized && block_correlation) {
+        throw std::invalid_argument("Portfolio size must match the block correlation model");
+    }
     portfolio = assets;
+    if (resized && (num_curve_factors > 0 || num_sentiment_factors > 0)) {
+        // Asset-factor correlations and sentiment loadings no longer line up with the portfolio
+        sentiment = SentimentFactorModel();
+        num_sentiment_factors = 0;
+        clearYieldCurveModel();
+    }
+    if (resized) {
+        liquidity = LiquidityProfile();
+    }
+    if (resized && regime_model.numRegimes() > 0) {
+        clearRegimeModel();
+    }
+    if (resized && pca_variance_target > 0.0) {
+        // Loadings are stale until a matching correlation matrix arrives
+        pca_variance_target = 0.0;
+        refreshPrincipalComponents();
+    }
+    if (!benchmark_weights.empty() && benchmark_weights.size() != portfolio.size()) {
+        benchmark_weights.clear();
+    }
+    for (const auto& option : option_positions) {
+        if (option.underlying >= portfolio.size()) {
+            option_positions.clear();
+            option_greeks.clear();
+            break;
+        }
+    }
+}
+
+void MonteCarloRiskEngine::setOptionPositions(const std::vector<EuropeanOption>& options,
+                                              double value, OptionRevaluation mode) {
+    WriteLock lock(state_mutex);
+    if (!options.empty() && value <= 0.0) {
+        throw std::invalid_argument("Portfolio value must be positive when holding options");
+    }
+    for (const auto& option : options) {
+        if (option.underlying >= portfolio.size()) {
+            throw std::invalid_argument("Option underlying index is out of range");
+        }
+    }
+    // Greeks at today's spot anchor both the delta-gamma expansion and the P&L baseline
+    option_greeks = blackScholesGreeksBatch(options);
+    option_positions = options;
+    portfolio_value = value;
+    option_revaluation = mode;
 }
 
 void MonteCarloRiskEngine::updateCorrelationMatrix(const std::vector<std::vector<double>>& corr_matrix) {
-    if (corr_matrix.size() != portfolio.size() || 
-        corr_matrix[0].size() != portfolio.size()) {
-        throw std::invalid_argument("Correlation matrix dimensions must match portfolio size");
+    WriteLock lock(state_mutex);
+    std::vector<std::vector<double>> factor = validatedFactor(corr_matrix, portfolio.size());
+    if (num_curve_factors > 0 || num_sentiment_factors > 0) {
+        // The curve and sentiment rows can make the joint matrix indefinite even when C is valid
+        factor = jointCholeskyFactor(corr_matrix);
     }
+    
+    // Nothing is committed until every factor of the new matrix has been built
+    std::vector<std::vector<double>> previous_matrix = std::move(correlation_matrix);
+    std::vector<std::vector<double>> previous_factor = std::move(cholesky_factor);
+    std::shared_ptr<const BlockCorrelationFactor> previous_block = std::move(block_correlation);
     correlation_matrix = corr_matrix;
+    cholesky_factor = std::move(factor);
+    block_correlation.reset();
+    try {
+        refreshPrincipalComponents();
+    } catch (const std::invalid_argument&) {
+        correlation_matrix = std::move(previous_matrix);
+        cholesky_factor = std::move(previous_factor);
+        block_correlation = std::move(previous_block);
+        refreshPrincipalComponents();
+        throw;
+    }
+}
+
+void MonteCarloRiskEngine::setFactorSimulation(double retained_variance, size_t max_factors) {
+    WriteLock lock(state_mutex);
+    if (retained_variance < 0.0 || retained_variance > 1.0) {
+        throw std::invalid_argument("Retained variance must be between 0 and 1");
+    }
+    if (retained_variance > 0.0 && num_curve_factors > 0) {
+        throw std::invalid_argument("Factor simulation cannot be combined with a yield curve model");
+    }
+    if (retained_variance > 0.0 && num_sentiment_factors > 0) {
+        throw std::invalid_argument("Factor simulation cannot be combined with a sentiment factor");
+    }
+    if (retained_variance > 0.0 && block_correlation) {
+        throw std::invalid_argument("Factor simulation needs a dense correlation matrix");
+    }
+    pca_variance_target = retained_variance;
+    pca_max_factors = max_factors;
+    refreshPrincipalComponents();
+}
+
+void MonteCarloRiskEngine::setScenarioSampling(const ScenarioSamplingSettings& settings) {
+    WriteLock lock(state_mutex);
+    if (settings.num_strata == 1) {
+        throw std::invalid_argument("Stratification needs at least two strata (0 disables it)");
+    }
+    if (settings.tail_fraction <= 0.0 || settings.tail_fraction >= 1.0) {
+        throw std::invalid_argument("Tail fraction must be in (0, 1)");
+    }
+    if (settings.tail_allocation < 0.0 || settings.tail_allocation >= 1.0) {
+        throw std::invalid_argument("Tail allocation must be in [0, 1)");
+    }
+    sampling = settings;
+}
+
+void MonteCarloRiskEngine::setYieldCurveModel(const YieldCurveFactorModel& model) {
+    WriteLock lock(state_mutex);
+    if (model.bonds.empty()) {
+        clearYieldCurveModel();
+        return;
+    }
+    
+    if (num_pca_factors > 0) {
+        throw std::invalid_argument("A yield curve model cannot be combined with factor simulation");
+    }
+    if (block_correlation) {
+        throw std::invalid_argument("A yield curve model needs a dense correlation matrix");
+    }
+    BondBookExposure book = aggregateBondExposure(model, portfolio.size());
+    YieldCurveFactorModel previous_curve = std::move(yield_curve);
+    size_t previous_factors = num_curve_factors;
+    yield_curve = model;
+    num_curve_factors = kYieldCurveFactors;
+    try {
+        refreshCholeskyFactor();
+    } catch (const std::invalid_argument&) {
+        yield_curve = std::move(previous_curve);
+        num_curve_factors = previous_factors;
+        throw;
+    }
+    bond_book = std::move(book);
+}
+
+void MonteCarloRiskEngine::clearYieldCurveModel() {
+    yield_curve = YieldCurveFactorModel();
+    bond_book = BondBookExposure();
+    num_curve_factors = 0;
+    refreshCholeskyFactor();
+}
+
+void MonteCarloRiskEngine::setSentimentFactor(const SentimentFactorModel& model) {
+    WriteLock lock(state_mutex);
+    if (model.loadings.empty()) {
+        clearSentimentFactor();
+        return;
+    }
+    
+    size_t n = portfolio.size();
+    if (model.loadings.size() != n) {
+        throw std::invalid_argument("Sentiment loadings must match portfolio size");
+    }
+    if (!model.asset_correlation.empty() && model.asset_correlation.size() != n) {
+        throw std::invalid_argument("Sentiment correlations must be empty or match portfolio size");
+    }
+    if (!model.drift_tilt.empty() && model.drift_tilt.size() != n) {
+        throw std::invalid_argument("Sentiment drift tilts must be empty or match portfolio size");
+    }
+    for (size_t i = 0; i < n; ++i) {
+        bool finite = std::isfinite(model.loadings[i]) &&
+                      (model.drift_tilt.empty() || std::isfinite(model.drift_tilt[i]));
+        if (!finite) {
+            throw std::invalid_argument("Sentiment loadings and drift tilts must be finite");
+        }
+        if (!model.asset_correlation.empty() && !(std::abs(model.asset_correlation[i]) < 1.0)) {
+            throw std::invalid_argument("Sentiment correlations must be in (-1, 1)");
+        }
+    }
+    if (num_pca_factors > 0) {
+        throw std::invalid_argument("A sentiment factor cannot be combined with factor simulation");
+    }
+    if (block_correlation) {
+        throw std::invalid_argument("A sentiment factor needs a dense correlation matrix");
+    }
+    
+    SentimentFactorModel previous_model = std::move(sentiment);
+    size_t previous_factors = num_sentiment_factors;
+    sentiment = model;
+    sentiment.asset_correlation.resize(n, 0.0);
+    sentiment.drift_tilt.resize(n, 0.0);
+    num_sentiment_factors = 1;
+    try {
+        refreshCholeskyFactor();
+    } catch (const std::invalid_argument&) {
+        sentiment = std::move(previous_model);
+        num_sentiment_factors = previous_factors;
+        throw;
+    }
+}
+
+void MonteCarloRiskEngine::clearSentimentFactor() {
+    sentiment = SentimentFactorModel();
+    num_sentiment_factors = 0;
+    refreshCholeskyFactor();
+}
+
+void MonteCarloRiskEngine::setLiquidityProfile(const LiquidityProfile& profile) {
+    WriteLock lock(state_mutex);
+    if (profile.average_daily_volume.empty()) {
+        liquidity = LiquidityProfile();
+        return;
+    }
+    if (profile.average_daily_volume.size() != portfolio.size()) {
+        throw std::invalid_argument("Average daily volumes must match portfolio size");
+    }
+    for (double volume : profile.average_daily_volume) {
+        if (!(volume > 0.0)) {
+            throw std::invalid_argument("Average daily volumes must be positive");
+        }
+    }
+    if (!(profile.portfolio_value > 0.0)) {
+        throw std::invalid_argument("Portfolio value must be positive");
+    }
+    if (!(profile.participation_rate > 0.0) || profile.participation_rate > 1.0) {
+        throw std::invalid_argument("Participation rate must be in (0, 1]");
+    }
+    if (profile.impact_coefficient < 0.0 || !(profile.trading_days_per_year > 0.0)) {
+        throw std::invalid_argument("Impact coefficient must be non-negative and trading days positive");
+    }
+    liquidity = profile;
+}
+
+void MonteCarloRiskEngine::setRegimeModel(const GaussianHMM& model, const std::vector<double>& start_probabilities) {
+    WriteLock lock(state_mutex);
+    size_t K = model.numRegimes();
+    if (K == 0) {
+        clearRegimeModel();
+        return;
+    }
+    
+    size_t n = portfolio.size();
+    if (model.periods_per_year <= 0.0) {
+        throw std::invalid_argument("Periods per year must be positive");
+    }
+    if (model.means.size() != K || model.covariances.size() != K) {
+        throw std::invalid_argument("Need a mean vector and a covariance matrix per regime");
+    }
+    const std::vector<double>& start = start_probabilities.empty() ? model.initial_probabilities
+                                                                   : start_probabilities;
+    if (start.size() != K) {
+        throw std::invalid_argument("Start probabilities must have one entry per regime");
+    }
+    auto isDistribution = [](const std::vector<double>& p) {
+        double total = 0.0;
+        for (double v : p) {
+            if (v < 0.0) return false;
+            total += v;
+        }
+        return std::abs(total - 1.0) < 1e-6;
+    };
+    if (!isDistribution(start)) {
+        throw std::invalid_argument("Start probabilities must be non-negative and sum to 1");
+    }
+    std::vector<double> factors(K * n * n);
+    for (size_t k = 0; k < K; ++k) {
+        if (model.transition[k].size() != K || !isDistribution(model.transition[k])) {
+            throw std::invalid_argument("Transition rows must be probability distributions over the regimes");
+        }
+        if (model.means[k].size() != n || model.covariances[k].size() != n) {
+            throw std::invalid_argument("Regime parameters must match portfolio size");
+        }
+        std::vector<double> factor(n * n);
+        for (size_t i = 0; i < n; ++i) {
+            if (model.covariances[k][i].size() != n) {
+                throw std::invalid_argument("Regime parameters must match portfolio size");
+            }
+            for (size_t j = 0; j < n; ++j) {
+                if (std::abs(model.covariances[k][i][j] - model.covariances[k][j][i]) > 1e-12) {
+                    throw std::invalid_argument("Regime covariance must be symmetric");
+                }
+                factor[i * n + j] = model.covariances[k][i][j];
+            }
+        }
+        if (!choleskyFactor(factor, n)) {
+            throw std::invalid_argument("Regime covariance must be positive definite");
+        }
+        std::copy(factor.begin(), factor.end(), &factors[k * n * n]);
+    }
+    regime_model = model;
+    regime_start = start;
+    regime_cholesky = std::move(factors);
+}
+
+void MonteCarloRiskEngine::clearRegimeModel() {
+    regime_model = GaussianHMM();
+    regime_start.clear();
+    regime_cholesky.clear();
+}
+
+void MonteCarloRiskEngine::setBenchmarkWeights(const std::vector<double>& weights) {
+    WriteLock lock(state_mutex);
+    if (!weights.empty() && weights.size() != portfolio.size()) {
+        throw std::invalid_argument("Benchmark weights must match portfolio size");
+    }
+    if (!weights.empty() && block_correlation) {
+        throw std::invalid_argument("Benchmark-relative risk needs a dense correlation matrix");
+    }
+    benchmark_weights = weights;
+}
+
+void MonteCarloRiskEngine::covarianceProduct(const std::vector<double>& x, std::vector<double>& out) const {
+    // Sigma x = D L L' D x using the cached factor
+    size_t n = portfolio.size();
+    std::vector<double> scaled(n), projected(n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        scaled[i] = portfolio[i].volatility * x[i];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t k = 0; k <= i; ++k) {
+            projected[k] += cholesky_factor[i][k] * scaled[i];
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        double sum = 0.0;
+        for (size_t k = 0; k <= i; ++k) {
+            sum += cholesky_factor[i][k] * projected[k];
+        }
+        out[i] = portfolio[i].volatility * sum;
+    }
+}
+
+double MonteCarloRiskEngine::maxCovarianceEigenvalue() const {
+    size_t n = portfolio.size();
+    std::vector<double> x(n, 1.0 / std::sqrt(static_cast<double>(n))), y(n);
+    double lambda = 0.0;
+    for (int iter = 0; iter < 100; ++iter) {
+        covarianceProduct(x, y);
+        double norm = 0.0;
+        for (double v : y) norm += v * v;
+        norm = std::sqrt(norm);
+        if (norm == 0.0) return 0.0;
+        for (size_t i = 0; i < n; ++i) x[i] = y[i] / norm;
+        bool converged = std::abs(norm - lambda) < 1e-10 * norm;
+        lambda = norm;
+        if (converged) break;
+    }
+    return lambda * 1.05;
+}
+
+double MonteCarloRiskEngine::calculateTrackingError(const std::vector<double>& weights) const {
+    ReadLock lock(state_mutex);
+    if (benchmark_weights.empty()) {
+        throw std::invalid_argument("Benchmark weights have not been set");
+    }
+    if (weights.size() != portfolio.size()) {
+        throw std::invalid_argument("Weights must match portfolio size");
+    }
+    return trackingError(weights);
+}
+
+double MonteCarloRiskEngine::trackingError(const std::vector<double>& weights) const {
+    // TE = || L' D (w - b) || * sqrt(T)
+    size_t n = portfolio.size();
+    std::vector<double> projected(n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        double scaled = portfolio[i].volatility * (weights[i] - benchmark_weights[i]);
+        for (size_t k = 0; k <= i; ++k) {
+            projected[k] += cholesky_factor[i][k] * scaled;
+        }
+    }
+    double variance = 0.0;
+    for (double v : projected) variance += v * v;
+    return std::sqrt(variance * time_horizon);
+}
+
+std::vector<double> MonteCarloRiskEngine::calculateTrackingErrors(
+    const std::vector<std::vector<double>>& account_weights) const {
+    
+    ReadLock lock(state_mutex);
+    std::vector<double> tracking_errors(account_weights.size());
+    for (const auto& weights : account_weights) {
+        if (weights.size() != portfolio.size()) {
+            throw std::invalid_argument("Weights must match portfolio size");
+        }
+    }
+    if (benchmark_weights.empty()) {
+        throw std::invalid_argument("Benchmark weights have not been set");
+    }
+    
+    #pragma omp parallel for schedule(static) num_threads(parallelThreads())
+    for (long k = 0; k < static_cast<long>(account_weights.size()); ++k) {
+        tracking_errors[k] = trackingError(account_weights[k]);
+    }
+    return tracking_errors;
+}
+
+TrackingErrorResult MonteCarloRiskEngine::solveTrackingError(const std::vector<double>& current_weights,
+                                                              double max_turnover, double max_weight,
+                                                              double lipschitz) const {
+    size_t n = portfolio.size();
+    std::vector<double> lower(n, 0.0), upper(n, max_weight);
+    std::vector<double> x(n), x_prev(n), y(n), g(n), step(n), active(n);
+    
+    // Accelerated projected gradient on (w - b)' Sigma (w - b) over budget, box and turnover
+    projectBudgetBoxTurnover(current_weights, current_weights, lower, upper, max_turnover, x);
+    y = x;
+    double t = 1.0;
+    int iterations = 0;
+    for (; iterations < 2000; ++iterations) {
+        for (size_t i = 0; i < n; ++i) active[i] = y[i] - benchmark_weights[i];
+        covarianceProduct(active, g);
+        for (size_t i = 0; i < n; ++i) {
+            step[i] = y[i] - 2.0 * g[i] / lipschitz;
+        }
+        x_prev.swap(x);
+        projectBudgetBoxTurnover(step, current_weights, lower, upper, max_turnover, x);
+        
+        double change = 0.0;
+        double direction = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            change = std::max(change, std::abs(x[i] - x_prev[i]));
+            direction += g[i] * (x[i] - x_prev[i]);
+        }
+        if (change < 1e-10) break;
+        
+        if (direction > 0.0) {
+            // Gradient-based restart keeps the momentum monotone
+            t = 1.0;
+            y = x;
+        } else {
+            double t_next = 0.5 * (1.0 + std::sqrt(1.0 + 4.0 * t * t));
+            double beta = (t - 1.0) / t_next;
+            for (size_t i = 0; i < n; ++i) {
+                y[i] = x[i] + beta * (x[i] - x_prev[i]);
+            }
+            t = t_next;
+        }
+    }
+    
+    TrackingErrorResult result;
+    result.weights = x;
+    result.tracking_error = trackingError(x);
+    result.turnover = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        result.turnover += std::abs(x[i] - current_weights[i]);
+    }
+    result.iterations = iterations;
+    return result;
+}
+
+TrackingErrorResult MonteCarloRiskEngine::minimizeTrackingError(const std::vector<double>& current_weights,
+                                                                 double max_turnover, double max_weight) const {
+    return minimizeTrackingErrorBatch({current_weights}, max_turnover, max_weight).front();
+}
+
+std::vector<TrackingErrorResult> MonteCarloRiskEngine::minimizeTrackingErrorBatch(
+    const std::vector<std::vector<double>>& current_weights,
+    double max_turnover, double max_weight) const {
+    
+    ReadLock lock(state_mutex);
+    if (benchmark_weights.empty()) {
+        throw std::invalid_argument("Benchmark weights have not been set");
+    }
+    if (max_turnover < 0.0) {
+        throw std::invalid_argument("Maximum turnover must be non-negative");
+    }
+    if (max_weight <= 0.0 || max_weight * portfolio.size() < 1.0) {
+        throw std::invalid_argument("Maximum weight is too small to be fully invested");
+    }
+    for (const auto& weights : current_weights) {
+        if (weights.size() != portfolio.size()) {
+            throw std::invalid_argument("Weights must match portfolio size");
+        }
+    }
+    
+    // The step size depends only on the shared covariance, so it is computed once per batch
+    double lipschitz = std::max(2.0 * maxCovarianceEigenvalue(), 1e-12);
+    std::vector<TrackingErrorResult> results(current_weights.size());
+    
+    #pragma omp parallel for schedule(dynamic) num_threads(parallelThreads())
+    for (long k = 0; k < static_cast<long>(current_weights.size()); ++k) {
+        results[k] = solveTrackingError(current_weights[k], max_turnover, max_weight, lipschitz);
+    }
+    return results;
 }
\ No newline at end of file
@@ -4,6 +4,16 @@
 #include <vector>
 #include <random>
 #include <memory>
+#include <shared_mutex>
+#include <string>
+#include <cstdint>
+#include "instruments.h"
+#include "fixed_income.h"
+#include "mlmc.h"
+#include "block_correlation.h"
+#include "regime.h"
+#include "huge_pages.h"
+#include "sentiment.h"
 
 struct PortfolioAsset {
     double weight;          // Portfolio weight
@@ -19,7 +29,134 @@ struct RiskMetrics {
     double cvar_99;         // 99% Conditional Value at Risk
     double expected_return; // Expected portfolio return
     double portfolio_vol;   // Portfolio volatility
-    std::vector<double> simulation_results; // All simulation results
+    double tracking_error;  // Ex-ante tracking error over the horizon (0 without benchmark)
+    double active_var_95;   // 95% Monte Carlo VaR of the active return
+    double active_var_99;   // 99% Monte Carlo VaR of the active return
+    double analytic_active_var_95; // 95% delta-normal VaR of the active return
+    double analytic_active_var_99; // 99% delta-normal VaR of the active return
+    int pca_factors;               // Principal components simulated (0 = full Cholesky)
+    double pca_retained_variance;  // Share of the correlation trace carried by those components
+    double pca_truncation_error;   // |99% delta-normal VaR under the truncated minus the full correlation|
+    double var_95_std_error;       // Standard error of var_95 (stratum-weighted when stratified; 0 unless
+                                   // stratified or ScenarioSamplingSettings::standard_errors is set)
+    double var_99_std_error;       // Standard error of var_99
+    double cvar_95_std_error;      // Standard error of cvar_95
+    double cvar_99_std_error;      // Standard error of cvar_99
+    double liquidity_var_95;       // 95% VaR over asset-specific liquidation horizons, net of impact (0 without a liquidity profile)
+    double liquidity_var_99;       // 99% liquidity-adjusted VaR
+    double liquidity_cvar_95;      // 95% liquidity-adjusted CVaR
+    double liquidity_cvar_99;      // 99% liquidity-adjusted CVaR
+    double liquidation_cost;       // Square-root impact of exiting every position, as a portfolio return
+    std::vector<double> liquidation_days;   // Trading days to exit each position at the participation rate
+    LargeVector<double> simulation_results; // All simulation results
+    LargeVector<double> scenario_weights;   // Probability of each result (empty = equally weighted)
+};
+
+struct LiquidityProfile {
+    std::vector<double> average_daily_volume; // Traded value per day of each asset (empty = no adjustment)
+    double portfolio_value;       // Converts weights into position values, same currency as the volumes
+    double participation_rate;    // Largest share of an asset's daily volume sold per day
+    double impact_coefficient;    // Square-root law: cost = k * daily vol * sqrt(position / daily volume)
+    double trading_days_per_year;
+
+    LiquidityProfile()
+        : portfolio_value(0.0), participation_rate(0.1), impact_coefficient(1.0), trading_days_per_year(252.0) {}
+};
+
+enum class ScenarioRng {
+    MERSENNE_TWISTER, // Per-thread std::mt19937 with a fresh system seed
+    PHILOX            // Counter-based Philox4x32-10: scenario i gets the same draws on any thread
+};
+
+struct ScenarioSamplingSettings {
+    ScenarioRng rng;
+    uint64_t seed;          // Philox key (0 = fresh random key per run)
+    size_t num_strata;      // Equiprobable strata along the portfolio loss direction (0 = off)
+    double tail_fraction;   // Probability mass of the loss-side strata given extra scenarios
+    double tail_allocation; // Share of scenarios placed in those strata (0 = proportional allocation)
+    bool standard_errors;   // Estimate VaR/CVaR standard errors for plain Monte Carlo (always on when stratified)
+
+    ScenarioSamplingSettings()
+        : rng(ScenarioRng::MERSENNE_TWISTER), seed(0), num_strata(0), tail_fraction(0.05),
+          tail_allocation(0.0), standard_errors(false) {}
+};
+
+enum class PathSampler {
+    PSEUDO_RANDOM, // Mersenne Twister normals
+    SOBOL          // Sobol points mapped through the inverse normal CDF (digitally shifted when seeded)
+};
+
+struct PathSimulationSettings {
+    int num_paths;         // Simulated paths
+    int num_steps;         // Constant-mix rebalancing steps over the horizon
+    double horizon;        // Path length in years
+    PathSampler sampler;
+    bool brownian_bridge;  // Build each asset's path by Brownian bridge instead of step by step
+    uint64_t seed;         // 0 = random seed (pseudo-random) or unscrambled points (Sobol)
+
+    PathSimulationSettings()
+        : num_paths(10000), num_steps(21), horizon(21.0 / 252.0), sampler(PathSampler::PSEUDO_RANDOM),
+          brownian_bridge(false), seed(0) {}
+};
+
+struct PathRiskMetrics {
+    double expected_return;       // Mean portfolio return over the horizon
+    double var_95;                // 95% VaR of the horizon return
+    double cvar_95;               // 95% CVaR of the horizon return
+    double expected_max_drawdown; // Mean of the per-path maximum peak-to-trough drawdown
+    double max_drawdown_95;       // 95th percentile of the maximum drawdown
+    double probability_of_loss;   // Share of paths ending below their starting value
+    LargeVector<double> path_returns;  // Horizon return per path
+    LargeVector<double> max_drawdowns; // Maximum drawdown per path
+    std::vector<double> regime_occupancy; // Share of path steps spent in each regime (empty without a regime model)
+};
+
+enum class PathMetric {
+    MAX_DRAWDOWN,    // Expected maximum peak-to-trough drawdown
+    TERMINAL_WEALTH, // Expected wealth per unit invested at the horizon
+    SHORTFALL        // Expected shortfall of terminal wealth below a target, E[max(target - W, 0)]
+};
+
+struct TrackingErrorResult {
+    std::vector<double> weights; // Optimized portfolio weights
+    double tracking_error;       // Ex-ante tracking error over the horizon
+    double turnover;             // Sum of absolute weight changes from the current portfolio
+    int iterations;              // Projected gradient iterations used
+};
+
+enum class MixingDistribution {
+    STUDENT_T, // Multivariate t: the covariance is scaled by (nu - 2) / chi^2_nu
+    REGIME,    // Regime path over the horizon, from the model given to setRegimeModel
+    JUMP       // Compound Poisson jumps in the portfolio return with normal jump sizes
+};
+
+struct ConditionalTailSettings {
+    MixingDistribution mixing;
+    size_t num_draws;          // Mixing-variable draws, one conditionally normal component each
+    double degrees_of_freedom; // Student-t, > 2; the portfolio variance matches the Gaussian model
+    double jump_intensity;     // Expected jumps per year
+    double jump_mean;          // Mean portfolio return per jump
+    double jump_volatility;    // Standard deviation of the portfolio return per jump
+    uint64_t seed;             // 0 = random seed
+
+    ConditionalTailSettings()
+        : mixing(MixingDistribution::STUDENT_T), num_draws(10000), degrees_of_freedom(5.0),
+          jump_intensity(1.0), jump_mean(-0.05), jump_volatility(0.05), seed(0) {}
+};
+
+struct ConditionalTailMetrics {
+    double var_95;            // 95% VaR, root of the mixture tail probability
+    double var_99;            // 99% VaR
+    double cvar_95;           // 95% CVaR, closed form per component
+    double cvar_99;           // 99% CVaR
+    double var_95_std_error;  // Standard errors from the spread across mixing draws
+    double var_99_std_error;
+    double cvar_95_std_error;
+    double cvar_99_std_error;
+    double expected_return;   // Mean horizon return of the mixture
+    double portfolio_vol;     // Standard deviation of the horizon return
+    std::vector<double> component_means; // Conditional mean return of each draw
+    std::vector<double> component_vols;  // Conditional standard deviation of each draw
 };
 
 class MonteCarloRiskEngine {
@@ -28,29 +165,141 @@ private:
     std::vector<std::vector<double>> correlation_matrix;
     int num_simulations;
     double time_horizon; // Time horizon in years (e.g., 1/252 for 1 day)
+    std::vector<std::vector<double>> cholesky_factor; // Cached factor of correlation_matrix
+    std::vector<double> benchmark_weights;            // Empty when no benchmark is set
+    std::vector<EuropeanOption> option_positions;     // Non-linear positions on portfolio assets
+    std::vector<OptionGreeks> option_greeks;          // Greeks at today's spot, cached per position
+    OptionRevaluation option_revaluation;
+    double portfolio_value;                           // Converts option P&L into portfolio return
+    YieldCurveFactorModel yield_curve;                // Curve factors appended to the Cholesky system
+    BondBookExposure bond_book;                       // Bonds collapsed onto the curve factors
+    size_t num_curve_factors;                         // 0 without bonds, kYieldCurveFactors otherwise
+    SentimentFactorModel sentiment;                   // Loadings, correlations and tilts filled to n entries
+    size_t num_sentiment_factors;                     // 1 when the sentiment row follows the curve factors
+    double pca_variance_target;                       // Retained-variance threshold (0 = PCA mode off)
+    size_t pca_max_factors;                           // Cap on principal components (0 = none)
+    size_t num_pca_factors;                           // Components in use, 0 when simulating via Cholesky
+    double pca_retained_variance;                     // Trace share of the components in use
+    std::vector<double> pca_loadings;                 // n x k row-major V sqrt(Lambda) of the correlation
+    std::vector<double> pca_residual_vol;             // Idiosyncratic vol restoring unit diagonal
+    ScenarioSamplingSettings sampling;
+    std::shared_ptr<const BlockCorrelationFactor> block_correlation; // Replaces the dense matrix when set
+    LiquidityProfile liquidity;                       // Empty volumes = no liquidity-adjusted VaR
+    GaussianHMM regime_model;                         // No regimes = paths use the static asset parameters
+    std::vector<double> regime_start;                 // Regime distribution at the start of each path
+    std::vector<double> regime_cholesky;              // K x n x n row-major factors of the regime covariances
+    mutable std::shared_mutex state_mutex;            // Shared by runs and queries, exclusive for setters
+    
+    // Sampling state of one runSimulation call, kept off the engine so concurrent runs never share it
+    struct ScenarioPlan {
+        uint64_t key;                       // Philox key of the run
+        std::vector<double> loss_direction; // Unit normal-space direction of the linear return
+        std::vector<size_t> stratum_begin;  // First scenario of each stratum (+ end sentinel)
+        std::vector<double> stratum_mass;   // Probability of each stratum (empty = plain Monte Carlo)
+    };
     
     // Helper methods
     std::vector<std::vector<double>> choleskyDecomposition(const std::vector<std::vector<double>>& matrix);
-    std::vector<double> generateCorrelatedReturns(std::mt19937& gen, 
-                                                 const std::vector<std::vector<double>>& cholesky);
-    double calculatePortfolioReturn(const std::vector<double>& asset_returns);
-    double calculateVaR(std::vector<double>& returns, double confidence_level);
-    double calculateCVaR(const std::vector<double>& returns, double confidence_level, double var_value);
+    std::vector<std::vector<double>> jointCholeskyFactor(const std::vector<std::vector<double>>& correlation);
+    void refreshCholeskyFactor();
+    void refreshPrincipalComponents();
+    size_t normalsPerScenario() const;
+    std::vector<double> equityShockLoadings() const;
+    std::vector<double> linearExposure() const;
+    std::vector<double> lossDirection() const;
+    ScenarioPlan planScenarios(size_t num_scenarios) const;
+    void generateScenarioBlock(std::mt19937& gen, const ScenarioPlan& plan, size_t first, size_t count,
+                               std::vector<double>& normals, std::vector<double>& returns,
+                               std::vector<double>& factor_shocks) const;
+    void revalueOptionsBlock(const std::vector<double>& returns, size_t count, double* block_returns,
+                             std::vector<double>& spots, std::vector<double>& prices) const;
+    void covarianceProduct(const std::vector<double>& x, std::vector<double>& out) const;
+    double maxCovarianceEigenvalue() const;
+    TrackingErrorResult solveTrackingError(const std::vector<double>& current_weights,
+                                           double max_turnover, double max_weight,
+                                           double lipschitz) const;
+    double trackingError(const std::vector<double>& weights) const;
+    void clearYieldCurveModel();
+    void clearSentimentFactor();
+    void clearRegimeModel();
+    double calculateVaR(LargeVector<double>& returns, double confidence_level) const;
+    double calculateCVaR(const LargeVector<double>& returns, double confidence_level, double var_value) const;
 
 public:
     MonteCarloRiskEngine(const std::vector<PortfolioAsset>& assets,
                         const std::vector<std::vector<double>>& corr_matrix,
                         int simulations = 100000,
                         double horizon = 1.0/252.0); // Default 1 day
+
+    // Sector-block correlation for universes where the dense n x n matrix is too large to hold.
+    // Yield curves, factor simulation and benchmark-relative risk need the dense constructor.
+    MonteCarloRiskEngine(const std::vector<PortfolioAsset>& assets,
+                        const BlockCorrelationModel& correlation_model,
+                        int simulations = 100000,
+                        double horizon = 1.0/252.0);
+    
+    // Runs and risk queries may be called concurrently on one engine (e.g. from free-threaded
+    // Python); setters wait for the runs in flight and block new ones until they return
     
     // Main simulation method with OpenMP parallelization
-    RiskMetrics runSimulation();
+    RiskMetrics runSimulation() const;
+    
+    // Multi-step paths of the equity portfolio (bonds, options and factor mode are not path-simulated).
+    // Normals are bridged per asset before the Cholesky transform when brownian_bridge is set.
+    PathRiskMetrics simulatePaths(const PathSimulationSettings& settings) const;
+    
+    // Multilevel Monte Carlo estimate of a continuously rebalanced path metric: level l uses
+    // base_steps * refinement^l steps, coupled to level l-1 through shared Brownian increments
+    MultilevelResult estimatePathMetric(PathMetric metric, double horizon, const MultilevelSettings& settings,
+                                        double shortfall_target = 1.0) const;
+    
+    // Conditional Monte Carlo for a Gaussian mixture of the equity portfolio return over the horizon:
+    // only the mixing variable is simulated, the return given it is normal, so the tail is integrated
+    // exactly per draw (VaR by root-finding on the mixture CDF, CVaR in closed form)
+    ConditionalTailMetrics estimateConditionalTail(const ConditionalTailSettings& settings) const;
     
     // Utility methods
     void setNumSimulations(int simulations);
     void setTimeHorizon(double horizon);
     void updatePortfolio(const std::vector<PortfolioAsset>& assets);
     void updateCorrelationMatrix(const std::vector<std::vector<double>>& corr_matrix);
+    
+    // Option positions; their P&L over the horizon is added to the linear portfolio return
+    void setOptionPositions(const std::vector<EuropeanOption>& options, double portfolio_value,
+                            OptionRevaluation mode = OptionRevaluation::FULL);
+    
+    // Random stream and stratification of the standard-normal coordinate along w'L * vols
+    void setScenarioSampling(const ScenarioSamplingSettings& settings);
+    
+    // Bond book driven by level/slope/curve factors; an empty bond list removes it
+    void setYieldCurveModel(const YieldCurveFactorModel& model);
+    
+    // Common sentiment shock appended to the Cholesky system after any curve factors: asset i's
+    // return gains tilt_i * T + loading_i * sqrt(T) * s. Applies to runSimulation; empty loadings remove it.
+    void setSentimentFactor(const SentimentFactorModel& model);
+    
+    // Simulate on the leading principal components of the correlation matrix plus an
+    // idiosyncratic residual: O(n k) per scenario. retained_variance = 0 switches back to Cholesky.
+    void setFactorSimulation(double retained_variance, size_t max_factors = 0);
+    
+    // Regime-switching paths: simulatePaths draws each path's regime from start_probabilities
+    // (default: the model's initial distribution) and evolves it by the transition matrix, using the
+    // regime's mean and covariance in place of the asset parameters. A model without regimes removes it.
+    void setRegimeModel(const GaussianHMM& model, const std::vector<double>& start_probabilities = {});
+    
+    // Liquidity-adjusted VaR, evaluated in the same scenario pass as the standard VaR: each asset's
+    // horizon stretches to its unwind time at the participation rate, and impact is deducted
+    void setLiquidityProfile(const LiquidityProfile& profile);
+    
+    // Benchmark-relative risk; all methods share the cached Cholesky factor
+    void setBenchmarkWeights(const std::vector<double>& weights);
+    double calculateTrackingError(const std::vector<double>& weights) const;
+    std::vector<double> calculateTrackingErrors(const std::vector<std::vector<double>>& account_weights) const;
+    TrackingErrorResult minimizeTrackingError(const std::vector<double>& current_weights,
+                                              double max_turnover, double max_weight = 1.0) const;
+    std::vector<TrackingErrorResult> minimizeTrackingErrorBatch(
+        const std::vector<std::vector<double>>& current_weights,
+        double max_turnover, double max_weight = 1.0) const;
 };
 
 #endif // MONTECARLO_H
\ No newline at end of file
@@ -0,0 +1,554 @@
+#include "optimizer.h"
+#include "projections.h"
+#include "lifecycle.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <omp.h>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const double kWeightEpsilon = 1e-7;
+
+// Per-thread deque of open nodes. The owner works depth-first from the back,
+// idle threads steal the oldest (largest) subtrees from the front.
+template <typename T>
+class WorkQueue {
+private:
+    std::mutex mutex;
+    std::deque<T> items;
+
+public:
+    void push(T&& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(std::move(item));
+    }
+
+    bool popBack(T& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) return false;
+        item = std::move(items.back());
+        items.pop_back();
+        return true;
+    }
+
+    bool stealFront(T& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        return true;
+    }
+
+    std::deque<T>& unsafeItems() { return items; }
+};
+
+} // namespace
+
+CardinalityConstrainedOptimizer::CardinalityConstrainedOptimizer(
+    const std::vector<double>& returns,
+    const std::vector<double>& volatilities,
+    const std::vector<std::vector<double>>& corr_matrix,
+    const std::vector<double>& asset_prices,
+    const std::vector<double>& asset_lot_sizes)
+    : n(returns.size()), expected_returns(returns), prices(asset_prices), lot_sizes(asset_lot_sizes) {
+
+    if (n == 0) {
+        throw std::invalid_argument("Asset universe cannot be empty");
+    }
+    if (volatilities.size() != n) {
+        throw std::invalid_argument("Volatilities must match number of expected returns");
+    }
+    if (corr_matrix.size() != n || corr_matrix[0].size() != n) {
+        throw std::invalid_argument("Correlation matrix dimensions must match number of assets");
+    }
+    if (!prices.empty() && prices.size() != n) {
+        throw std::invalid_argument("Prices must match number of assets");
+    }
+    if (lot_sizes.empty()) {
+        lot_sizes.assign(n, 1.0);
+    } else if (lot_sizes.size() != n) {
+        throw std::invalid_argument("Lot sizes must match number of assets");
+    }
+
+    covariance.resize(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        if (corr_matrix[i].size() != n) {
+            throw std::invalid_argument("Correlation matrix must be square");
+        }
+        for (size_t j = 0; j < n; ++j) {
+            covariance[i * n + j] = volatilities[i] * volatilities[j] * corr_matrix[i][j];
+        }
+    }
+    max_eigenvalue = estimateMaxEigenvalue();
+}
+
+double CardinalityConstrainedOptimizer::estimateMaxEigenvalue() const {
+    // Power iteration; the estimate is inflated slightly so 1/L stays a safe step size
+    std::vector<double> x(n, 1.0 / std::sqrt(static_cast<double>(n))), y(n);
+    double lambda = 0.0;
+    for (int iter = 0; iter < 100; ++iter) {
+        for (size_t i = 0; i < n; ++i) {
+            double sum = 0.0;
+            for (size_t j = 0; j < n; ++j) {
+                sum += covariance[i * n + j] * x[j];
+            }
+            y[i] = sum;
+        }
+        double norm = std::sqrt(std::inner_product(y.begin(), y.end(), y.begin(), 0.0));
+        if (norm == 0.0) return 0.0;
+        for (size_t i = 0; i < n; ++i) x[i] = y[i] / norm;
+        if (std::abs(norm - lambda) < 1e-10 * norm) {
+            lambda = norm;
+            break;
+        }
+        lambda = norm;
+    }
+    return lambda * 1.05;
+}
+
+double CardinalityConstrainedOptimizer::objectiveValue(const std::vector<double>& w,
+                                                       double risk_aversion) const {
+    double variance = 0.0;
+    double mean = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        if (w[i] == 0.0) continue;
+        double row = 0.0;
+        for (size_t j = 0; j < n; ++j) {
+            row += covariance[i * n + j] * w[j];
+        }
+        variance += w[i] * row;
+        mean += w[i] * expected_returns[i];
+    }
+    return 0.5 * risk_aversion * variance - mean;
+}
+
+CardinalityConstrainedOptimizer::Relaxation CardinalityConstrainedOptimizer::solveRelaxation(
+    const std::vector<int8_t>& status,
+    const std::vector<double>& warm_start,
+    const CardinalityConstraints& constraints) const {
+
+    Relaxation relaxation;
+    relaxation.weights.assign(n, 0.0);
+    relaxation.feasible = false;
+    relaxation.objective = std::numeric_limits<double>::infinity();
+    relaxation.lower_bound = std::numeric_limits<double>::infinity();
+
+    // Compress to the non-excluded assets
+    std::vector<size_t> active;
+    std::vector<double> lower, upper;
+    for (size_t i = 0; i < n; ++i) {
+        if (status[i] < 0) continue;
+        active.push_back(i);
+        lower.push_back(status[i] > 0 ? constraints.min_weight : 0.0);
+        upper.push_back(constraints.max_weight);
+    }
+    size_t m = active.size();
+    double lower_sum = std::accumulate(lower.begin(), lower.end(), 0.0);
+    double upper_sum = std::accumulate(upper.begin(), upper.end(), 0.0);
+    if (m == 0 || lower_sum > 1.0 + 1e-12 || upper_sum < 1.0 - 1e-12) {
+        return relaxation;
+    }
+
+    double lambda = constraints.risk_aversion;
+    std::vector<double> sigma(m * m), mu(m);
+    for (size_t a = 0; a < m; ++a) {
+        mu[a] = expected_returns[active[a]];
+        for (size_t b = 0; b < m; ++b) {
+            sigma[a * m + b] = lambda * covariance[active[a] * n + active[b]];
+        }
+    }
+
+    auto gradient = [&](const std::vector<double>& x, std::vector<double>& g) {
+        for (size_t a = 0; a < m; ++a) {
+            double sum = 0.0;
+            const double* row = &sigma[a * m];
+            for (size_t b = 0; b < m; ++b) {
+                sum += row[b] * x[b];
+            }
+            g[a] = sum - mu[a];
+        }
+    };
+    auto objective = [&](const std::vector<double>& x, const std::vector<double>& g) {
+        // f(x) = 0.5 x'Sx - mu'x = 0.5 x'(g + mu) - mu'x
+        double value = 0.0;
+        for (size_t a = 0; a < m; ++a) {
+            value += 0.5 * x[a] * (g[a] + mu[a]) - mu[a] * x[a];
+        }
+        return value;
+    };
+
+    // Accelerated projected gradient (FISTA with adaptive restart), warm started from the parent
+    std::vector<double> x(m), x_prev(m), y(m), g(m), step(m);
+    for (size_t a = 0; a < m; ++a) {
+        x[a] = warm_start.empty() ? 1.0 / m : warm_start[active[a]];
+    }
+    projectBudgetBox(x, lower, upper, x);
+    y = x;
+    double lipschitz = std::max(lambda * max_eigenvalue, 1e-12);
+    double t = 1.0;
+    double f_prev = std::numeric_limits<double>::infinity();
+    for (int iter = 0; iter < 5000; ++iter) {
+        gradient(y, g);
+        for (size_t a = 0; a < m; ++a) {
+            step[a] = y[a] - g[a] / lipschitz;
+        }
+        x_prev.swap(x);
+        projectBudgetBox(step, lower, upper, x);
+
+        double change = 0.0;
+        for (size_t a = 0; a < m; ++a) {
+            change = std::max(change, std::abs(x[a] - x_prev[a]));
+        }
+        if (change < 1e-10) break;
+
+        gradient(x, g);
+        double f = objective(x, g);
+        if (f > f_prev) {
+            // Restart momentum when the objective increases
+            t = 1.0;
+            y = x;
+        } else {
+            double t_next = 0.5 * (1.0 + std::sqrt(1.0 + 4.0 * t * t));
+            double beta = (t - 1.0) / t_next;
+            for (size_t a = 0; a < m; ++a) {
+                y[a] = x[a] + beta * (x[a] - x_prev[a]);
+            }
+            t = t_next;
+        }
+        f_prev = f;
+    }
+
+    gradient(x, g);
+    double f = objective(x, g);
+
+    // Frank-Wolfe duality gap gives a valid lower bound from the inexact solution:
+    // min over the feasible set of the linearization is a fractional knapsack
+    std::vector<size_t> order(m);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return g[a] < g[b]; });
+    double remaining = 1.0 - lower_sum;
+    double linear_min = 0.0;
+    for (size_t a = 0; a < m; ++a) linear_min += g[a] * lower[a];
+    for (size_t idx : order) {
+        double room = std::min(upper[idx] - lower[idx], remaining);
+        linear_min += g[idx] * room;
+        remaining -= room;
+        if (remaining <= 0.0) break;
+    }
+    double linear_at_x = 0.0;
+    for (size_t a = 0; a < m; ++a) linear_at_x += g[a] * x[a];
+
+    for (size_t a = 0; a < m; ++a) {
+        relaxation.weights[active[a]] = x[a];
+    }
+    relaxation.objective = f;
+    relaxation.lower_bound = f + std::min(0.0, linear_min - linear_at_x);
+    relaxation.feasible = true;
+    return relaxation;
+}
+
+CardinalityConstrainedOptimizer::Relaxation CardinalityConstrainedOptimizer::solveSupport(
+    const std::vector<size_t>& support,
+    const std::vector<double>& warm_start,
+    const CardinalityConstraints& constraints) const {
+
+    std::vector<int8_t> status(n, -1);
+    for (size_t i : support) {
+        status[i] = 1;
+    }
+    return solveRelaxation(status, warm_start, constraints);
+}
+
+void CardinalityConstrainedOptimizer::roundToLots(OptimizationResult& result,
+                                                  const CardinalityConstraints& constraints) const {
+    double portfolio_value = constraints.portfolio_value;
+    double min_value = constraints.min_weight * portfolio_value * (1.0 - 1e-12);
+    double max_value = constraints.max_weight * portfolio_value * (1.0 + 1e-12);
+    std::vector<double> lot_value(n), lots(n, 0.0);
+    double invested = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        lot_value[i] = prices[i] * lot_sizes[i];
+        if (result.weights[i] <= 0.0 || lot_value[i] <= 0.0) continue;
+        lots[i] = std::floor(result.weights[i] * portfolio_value / lot_value[i]);
+        invested += lots[i] * lot_value[i];
+    }
+    double cash = portfolio_value - invested;
+
+    // Flooring can leave a holding below min_weight: top it up to the minimum if cash allows and
+    // one more lot stays within max_weight, otherwise sell it out so every holding is within bounds
+    for (size_t i = 0; i < n; ++i) {
+        if (lots[i] <= 0.0 || lots[i] * lot_value[i] >= min_value) continue;
+        double needed = std::ceil(min_value / lot_value[i]);
+        double cost = (needed - lots[i]) * lot_value[i];
+        if (cost <= cash && needed * lot_value[i] <= max_value) {
+            lots[i] = needed;
+            cash -= cost;
+        } else {
+            cash += lots[i] * lot_value[i];
+            lots[i] = 0.0;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (result.weights[i] <= 0.0 || lots[i] > 0.0 || lot_value[i] <= 0.0) continue;
+        double needed = std::max(1.0, std::ceil(min_value / lot_value[i]));
+        if (needed * lot_value[i] <= cash && needed * lot_value[i] <= max_value &&
+            result.weights[i] * portfolio_value - needed * lot_value[i] > -0.5 * lot_value[i]) {
+            lots[i] = needed;
+            cash -= needed * lot_value[i];
+        }
+    }
+
+    // Greedily spend leftover cash on the held asset furthest below its target, as long as one
+    // more lot undershoots less than it would overshoot and stays within max_weight
+    while (true) {
+        size_t best = n;
+        double best_deficit = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            if (lots[i] <= 0.0 || lot_value[i] > cash || (lots[i] + 1.0) * lot_value[i] > max_value) continue;
+            double deficit = result.weights[i] * portfolio_value - lots[i] * lot_value[i];
+            if (deficit > 0.5 * lot_value[i] && deficit > best_deficit) {
+                best_deficit = deficit;
+                best = i;
+            }
+        }
+        if (best == n) break;
+        lots[best] += 1.0;
+        cash -= lot_value[best];
+    }
+
+    result.quantities.assign(n, 0.0);
+    result.rounded = false;
+    for (size_t i = 0; i < n; ++i) {
+        double weight = lots[i] * lot_value[i] / portfolio_value;
+        if (std::fabs(weight - result.weights[i]) > 1e-12) result.rounded = true;
+        result.quantities[i] = lots[i] * lot_sizes[i];
+        result.weights[i] = weight;
+    }
+    result.cash_residual = cash;
+}
+
+OptimizationResult CardinalityConstrainedOptimizer::optimize(const CardinalityConstraints& constraints) const {
+    if (constraints.max_assets <= 0) {
+        throw std::invalid_argument("Maximum number of assets must be positive");
+    }
+    if (constraints.min_weight < 0.0 || constraints.max_weight <= 0.0 ||
+        constraints.min_weight > constraints.max_weight) {
+        throw std::invalid_argument("Weight bounds must satisfy 0 <= min_weight <= max_weight");
+    }
+    if (constraints.risk_aversion < 0.0) {
+        throw std::invalid_argument("Risk aversion must be non-negative");
+    }
+    if (constraints.portfolio_value > 0.0 && prices.empty()) {
+        throw std::invalid_argument("Prices are required for whole-lot rounding");
+    }
+
+    int max_assets = static_cast<int>(std::min<size_t>(constraints.max_assets, n));
+    if (max_assets * constraints.max_weight < 1.0 - 1e-12) {
+        throw std::invalid_argument("Constraints are infeasible: max_assets * max_weight < 1");
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(constraints.time_limit_seconds));
+
+    // Shared incumbent
+    std::mutex incumbent_mutex;
+    std::vector<double> best_weights;
+    std::atomic<double> best_objective{std::numeric_limits<double>::infinity()};
+
+    auto offerIncumbent = [&](const Relaxation& candidate) {
+        if (!candidate.feasible || candidate.objective >= best_objective.load()) return;
+        std::lock_guard<std::mutex> lock(incumbent_mutex);
+        if (candidate.objective < best_objective.load()) {
+            best_weights = candidate.weights;
+            best_objective.store(candidate.objective);
+        }
+    };
+    auto gapTolerance = [&](double incumbent) {
+        return constraints.relative_gap * std::max(1e-12, std::abs(incumbent));
+    };
+    // Top-K heuristic: keep all forced assets plus the largest relaxed weights
+    auto topKHeuristic = [&](const std::vector<int8_t>& status, const std::vector<double>& w) {
+        std::vector<size_t> support, candidates;
+        for (size_t i = 0; i < n; ++i) {
+            if (status[i] > 0) {
+                support.push_back(i);
+            } else if (status[i] == 0 && w[i] > kWeightEpsilon) {
+                candidates.push_back(i);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [&](size_t a, size_t b) { return w[a] > w[b]; });
+        for (size_t i : candidates) {
+            if (static_cast<int>(support.size()) >= max_assets) break;
+            support.push_back(i);
+        }
+        offerIncumbent(solveSupport(support, w, constraints));
+    };
+
+    int num_threads = parallelThreads();
+    std::vector<WorkQueue<Node>> queues(num_threads);
+    std::atomic<long> pending{1};
+    std::atomic<long> nodes_explored{0};
+    std::atomic<bool> timed_out{false};
+    std::vector<double> fathomed_bound(num_threads, std::numeric_limits<double>::infinity());
+
+    Node root;
+    root.status.assign(n, 0);
+    root.parent_bound = -std::numeric_limits<double>::infinity();
+    root.num_included = 0;
+    root.depth = 0;
+    queues[0].push(std::move(root));
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        std::mt19937 victim_gen(static_cast<unsigned>(tid) * 7919u + 1u);
+        std::uniform_int_distribution<int> victim_dist(0, num_threads - 1);
+        Node node;
+
+        while (pending.load() > 0 && !timed_out.load()) {
+            bool have_node = queues[tid].popBack(node);
+            for (int attempt = 0; !have_node && attempt < 2 * num_threads; ++attempt) {
+                int victim = victim_dist(victim_gen);
+                if (victim != tid) {
+                    have_node = queues[victim].stealFront(node);
+                }
+            }
+            if (!have_node) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            double incumbent = best_objective.load();
+            if (node.parent_bound >= incumbent - gapTolerance(incumbent)) {
+                fathomed_bound[tid] = std::min(fathomed_bound[tid], node.parent_bound);
+                pending.fetch_sub(1);
+                continue;
+            }
+
+            Relaxation relaxation = solveRelaxation(node.status, node.warm_start, constraints);
+            nodes_explored.fetch_add(1);
+
+            incumbent = best_objective.load();
+            if (!relaxation.feasible) {
+                pending.fetch_sub(1);
+                continue;
+            }
+            if (relaxation.lower_bound >= incumbent - gapTolerance(incumbent)) {
+                fathomed_bound[tid] = std::min(fathomed_bound[tid], relaxation.lower_bound);
+                pending.fetch_sub(1);
+                continue;
+            }
+
+            // Check whether the relaxed solution already satisfies cardinality and minimum weights
+            std::vector<size_t> support;
+            size_t branch_index = n;
+            double branch_weight = 0.0;
+            bool min_weight_violated = false;
+            for (size_t i = 0; i < n; ++i) {
+                double w = relaxation.weights[i];
+                if (w <= kWeightEpsilon) continue;
+                support.push_back(i);
+                bool violates = w < constraints.min_weight - kWeightEpsilon;
+                min_weight_violated = min_weight_violated || violates;
+                if (node.status[i] == 0 && w > branch_weight) {
+                    branch_index = i;
+                    branch_weight = w;
+                }
+            }
+
+            if (static_cast<int>(support.size()) <= max_assets && !min_weight_violated) {
+                // Relaxation is feasible for the mixed-integer problem; polish on its support
+                offerIncumbent(solveSupport(support, relaxation.weights, constraints));
+                fathomed_bound[tid] = std::min(fathomed_bound[tid], relaxation.lower_bound);
+                pending.fetch_sub(1);
+                continue;
+            }
+            if (branch_index == n) {
+                pending.fetch_sub(1);
+                continue;
+            }
+
+            if (node.depth % 5 == 0) {
+                topKHeuristic(node.status, relaxation.weights);
+            }
+
+            Node exclude_child;
+            exclude_child.status = node.status;
+            exclude_child.status[branch_index] = -1;
+            exclude_child.warm_start = relaxation.weights;
+            exclude_child.parent_bound = relaxation.lower_bound;
+            exclude_child.num_included = node.num_included;
+            exclude_child.depth = node.depth + 1;
+
+            Node include_child;
+            include_child.status = std::move(node.status);
+            include_child.status[branch_index] = 1;
+            include_child.warm_start = std::move(relaxation.weights);
+            include_child.parent_bound = relaxation.lower_bound;
+            include_child.num_included = node.num_included + 1;
+            include_child.depth = node.depth + 1;
+            if (include_child.num_included >= max_assets) {
+                for (size_t i = 0; i < n; ++i) {
+                    if (include_child.status[i] == 0) include_child.status[i] = -1;
+                }
+            }
+
+            // Include branch is pushed last so the owner dives into it first
+            pending.fetch_add(2);
+            queues[tid].push(std::move(exclude_child));
+            queues[tid].push(std::move(include_child));
+            pending.fetch_sub(1);
+
+            if (std::chrono::steady_clock::now() >= deadline) {
+                timed_out.store(true);
+            }
+        }
+    }
+
+    // Lower bound over everything not solved to completion
+    double lower_bound = *std::min_element(fathomed_bound.begin(), fathomed_bound.end());
+    for (auto& queue : queues) {
+        for (const Node& open : queue.unsafeItems()) {
+            lower_bound = std::min(lower_bound, open.parent_bound);
+        }
+    }
+
+    if (best_weights.empty()) {
+        throw std::runtime_error("No feasible portfolio found within the time limit");
+    }
+
+    OptimizationResult result;
+    result.weights = best_weights;
+    result.cash_residual = 0.0;
+    result.nodes_explored = nodes_explored.load();
+    result.timed_out = timed_out.load();
+    result.rounded = false;
+    if (constraints.portfolio_value > 0.0) {
+        roundToLots(result, constraints);
+    }
+    // Optimality is proven for the continuous weights only, not for their lot-rounded neighbour
+    result.proven_optimal = !result.timed_out && !result.rounded;
+
+    result.objective = objectiveValue(result.weights, constraints.risk_aversion);
+    result.lower_bound = std::min(lower_bound, best_objective.load());
+    result.expected_return = 0.0;
+    double variance = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        result.expected_return += result.weights[i] * expected_returns[i];
+        for (size_t j = 0; j < n; ++j) {
+            variance += result.weights[i] * result.weights[j] * covariance[i * n + j];
+        }
+    }
+    result.portfolio_vol = std::sqrt(std::max(0.0, variance));
+    return result;
+}
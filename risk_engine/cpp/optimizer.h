@@ -0,0 +1,83 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+struct CardinalityConstraints {
+    int max_assets;            // Maximum number of holdings (K)
+    double min_weight;         // Minimum weight of any held asset
+    double max_weight;         // Maximum weight of any single asset
+    double risk_aversion;      // Mean-variance risk aversion (lambda)
+    double portfolio_value;    // Portfolio value for whole-share rounding (0 disables rounding)
+    double time_limit_seconds; // Wall-clock budget; best found solution is returned when exceeded
+    double relative_gap;       // Stop once (incumbent - bound) / |incumbent| falls below this
+
+    CardinalityConstraints()
+        : max_assets(10), min_weight(0.0), max_weight(1.0), risk_aversion(1.0),
+          portfolio_value(0.0), time_limit_seconds(5.0), relative_gap(1e-6) {}
+};
+
+struct OptimizationResult {
+    std::vector<double> weights;    // Optimal (or best found) weights
+    std::vector<double> quantities; // Whole-lot quantities (empty when rounding is disabled)
+    double cash_residual;           // Uninvested value after lot rounding
+    double objective;               // 0.5 * lambda * w'Sw - mu'w of the returned weights
+    double lower_bound;             // Best proven lower bound on the objective
+    double expected_return;         // Expected portfolio return
+    double portfolio_vol;           // Portfolio volatility
+    long nodes_explored;            // Branch-and-bound nodes solved
+    bool proven_optimal;            // True if the search tree was exhausted within the gap and the
+                                    // weights were not moved afterwards by lot rounding
+    bool timed_out;                 // True if the time limit stopped the search
+    bool rounded;                   // True if lot rounding changed any weight
+};
+
+class CardinalityConstrainedOptimizer {
+private:
+    size_t n;
+    std::vector<double> expected_returns;
+    std::vector<double> covariance;  // Row-major n x n covariance matrix
+    std::vector<double> prices;      // Per-asset prices (optional, for lot rounding)
+    std::vector<double> lot_sizes;   // Per-asset lot sizes (defaults to whole shares)
+    double max_eigenvalue;           // Largest eigenvalue of the covariance (step size bound)
+
+    struct Node {
+        std::vector<int8_t> status;  // -1 excluded, 0 free, +1 included
+        std::vector<double> warm_start;
+        double parent_bound;
+        int num_included;
+        int depth;
+    };
+
+    struct Relaxation {
+        std::vector<double> weights;
+        double objective;
+        double lower_bound;
+        bool feasible;
+    };
+
+    // Helper methods
+    double estimateMaxEigenvalue() const;
+    double objectiveValue(const std::vector<double>& w, double risk_aversion) const;
+    Relaxation solveRelaxation(const std::vector<int8_t>& status,
+                               const std::vector<double>& warm_start,
+                               const CardinalityConstraints& constraints) const;
+    Relaxation solveSupport(const std::vector<size_t>& support,
+                            const std::vector<double>& warm_start,
+                            const CardinalityConstraints& constraints) const;
+    void roundToLots(OptimizationResult& result, const CardinalityConstraints& constraints) const;
+
+public:
+    CardinalityConstrainedOptimizer(const std::vector<double>& expected_returns,
+                                    const std::vector<double>& volatilities,
+                                    const std::vector<std::vector<double>>& corr_matrix,
+                                    const std::vector<double>& prices = {},
+                                    const std::vector<double>& lot_sizes = {});
+
+    // Branch-and-bound over asset inclusion, parallelized with work stealing across threads
+    OptimizationResult optimize(const CardinalityConstraints& constraints) const;
+};
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,269 @@
+#include "performance.h"
+#include "lifecycle.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// exp(y * t) stays finite for |y * t| below this
+const double kMaxExponent = 700.0;
+
+// Points probed for a sign change when the end points of the search range agree
+const int kBracketScanPoints = 64;
+
+// Weight totals of portfolio and benchmark may differ by this much in a period
+const double kWeightTolerance = 1e-6;
+
+void checkOffsets(const std::vector<size_t>& offsets, size_t length, const char* what) {
+    if (offsets.empty() || offsets.front() != 0 || offsets.back() != length) {
+        throw std::invalid_argument(std::string(what) + " offsets must start at 0 and end at the data length");
+    }
+    for (size_t p = 1; p < offsets.size(); ++p) {
+        if (offsets[p] < offsets[p - 1]) {
+            throw std::invalid_argument(std::string(what) + " offsets must be non-decreasing");
+        }
+    }
+}
+
+// Net present value of the investor's flows at continuously compounded rate y, and its derivative
+inline void presentValue(const double* amounts, const double* times, size_t count, double y,
+                         double& npv, double& slope) {
+    double value = 0.0, derivative = 0.0;
+    #pragma omp simd reduction(+:value, derivative)
+    for (size_t k = 0; k < count; ++k) {
+        double discounted = amounts[k] * std::exp(-y * times[k]);
+        value += discounted;
+        derivative -= times[k] * discounted;
+    }
+    npv = value;
+    slope = derivative;
+}
+
+// Newton on ln(1 + IRR) inside a sign-change bracket, bisecting whenever a step leaves it
+void solveIrr(const double* amounts, const double* times, size_t count, double guess,
+              const IrrSettings& settings, PerformanceResult& result) {
+    result.money_weighted_return = std::numeric_limits<double>::quiet_NaN();
+    result.irr_iterations = 0;
+    result.irr_converged = false;
+
+    double horizon = times[count - 1];
+    double limit = std::min(settings.max_log_rate, kMaxExponent / horizon);
+    double lo = -limit, hi = limit, f_lo, f_hi, unused;
+    presentValue(amounts, times, count, lo, f_lo, unused);
+    presentValue(amounts, times, count, hi, f_hi, unused);
+    if (f_lo * f_hi > 0.0) {
+        // Mixed deposits and withdrawals can put an even number of roots in the range
+        bool found = false;
+        double previous = lo, f_previous = f_lo;
+        for (int s = 1; s <= kBracketScanPoints && !found; ++s) {
+            double y = -limit + 2.0 * limit * s / kBracketScanPoints;
+            double f_y;
+            presentValue(amounts, times, count, y, f_y, unused);
+            if (f_previous * f_y <= 0.0) {
+                lo = previous; f_lo = f_previous;
+                hi = y; f_hi = f_y;
+                found = true;
+            }
+            previous = y;
+            f_previous = f_y;
+        }
+        if (!found) return;
+    }
+
+    double y = std::min(std::max(guess, lo), hi);
+    for (int iteration = 1; iteration <= settings.max_iterations; ++iteration) {
+        double f, slope;
+        presentValue(amounts, times, count, y, f, slope);
+        result.irr_iterations = iteration;
+        if (f == 0.0) {
+            result.irr_converged = true;
+            break;
+        }
+        if ((f < 0.0) == (f_lo < 0.0)) {
+            lo = y; f_lo = f;
+        } else {
+            hi = y; f_hi = f;
+        }
+        double next = 0.5 * (lo + hi);
+        if (slope != 0.0) {
+            double newton = y - f / slope;
+            if (newton > lo && newton < hi) next = newton;
+        }
+        double step = std::abs(next - y);
+        y = next;
+        if (step < settings.tolerance || hi - lo < settings.tolerance) {
+            result.irr_converged = true;
+            break;
+        }
+    }
+    result.money_weighted_return = std::expm1(y);
+}
+
+void measureOne(const ValueHistories& histories, size_t first, size_t last, const IrrSettings& settings,
+                std::vector<double>& amounts, std::vector<double>& times, PerformanceResult& result) {
+    const double* values = histories.values.data();
+    const double* flows = histories.flows.empty() ? nullptr : histories.flows.data();
+    size_t count = last - first;
+
+    result.time_weighted_return = 0.0;
+    result.annualized_twr = 0.0;
+    result.money_weighted_return = std::numeric_limits<double>::quiet_NaN();
+    result.years = count > 0 ? histories.times[last - 1] - histories.times[first] : 0.0;
+    result.irr_iterations = 0;
+    result.irr_converged = false;
+    if (count < 2) return;
+
+    // Each sub-period ends at an observation; its flow arrived during the period
+    double growth = 1.0;
+    for (size_t i = first + 1; i < last; ++i) {
+        double start = values[i - 1];
+        if (start <= 0.0) continue; // No capital at risk in this period
+        double flow = flows ? flows[i] : 0.0;
+        growth *= (values[i] - flow) / start;
+    }
+    result.time_weighted_return = growth - 1.0;
+    if (growth <= 0.0) {
+        // Losing everything (or more, once flows are removed) annualizes to a total loss
+        result.annualized_twr = -1.0;
+    } else {
+        result.annualized_twr = result.years > 1.0 ? std::pow(growth, 1.0 / result.years) - 1.0
+                                                   : result.time_weighted_return;
+    }
+    if (result.years <= 0.0) return;
+
+    // Investor's view: pay in the first value and every deposit, receive the final value
+    amounts.resize(count);
+    times.resize(count);
+    for (size_t k = 0; k < count; ++k) {
+        amounts[k] = k == 0 ? -values[first] : -(flows ? flows[first + k] : 0.0);
+        times[k] = histories.times[first + k] - histories.times[first];
+    }
+    amounts[count - 1] += values[last - 1];
+
+    double guess = growth > 0.0 ? std::log(growth) / result.years : 0.0;
+    solveIrr(amounts.data(), times.data(), count, guess, settings, result);
+}
+
+// Carino's logarithmic linking coefficient for a period (or the whole horizon); returns > -100%
+inline double linkingFactor(double portfolio_return, double benchmark_return) {
+    double difference = portfolio_return - benchmark_return;
+    if (std::abs(difference) < 1e-14) return 1.0 / (1.0 + portfolio_return);
+    return (std::log1p(portfolio_return) - std::log1p(benchmark_return)) / difference;
+}
+
+} // namespace
+
+std::vector<PerformanceResult> measurePerformance(const ValueHistories& histories, const IrrSettings& settings) {
+    size_t length = histories.values.size();
+    checkOffsets(histories.offsets, length, "History");
+    if (histories.times.size() != length) {
+        throw std::invalid_argument("Times must match the number of values");
+    }
+    if (!histories.flows.empty() && histories.flows.size() != length) {
+        throw std::invalid_argument("Flows must be empty or match the number of values");
+    }
+    if (settings.max_iterations <= 0 || settings.tolerance <= 0.0 || settings.max_log_rate <= 0.0) {
+        throw std::invalid_argument("IRR iterations, tolerance and search limit must be positive");
+    }
+    size_t num_portfolios = histories.offsets.size() - 1;
+    for (size_t p = 0; p < num_portfolios; ++p) {
+        for (size_t i = histories.offsets[p] + 1; i < histories.offsets[p + 1]; ++i) {
+            if (!(histories.times[i] > histories.times[i - 1])) {
+                throw std::invalid_argument("Observation times must increase within each portfolio");
+            }
+        }
+    }
+
+    std::vector<PerformanceResult> results(num_portfolios);
+    #pragma omp parallel num_threads(parallelThreads())
+    {
+        std::vector<double> amounts, times; // Per-thread scratch, reused across portfolios
+        #pragma omp for schedule(dynamic, 64)
+        for (long p = 0; p < static_cast<long>(num_portfolios); ++p) {
+            measureOne(histories, histories.offsets[p], histories.offsets[p + 1], settings, amounts, times, results[p]);
+        }
+    }
+    return results;
+}
+
+std::vector<AttributionResult> attributePerformance(const AttributionInputs& inputs) {
+    size_t k = inputs.num_classes;
+    if (k == 0) {
+        throw std::invalid_argument("Need at least one asset class");
+    }
+    size_t length = inputs.portfolio_weights.size();
+    if (length % k != 0 || inputs.portfolio_returns.size() != length ||
+        inputs.benchmark_weights.size() != length || inputs.benchmark_returns.size() != length) {
+        throw std::invalid_argument("Weights and returns must all hold num_classes values per period");
+    }
+    checkOffsets(inputs.offsets, length / k, "Period");
+    for (size_t t = 0; t < length / k; ++t) {
+        double portfolio_total = 0.0, benchmark_total = 0.0;
+        for (size_t c = 0; c < k; ++c) {
+            portfolio_total += inputs.portfolio_weights[t * k + c];
+            benchmark_total += inputs.benchmark_weights[t * k + c];
+        }
+        if (std::abs(portfolio_total - benchmark_total) > kWeightTolerance) {
+            throw std::invalid_argument("Portfolio and benchmark weights must have the same total in every period");
+        }
+    }
+
+    // Period returns first, so invalid ones are reported before any parallel work
+    size_t num_periods = length / k;
+    std::vector<double> period_portfolio(num_periods), period_benchmark(num_periods);
+    #pragma omp parallel for schedule(static) if (num_periods > 4096) num_threads(parallelThreads())
+    for (long t = 0; t < static_cast<long>(num_periods); ++t) {
+        double portfolio_return = 0.0, benchmark_return = 0.0;
+        for (size_t c = 0; c < k; ++c) {
+            portfolio_return += inputs.portfolio_weights[t * k + c] * inputs.portfolio_returns[t * k + c];
+            benchmark_return += inputs.benchmark_weights[t * k + c] * inputs.benchmark_returns[t * k + c];
+        }
+        period_portfolio[t] = portfolio_return;
+        period_benchmark[t] = benchmark_return;
+    }
+    for (size_t t = 0; t < num_periods; ++t) {
+        if (!(period_portfolio[t] > -1.0 && period_benchmark[t] > -1.0)) {
+            throw std::invalid_argument("Period returns must be greater than -100%");
+        }
+    }
+
+    size_t num_portfolios = inputs.offsets.size() - 1;
+    std::vector<AttributionResult> results(num_portfolios);
+    #pragma omp parallel for schedule(dynamic, 64) num_threads(parallelThreads())
+    for (long p = 0; p < static_cast<long>(num_portfolios); ++p) {
+        AttributionResult& result = results[p];
+        result.allocation.assign(k, 0.0);
+        result.selection.assign(k, 0.0);
+        result.interaction.assign(k, 0.0);
+
+        size_t first = inputs.offsets[p], last = inputs.offsets[p + 1];
+        double portfolio_growth = 1.0, benchmark_growth = 1.0;
+        for (size_t t = first; t < last; ++t) {
+            portfolio_growth *= 1.0 + period_portfolio[t];
+            benchmark_growth *= 1.0 + period_benchmark[t];
+        }
+        result.portfolio_return = portfolio_growth - 1.0;
+        result.benchmark_return = benchmark_growth - 1.0;
+        result.excess_return = result.portfolio_return - result.benchmark_return;
+        if (last == first) continue;
+
+        double total_factor = linkingFactor(result.portfolio_return, result.benchmark_return);
+        for (size_t t = first; t < last; ++t) {
+            const double* wp = &inputs.portfolio_weights[t * k];
+            const double* rp = &inputs.portfolio_returns[t * k];
+            const double* wb = &inputs.benchmark_weights[t * k];
+            const double* rb = &inputs.benchmark_returns[t * k];
+            double benchmark_return = period_benchmark[t];
+            double scale = linkingFactor(period_portfolio[t], benchmark_return) / total_factor;
+            for (size_t c = 0; c < k; ++c) {
+                double active_weight = wp[c] - wb[c];
+                result.allocation[c] += scale * active_weight * (rb[c] - benchmark_return);
+                result.selection[c] += scale * wb[c] * (rp[c] - rb[c]);
+                result.interaction[c] += scale * active_weight * (rp[c] - rb[c]);
+            }
+        }
+    }
+    return results;
+}
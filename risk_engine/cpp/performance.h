@@ -0,0 +1,65 @@
+#ifndef PERFORMANCE_H
+#define PERFORMANCE_H
+
+#include <vector>
+#include <cstddef>
+
+// Batched return measurement over portfolio value histories (the portfolio_snapshots table).
+// Histories of all portfolios are stored back to back in flat arrays, portfolio p occupying
+// [offsets[p], offsets[p + 1]), so a nightly run over every account is one pass over memory.
+
+struct ValueHistories {
+    std::vector<size_t> offsets; // Portfolio p's observations are [offsets[p], offsets[p + 1]); size P + 1
+    std::vector<double> times;   // Observation time in years, increasing within each portfolio
+    std::vector<double> values;  // Portfolio value at each observation, including that date's flow
+    std::vector<double> flows;   // External flow at each observation (+ deposit, - withdrawal); empty = none
+};
+
+struct IrrSettings {
+    int max_iterations;  // Newton steps per portfolio, bisection fallbacks included
+    double tolerance;    // On the continuously compounded rate
+    double max_log_rate; // Search limit for |ln(1 + IRR)|
+
+    IrrSettings() : max_iterations(100), tolerance(1e-12), max_log_rate(20.0) {}
+};
+
+struct PerformanceResult {
+    double time_weighted_return;  // Chained sub-period returns with flows removed
+    double annualized_twr;        // (1 + TWR)^(1 / years) - 1; equals TWR under one year of history,
+                                  // -1 when TWR <= -100%
+    double money_weighted_return; // Annual IRR of the investor's flows and final value
+    double years;                 // Length of the history
+    int irr_iterations;
+    bool irr_converged;           // False when no sign change was found or the history is too short
+};
+
+// TWR and IRR of every portfolio, in parallel across portfolios
+std::vector<PerformanceResult> measurePerformance(const ValueHistories& histories,
+                                                  const IrrSettings& settings = IrrSettings());
+
+// Brinson-Fachler attribution of portfolio against benchmark by asset class, linked across periods
+// with Carino factors so the effects add up to the geometric excess return. Inputs are
+// [period][class] blocks laid out back to back, portfolio p owning periods [offsets[p], offsets[p + 1]).
+struct AttributionInputs {
+    size_t num_classes;                    // K, e.g. one per assets.type
+    std::vector<size_t> offsets;           // Size P + 1, in periods
+    std::vector<double> portfolio_weights; // Beginning-of-period weight per class
+    std::vector<double> portfolio_returns; // Period return of the portfolio's holdings per class
+    std::vector<double> benchmark_weights; // Same total as the portfolio weights in every period
+    std::vector<double> benchmark_returns;
+
+    AttributionInputs() : num_classes(0) {}
+};
+
+struct AttributionResult {
+    std::vector<double> allocation;  // Per class: (wp - wb)(rb - Rb), linked
+    std::vector<double> selection;   // Per class: wb (rp - rb), linked
+    std::vector<double> interaction; // Per class: (wp - wb)(rp - rb), linked
+    double portfolio_return;         // Compounded over the periods
+    double benchmark_return;
+    double excess_return;            // portfolio_return - benchmark_return = sum of all effects
+};
+
+std::vector<AttributionResult> attributePerformance(const AttributionInputs& inputs);
+
+#endif // PERFORMANCE_H
@@ -0,0 +1,76 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cstdint>
+#include <cstddef>
+#include "vecmath.h"
+
+// Philox4x32-10 counter-based generator (Salmon et al. 2011). The output is a pure function of
+// (counter, key), so the draws of any scenario can be produced on any thread, in any order.
+namespace philox {
+
+inline void mulHiLo(uint32_t a, uint32_t b, uint32_t& hi, uint32_t& lo) {
+    uint64_t product = static_cast<uint64_t>(a) * b;
+    hi = static_cast<uint32_t>(product >> 32);
+    lo = static_cast<uint32_t>(product);
+}
+
+inline void generate(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]) {
+    const uint32_t kMultiplier0 = 0xD2511F53, kMultiplier1 = 0xCD9E8D57;
+    const uint32_t kWeyl0 = 0x9E3779B9, kWeyl1 = 0xBB67AE85;
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+        uint32_t hi0, lo0, hi1, lo1;
+        mulHiLo(kMultiplier0, c0, hi0, lo0);
+        mulHiLo(kMultiplier1, c2, hi1, lo1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += kWeyl0;
+        k1 += kWeyl1;
+    }
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+// Two uniforms in (0, 1) with 53-bit resolution: draws 2j and 2j+1 of `stream` under `key`
+inline void uniformPair(uint64_t key, uint64_t stream, uint64_t j, double& u0, double& u1) {
+    const double kScale = 1.0 / 9007199254740992.0; // 2^-53
+    uint32_t counter[4] = {static_cast<uint32_t>(j), static_cast<uint32_t>(j >> 32),
+                           static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)};
+    uint32_t k[2] = {static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)};
+    uint32_t out[4];
+    generate(counter, k, out);
+    uint64_t a = ((static_cast<uint64_t>(out[0]) << 32) | out[1]) >> 11;
+    uint64_t b = ((static_cast<uint64_t>(out[2]) << 32) | out[3]) >> 11;
+    u0 = (static_cast<double>(a) + 0.5) * kScale;
+    u1 = (static_cast<double>(b) + 0.5) * kScale;
+}
+
+// Draw `index` of `stream` as a uniform in (0, 1)
+inline double uniform(uint64_t key, uint64_t stream, uint64_t index) {
+    double u0, u1;
+    uniformPair(key, stream, index >> 1, u0, u1);
+    return (index & 1) ? u1 : u0;
+}
+
+// Draws 0..count-1 of `stream` as standard normals (inverse CDF, so strata and antithetics map cleanly)
+inline void normals(uint64_t key, uint64_t stream, size_t count, double* out) {
+    size_t pairs = count / 2;
+    for (size_t j = 0; j < pairs; ++j) {
+        uniformPair(key, stream, j, out[2 * j], out[2 * j + 1]);
+    }
+    if (count & 1) {
+        double spare;
+        uniformPair(key, stream, pairs, out[count - 1], spare);
+    }
+    #pragma omp simd
+    for (size_t k = 0; k < count; ++k) {
+        out[k] = vecmath::normInv(out[k]);
+    }
+}
+
+} // namespace philox
+
+#endif // PHILOX_H
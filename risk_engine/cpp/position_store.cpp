@@ -0,0 +1,356 @@
+#include "position_store.h"
+#include "lifecycle.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+
+using ReadLock = std::shared_lock<std::shared_mutex>;
+using WriteLock = std::unique_lock<std::shared_mutex>;
+
+const char* const kAssetTypeNames[kAssetTypeCount] = {"stock", "bond", "crypto", "reit", "cash", "commodity"};
+
+// Below this many portfolios the normalization pass is not worth a parallel region
+const size_t kParallelPortfolios = 256;
+
+// "YYYY-MM-DD" (optionally followed by a time, as DATETIME columns are) to YYYYMMDD; "" is 0
+int32_t parseDate(const std::string& date) {
+    if (date.empty()) return 0;
+    bool valid = date.size() >= 10 && date[4] == '-' && date[7] == '-';
+    for (size_t i : {0, 1, 2, 3, 5, 6, 8, 9}) {
+        valid = valid && std::isdigit(static_cast<unsigned char>(date[i]));
+    }
+    if (!valid) {
+        throw std::invalid_argument("Price date must be YYYY-MM-DD: " + date);
+    }
+    return std::stoi(date.substr(0, 4)) * 10000 + std::stoi(date.substr(5, 2)) * 100 + std::stoi(date.substr(8, 2));
+}
+
+void checkPosition(const PositionRecord& position) {
+    if (!std::isfinite(position.quantity)) {
+        throw std::invalid_argument("Position quantity must be finite");
+    }
+    if (!std::isfinite(position.purchase_price) || position.purchase_price < 0.0) {
+        throw std::invalid_argument("Purchase price must be finite and non-negative");
+    }
+}
+
+void checkPrice(const PriceRecord& price) {
+    if (!std::isfinite(price.price) || price.price < 0.0) {
+        throw std::invalid_argument("Price must be finite and non-negative");
+    }
+    parseDate(price.price_date);
+}
+
+template <typename T>
+size_t columnBytes(const std::vector<T>& column) {
+    return column.capacity() * sizeof(T);
+}
+
+} // namespace
+
+AssetType parseAssetType(const std::string& name) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (size_t t = 0; t < kAssetTypeCount; ++t) {
+        if (lower == kAssetTypeNames[t]) return static_cast<AssetType>(t);
+    }
+    throw std::invalid_argument("Unknown asset type: " + name);
+}
+
+std::string assetTypeName(AssetType type) {
+    return kAssetTypeNames[static_cast<size_t>(type)];
+}
+
+uint32_t PositionStore::portfolioSlot(int64_t portfolio_id) {
+    auto it = slot_of_portfolio.find(portfolio_id);
+    if (it != slot_of_portfolio.end()) return it->second;
+    uint32_t slot = static_cast<uint32_t>(portfolio_ids.size());
+    portfolio_ids.push_back(portfolio_id);
+    position_counts.push_back(0);
+    slot_of_portfolio.emplace(portfolio_id, slot);
+    return slot;
+}
+
+void PositionStore::upsertLocked(const PositionRecord& position) {
+    checkPosition(position);
+    uint32_t portfolio = portfolioSlot(position.portfolio_id);
+    auto it = slot_of_asset.find(position.asset_id);
+    if (it == slot_of_asset.end()) {
+        slot_of_asset.emplace(position.asset_id, asset_ids.size());
+        asset_ids.push_back(position.asset_id);
+        portfolio_slots.push_back(portfolio);
+        types.push_back(static_cast<uint8_t>(position.type));
+        quantities.push_back(position.quantity);
+        purchase_prices.push_back(position.purchase_price);
+        prices.push_back(position.purchase_price);
+        price_dates.push_back(0);
+        symbols.push_back(position.symbol);
+        ++position_counts[portfolio];
+        return;
+    }
+    size_t i = it->second;
+    if (portfolio_slots[i] != portfolio) {
+        --position_counts[portfolio_slots[i]];
+        ++position_counts[portfolio];
+        portfolio_slots[i] = portfolio;
+    }
+    types[i] = static_cast<uint8_t>(position.type);
+    quantities[i] = position.quantity;
+    purchase_prices[i] = position.purchase_price;
+    if (price_dates[i] == 0) prices[i] = position.purchase_price;
+    symbols[i] = position.symbol;
+}
+
+void PositionStore::removeLocked(int64_t asset_id) {
+    size_t i = slot_of_asset.at(asset_id);
+    size_t last = asset_ids.size() - 1;
+    --position_counts[portfolio_slots[i]];
+    if (i != last) {
+        asset_ids[i] = asset_ids[last];
+        portfolio_slots[i] = portfolio_slots[last];
+        types[i] = types[last];
+        quantities[i] = quantities[last];
+        purchase_prices[i] = purchase_prices[last];
+        prices[i] = prices[last];
+        price_dates[i] = price_dates[last];
+        symbols[i] = std::move(symbols[last]);
+        slot_of_asset[asset_ids[i]] = i;
+    }
+    asset_ids.pop_back();
+    portfolio_slots.pop_back();
+    types.pop_back();
+    quantities.pop_back();
+    purchase_prices.pop_back();
+    prices.pop_back();
+    price_dates.pop_back();
+    symbols.pop_back();
+    slot_of_asset.erase(asset_id);
+}
+
+void PositionStore::clearLocked() {
+    asset_ids.clear();
+    portfolio_slots.clear();
+    types.clear();
+    quantities.clear();
+    purchase_prices.clear();
+    prices.clear();
+    price_dates.clear();
+    symbols.clear();
+    slot_of_asset.clear();
+    portfolio_ids.clear();
+    position_counts.clear();
+    slot_of_portfolio.clear();
+}
+
+bool PositionStore::applyPriceLocked(const PriceRecord& price) {
+    checkPrice(price);
+    int32_t date = parseDate(price.price_date);
+    auto it = slot_of_asset.find(price.asset_id);
+    if (it == slot_of_asset.end()) return false;
+    size_t i = it->second;
+    if (date < price_dates[i]) return false;
+    prices[i] = price.price;
+    // An undated price still counts as a market price; later dated ticks replace it
+    price_dates[i] = std::max(date, 1);
+    return true;
+}
+
+void PositionStore::loadPositionsLocked(const std::vector<PositionRecord>& positions) {
+    std::unordered_map<int64_t, std::pair<double, int32_t>> kept_prices;
+    for (size_t i = 0; i < asset_ids.size(); ++i) {
+        if (price_dates[i] > 0) kept_prices.emplace(asset_ids[i], std::make_pair(prices[i], price_dates[i]));
+    }
+
+    clearLocked();
+    asset_ids.reserve(positions.size());
+    portfolio_slots.reserve(positions.size());
+    types.reserve(positions.size());
+    quantities.reserve(positions.size());
+    purchase_prices.reserve(positions.size());
+    prices.reserve(positions.size());
+    price_dates.reserve(positions.size());
+    symbols.reserve(positions.size());
+    slot_of_asset.reserve(positions.size());
+
+    for (const auto& position : positions) {
+        upsertLocked(position);
+        auto kept = kept_prices.find(position.asset_id);
+        if (kept != kept_prices.end()) {
+            size_t i = slot_of_asset[position.asset_id];
+            prices[i] = kept->second.first;
+            price_dates[i] = kept->second.second;
+        }
+    }
+}
+
+void PositionStore::loadPositions(const std::vector<PositionRecord>& positions) {
+    for (const auto& position : positions) checkPosition(position);
+
+    WriteLock lock(state_mutex);
+    loadPositionsLocked(positions);
+}
+
+size_t PositionStore::loadPrices(const std::vector<PriceRecord>& price_records) {
+    WriteLock lock(state_mutex);
+    size_t applied = 0;
+    for (const auto& price : price_records) {
+        if (applyPriceLocked(price)) ++applied;
+    }
+    return applied;
+}
+
+size_t PositionStore::loadSnapshot(const std::vector<PositionRecord>& positions,
+                                   const std::vector<PriceRecord>& price_records) {
+    for (const auto& position : positions) checkPosition(position);
+    // Everything is validated before the lock so a bad record leaves the store untouched
+    for (const auto& price : price_records) checkPrice(price);
+
+    WriteLock lock(state_mutex);
+    loadPositionsLocked(positions);
+    size_t applied = 0;
+    for (const auto& price : price_records) {
+        if (applyPriceLocked(price)) ++applied;
+    }
+    return applied;
+}
+
+size_t PositionStore::refreshAssets(const std::vector<int64_t>& refreshed,
+                                    const std::vector<PositionRecord>& positions,
+                                    const std::vector<PriceRecord>& price_records) {
+    for (const auto& position : positions) checkPosition(position);
+    for (const auto& price : price_records) checkPrice(price);
+    std::unordered_set<int64_t> present;
+    for (const auto& position : positions) present.insert(position.asset_id);
+
+    WriteLock lock(state_mutex);
+    for (const auto& position : positions) upsertLocked(position);
+    for (const auto& price : price_records) applyPriceLocked(price);
+    size_t removed = 0;
+    for (int64_t asset_id : refreshed) {
+        if (present.count(asset_id) || slot_of_asset.find(asset_id) == slot_of_asset.end()) continue;
+        removeLocked(asset_id);
+        ++removed;
+    }
+    return removed;
+}
+
+void PositionStore::upsertPosition(const PositionRecord& position) {
+    WriteLock lock(state_mutex);
+    upsertLocked(position);
+}
+
+bool PositionStore::removePosition(int64_t asset_id) {
+    WriteLock lock(state_mutex);
+    if (slot_of_asset.find(asset_id) == slot_of_asset.end()) return false;
+    removeLocked(asset_id);
+    return true;
+}
+
+bool PositionStore::updatePrice(const PriceRecord& price) {
+    WriteLock lock(state_mutex);
+    return applyPriceLocked(price);
+}
+
+std::vector<PortfolioValuation> PositionStore::valuePortfolios(const std::vector<int64_t>& requested) const {
+    ReadLock lock(state_mutex);
+    std::vector<int64_t> held;
+    if (requested.empty()) {
+        for (size_t slot = 0; slot < portfolio_ids.size(); ++slot) {
+            if (position_counts[slot] > 0) held.push_back(portfolio_ids[slot]);
+        }
+    }
+    const std::vector<int64_t>& ids = requested.empty() ? held : requested;
+    size_t m = ids.size();
+
+    // Output row of each portfolio slot; a portfolio requested twice is filled once and copied
+    std::vector<int32_t> row_of_slot(portfolio_ids.size(), -1);
+    std::vector<int32_t> duplicate_of(m, -1);
+    std::vector<PortfolioValuation> result(m);
+    for (size_t r = 0; r < m; ++r) {
+        result[r].portfolio_id = ids[r];
+        result[r].total_value = 0.0;
+        result[r].allocation.assign(kAssetTypeCount, 0.0);
+        auto it = slot_of_portfolio.find(ids[r]);
+        if (it == slot_of_portfolio.end()) continue;
+        if (row_of_slot[it->second] >= 0) {
+            duplicate_of[r] = row_of_slot[it->second];
+            continue;
+        }
+        row_of_slot[it->second] = static_cast<int32_t>(r);
+        size_t count = position_counts[it->second];
+        result[r].asset_ids.reserve(count);
+        result[r].symbols.reserve(count);
+        result[r].values.reserve(count);
+    }
+
+    // Market values in one contiguous pass, then scattered to their portfolios
+    size_t n = asset_ids.size();
+    std::vector<double> market_values(n);
+    const double* quantity = quantities.data();
+    const double* price = prices.data();
+    double* value = market_values.data();
+    #pragma omp simd
+    for (size_t i = 0; i < n; ++i) {
+        value[i] = quantity[i] * price[i];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        int32_t r = row_of_slot[portfolio_slots[i]];
+        if (r < 0) continue;
+        PortfolioValuation& valuation = result[r];
+        valuation.total_value += value[i];
+        valuation.allocation[types[i]] += value[i];
+        valuation.asset_ids.push_back(asset_ids[i]);
+        valuation.symbols.push_back(symbols[i]);
+        valuation.values.push_back(value[i]);
+    }
+
+    #pragma omp parallel for schedule(static) if (m > kParallelPortfolios) num_threads(parallelThreads())
+    for (long r = 0; r < static_cast<long>(m); ++r) {
+        PortfolioValuation& valuation = result[r];
+        double scale = valuation.total_value != 0.0 ? 1.0 / valuation.total_value : 0.0;
+        valuation.weights.resize(valuation.values.size());
+        for (size_t k = 0; k < valuation.values.size(); ++k) {
+            valuation.weights[k] = valuation.values[k] * scale;
+        }
+        for (double& share : valuation.allocation) share *= scale;
+    }
+    for (size_t r = 0; r < m; ++r) {
+        if (duplicate_of[r] >= 0) result[r] = result[duplicate_of[r]];
+    }
+    return result;
+}
+
+double PositionStore::price(int64_t asset_id) const {
+    ReadLock lock(state_mutex);
+    auto it = slot_of_asset.find(asset_id);
+    if (it == slot_of_asset.end()) {
+        throw std::invalid_argument("Asset " + std::to_string(asset_id) + " is not in the position store");
+    }
+    return prices[it->second];
+}
+
+PositionStoreStats PositionStore::stats() const {
+    ReadLock lock(state_mutex);
+    PositionStoreStats stats;
+    stats.positions = asset_ids.size();
+    stats.portfolios = static_cast<size_t>(std::count_if(position_counts.begin(), position_counts.end(),
+                                                         [](uint32_t count) { return count > 0; }));
+    stats.priced_positions = static_cast<size_t>(std::count_if(price_dates.begin(), price_dates.end(),
+                                                               [](int32_t date) { return date > 0; }));
+    stats.memory_bytes = columnBytes(asset_ids) + columnBytes(portfolio_slots) + columnBytes(types) +
+                         columnBytes(quantities) + columnBytes(purchase_prices) + columnBytes(prices) +
+                         columnBytes(price_dates) + columnBytes(symbols) + columnBytes(portfolio_ids) +
+                         columnBytes(position_counts);
+    return stats;
+}
+
+void PositionStore::clear() {
+    WriteLock lock(state_mutex);
+    clearLocked();
+}
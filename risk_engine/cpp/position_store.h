@@ -0,0 +1,131 @@
+#ifndef POSITION_STORE_H
+#define POSITION_STORE_H
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <shared_mutex>
+#include <cstdint>
+#include <cstddef>
+
+// In-memory columnar copy of the platform's positions (assets table) and their latest prices
+// (asset_prices table). It is bulk-loaded once and then kept current by upserts and price ticks, so
+// valuing thousands of portfolios is one pass over contiguous columns instead of a price query per
+// asset.
+
+// Mirrors the CHECK constraint on assets.type
+enum class AssetType {
+    STOCK,
+    BOND,
+    CRYPTO,
+    REIT,
+    CASH,
+    COMMODITY
+};
+
+const size_t kAssetTypeCount = 6;
+
+AssetType parseAssetType(const std::string& name);
+std::string assetTypeName(AssetType type);
+
+struct PositionRecord {
+    int64_t asset_id;      // assets.id
+    int64_t portfolio_id;  // assets.portfolio_id
+    std::string symbol;    // assets.symbol
+    AssetType type;        // assets.type
+    double quantity;       // Units held
+    double purchase_price; // Valuation price until a market price arrives
+};
+
+struct PriceRecord {
+    int64_t asset_id;       // asset_prices.asset_id
+    double price;           // Price per unit
+    std::string price_date; // YYYY-MM-DD; older dates than the stored price are ignored
+};
+
+struct PortfolioValuation {
+    int64_t portfolio_id;
+    double total_value;              // Sum of quantity * latest price
+    std::vector<int64_t> asset_ids;  // Positions in the portfolio, in load order
+    std::vector<std::string> symbols;
+    std::vector<double> values;      // Market value per position
+    std::vector<double> weights;     // values / total_value (zero when the portfolio is worthless)
+    std::vector<double> allocation;  // Fraction of total_value per AssetType, kAssetTypeCount entries
+};
+
+struct PositionStoreStats {
+    size_t positions;
+    size_t portfolios;
+    size_t priced_positions; // Positions valued at a market price rather than the purchase price
+    size_t memory_bytes;     // Column capacity in bytes
+};
+
+class PositionStore {
+private:
+    // One slot per position; removal moves the last slot into the hole
+    std::vector<int64_t> asset_ids;
+    std::vector<uint32_t> portfolio_slots; // Index into portfolio_ids
+    std::vector<uint8_t> types;
+    std::vector<double> quantities;
+    std::vector<double> purchase_prices;
+    std::vector<double> prices;            // Latest market price, or purchase price when unpriced
+    std::vector<int32_t> price_dates;      // YYYYMMDD of the latest price, 0 when unpriced
+    std::vector<std::string> symbols;
+    std::unordered_map<int64_t, size_t> slot_of_asset;
+
+    // Portfolio slots are never reused, so an emptied portfolio keeps its slot until clear()
+    std::vector<int64_t> portfolio_ids;
+    std::vector<uint32_t> position_counts;
+    std::unordered_map<int64_t, uint32_t> slot_of_portfolio;
+
+    mutable std::shared_mutex state_mutex; // Valuations share it, writes take it exclusively
+
+    // Helper methods
+    uint32_t portfolioSlot(int64_t portfolio_id);
+    void upsertLocked(const PositionRecord& position);
+    void removeLocked(int64_t asset_id);
+    void clearLocked();
+    bool applyPriceLocked(const PriceRecord& price);
+    void loadPositionsLocked(const std::vector<PositionRecord>& positions);
+
+public:
+    PositionStore() = default;
+    PositionStore(const PositionStore&) = delete;
+    PositionStore& operator=(const PositionStore&) = delete;
+
+    // Replace every position; prices of assets that are still held are kept
+    void loadPositions(const std::vector<PositionRecord>& positions);
+
+    // Apply many price ticks at once; returns how many were applied
+    size_t loadPrices(const std::vector<PriceRecord>& prices);
+
+    // loadPositions then loadPrices under one write lock, so no valuation sees the new positions
+    // with the old prices; returns how many prices were applied
+    size_t loadSnapshot(const std::vector<PositionRecord>& positions, const std::vector<PriceRecord>& prices);
+
+    // Upsert the given positions, apply the prices and remove every listed asset that is not among
+    // the positions, under one write lock; returns how many positions were removed
+    size_t refreshAssets(const std::vector<int64_t>& asset_ids, const std::vector<PositionRecord>& positions,
+                         const std::vector<PriceRecord>& prices);
+
+    // Insert or update a position (quantity, type and portfolio may all change)
+    void upsertPosition(const PositionRecord& position);
+
+    // Returns false if the asset was not held
+    bool removePosition(int64_t asset_id);
+
+    // Returns false if the asset is unknown or the price is older than the stored one
+    bool updatePrice(const PriceRecord& price);
+
+    // Values, position weights and type allocation of the given portfolios in request order (every
+    // portfolio holding positions when empty). Unknown portfolios come back empty with zero value.
+    std::vector<PortfolioValuation> valuePortfolios(const std::vector<int64_t>& portfolio_ids) const;
+
+    // Latest valuation price of one asset; throws std::invalid_argument if it is not held
+    double price(int64_t asset_id) const;
+
+    PositionStoreStats stats() const;
+    void clear();
+};
+
+#endif // POSITION_STORE_H
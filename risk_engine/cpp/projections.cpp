@@ -0,0 +1,108 @@
+#include "projections.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+inline double softThreshold(double x, double threshold) {
+    if (x > threshold) return x - threshold;
+    if (x < -threshold) return x + threshold;
+    return 0.0;
+}
+
+// Solves sum_i clamp(reference_i + soft(v_i - nu - reference_i, theta), lower_i, upper_i) = 1 for nu
+// and writes the resulting point; the sum is non-increasing in nu.
+double projectWithThreshold(const std::vector<double>& v, const std::vector<double>& reference,
+                            const std::vector<double>& lower, const std::vector<double>& upper,
+                            double theta, std::vector<double>& out) {
+    size_t m = v.size();
+    double nu_lo = std::numeric_limits<double>::infinity();
+    double nu_hi = -std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < m; ++i) {
+        nu_lo = std::min(nu_lo, v[i] - upper[i]);
+        nu_hi = std::max(nu_hi, v[i] - lower[i]);
+    }
+    nu_lo -= theta;
+    nu_hi += theta;
+
+    auto evaluate = [&](double nu) {
+        double sum = 0.0;
+        for (size_t i = 0; i < m; ++i) {
+            double w = reference[i] + softThreshold(v[i] - nu - reference[i], theta);
+            out[i] = std::min(std::max(w, lower[i]), upper[i]);
+            sum += out[i];
+        }
+        return sum;
+    };
+
+    for (int iter = 0; iter < 100 && nu_hi - nu_lo > 1e-15; ++iter) {
+        double nu = 0.5 * (nu_lo + nu_hi);
+        if (evaluate(nu) > 1.0) {
+            nu_lo = nu;
+        } else {
+            nu_hi = nu;
+        }
+    }
+    evaluate(0.5 * (nu_lo + nu_hi));
+
+    double turnover = 0.0;
+    for (size_t i = 0; i < m; ++i) {
+        turnover += std::abs(out[i] - reference[i]);
+    }
+    return turnover;
+}
+
+} // namespace
+
+void projectBudgetBox(const std::vector<double>& v, const std::vector<double>& lower,
+                      const std::vector<double>& upper, std::vector<double>& out) {
+    size_t m = v.size();
+    double tau_lo = std::numeric_limits<double>::infinity();
+    double tau_hi = -std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < m; ++i) {
+        tau_lo = std::min(tau_lo, v[i] - upper[i]);
+        tau_hi = std::max(tau_hi, v[i] - lower[i]);
+    }
+    for (int iter = 0; iter < 100 && tau_hi - tau_lo > 1e-15; ++iter) {
+        double tau = 0.5 * (tau_lo + tau_hi);
+        double sum = 0.0;
+        for (size_t i = 0; i < m; ++i) {
+            sum += std::min(std::max(v[i] - tau, lower[i]), upper[i]);
+        }
+        if (sum > 1.0) {
+            tau_lo = tau;
+        } else {
+            tau_hi = tau;
+        }
+    }
+    double tau = 0.5 * (tau_lo + tau_hi);
+    for (size_t i = 0; i < m; ++i) {
+        out[i] = std::min(std::max(v[i] - tau, lower[i]), upper[i]);
+    }
+}
+
+void projectBudgetBoxTurnover(const std::vector<double>& v, const std::vector<double>& reference,
+                              const std::vector<double>& lower, const std::vector<double>& upper,
+                              double max_turnover, std::vector<double>& out) {
+    // Without shrinkage the plain budget-box projection may already satisfy the turnover limit
+    if (projectWithThreshold(v, reference, lower, upper, 0.0, out) <= max_turnover) {
+        return;
+    }
+
+    // Otherwise bisect on the L1 multiplier; turnover is non-increasing in theta
+    double theta_lo = 0.0;
+    double theta_hi = 1e-12;
+    for (size_t i = 0; i < v.size(); ++i) {
+        theta_hi = std::max(theta_hi, 2.0 * std::abs(v[i] - reference[i]));
+    }
+    for (int iter = 0; iter < 100 && theta_hi - theta_lo > 1e-15; ++iter) {
+        double theta = 0.5 * (theta_lo + theta_hi);
+        if (projectWithThreshold(v, reference, lower, upper, theta, out) > max_turnover) {
+            theta_lo = theta;
+        } else {
+            theta_hi = theta;
+        }
+    }
+    projectWithThreshold(v, reference, lower, upper, theta_hi, out);
+}
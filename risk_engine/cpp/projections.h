@@ -0,0 +1,21 @@
+#ifndef PROJECTIONS_H
+#define PROJECTIONS_H
+
+#include <vector>
+
+// Euclidean projection of v onto {sum(w) = 1, lower <= w <= upper}
+void projectBudgetBox(const std::vector<double>& v,
+                      const std::vector<double>& lower,
+                      const std::vector<double>& upper,
+                      std::vector<double>& out);
+
+// Euclidean projection of v onto {sum(w) = 1, lower <= w <= upper, ||w - reference||_1 <= max_turnover}.
+// If the turnover ball does not intersect the budget box, the closest point in turnover is returned.
+void projectBudgetBoxTurnover(const std::vector<double>& v,
+                              const std::vector<double>& reference,
+                              const std::vector<double>& lower,
+                              const std::vector<double>& upper,
+                              double max_turnover,
+                              std::vector<double>& out);
+
+#endif // PROJECTIONS_H
@@ -0,0 +1,387 @@
+#include "realized_covariance.h"
+#include "linalg.h"
+#include "serialization.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Returns buffered before a rank-k update of the accumulators; keeps each accumulator row in cache
+const size_t kBlockRows = 32;
+
+double preAveragingWeight(double x) {
+    return std::min(x, 1.0 - x);
+}
+
+// Smallest eigenvalue of a symmetric matrix with unit diagonal, by power iteration on c I - R
+double estimateMinEigenvalue(const std::vector<double>& r, size_t n) {
+    double shift = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double row_sum = 0.0;
+        for (size_t j = 0; j < n; ++j) row_sum += std::abs(r[i * n + j]);
+        shift = std::max(shift, row_sum);
+    }
+    std::vector<double> x(n), y(n);
+    for (size_t i = 0; i < n; ++i) x[i] = 1.0 + 0.01 * static_cast<double>(i % 7);
+    double mu = 0.0;
+    for (int iter = 0; iter < 300; ++iter) {
+        double norm = 0.0;
+        for (double v : x) norm += v * v;
+        norm = std::sqrt(norm);
+        for (double& v : x) v /= norm;
+        matrixVectorProduct(r, n, x, y);
+        double next = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = shift * x[i] - y[i];
+            next += x[i] * y[i];
+        }
+        x.swap(y);
+        bool converged = std::abs(next - mu) <= 1e-10 * shift;
+        mu = next;
+        if (converged) break;
+    }
+    return shift - mu;
+}
+
+} // namespace
+
+RealizedCovarianceEstimator::RealizedCovarianceEstimator(size_t num_assets,
+                                                         const RealizedCovarianceSettings& cfg)
+    : n(num_assets), settings(cfg), num_updated(0), has_refresh(false), observations(0),
+      window_filled(0), window_next(0), averaged_observations(0), signal_rows(0), noise_rows(0) {
+
+    if (n == 0) {
+        throw std::invalid_argument("Number of assets must be positive");
+    }
+    if (settings.annualization <= 0.0) {
+        throw std::invalid_argument("Annualization factor must be positive");
+    }
+    if (settings.min_eigenvalue < 0.0 || settings.min_eigenvalue >= 1.0) {
+        throw std::invalid_argument("Minimum eigenvalue must be in [0, 1)");
+    }
+    if (settings.min_shrinkage < 0.0 || settings.min_shrinkage > 1.0) {
+        throw std::invalid_argument("Minimum shrinkage must be in [0, 1]");
+    }
+
+    last_prices.assign(n, 0.0);
+    refresh_prices.assign(n, 0.0);
+    updated.assign(n, 0);
+    signal_sum.assign(n * n, 0.0);
+    signal_block.assign(kBlockRows * n, 0.0);
+
+    if (settings.method == RealizedCovarianceMethod::PRE_AVERAGED) {
+        size_t k = settings.pre_averaging_window;
+        if (k < 2) {
+            throw std::invalid_argument("Pre-averaging window must be at least 2");
+        }
+        for (size_t j = 1; j < k; ++j) {
+            weights.push_back(preAveragingWeight(static_cast<double>(j) / k));
+        }
+        return_window.assign((k - 1) * n, 0.0);
+        noise_sum.assign(n * n, 0.0);
+        noise_block.assign(kBlockRows * n, 0.0);
+    }
+}
+
+void RealizedCovarianceEstimator::addTick(size_t asset, double price) {
+    if (asset >= n) {
+        throw std::invalid_argument("Asset index is out of range");
+    }
+    if (!(price > 0.0) || !std::isfinite(price)) {
+        throw std::invalid_argument("Prices must be positive and finite");
+    }
+    std::lock_guard<std::mutex> lock(state_mutex);
+    last_prices[asset] = price;
+    if (!updated[asset]) {
+        updated[asset] = 1;
+        if (++num_updated == n) onRefresh();
+    }
+}
+
+void RealizedCovarianceEstimator::addBar(const std::vector<double>& prices) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    ingestBar(prices);
+}
+
+void RealizedCovarianceEstimator::addBars(const std::vector<std::vector<double>>& bars) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    for (const auto& bar : bars) {
+        ingestBar(bar);
+    }
+}
+
+void RealizedCovarianceEstimator::ingestBar(const std::vector<double>& prices) {
+    if (prices.size() != n) {
+        throw std::invalid_argument("Bar must contain one price per asset");
+    }
+    for (size_t i = 0; i < n; ++i) {
+        double price = prices[i];
+        if (std::isnan(price)) continue;
+        if (!(price > 0.0) || !std::isfinite(price)) {
+            throw std::invalid_argument("Prices must be positive and finite");
+        }
+        last_prices[i] = price;
+        if (!updated[i]) {
+            updated[i] = 1;
+            ++num_updated;
+        }
+    }
+    if (num_updated == n) onRefresh();
+}
+
+void RealizedCovarianceEstimator::onRefresh() {
+    // Every asset has traded since the last refresh time: sample one synchronized return
+    std::fill(updated.begin(), updated.end(), 0);
+    num_updated = 0;
+    if (!has_refresh) {
+        refresh_prices = last_prices;
+        has_refresh = true;
+        return;
+    }
+
+    bool pre_averaged = settings.method == RealizedCovarianceMethod::PRE_AVERAGED;
+    double* row = pre_averaged ? &return_window[window_next * n] : &signal_block[signal_rows * n];
+    for (size_t i = 0; i < n; ++i) {
+        row[i] = std::log(last_prices[i] / refresh_prices[i]);
+    }
+    refresh_prices = last_prices;
+    ++observations;
+
+    if (!pre_averaged) {
+        if (++signal_rows == kBlockRows) {
+            flushInto(signal_sum, signal_block, signal_rows, n);
+            signal_rows = 0;
+        }
+        return;
+    }
+
+    std::copy(row, row + n, &noise_block[noise_rows * n]);
+    if (++noise_rows == kBlockRows) {
+        flushInto(noise_sum, noise_block, noise_rows, n);
+        noise_rows = 0;
+    }
+
+    size_t span = weights.size();
+    window_next = (window_next + 1) % span;
+    window_filled = std::min(window_filled + 1, span);
+    if (window_filled < span) return;
+
+    // Pre-averaged return over the last k-1 returns, oldest slot first
+    double* averaged = &signal_block[signal_rows * n];
+    std::fill(averaged, averaged + n, 0.0);
+    for (size_t j = 0; j < span; ++j) {
+        const double* r = &return_window[((window_next + j) % span) * n];
+        double w = weights[j];
+        #pragma omp simd
+        for (size_t i = 0; i < n; ++i) {
+            averaged[i] += w * r[i];
+        }
+    }
+    ++averaged_observations;
+    if (++signal_rows == kBlockRows) {
+        flushInto(signal_sum, signal_block, signal_rows, n);
+        signal_rows = 0;
+    }
+}
+
+void RealizedCovarianceEstimator::flushInto(std::vector<double>& sum, const std::vector<double>& block,
+                                            size_t rows, size_t n) {
+    // Rank-`rows` update of the upper triangle; the inner loop is a contiguous axpy
+    for (size_t i = 0; i < n; ++i) {
+        double* s = &sum[i * n];
+        for (size_t b = 0; b < rows; ++b) {
+            const double* y = &block[b * n];
+            double a = y[i];
+            if (a == 0.0) continue;
+            #pragma omp simd
+            for (size_t j = i; j < n; ++j) {
+                s[j] += a * y[j];
+            }
+        }
+    }
+}
+
+RealizedCovarianceResult RealizedCovarianceEstimator::estimate() const {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    bool pre_averaged = settings.method == RealizedCovarianceMethod::PRE_AVERAGED;
+    if (observations == 0 || (pre_averaged && averaged_observations == 0)) {
+        throw std::invalid_argument("Not enough synchronized returns to estimate a covariance");
+    }
+
+    std::vector<double> c = signal_sum;
+    flushInto(c, signal_block, signal_rows, n);
+
+    if (pre_averaged) {
+        // Christensen, Kinnebrock and Podolskij (2010) modulated realized covariance
+        double k = static_cast<double>(settings.pre_averaging_window);
+        double psi2 = 0.0;
+        for (double w : weights) psi2 += w * w;
+        psi2 /= k;
+        double psi1 = 0.0;
+        for (size_t j = 0; j <= weights.size(); ++j) {
+            double next = j < weights.size() ? weights[j] : 0.0;
+            double previous = j > 0 ? weights[j - 1] : 0.0;
+            psi1 += (next - previous) * (next - previous);
+        }
+        psi1 *= k;
+
+        std::vector<double> noise = noise_sum;
+        flushInto(noise, noise_block, noise_rows, n);
+        double num_returns = static_cast<double>(observations);
+        double scale = num_returns / (static_cast<double>(averaged_observations) * k * psi2);
+        double bias = psi1 / (2.0 * k * k * psi2);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i; j < n; ++j) {
+                c[i * n + j] = scale * c[i * n + j] - bias * noise[i * n + j];
+            }
+        }
+    }
+
+    // Symmetrize the upper triangle and split into volatilities and correlation
+    std::vector<double> vols(n), r(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        vols[i] = std::sqrt(std::max(c[i * n + i], 0.0));
+    }
+    for (size_t i = 0; i < n; ++i) {
+        r[i * n + i] = 1.0;
+        for (size_t j = i + 1; j < n; ++j) {
+            double rho = 0.0;
+            if (vols[i] > 0.0 && vols[j] > 0.0) {
+                rho = std::max(-1.0, std::min(1.0, c[i * n + j] / (vols[i] * vols[j])));
+            }
+            r[i * n + j] = r[j * n + i] = rho;
+        }
+    }
+
+    // Minimal shrinkage toward the identity that leaves every eigenvalue >= min_eigenvalue
+    double floor = settings.min_eigenvalue;
+    double lambda = estimateMinEigenvalue(r, n);
+    double shrinkage = settings.min_shrinkage;
+    if (lambda < floor + 1e-9) {
+        shrinkage = std::max(shrinkage, std::min(1.0, (floor - lambda) / (1.0 - lambda) + 1e-9));
+    }
+    std::vector<double> shrunk(n * n), test(n * n);
+    while (true) {
+        for (size_t k = 0; k < n * n; ++k) {
+            shrunk[k] = (1.0 - shrinkage) * r[k];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            shrunk[i * n + i] += shrinkage;
+        }
+        test = shrunk;
+        for (size_t i = 0; i < n; ++i) {
+            test[i * n + i] -= floor;
+        }
+        if (shrinkage >= 1.0 || choleskyFactor(test, n)) break;
+        // The power-iteration estimate was optimistic; widen the margin
+        shrinkage = std::min(1.0, 2.0 * shrinkage + 1e-6);
+    }
+
+    RealizedCovarianceResult result;
+    result.shrinkage = shrinkage;
+    result.observations = observations;
+    result.volatilities.resize(n);
+    result.covariance.assign(n, std::vector<double>(n));
+    result.correlation.assign(n, std::vector<double>(n));
+    double annualization = settings.annualization;
+    for (size_t i = 0; i < n; ++i) {
+        result.volatilities[i] = vols[i] * std::sqrt(annualization);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            result.correlation[i][j] = shrunk[i * n + j];
+            result.covariance[i][j] = result.volatilities[i] * result.volatilities[j] * shrunk[i * n + j];
+        }
+    }
+    return result;
+}
+
+std::vector<uint8_t> RealizedCovarianceEstimator::serialize() const {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    ByteWriter out;
+    out.put<uint64_t>(n);
+    out.put<uint32_t>(static_cast<uint32_t>(settings.method));
+    out.put<uint64_t>(settings.pre_averaging_window);
+    out.put(settings.annualization);
+    out.put(settings.min_eigenvalue);
+    out.put(settings.min_shrinkage);
+    out.putVector(last_prices);
+    out.putVector(refresh_prices);
+    out.putVector(updated);
+    out.put<uint64_t>(num_updated);
+    out.put<uint8_t>(has_refresh ? 1 : 0);
+    out.put<uint64_t>(observations);
+    out.putVector(return_window);
+    out.put<uint64_t>(window_filled);
+    out.put<uint64_t>(window_next);
+    out.put<uint64_t>(averaged_observations);
+    out.putVector(signal_sum);
+    out.putVector(noise_sum);
+    out.putVector(signal_block);
+    out.putVector(noise_block);
+    out.put<uint64_t>(signal_rows);
+    out.put<uint64_t>(noise_rows);
+    return out.bytes();
+}
+
+std::unique_ptr<RealizedCovarianceEstimator> RealizedCovarianceEstimator::deserialize(const uint8_t* data,
+                                                                                      size_t size) {
+    ByteReader in(data, size);
+    size_t num_assets = static_cast<size_t>(in.get<uint64_t>());
+    RealizedCovarianceSettings cfg;
+    uint32_t method = in.get<uint32_t>();
+    if (method > static_cast<uint32_t>(RealizedCovarianceMethod::PRE_AVERAGED)) {
+        throw std::invalid_argument("Unknown realized covariance method in saved state");
+    }
+    cfg.method = static_cast<RealizedCovarianceMethod>(method);
+    cfg.pre_averaging_window = static_cast<size_t>(in.get<uint64_t>());
+    cfg.annualization = in.get<double>();
+    cfg.min_eigenvalue = in.get<double>();
+    cfg.min_shrinkage = in.get<double>();
+    std::unique_ptr<RealizedCovarianceEstimator> estimator(new RealizedCovarianceEstimator(num_assets, cfg));
+    RealizedCovarianceEstimator& e = *estimator;
+
+    // Every buffer must have the shape the constructor gave it
+    auto restore = [&in](auto& target) {
+        auto values = in.getVector<typename std::decay<decltype(target)>::type::value_type>();
+        if (values.size() != target.size()) {
+            throw std::invalid_argument("Saved realized covariance state does not match its settings");
+        }
+        target = std::move(values);
+    };
+    restore(e.last_prices);
+    restore(e.refresh_prices);
+    restore(e.updated);
+    e.num_updated = static_cast<size_t>(in.get<uint64_t>());
+    e.has_refresh = in.get<uint8_t>() != 0;
+    e.observations = static_cast<size_t>(in.get<uint64_t>());
+    restore(e.return_window);
+    e.window_filled = static_cast<size_t>(in.get<uint64_t>());
+    e.window_next = static_cast<size_t>(in.get<uint64_t>());
+    e.averaged_observations = static_cast<size_t>(in.get<uint64_t>());
+    restore(e.signal_sum);
+    restore(e.noise_sum);
+    restore(e.signal_block);
+    restore(e.noise_block);
+    e.signal_rows = static_cast<size_t>(in.get<uint64_t>());
+    e.noise_rows = static_cast<size_t>(in.get<uint64_t>());
+    size_t span = e.weights.size();
+    if (!in.exhausted() || e.num_updated > e.n || e.signal_rows >= kBlockRows || e.noise_rows >= kBlockRows ||
+        e.window_filled > span || (span > 0 && e.window_next >= span)) {
+        throw std::invalid_argument("Saved realized covariance state is inconsistent");
+    }
+    return estimator;
+}
+
+void RealizedCovarianceEstimator::reset() {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    std::fill(signal_sum.begin(), signal_sum.end(), 0.0);
+    std::fill(noise_sum.begin(), noise_sum.end(), 0.0);
+    signal_rows = 0;
+    noise_rows = 0;
+    observations = 0;
+    averaged_observations = 0;
+    window_filled = 0;
+    window_next = 0;
+}
@@ -0,0 +1,98 @@
+#ifndef REALIZED_COVARIANCE_H
+#define REALIZED_COVARIANCE_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+enum class RealizedCovarianceMethod {
+    REFRESH_TIME,  // Sum of outer products of refresh-time synchronized log returns
+    PRE_AVERAGED   // Modulated realized covariance on pre-averaged returns (robust to microstructure noise)
+};
+
+struct RealizedCovarianceSettings {
+    RealizedCovarianceMethod method;
+    size_t pre_averaging_window; // Pre-averaging window k in synchronized returns
+    double annualization;        // Estimation windows per year (252 for one trading day of bars)
+    double min_eigenvalue;       // Smallest eigenvalue allowed in the output correlation matrix
+    double min_shrinkage;        // Shrinkage toward the identity applied even when not needed
+
+    RealizedCovarianceSettings()
+        : method(RealizedCovarianceMethod::REFRESH_TIME), pre_averaging_window(20),
+          annualization(252.0), min_eigenvalue(1e-6), min_shrinkage(0.0) {}
+};
+
+struct RealizedCovarianceResult {
+    std::vector<std::vector<double>> covariance;  // Annualized covariance consistent with the correlation below
+    std::vector<std::vector<double>> correlation; // Positive definite correlation matrix
+    std::vector<double> volatilities;             // Annualized volatilities
+    double shrinkage;                             // Weight on the identity in the correlation matrix
+    size_t observations;                          // Synchronized returns in the window
+};
+
+class RealizedCovarianceEstimator {
+private:
+    size_t n;
+    RealizedCovarianceSettings settings;
+
+    // Refresh-time synchronization
+    std::vector<double> last_prices;    // Latest observed price per asset
+    std::vector<double> refresh_prices; // Prices at the previous refresh time
+    std::vector<char> updated;          // Asset traded since the previous refresh time
+    size_t num_updated;
+    bool has_refresh;
+    size_t observations;
+
+    // Pre-averaging
+    std::vector<double> weights;        // g(j/k) for j = 1..k-1
+    std::vector<double> return_window;  // Ring of the last k-1 synchronized returns, (k-1) x n
+    size_t window_filled;
+    size_t window_next;
+    size_t averaged_observations;
+
+    // Upper-triangular accumulators, fed in blocks of rows
+    std::vector<double> signal_sum;     // Sum of outer products of the estimator's returns
+    std::vector<double> noise_sum;      // Sum of raw return outer products (pre-averaging bias term)
+    std::vector<double> signal_block;
+    std::vector<double> noise_block;
+    size_t signal_rows;
+    size_t noise_rows;
+    mutable std::mutex state_mutex;     // Serializes ticks, bars, estimates and resets
+
+    // Helper methods
+    void ingestBar(const std::vector<double>& prices);
+    void onRefresh();
+    static void accumulate(std::vector<double>& sum, std::vector<double>& block, size_t& rows, size_t n);
+    static void flushInto(std::vector<double>& sum, const std::vector<double>& block, size_t rows, size_t n);
+
+public:
+    RealizedCovarianceEstimator(size_t num_assets,
+                                const RealizedCovarianceSettings& settings = RealizedCovarianceSettings());
+
+    // Bar of prices for every asset; NaN marks an asset that did not trade in the bar
+    void addBar(const std::vector<double>& prices);
+    void addBars(const std::vector<std::vector<double>>& bars);
+
+    // Asynchronous trade for one asset
+    void addTick(size_t asset, double price);
+
+    size_t numObservations() const {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        return observations;
+    }
+
+    // Annualized covariance with a positive definite correlation matrix
+    RealizedCovarianceResult estimate() const;
+
+    // Start a new estimation window (prices are kept for synchronization)
+    void reset();
+
+    // Complete state (settings, synchronization, pre-averaging window and accumulators), so an
+    // estimator can be saved in a snapshot and resumed by another process
+    std::vector<uint8_t> serialize() const;
+    static std::unique_ptr<RealizedCovarianceEstimator> deserialize(const uint8_t* data, size_t size);
+};
+
+#endif // REALIZED_COVARIANCE_H
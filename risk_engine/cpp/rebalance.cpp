@@ -0,0 +1,234 @@
+#include "rebalance.h"
+#include "linalg.h"
+#include "projections.h"
+#include "lifecycle.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+const double kOverRelaxation = 1.6;
+
+inline double softThreshold(double x, double threshold) {
+    if (x > threshold) return x - threshold;
+    if (x < -threshold) return x + threshold;
+    return 0.0;
+}
+
+} // namespace
+
+RebalanceSolver::RebalanceSolver(const std::vector<double>& returns,
+                                 const std::vector<double>& volatilities,
+                                 const std::vector<std::vector<double>>& corr_matrix,
+                                 const RebalanceCosts& trading_costs,
+                                 const RebalanceSettings& solver_settings)
+    : n(returns.size()), expected_returns(returns), costs(trading_costs), settings(solver_settings) {
+
+    if (n == 0) {
+        throw std::invalid_argument("Asset universe cannot be empty");
+    }
+    if (volatilities.size() != n) {
+        throw std::invalid_argument("Volatilities must match number of expected returns");
+    }
+    if (corr_matrix.size() != n || corr_matrix[0].size() != n) {
+        throw std::invalid_argument("Correlation matrix dimensions must match number of assets");
+    }
+    if (costs.linear.empty()) costs.linear.assign(n, 0.0);
+    if (costs.impact.empty()) costs.impact.assign(n, 0.0);
+    if (costs.no_trade.empty()) costs.no_trade.assign(n, 0.0);
+    if (costs.linear.size() != n || costs.impact.size() != n || costs.no_trade.size() != n) {
+        throw std::invalid_argument("Cost vectors must match number of assets");
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (costs.linear[i] < 0.0 || costs.impact[i] < 0.0 || costs.no_trade[i] < 0.0) {
+            throw std::invalid_argument("Transaction costs must be non-negative");
+        }
+    }
+    if (settings.rho <= 0.0) {
+        throw std::invalid_argument("ADMM penalty rho must be positive");
+    }
+    if (settings.max_weight <= 0.0 || settings.max_weight * n < 1.0) {
+        throw std::invalid_argument("Maximum weight is too small to be fully invested");
+    }
+
+    covariance.resize(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            covariance[i * n + j] = volatilities[i] * volatilities[j] * corr_matrix[i][j];
+        }
+    }
+    factorSystem();
+}
+
+void RebalanceSolver::factorSystem() {
+    system_factor.resize(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            system_factor[i * n + j] = settings.risk_aversion * covariance[i * n + j];
+        }
+        system_factor[i * n + i] += 2.0 * costs.impact[i] + settings.rho;
+    }
+    if (!choleskyFactor(system_factor, n)) {
+        throw std::invalid_argument("Rebalancing system is not positive definite");
+    }
+    ones_solution.assign(n, 1.0);
+    choleskySolve(system_factor, n, ones_solution);
+}
+
+void RebalanceSolver::updateExpectedReturns(const std::vector<double>& returns) {
+    if (returns.size() != n) {
+        throw std::invalid_argument("Expected returns must match number of assets");
+    }
+    std::unique_lock<std::shared_mutex> lock(state_mutex);
+    expected_returns = returns;
+}
+
+int RebalanceSolver::runADMM(const std::vector<double>& current_weights,
+                             const std::vector<double>& lower,
+                             const std::vector<double>& upper,
+                             RebalanceState& state, bool& converged) const {
+    // f(x) = 0.5 lambda x'Sx - mu'x + sum q_i (x_i - w0_i)^2 subject to 1'x = 1
+    // g(z) = sum c_i |z_i - w0_i| subject to lower <= z <= upper
+    double rho = settings.rho;
+    double ones_sum = 0.0;
+    for (double v : ones_solution) ones_sum += v;
+
+    std::vector<double> x(n), rhs(n), z_prev(n);
+    std::vector<double>& z = state.z;
+    std::vector<double>& u = state.u;
+    double tolerance = settings.tolerance;
+    double sqrt_n = std::sqrt(static_cast<double>(n));
+    converged = false;
+
+    int iteration = 0;
+    for (; iteration < settings.max_iterations; ++iteration) {
+        // x-update: one cached solve plus the budget correction along M^{-1} 1
+        for (size_t i = 0; i < n; ++i) {
+            rhs[i] = expected_returns[i] + 2.0 * costs.impact[i] * current_weights[i] + rho * (z[i] - u[i]);
+        }
+        choleskySolve(system_factor, n, rhs);
+        double rhs_sum = 0.0;
+        for (double v : rhs) rhs_sum += v;
+        double nu = (rhs_sum - 1.0) / ones_sum;
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = rhs[i] - nu * ones_solution[i];
+        }
+
+        // z-update: soft-threshold around the current holdings, then clip to the box
+        z_prev = z;
+        for (size_t i = 0; i < n; ++i) {
+            double x_relaxed = kOverRelaxation * x[i] + (1.0 - kOverRelaxation) * z_prev[i];
+            double v = x_relaxed + u[i];
+            double threshold = (costs.linear[i] + settings.turnover_penalty) / rho;
+            double candidate = current_weights[i] + softThreshold(v - current_weights[i], threshold);
+            z[i] = std::min(std::max(candidate, lower[i]), upper[i]);
+            u[i] = v - z[i];
+        }
+
+        double primal = 0.0, dual = 0.0, x_norm = 0.0, z_norm = 0.0, u_norm = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            primal += (x[i] - z[i]) * (x[i] - z[i]);
+            dual += (z[i] - z_prev[i]) * (z[i] - z_prev[i]);
+            x_norm += x[i] * x[i];
+            z_norm += z[i] * z[i];
+            u_norm += u[i] * u[i];
+        }
+        double eps_primal = sqrt_n * tolerance + tolerance * std::sqrt(std::max(x_norm, z_norm));
+        double eps_dual = sqrt_n * tolerance + tolerance * rho * std::sqrt(u_norm);
+        if (std::sqrt(primal) < eps_primal && rho * std::sqrt(dual) < eps_dual) {
+            converged = true;
+            ++iteration;
+            break;
+        }
+    }
+    return iteration;
+}
+
+RebalanceResult RebalanceSolver::solve(const std::vector<double>& current_weights,
+                                       RebalanceState& state) const {
+    if (current_weights.size() != n) {
+        throw std::invalid_argument("Current weights must match number of assets");
+    }
+    std::shared_lock<std::shared_mutex> lock(state_mutex);
+    return solveAccount(current_weights, state);
+}
+
+RebalanceResult RebalanceSolver::solveAccount(const std::vector<double>& current_weights,
+                                              RebalanceState& state) const {
+
+    std::vector<double> lower(n, 0.0), upper(n, settings.max_weight);
+    if (state.z.size() != n || state.u.size() != n) {
+        // Cold start from the current holdings
+        state.z.resize(n);
+        state.u.assign(n, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            state.z[i] = std::min(std::max(current_weights[i], lower[i]), upper[i]);
+        }
+    }
+
+    bool converged = false;
+    int iterations = runADMM(current_weights, lower, upper, state, converged);
+
+    // No-trade zones: pin assets whose trade is inside their band and polish the rest
+    bool pinned_any = false;
+    for (size_t i = 0; i < n; ++i) {
+        double trade = state.z[i] - current_weights[i];
+        if (trade != 0.0 && std::abs(trade) < costs.no_trade[i] &&
+            current_weights[i] >= 0.0 && current_weights[i] <= settings.max_weight) {
+            lower[i] = upper[i] = current_weights[i];
+            pinned_any = true;
+        }
+    }
+    if (pinned_any) {
+        bool polished = false;
+        iterations += runADMM(current_weights, lower, upper, state, polished);
+        converged = converged && polished;
+    }
+
+    // ADMM only meets the budget to within tolerance; finish with an exact projection
+    RebalanceResult result;
+    result.weights.resize(n);
+    projectBudgetBox(state.z, lower, upper, result.weights);
+    result.trades.resize(n);
+    result.transaction_cost = 0.0;
+    result.turnover = 0.0;
+    double mean = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double trade = result.weights[i] - current_weights[i];
+        result.trades[i] = trade;
+        result.turnover += std::abs(trade);
+        result.transaction_cost += costs.linear[i] * std::abs(trade) + costs.impact[i] * trade * trade;
+        mean += expected_returns[i] * result.weights[i];
+    }
+    std::vector<double> sigma_w(n);
+    matrixVectorProduct(covariance, n, result.weights, sigma_w);
+    double variance = 0.0;
+    for (size_t i = 0; i < n; ++i) variance += result.weights[i] * sigma_w[i];
+    result.objective = 0.5 * settings.risk_aversion * variance - mean + result.transaction_cost +
+                       settings.turnover_penalty * result.turnover;
+    result.iterations = iterations;
+    result.converged = converged;
+    return result;
+}
+
+std::vector<RebalanceResult> RebalanceSolver::solveBatch(
+    const std::vector<std::vector<double>>& current_weights,
+    std::vector<RebalanceState>& states) const {
+
+    states.resize(current_weights.size());
+    std::vector<RebalanceResult> results(current_weights.size());
+    for (const auto& weights : current_weights) {
+        if (weights.size() != n) {
+            throw std::invalid_argument("Current weights must match number of assets");
+        }
+    }
+
+    std::shared_lock<std::shared_mutex> lock(state_mutex);
+    #pragma omp parallel for schedule(dynamic, 16) num_threads(parallelThreads())
+    for (long k = 0; k < static_cast<long>(current_weights.size()); ++k) {
+        results[k] = solveAccount(current_weights[k], states[k]);
+    }
+    return results;
+}
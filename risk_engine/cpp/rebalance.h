@@ -0,0 +1,80 @@
+#ifndef REBALANCE_H
+#define REBALANCE_H
+
+#include <vector>
+#include <cstddef>
+#include <shared_mutex>
+
+struct RebalanceCosts {
+    std::vector<double> linear;   // Per-asset linear cost per unit of weight traded (spread + fees)
+    std::vector<double> impact;   // Per-asset quadratic market-impact coefficient
+    std::vector<double> no_trade; // Per-asset no-trade band; smaller trades are suppressed
+};
+
+struct RebalanceSettings {
+    double risk_aversion;    // Mean-variance risk aversion (lambda)
+    double turnover_penalty; // Uniform L1 turnover penalty added to the linear costs
+    double max_weight;       // Maximum weight of any single asset
+    double rho;              // ADMM penalty parameter
+    int max_iterations;      // ADMM iteration cap per solve
+    double tolerance;        // Primal/dual residual tolerance
+
+    RebalanceSettings()
+        : risk_aversion(1.0), turnover_penalty(0.0), max_weight(1.0), rho(1.0),
+          max_iterations(500), tolerance(1e-7) {}
+};
+
+// ADMM iterates kept per account so consecutive days start from yesterday's solution
+struct RebalanceState {
+    std::vector<double> z; // Feasible (box-projected) weights
+    std::vector<double> u; // Scaled dual variable
+};
+
+struct RebalanceResult {
+    std::vector<double> weights;  // Target weights after rebalancing
+    std::vector<double> trades;   // weights - current weights
+    double objective;             // Mean-variance objective plus transaction costs
+    double transaction_cost;      // Linear plus market-impact cost of the trades
+    double turnover;              // Sum of absolute trades
+    int iterations;               // ADMM iterations including the no-trade polishing pass
+    bool converged;               // Residuals fell below tolerance
+};
+
+class RebalanceSolver {
+private:
+    size_t n;
+    std::vector<double> expected_returns;
+    std::vector<double> covariance;    // Row-major n x n covariance matrix
+    RebalanceCosts costs;
+    RebalanceSettings settings;
+    std::vector<double> system_factor; // Cholesky factor of lambda * Sigma + 2 * diag(impact) + rho * I
+    std::vector<double> ones_solution; // (lambda * Sigma + 2 * diag(impact) + rho * I)^{-1} 1
+    mutable std::shared_mutex state_mutex; // Solves share it; expected-return updates take it exclusively
+
+    // Helper methods
+    void factorSystem();
+    RebalanceResult solveAccount(const std::vector<double>& current_weights, RebalanceState& state) const;
+    int runADMM(const std::vector<double>& current_weights,
+                const std::vector<double>& lower,
+                const std::vector<double>& upper,
+                RebalanceState& state, bool& converged) const;
+
+public:
+    RebalanceSolver(const std::vector<double>& expected_returns,
+                    const std::vector<double>& volatilities,
+                    const std::vector<std::vector<double>>& corr_matrix,
+                    const RebalanceCosts& costs,
+                    const RebalanceSettings& settings = RebalanceSettings());
+
+    // Solve for one account; state carries the warm start across consecutive days
+    RebalanceResult solve(const std::vector<double>& current_weights, RebalanceState& state) const;
+
+    // Solve for many accounts sharing the universe and factorization, in parallel
+    std::vector<RebalanceResult> solveBatch(const std::vector<std::vector<double>>& current_weights,
+                                            std::vector<RebalanceState>& states) const;
+
+    // Daily alpha updates do not change the factorized system
+    void updateExpectedReturns(const std::vector<double>& expected_returns);
+};
+
+#endif // REBALANCE_H
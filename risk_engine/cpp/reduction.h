@@ -0,0 +1,59 @@
+#ifndef REDUCTION_H
+#define REDUCTION_H
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <cstddef>
+#include "lifecycle.h"
+
+// Order-independent accumulation for engine reductions. Values are summed in fixed-size chunks,
+// each chunk in index order, and the chunk partials are combined in a fixed binary tree. The
+// bracketing depends only on the number of values, never on the thread count or the schedule, so
+// results are bit-identical on any number of threads (and the tree keeps rounding error O(log n)).
+
+const size_t kReductionChunk = 2048;
+
+// Combines partials[0] + partials[1] + ... as ((p0 + p1) + (p2 + p3)) + ..., in place
+template <typename T, typename Combine>
+T treeReduce(std::vector<T>& partials, Combine combine) {
+    if (partials.empty()) return T();
+    for (size_t stride = 1; stride < partials.size(); stride *= 2) {
+        for (size_t i = 0; i + stride < partials.size(); i += 2 * stride) {
+            partials[i] = combine(partials[i], partials[i + stride]);
+        }
+    }
+    return partials[0];
+}
+
+// K running sums over [0, count): chunk(first, last) returns the sums of one chunk, and chunks
+// are evaluated in parallel
+template <size_t K, typename Chunk>
+std::array<double, K> chunkedSums(size_t count, Chunk chunk, size_t chunk_size = kReductionChunk) {
+    size_t num_chunks = (count + chunk_size - 1) / chunk_size;
+    std::vector<std::array<double, K>> partials(num_chunks);
+    #pragma omp parallel for schedule(static) if (num_chunks > 8) num_threads(parallelThreads())
+    for (long c = 0; c < static_cast<long>(num_chunks); ++c) {
+        size_t first = static_cast<size_t>(c) * chunk_size;
+        partials[c] = chunk(first, std::min(first + chunk_size, count));
+    }
+    if (partials.empty()) {
+        std::array<double, K> zero;
+        zero.fill(0.0);
+        return zero;
+    }
+    return treeReduce(partials, [](std::array<double, K> a, const std::array<double, K>& b) {
+        for (size_t k = 0; k < K; ++k) a[k] += b[k];
+        return a;
+    });
+}
+
+inline double reproducibleSum(const double* values, size_t count) {
+    return chunkedSums<1>(count, [values](size_t first, size_t last) {
+        double sum = 0.0;
+        for (size_t i = first; i < last; ++i) sum += values[i];
+        return std::array<double, 1>{sum};
+    })[0];
+}
+
+#endif // REDUCTION_H
@@ -0,0 +1,362 @@
+#include "regime.h"
+#include "linalg.h"
+#include "lifecycle.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+const double kLogTwoPi = 1.8378770664093453;
+
+// Transition probabilities are kept away from zero so no regime becomes unreachable
+const double kMinTransition = 1e-10;
+
+// A regime needs this many effective observations per asset to keep a usable covariance
+const double kMinRegimeObservations = 2.0;
+
+struct HmmParameters {
+    std::vector<double> initial;     // K
+    std::vector<double> transition;  // K x K
+    std::vector<double> means;       // K x n
+    std::vector<double> covariances; // K x n x n
+};
+
+struct RestartResult {
+    HmmParameters parameters;
+    std::vector<double> gamma; // T x K
+    double log_likelihood;
+    int iterations;
+    bool converged;
+};
+
+// Weighted means and covariances from responsibilities gamma (T x K); data is asset-major (n x T).
+// Returns false if a regime is left with too little weight.
+bool updateEmissions(const std::vector<double>& data, size_t num_obs, size_t n, size_t num_regimes,
+                     const std::vector<double>& gamma, double ridge, HmmParameters& params,
+                     std::vector<double>& weights, std::vector<double>& centered) {
+    params.means.assign(num_regimes * n, 0.0);
+    params.covariances.assign(num_regimes * n * n, 0.0);
+    for (size_t k = 0; k < num_regimes; ++k) {
+        double total = 0.0;
+        for (size_t t = 0; t < num_obs; ++t) {
+            weights[t] = gamma[t * num_regimes + k];
+            total += weights[t];
+        }
+        if (total < kMinRegimeObservations * static_cast<double>(n)) return false;
+        double* mean = &params.means[k * n];
+        for (size_t i = 0; i < n; ++i) {
+            const double* x = &data[i * num_obs];
+            double sum = 0.0;
+            #pragma omp simd reduction(+:sum)
+            for (size_t t = 0; t < num_obs; ++t) sum += weights[t] * x[t];
+            mean[i] = sum / total;
+            double* c = &centered[i * num_obs];
+            double m = mean[i];
+            #pragma omp simd
+            for (size_t t = 0; t < num_obs; ++t) c[t] = x[t] - m;
+        }
+        double* cov = &params.covariances[k * n * n];
+        for (size_t i = 0; i < n; ++i) {
+            const double* ci = &centered[i * num_obs];
+            for (size_t j = 0; j <= i; ++j) {
+                const double* cj = &centered[j * num_obs];
+                double sum = 0.0;
+                #pragma omp simd reduction(+:sum)
+                for (size_t t = 0; t < num_obs; ++t) sum += weights[t] * ci[t] * cj[t];
+                cov[i * n + j] = cov[j * n + i] = sum / total;
+            }
+            cov[i * n + i] += ridge;
+        }
+    }
+    return true;
+}
+
+// log N(x_t; mu_k, Sigma_k) for every observation and regime (T x K). Solving L y = x - mu one
+// asset row at a time keeps the inner loops running over the time axis.
+bool emissionLogDensities(const std::vector<double>& data, size_t num_obs, size_t n, size_t num_regimes,
+                          const HmmParameters& params, std::vector<double>& log_density,
+                          std::vector<double>& solved, std::vector<double>& quadratic) {
+    std::vector<double> factor(n * n);
+    for (size_t k = 0; k < num_regimes; ++k) {
+        std::copy(&params.covariances[k * n * n], &params.covariances[(k + 1) * n * n], factor.begin());
+        if (!choleskyFactor(factor, n)) return false;
+        double log_det = 0.0;
+        std::fill(quadratic.begin(), quadratic.end(), 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            double* y = &solved[i * num_obs];
+            const double* x = &data[i * num_obs];
+            double mean = params.means[k * n + i];
+            #pragma omp simd
+            for (size_t t = 0; t < num_obs; ++t) y[t] = x[t] - mean;
+            for (size_t j = 0; j < i; ++j) {
+                const double* yj = &solved[j * num_obs];
+                double l = factor[i * n + j];
+                #pragma omp simd
+                for (size_t t = 0; t < num_obs; ++t) y[t] -= l * yj[t];
+            }
+            double inverse_pivot = 1.0 / factor[i * n + i];
+            #pragma omp simd
+            for (size_t t = 0; t < num_obs; ++t) {
+                y[t] *= inverse_pivot;
+                quadratic[t] += y[t] * y[t];
+            }
+            log_det += 2.0 * std::log(factor[i * n + i]);
+        }
+        double constant = -0.5 * (static_cast<double>(n) * kLogTwoPi + log_det);
+        for (size_t t = 0; t < num_obs; ++t) {
+            log_density[t * num_regimes + k] = constant - 0.5 * quadratic[t];
+        }
+    }
+    return true;
+}
+
+// Scaled forward-backward: fills gamma (T x K) and the expected transition counts, returns log L
+double forwardBackward(const std::vector<double>& log_density, size_t num_obs, size_t num_regimes,
+                       const HmmParameters& params, std::vector<double>& emission,
+                       std::vector<double>& alpha, std::vector<double>& beta, std::vector<double>& scale,
+                       std::vector<double>& gamma, std::vector<double>& transition_counts) {
+    size_t K = num_regimes;
+    double log_likelihood = 0.0;
+    for (size_t t = 0; t < num_obs; ++t) {
+        const double* lb = &log_density[t * K];
+        double shift = *std::max_element(lb, lb + K);
+        for (size_t k = 0; k < K; ++k) emission[t * K + k] = std::exp(lb[k] - shift);
+        log_likelihood += shift;
+    }
+
+    for (size_t t = 0; t < num_obs; ++t) {
+        double* a = &alpha[t * K];
+        const double* e = &emission[t * K];
+        double total = 0.0;
+        for (size_t k = 0; k < K; ++k) {
+            double prior = 0.0;
+            if (t == 0) {
+                prior = params.initial[k];
+            } else {
+                const double* previous = &alpha[(t - 1) * K];
+                for (size_t j = 0; j < K; ++j) prior += previous[j] * params.transition[j * K + k];
+            }
+            a[k] = prior * e[k];
+            total += a[k];
+        }
+        if (!(total > 0.0)) return -std::numeric_limits<double>::infinity();
+        scale[t] = total;
+        for (size_t k = 0; k < K; ++k) a[k] /= total;
+        log_likelihood += std::log(total);
+    }
+
+    std::fill(&beta[(num_obs - 1) * K], &beta[num_obs * K], 1.0);
+    std::fill(transition_counts.begin(), transition_counts.end(), 0.0);
+    for (size_t t = num_obs - 1; t > 0; --t) {
+        const double* next = &beta[t * K];
+        const double* e = &emission[t * K];
+        const double* a = &alpha[(t - 1) * K];
+        double* b = &beta[(t - 1) * K];
+        double inverse_scale = 1.0 / scale[t];
+        for (size_t j = 0; j < K; ++j) {
+            double sum = 0.0;
+            for (size_t k = 0; k < K; ++k) {
+                double flow = params.transition[j * K + k] * e[k] * next[k] * inverse_scale;
+                sum += flow;
+                transition_counts[j * K + k] += a[j] * flow;
+            }
+            b[j] = sum;
+        }
+    }
+    for (size_t t = 0; t < num_obs; ++t) {
+        double total = 0.0;
+        for (size_t k = 0; k < K; ++k) {
+            gamma[t * K + k] = alpha[t * K + k] * beta[t * K + k];
+            total += gamma[t * K + k];
+        }
+        for (size_t k = 0; k < K; ++k) gamma[t * K + k] /= total;
+    }
+    return log_likelihood;
+}
+
+// Hard initial assignment by smoothed squared return magnitude: restart 0 splits at equal
+// quantiles, later restarts at random cut points with a random smoothing window
+void initialResponsibilities(const std::vector<double>& data, size_t num_obs, size_t n, size_t num_regimes,
+                             size_t restart, uint64_t seed, std::vector<double>& gamma) {
+    std::mt19937_64 gen(seed + 0x9e3779b97f4a7c15ULL * (restart + 1));
+    size_t window = restart == 0 ? 21 : 1 + gen() % 42;
+    window = std::min(window, num_obs);
+
+    std::vector<double> magnitude(num_obs, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        const double* x = &data[i * num_obs];
+        for (size_t t = 0; t < num_obs; ++t) magnitude[t] += x[t] * x[t];
+    }
+    std::vector<double> smoothed(num_obs);
+    double running = 0.0;
+    for (size_t t = 0; t < num_obs; ++t) {
+        running += magnitude[t];
+        if (t >= window) running -= magnitude[t - window];
+        smoothed[t] = running / static_cast<double>(std::min(t + 1, window));
+    }
+
+    std::vector<double> cuts(num_regimes - 1);
+    std::uniform_real_distribution<double> uniform(0.1, 0.9);
+    for (size_t k = 0; k + 1 < num_regimes; ++k) {
+        cuts[k] = restart == 0 ? static_cast<double>(k + 1) / num_regimes : uniform(gen);
+    }
+    std::sort(cuts.begin(), cuts.end());
+    std::vector<size_t> order(num_obs);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return smoothed[a] < smoothed[b]; });
+
+    std::fill(gamma.begin(), gamma.end(), 0.0);
+    for (size_t rank = 0, k = 0; rank < num_obs; ++rank) {
+        double quantile = (rank + 0.5) / static_cast<double>(num_obs);
+        while (k + 1 < num_regimes && quantile > cuts[k]) ++k;
+        gamma[order[rank] * num_regimes + k] = 1.0;
+    }
+}
+
+RestartResult fitRestart(const std::vector<double>& data, size_t num_obs, size_t n,
+                         const HmmFitSettings& settings, size_t restart, uint64_t seed, double ridge) {
+    size_t K = settings.num_regimes;
+    RestartResult result;
+    result.log_likelihood = -std::numeric_limits<double>::infinity();
+    result.iterations = 0;
+    result.converged = false;
+
+    std::vector<double> gamma(num_obs * K), weights(num_obs), work(n * num_obs), quadratic(num_obs);
+    std::vector<double> log_density(num_obs * K), emission(num_obs * K), alpha(num_obs * K),
+                        beta(num_obs * K), scale(num_obs), transition_counts(K * K);
+    HmmParameters params;
+    initialResponsibilities(data, num_obs, n, K, restart, seed, gamma);
+    params.initial.assign(K, 1.0 / K);
+    params.transition.assign(K * K, 0.05 / std::max<size_t>(K - 1, 1));
+    for (size_t k = 0; k < K; ++k) params.transition[k * K + k] = K > 1 ? 0.95 : 1.0;
+    if (!updateEmissions(data, num_obs, n, K, gamma, ridge, params, weights, work)) return result;
+
+    double previous = -std::numeric_limits<double>::infinity();
+    for (size_t iteration = 0; iteration < settings.max_iterations; ++iteration) {
+        // E-step
+        if (!emissionLogDensities(data, num_obs, n, K, params, log_density, work, quadratic)) return result;
+        double log_likelihood = forwardBackward(log_density, num_obs, K, params, emission, alpha, beta,
+                                                scale, gamma, transition_counts);
+        if (!std::isfinite(log_likelihood)) return result;
+        result.parameters = params;
+        result.gamma = gamma;
+        result.log_likelihood = log_likelihood;
+        result.iterations = static_cast<int>(iteration + 1);
+        if (log_likelihood - previous < settings.tolerance * static_cast<double>(num_obs)) {
+            result.converged = true;
+            break;
+        }
+        previous = log_likelihood;
+
+        // M-step
+        for (size_t k = 0; k < K; ++k) params.initial[k] = gamma[k];
+        for (size_t j = 0; j < K; ++j) {
+            double total = 0.0;
+            for (size_t k = 0; k < K; ++k) {
+                params.transition[j * K + k] = std::max(transition_counts[j * K + k], kMinTransition);
+                total += params.transition[j * K + k];
+            }
+            for (size_t k = 0; k < K; ++k) params.transition[j * K + k] /= total;
+        }
+        if (!updateEmissions(data, num_obs, n, K, gamma, ridge, params, weights, work)) break;
+    }
+    return result;
+}
+
+} // namespace
+
+HmmFitResult fitGaussianHMM(const std::vector<std::vector<double>>& returns, const HmmFitSettings& settings) {
+    size_t num_obs = returns.size();
+    size_t K = settings.num_regimes;
+    if (K == 0) {
+        throw std::invalid_argument("Need at least one regime");
+    }
+    if (settings.restarts == 0 || settings.max_iterations == 0) {
+        throw std::invalid_argument("Need at least one restart and one iteration");
+    }
+    if (settings.periods_per_year <= 0.0) {
+        throw std::invalid_argument("Periods per year must be positive");
+    }
+    if (num_obs == 0 || returns[0].empty()) {
+        throw std::invalid_argument("Return history cannot be empty");
+    }
+    size_t n = returns[0].size();
+    if (static_cast<double>(num_obs) < kMinRegimeObservations * static_cast<double>(n * K)) {
+        throw std::invalid_argument("Return history is too short for the number of assets and regimes");
+    }
+
+    // Asset-major copy so every per-asset pass streams over the time axis
+    std::vector<double> data(n * num_obs);
+    double mean_variance = 0.0;
+    for (size_t t = 0; t < num_obs; ++t) {
+        if (returns[t].size() != n) {
+            throw std::invalid_argument("Every observation must have one return per asset");
+        }
+        for (size_t i = 0; i < n; ++i) data[i * num_obs + t] = returns[t][i];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const double* x = &data[i * num_obs];
+        double mean = std::accumulate(x, x + num_obs, 0.0) / num_obs;
+        double sum = 0.0;
+        for (size_t t = 0; t < num_obs; ++t) sum += (x[t] - mean) * (x[t] - mean);
+        mean_variance += sum / num_obs;
+    }
+    mean_variance /= n;
+    double ridge = settings.regularization * std::max(mean_variance, std::numeric_limits<double>::min());
+
+    std::random_device seed_source;
+    uint64_t seed = settings.seed != 0 ? settings.seed : (uint64_t(seed_source()) << 32) | seed_source();
+    std::vector<RestartResult> restarts(settings.restarts);
+    #pragma omp parallel for schedule(dynamic) num_threads(parallelThreads())
+    for (long r = 0; r < static_cast<long>(settings.restarts); ++r) {
+        restarts[r] = fitRestart(data, num_obs, n, settings, static_cast<size_t>(r), seed, ridge);
+    }
+    size_t best = 0;
+    for (size_t r = 1; r < restarts.size(); ++r) {
+        if (restarts[r].log_likelihood > restarts[best].log_likelihood) best = r;
+    }
+    const RestartResult& winner = restarts[best];
+    if (!std::isfinite(winner.log_likelihood)) {
+        throw std::runtime_error("HMM fit failed on every restart; try fewer regimes or more regularization");
+    }
+
+    // Order regimes from calm to turbulent by total variance
+    const HmmParameters& params = winner.parameters;
+    std::vector<double> total_variance(K, 0.0);
+    for (size_t k = 0; k < K; ++k) {
+        for (size_t i = 0; i < n; ++i) total_variance[k] += params.covariances[k * n * n + i * n + i];
+    }
+    std::vector<size_t> order(K);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return total_variance[a] < total_variance[b]; });
+
+    HmmFitResult result;
+    GaussianHMM& model = result.model;
+    model.periods_per_year = settings.periods_per_year;
+    model.initial_probabilities.resize(K);
+    model.transition.assign(K, std::vector<double>(K));
+    model.means.assign(K, std::vector<double>(n));
+    model.covariances.assign(K, std::vector<std::vector<double>>(n, std::vector<double>(n)));
+    for (size_t a = 0; a < K; ++a) {
+        size_t k = order[a];
+        model.initial_probabilities[a] = params.initial[k];
+        for (size_t b = 0; b < K; ++b) model.transition[a][b] = params.transition[k * K + order[b]];
+        std::copy(&params.means[k * n], &params.means[(k + 1) * n], model.means[a].begin());
+        for (size_t i = 0; i < n; ++i) {
+            const double* row = &params.covariances[k * n * n + i * n];
+            std::copy(row, row + n, model.covariances[a][i].begin());
+        }
+    }
+    result.regime_probabilities.assign(num_obs, std::vector<double>(K));
+    for (size_t t = 0; t < num_obs; ++t) {
+        for (size_t a = 0; a < K; ++a) result.regime_probabilities[t][a] = winner.gamma[t * K + order[a]];
+    }
+    result.log_likelihood = winner.log_likelihood;
+    result.iterations = winner.iterations;
+    result.converged = winner.converged;
+    return result;
+}
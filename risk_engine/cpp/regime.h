@@ -0,0 +1,49 @@
+#ifndef REGIME_H
+#define REGIME_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Gaussian hidden Markov model of per-period asset returns: the regime follows a Markov chain and
+// returns in regime k are N(means[k], covariances[k])
+struct GaussianHMM {
+    std::vector<double> initial_probabilities;                // Regime distribution at the first observation
+    std::vector<std::vector<double>> transition;              // K x K, row j = P(next regime | regime j)
+    std::vector<std::vector<double>> means;                   // K x n mean return per period
+    std::vector<std::vector<std::vector<double>>> covariances; // K x n x n return covariance per period
+    double periods_per_year;                                  // Observation frequency (252 = daily)
+
+    GaussianHMM() : periods_per_year(252.0) {}
+
+    size_t numRegimes() const { return transition.size(); }
+};
+
+struct HmmFitSettings {
+    size_t num_regimes;     // Hidden states
+    size_t max_iterations;  // Baum-Welch iterations per restart
+    double tolerance;       // Stop once the log-likelihood per observation improves by less
+    size_t restarts;        // Independent initializations, fitted in parallel; the best one wins
+    double regularization;  // Ridge added to each covariance, relative to the mean sample variance
+    double periods_per_year;
+    uint64_t seed;          // 0 = random seed (restart 0 is always the deterministic volatility split)
+
+    HmmFitSettings()
+        : num_regimes(2), max_iterations(200), tolerance(1e-7), restarts(4), regularization(1e-6),
+          periods_per_year(252.0), seed(0) {}
+};
+
+struct HmmFitResult {
+    GaussianHMM model;                               // Regimes ordered from lowest to highest variance
+    double log_likelihood;                           // Of the winning restart
+    int iterations;                                  // Baum-Welch iterations of the winning restart
+    bool converged;                                  // False when max_iterations was hit
+    std::vector<std::vector<double>> regime_probabilities; // T x K smoothed P(regime | all returns)
+};
+
+// Baum-Welch fit of a Gaussian HMM to T x n returns. Emission densities are evaluated for all
+// observations at once via triangular solves over the time axis; forward-backward runs on
+// max-shifted log densities with per-step rescaling, so long samples do not underflow.
+HmmFitResult fitGaussianHMM(const std::vector<std::vector<double>>& returns, const HmmFitSettings& settings);
+
+#endif // REGIME_H
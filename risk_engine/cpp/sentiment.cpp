@@ -0,0 +1,291 @@
+#include "sentiment.h"
+#include "lifecycle.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+const double kDaysPerYear = 365.25;
+
+// Standard deviations below this are treated as a constant series
+const double kMinDeviation = 1e-12;
+
+void checkSeries(const std::vector<size_t>& offsets, const std::vector<double>& days,
+                 const std::vector<double>& values, size_t num_assets, const char* what) {
+    if (offsets.size() != num_assets + 1 || offsets.front() != 0 || offsets.back() != days.size()) {
+        throw std::invalid_argument(std::string(what) + " offsets must have one entry per ticker plus one, "
+                                    "start at 0 and end at the data length");
+    }
+    if (values.size() != days.size()) {
+        throw std::invalid_argument(std::string(what) + " values must match the number of days");
+    }
+    for (size_t a = 0; a < num_assets; ++a) {
+        if (offsets[a + 1] < offsets[a]) {
+            throw std::invalid_argument(std::string(what) + " offsets must be non-decreasing");
+        }
+        for (size_t k = offsets[a]; k < offsets[a + 1]; ++k) {
+            if (!std::isfinite(days[k]) || !std::isfinite(values[k])) {
+                throw std::invalid_argument(std::string(what) + " days and values must be finite");
+            }
+            if (k > offsets[a] && !(days[k] > days[k - 1])) {
+                throw std::invalid_argument(std::string(what) + " days must increase within each ticker");
+            }
+        }
+    }
+}
+
+// Index of the last observation on or before day in [first, last), or last if there is none
+inline size_t asOf(const double* days, size_t first, size_t last, size_t& cursor, double day) {
+    while (cursor < last && days[cursor] <= day) ++cursor;
+    return cursor > first ? cursor - 1 : last;
+}
+
+inline double nan() {
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+} // namespace
+
+SentimentCalibration calibrateSentimentFactors(const SentimentHistories& histories,
+                                               const SentimentCalibrationSettings& settings) {
+    if (histories.price_offsets.empty()) {
+        throw std::invalid_argument("Price offsets must have one entry per ticker plus one");
+    }
+    size_t num_assets = histories.price_offsets.size() - 1;
+    checkSeries(histories.price_offsets, histories.price_days, histories.prices, num_assets, "Price");
+    checkSeries(histories.score_offsets, histories.score_days, histories.scores, num_assets, "Score");
+    for (double price : histories.prices) {
+        if (!(price > 0.0)) {
+            throw std::invalid_argument("Prices must be positive");
+        }
+    }
+    if (settings.min_observations < 3) {
+        throw std::invalid_argument("Calibration needs at least three observations per asset");
+    }
+    if (settings.drift_shrinkage < 0.0 || settings.drift_shrinkage > 1.0) {
+        throw std::invalid_argument("Drift shrinkage must be between 0 and 1");
+    }
+
+    // Common grid: every day on which some ticker has a price
+    std::vector<double> grid(histories.price_days);
+    std::sort(grid.begin(), grid.end());
+    grid.erase(std::unique(grid.begin(), grid.end()), grid.end());
+    size_t num_intervals = grid.size() > 1 ? grid.size() - 1 : 0;
+    std::vector<double> interval_years(num_intervals);
+    for (size_t t = 0; t < num_intervals; ++t) {
+        interval_years[t] = (grid[t + 1] - grid[t]) / kDaysPerYear;
+    }
+
+    // Per asset and interval, NaN where the asset has no data: log return per sqrt(year),
+    // standardized score change, and the score z-score at the start of the interval
+    size_t cells = num_assets * num_intervals;
+    std::vector<double> scaled_returns(cells, nan()), score_changes(cells, nan()), lagged_levels(cells, nan());
+    SentimentCalibration result;
+    result.current_sentiment.assign(num_assets, 0.0);
+    #pragma omp parallel for schedule(dynamic, 16) num_threads(parallelThreads())
+    for (long a = 0; a < static_cast<long>(num_assets); ++a) {
+        size_t price_first = histories.price_offsets[a], price_last = histories.price_offsets[a + 1];
+        size_t score_first = histories.score_offsets[a], score_last = histories.score_offsets[a + 1];
+        if (price_last - price_first < 2 || score_last == score_first) continue;
+        const double* price_days = histories.price_days.data();
+        const double* score_days = histories.score_days.data();
+
+        double score_mean = 0.0, score_square = 0.0;
+        for (size_t k = score_first; k < score_last; ++k) score_mean += histories.scores[k];
+        score_mean /= static_cast<double>(score_last - score_first);
+        for (size_t k = score_first; k < score_last; ++k) {
+            double d = histories.scores[k] - score_mean;
+            score_square += d * d;
+        }
+        double score_deviation = std::sqrt(score_square / static_cast<double>(score_last - score_first));
+        double level_scale = score_deviation > kMinDeviation ? 1.0 / score_deviation : 0.0;
+        result.current_sentiment[a] = (histories.scores[score_last - 1] - score_mean) * level_scale;
+
+        // Walk the grid once from the ticker's first price, carrying prices and scores forward
+        size_t start = std::lower_bound(grid.begin(), grid.end(), price_days[price_first]) - grid.begin();
+        double end_day = price_days[price_last - 1];
+        size_t price_cursor = price_first, score_cursor = score_first;
+        size_t previous_price = asOf(price_days, price_first, price_last, price_cursor, grid[start]);
+        size_t previous_score = asOf(score_days, score_first, score_last, score_cursor, grid[start]);
+        double* returns = &scaled_returns[a * num_intervals];
+        double* changes = &score_changes[a * num_intervals];
+        double* levels = &lagged_levels[a * num_intervals];
+        double change_sum = 0.0, change_square = 0.0;
+        size_t change_count = 0;
+        for (size_t t = start; t < num_intervals && grid[t + 1] <= end_day; ++t) {
+            size_t price = asOf(price_days, price_first, price_last, price_cursor, grid[t + 1]);
+            size_t score = asOf(score_days, score_first, score_last, score_cursor, grid[t + 1]);
+            if (previous_score != score_last) {
+                double root_years = std::sqrt(interval_years[t]);
+                returns[t] = std::log(histories.prices[price] / histories.prices[previous_price]) / root_years;
+                changes[t] = (histories.scores[score] - histories.scores[previous_score]) / root_years;
+                levels[t] = (histories.scores[previous_score] - score_mean) * level_scale;
+                change_sum += changes[t];
+                change_square += changes[t] * changes[t];
+                ++change_count;
+            }
+            previous_price = price;
+            previous_score = score;
+        }
+
+        // Standardize the asset's score changes so every ticker's scale counts the same
+        if (change_count == 0) continue;
+        double change_mean = change_sum / static_cast<double>(change_count);
+        double change_variance = change_square / static_cast<double>(change_count) - change_mean * change_mean;
+        double change_scale = change_variance > kMinDeviation * kMinDeviation ? 1.0 / std::sqrt(change_variance) : 0.0;
+        for (size_t t = start; t < num_intervals; ++t) {
+            if (!std::isnan(changes[t])) changes[t] = (changes[t] - change_mean) * change_scale;
+        }
+    }
+
+    // Common shock and equal-weighted market return per interval
+    std::vector<double> shock(num_intervals, nan()), market(num_intervals, nan());
+    #pragma omp parallel for schedule(static) if (num_intervals * num_assets > 65536) num_threads(parallelThreads())
+    for (long t = 0; t < static_cast<long>(num_intervals); ++t) {
+        double shock_sum = 0.0, market_sum = 0.0;
+        size_t count = 0;
+        for (size_t a = 0; a < num_assets; ++a) {
+            double change = score_changes[a * num_intervals + t];
+            if (std::isnan(change)) continue;
+            shock_sum += change;
+            market_sum += scaled_returns[a * num_intervals + t];
+            ++count;
+        }
+        if (count == 0) continue;
+        shock[t] = shock_sum / static_cast<double>(count);
+        market[t] = market_sum / static_cast<double>(count);
+    }
+    double shock_sum = 0.0, shock_square = 0.0;
+    size_t shock_count = 0;
+    for (size_t t = 0; t < num_intervals; ++t) {
+        if (std::isnan(shock[t])) continue;
+        shock_sum += shock[t];
+        shock_square += shock[t] * shock[t];
+        ++shock_count;
+    }
+    double shock_mean = shock_count > 0 ? shock_sum / static_cast<double>(shock_count) : 0.0;
+    double shock_variance = shock_count > 0 ? shock_square / static_cast<double>(shock_count) - shock_mean * shock_mean : 0.0;
+    double shock_scale = shock_variance > kMinDeviation * kMinDeviation ? 1.0 / std::sqrt(shock_variance) : 0.0;
+    double covariance = 0.0, market_square = 0.0, market_sum = 0.0;
+    for (size_t t = 0; t < num_intervals; ++t) {
+        if (std::isnan(shock[t])) continue;
+        shock[t] = (shock[t] - shock_mean) * shock_scale;
+        market_sum += market[t];
+    }
+    double market_mean = shock_count > 0 ? market_sum / static_cast<double>(shock_count) : 0.0;
+    for (size_t t = 0; t < num_intervals; ++t) {
+        if (std::isnan(shock[t])) continue;
+        covariance += shock[t] * (market[t] - market_mean);
+        market_square += (market[t] - market_mean) * (market[t] - market_mean);
+    }
+    result.market_correlation = shock_scale > 0.0 && market_square > 0.0
+                                    ? covariance / std::sqrt(static_cast<double>(shock_count) * market_square)
+                                    : 0.0;
+
+    // Per-asset loading on the shock, and within-asset sums for the pooled drift slope
+    result.model.loadings.assign(num_assets, 0.0);
+    result.residual_volatility.assign(num_assets, 0.0);
+    result.r_squared.assign(num_assets, 0.0);
+    result.observations.assign(num_assets, 0);
+    std::vector<double> slope_numerator(num_assets, 0.0), slope_denominator(num_assets, 0.0);
+    std::vector<double> mean_levels(num_assets, 0.0), mean_rates(num_assets, 0.0);
+    std::vector<size_t> drift_counts(num_assets, 0);
+    #pragma omp parallel for schedule(dynamic, 16) num_threads(parallelThreads())
+    for (long a = 0; a < static_cast<long>(num_assets); ++a) {
+        const double* returns = &scaled_returns[a * num_intervals];
+        const double* levels = &lagged_levels[a * num_intervals];
+        double sum_s = 0.0, sum_x = 0.0, sum_ss = 0.0, sum_xx = 0.0, sum_sx = 0.0;
+        double years = 0.0, level_weight = 0.0, log_growth = 0.0;
+        size_t count = 0;
+        for (size_t t = 0; t < num_intervals; ++t) {
+            double x = returns[t], s = shock[t];
+            if (std::isnan(x) || std::isnan(s)) continue;
+            sum_s += s;
+            sum_x += x;
+            sum_ss += s * s;
+            sum_xx += x * x;
+            sum_sx += s * x;
+            double root_years = std::sqrt(interval_years[t]);
+            years += interval_years[t];
+            level_weight += interval_years[t] * levels[t];
+            log_growth += x * root_years;
+            ++count;
+        }
+        result.observations[a] = count;
+        if (count < 2) continue;
+        double inverse = 1.0 / static_cast<double>(count);
+        double variance_s = sum_ss * inverse - sum_s * inverse * sum_s * inverse;
+        double variance_x = std::max(sum_xx * inverse - sum_x * inverse * sum_x * inverse, 0.0);
+        double covariance_sx = sum_sx * inverse - sum_s * inverse * sum_x * inverse;
+        result.residual_volatility[a] = std::sqrt(variance_x);
+        if (count < settings.min_observations || variance_s <= kMinDeviation) continue;
+
+        double loading = covariance_sx / variance_s;
+        result.model.loadings[a] = loading;
+        result.residual_volatility[a] = std::sqrt(std::max(variance_x - loading * covariance_sx, 0.0));
+        result.r_squared[a] = variance_x > 0.0 ? loading * covariance_sx / variance_x : 0.0;
+
+        // Weighted least squares of the annualized return on the lagged level, demeaned per asset
+        if (years <= 0.0) continue;
+        double mean_level = level_weight / years, mean_rate = log_growth / years;
+        double numerator = 0.0, denominator = 0.0;
+        for (size_t t = 0; t < num_intervals; ++t) {
+            double x = returns[t];
+            if (std::isnan(x) || std::isnan(shock[t])) continue;
+            double centered = levels[t] - mean_level;
+            numerator += centered * (x * std::sqrt(interval_years[t]) - mean_rate * interval_years[t]);
+            denominator += interval_years[t] * centered * centered;
+        }
+        slope_numerator[a] = numerator;
+        slope_denominator[a] = denominator;
+        mean_levels[a] = mean_level;
+        mean_rates[a] = mean_rate;
+        drift_counts[a] = count;
+    }
+
+    // Pooled in asset order, so the slope does not depend on the thread count
+    double numerator = 0.0, denominator = 0.0;
+    for (size_t a = 0; a < num_assets; ++a) {
+        numerator += slope_numerator[a];
+        denominator += slope_denominator[a];
+    }
+    result.drift_slope = denominator > 0.0 ? numerator / denominator : 0.0;
+
+    // Standard error of the pooled slope, clustered by interval: every asset loads on the same
+    // shock, so residuals of one interval are not independent across assets
+    std::vector<double> interval_scores(num_intervals, 0.0);
+    #pragma omp parallel for schedule(static) if (cells > 65536) num_threads(parallelThreads())
+    for (long t = 0; t < static_cast<long>(num_intervals); ++t) {
+        if (std::isnan(shock[t])) continue;
+        double root_years = std::sqrt(interval_years[t]);
+        double sum = 0.0;
+        for (size_t a = 0; a < num_assets; ++a) {
+            double x = scaled_returns[a * num_intervals + t];
+            if (drift_counts[a] == 0 || std::isnan(x)) continue;
+            double centered = lagged_levels[a * num_intervals + t] - mean_levels[a];
+            double residual = x - (mean_rates[a] + result.drift_slope * centered) * root_years;
+            sum += centered * root_years * residual;
+        }
+        interval_scores[t] = sum;
+    }
+    double score_variance = 0.0;
+    for (double score : interval_scores) score_variance += score * score;
+    result.drift_t_stat = score_variance > 0.0 && shock_count >= settings.min_observations
+                              ? result.drift_slope * denominator / std::sqrt(score_variance)
+                              : 0.0;
+
+    // Positive-part James-Stein: an insignificant slope (|t| <= 1) contributes no tilt
+    double t_square = result.drift_t_stat * result.drift_t_stat;
+    double shrinkage = t_square > 1.0 ? settings.drift_shrinkage * (1.0 - 1.0 / t_square) : 0.0;
+    result.model.drift_tilt.assign(num_assets, 0.0);
+    for (size_t a = 0; a < num_assets; ++a) {
+        if (result.model.loadings[a] != 0.0) {
+            result.model.drift_tilt[a] = shrinkage * result.drift_slope * result.current_sentiment[a];
+        }
+    }
+    result.num_intervals = num_intervals;
+    return result;
+}
@@ -0,0 +1,56 @@
+#ifndef SENTIMENT_H
+#define SENTIMENT_H
+
+#include <vector>
+#include <cstddef>
+
+// News-sentiment factor for scenario generation. Every asset loads on one common sentiment shock,
+// simulated as an extra row of the engine's Cholesky system, and today's sentiment tilts each
+// asset's drift. Loadings are calibrated for a whole universe in one call from the sentiment
+// service's score and price histories.
+
+struct SentimentFactorModel {
+    std::vector<double> loadings;          // Annual return volatility per unit sentiment shock, one per asset
+    std::vector<double> asset_correlation; // Correlation of the shock with each asset's own driver (empty = 0)
+    std::vector<double> drift_tilt;        // Annual expected-return shift from today's sentiment (empty = 0)
+};
+
+// Histories of all tickers back to back, ticker a's scores in [score_offsets[a], score_offsets[a + 1])
+// and its prices in [price_offsets[a], price_offsets[a + 1]). Days are any common day count
+// (e.g. days since 1970-01-01), increasing within each ticker.
+struct SentimentHistories {
+    std::vector<size_t> score_offsets; // Size A + 1
+    std::vector<double> score_days;
+    std::vector<double> scores;        // Sentiment score on that day, any scale
+    std::vector<size_t> price_offsets; // Size A + 1
+    std::vector<double> price_days;
+    std::vector<double> prices;        // Closing price, positive
+};
+
+struct SentimentCalibrationSettings {
+    size_t min_observations; // Return intervals needed for an asset's regression; fewer gives zero loading
+    double drift_shrinkage;  // Weight of the fitted drift slope, in [0, 1], before the t-statistic
+                             // shrinkage (1 - 1 / t^2)+; 0 disables the tilt
+
+    SentimentCalibrationSettings() : min_observations(5), drift_shrinkage(0.5) {}
+};
+
+struct SentimentCalibration {
+    SentimentFactorModel model;             // Ready for MonteCarloRiskEngine::setSentimentFactor
+    std::vector<double> residual_volatility; // Annual vol of each asset's return net of the sentiment shock
+    std::vector<double> r_squared;          // Share of return variance explained by the shock
+    std::vector<double> current_sentiment;  // Latest score as a z-score of the asset's own history
+    std::vector<size_t> observations;       // Return intervals used per asset
+    double drift_slope;                     // Pooled annual return per unit of lagged sentiment z-score
+    double drift_t_stat;                    // Its t-statistic
+    double market_correlation;              // Correlation of the shock with the equal-weighted market return
+    size_t num_intervals;                   // Intervals of the common day grid
+};
+
+// One regression per asset against the common shock (the standardized cross-sectional mean of the
+// assets' standardized score changes) on the union grid of price days, in parallel across assets
+SentimentCalibration calibrateSentimentFactors(const SentimentHistories& histories,
+                                               const SentimentCalibrationSettings& settings =
+                                                   SentimentCalibrationSettings());
+
+#endif // SENTIMENT_H
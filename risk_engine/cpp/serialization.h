@@ -0,0 +1,92 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+// Flat little-endian encoding of plain values, vectors and strings for snapshot payloads.
+// Readers check every length against the remaining bytes, so a truncated or corrupt payload
+// throws instead of reading past the end.
+
+class ByteWriter {
+private:
+    std::vector<uint8_t> buffer;
+
+public:
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written");
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+        buffer.insert(buffer.end(), p, p + sizeof(T));
+    }
+
+    template <typename T>
+    void putVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written");
+        put<uint64_t>(values.size());
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(values.data());
+        buffer.insert(buffer.end(), p, p + values.size() * sizeof(T));
+    }
+
+    void putString(const std::string& value) {
+        put<uint64_t>(value.size());
+        buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+
+    const std::vector<uint8_t>& bytes() const { return buffer; }
+};
+
+class ByteReader {
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+
+    void require(size_t bytes) const {
+        if (bytes > size - position) {
+            throw std::invalid_argument("Snapshot payload is truncated");
+        }
+    }
+
+public:
+    ByteReader(const uint8_t* bytes, size_t length) : data(bytes), size(length), position(0) {}
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read");
+        require(sizeof(T));
+        T value;
+        std::memcpy(&value, data + position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+
+    template <typename T>
+    std::vector<T> getVector() {
+        uint64_t count = get<uint64_t>();
+        if (count > (size - position) / sizeof(T)) {
+            throw std::invalid_argument("Snapshot payload is truncated");
+        }
+        std::vector<T> values(static_cast<size_t>(count));
+        std::memcpy(values.data(), data + position, values.size() * sizeof(T));
+        position += values.size() * sizeof(T);
+        return values;
+    }
+
+    std::string getString() {
+        uint64_t length = get<uint64_t>();
+        require(static_cast<size_t>(length));
+        std::string value(reinterpret_cast<const char*>(data + position), static_cast<size_t>(length));
+        position += value.size();
+        return value;
+    }
+
+    bool exhausted() const { return position == size; }
+};
+
+#endif // SERIALIZATION_H
@@ -0,0 +1,385 @@
+#include "snapshot.h"
+#include "factor_cache.h"
+#include "serialization.h"
+#include "sobol.h"
+#include "lifecycle.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kMagic[8] = {'R', 'I', 'S', 'K', 'S', 'N', 'A', 'P'};
+const uint32_t kSnapshotVersion = 1;
+const uint32_t kByteOrderMark = 0x01020304;
+
+// Header and directory entries are one cache line each; sections start on a cache line
+const size_t kAlignment = 64;
+const size_t kKeyBytes = 32;
+const size_t kFactorHeaderBytes = 32;
+
+size_t alignUp(size_t offset) {
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+inline uint64_t rotateLeft(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Word-at-a-time integrity check; detects truncation and bit rot, not tampering
+class Checksum {
+private:
+    uint64_t state;
+
+public:
+    Checksum() : state(0x9e3779b97f4a7c15ULL) {}
+
+    void update(const uint8_t* data, size_t size) {
+        size_t words = size / 8;
+        for (size_t i = 0; i < words; ++i) {
+            uint64_t word;
+            std::memcpy(&word, data + i * 8, 8);
+            state = rotateLeft(state ^ (word * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
+        }
+        for (size_t i = words * 8; i < size; ++i) {
+            state = (state ^ data[i]) * 0x100000001b3ULL;
+        }
+    }
+
+    uint64_t value() const {
+        uint64_t x = state;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        return x ^ (x >> 33);
+    }
+};
+
+void putKey(ByteWriter& out, const std::string& key) {
+    char buffer[kKeyBytes] = {};
+    std::memcpy(buffer, key.data(), key.size());
+    for (char c : buffer) out.put(c);
+}
+
+std::vector<uint8_t> serializeModel(const GaussianHMM& model) {
+    size_t K = model.numRegimes();
+    size_t n = K > 0 ? model.means[0].size() : 0;
+    ByteWriter out;
+    out.put<uint64_t>(K);
+    out.put<uint64_t>(n);
+    out.put(model.periods_per_year);
+    out.putVector(model.initial_probabilities);
+    for (size_t k = 0; k < K; ++k) out.putVector(model.transition[k]);
+    for (size_t k = 0; k < K; ++k) out.putVector(model.means[k]);
+    for (size_t k = 0; k < K; ++k) {
+        for (size_t i = 0; i < n; ++i) out.putVector(model.covariances[k][i]);
+    }
+    return out.bytes();
+}
+
+GaussianHMM deserializeModel(const uint8_t* data, size_t size) {
+    ByteReader in(data, size);
+    size_t K = static_cast<size_t>(in.get<uint64_t>());
+    size_t n = static_cast<size_t>(in.get<uint64_t>());
+    GaussianHMM model;
+    model.periods_per_year = in.get<double>();
+    auto sized = [&in](size_t expected) {
+        std::vector<double> values = in.getVector<double>();
+        if (values.size() != expected) {
+            throw std::invalid_argument("Saved regime model has inconsistent dimensions");
+        }
+        return values;
+    };
+    model.initial_probabilities = sized(K);
+    for (size_t k = 0; k < K; ++k) model.transition.push_back(sized(K));
+    for (size_t k = 0; k < K; ++k) model.means.push_back(sized(n));
+    model.covariances.resize(K);
+    for (size_t k = 0; k < K; ++k) {
+        for (size_t i = 0; i < n; ++i) model.covariances[k].push_back(sized(n));
+    }
+    if (!in.exhausted()) {
+        throw std::invalid_argument("Saved regime model has trailing data");
+    }
+    return model;
+}
+
+} // namespace
+
+void SnapshotWriter::addSection(SnapshotSection type, const std::string& key, std::vector<uint8_t> header,
+                                std::shared_ptr<const void> body, size_t body_bytes) {
+    if (key.size() >= kKeyBytes) {
+        throw std::invalid_argument("Snapshot keys must be shorter than 32 characters");
+    }
+    for (const auto& section : sections) {
+        if (section.type == type && section.key == key) {
+            throw std::invalid_argument("Duplicate snapshot key: " + key);
+        }
+    }
+    sections.push_back({type, key, std::move(header), std::move(body), body_bytes});
+}
+
+void SnapshotWriter::addProcessCaches() {
+    size_t rows = 0;
+    std::shared_ptr<const uint32_t> directions = SobolSequence::sharedDirections(rows);
+    if (directions) {
+        addSection(SnapshotSection::SOBOL_DIRECTIONS, "sobol", {}, directions,
+                   rows * SobolSequence::kSobolBits * sizeof(uint32_t));
+    }
+    for (const CachedFactor& factor : cachedFactors()) {
+        ByteWriter header;
+        header.put(factor.fingerprint.high);
+        header.put(factor.fingerprint.low);
+        header.put<uint64_t>(factor.size);
+        header.put<uint64_t>(0);
+        char key[kKeyBytes];
+        std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(factor.fingerprint.high));
+        addSection(SnapshotSection::FACTORIZATION, key, header.bytes(), factor.lower,
+                   factor.size * factor.size * sizeof(double));
+    }
+}
+
+void SnapshotWriter::addModel(const std::string& key, const GaussianHMM& model) {
+    addSection(SnapshotSection::REGIME_MODEL, key, serializeModel(model));
+}
+
+void SnapshotWriter::addEstimator(const std::string& key, const RealizedCovarianceEstimator& estimator) {
+    addSection(SnapshotSection::ESTIMATOR, key, estimator.serialize());
+}
+
+SnapshotInfo SnapshotWriter::write(const std::string& path) const {
+    // Layout: header, directory, then each section on its own aligned offset
+    std::vector<size_t> offsets(sections.size());
+    size_t offset = alignUp(kAlignment * (1 + sections.size()));
+    for (size_t s = 0; s < sections.size(); ++s) {
+        offsets[s] = offset;
+        offset = alignUp(offset + sections[s].header.size() + sections[s].body_bytes);
+    }
+    size_t file_size = offset;
+
+    ByteWriter head;
+    for (char c : kMagic) head.put(c);
+    head.put(kSnapshotVersion);
+    head.put(kByteOrderMark);
+    head.put<uint64_t>(sections.size());
+    head.put<uint64_t>(kAlignment);
+    head.put<uint64_t>(file_size);
+    for (int i = 0; i < 3; ++i) head.put<uint64_t>(0); // Reserved
+    for (size_t s = 0; s < sections.size(); ++s) {
+        const Section& section = sections[s];
+        Checksum checksum;
+        checksum.update(section.header.data(), section.header.size());
+        checksum.update(static_cast<const uint8_t*>(section.body.get()), section.body_bytes);
+        head.put(static_cast<uint32_t>(section.type));
+        head.put<uint32_t>(0);
+        head.put<uint64_t>(offsets[s]);
+        head.put<uint64_t>(section.header.size() + section.body_bytes);
+        head.put(checksum.value());
+        putKey(head, section.key);
+    }
+
+    // Per-process name, so workers saving the same path concurrently do not interleave
+    std::string temporary = path + ".tmp." + std::to_string(runtimeStatus().pid);
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Cannot create snapshot file " + temporary);
+        }
+        const std::vector<uint8_t>& bytes = head.bytes();
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        std::vector<char> padding(kAlignment, 0);
+        size_t written = bytes.size();
+        for (size_t s = 0; s < sections.size(); ++s) {
+            file.write(padding.data(), offsets[s] - written);
+            file.write(reinterpret_cast<const char*>(sections[s].header.data()), sections[s].header.size());
+            if (sections[s].body_bytes > 0) {
+                file.write(static_cast<const char*>(sections[s].body.get()), sections[s].body_bytes);
+            }
+            written = offsets[s] + sections[s].header.size() + sections[s].body_bytes;
+        }
+        file.write(padding.data(), file_size - written);
+        if (!file) {
+            throw std::runtime_error("Failed writing snapshot file " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot move snapshot into place at " + path);
+    }
+    return Snapshot(path).info();
+}
+
+struct Snapshot::Mapping {
+    const uint8_t* data;
+    size_t size;
+#ifdef _WIN32
+    std::vector<uint8_t> buffer;
+#endif
+
+    explicit Mapping(const std::string& path) : data(nullptr), size(0) {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw std::runtime_error("Cannot open snapshot file " + path);
+        }
+        buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        data = buffer.data();
+        size = buffer.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open snapshot file " + path);
+        }
+        struct stat status;
+        if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(kAlignment)) {
+            ::close(fd);
+            throw std::invalid_argument("Snapshot file is too small: " + path);
+        }
+        size = static_cast<size_t>(status.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Cannot map snapshot file " + path);
+        }
+        data = static_cast<const uint8_t*>(mapped);
+#endif
+    }
+
+    ~Mapping() {
+#ifndef _WIN32
+        if (data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+    }
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+};
+
+Snapshot::Snapshot(const std::string& path) : mapping(std::make_shared<const Mapping>(path)) {
+    const uint8_t* base = mapping->data;
+    size_t size = mapping->size;
+    if (size < kAlignment || std::memcmp(base, kMagic, sizeof(kMagic)) != 0) {
+        throw std::invalid_argument("Not a risk engine snapshot: " + path);
+    }
+    ByteReader head(base + sizeof(kMagic), size - sizeof(kMagic));
+    version = head.get<uint32_t>();
+    if (version != kSnapshotVersion) {
+        throw std::invalid_argument("Unsupported snapshot version " + std::to_string(version));
+    }
+    if (head.get<uint32_t>() != kByteOrderMark) {
+        throw std::invalid_argument("Snapshot was written on a machine with a different byte order");
+    }
+    uint64_t count = head.get<uint64_t>();
+    uint64_t entry_bytes = head.get<uint64_t>();
+    uint64_t file_size = head.get<uint64_t>();
+    if (entry_bytes != kAlignment || file_size != size || count > size / kAlignment) {
+        throw std::invalid_argument("Snapshot header does not match the file");
+    }
+
+    ByteReader directory(base + kAlignment, static_cast<size_t>(count) * kAlignment);
+    for (uint64_t s = 0; s < count; ++s) {
+        Entry entry;
+        uint32_t type = directory.get<uint32_t>();
+        directory.get<uint32_t>();
+        uint64_t offset = directory.get<uint64_t>();
+        uint64_t length = directory.get<uint64_t>();
+        uint64_t expected = directory.get<uint64_t>();
+        char key[kKeyBytes];
+        for (char& c : key) c = directory.get<char>();
+        if (type < 1 || type > static_cast<uint32_t>(SnapshotSection::ESTIMATOR) || offset % kAlignment != 0 ||
+            offset > size || length > size - offset || key[kKeyBytes - 1] != '\0') {
+            throw std::invalid_argument("Corrupt snapshot directory");
+        }
+        entry.type = static_cast<SnapshotSection>(type);
+        entry.key = key;
+        entry.data = base + offset;
+        entry.length = static_cast<size_t>(length);
+        Checksum checksum;
+        checksum.update(entry.data, entry.length);
+        if (checksum.value() != expected) {
+            throw std::invalid_argument("Snapshot section '" + entry.key + "' failed its checksum");
+        }
+        if (entry.type == SnapshotSection::SOBOL_DIRECTIONS &&
+            entry.length % (SobolSequence::kSobolBits * sizeof(uint32_t)) != 0) {
+            throw std::invalid_argument("Corrupt Sobol direction section");
+        }
+        if (entry.type == SnapshotSection::FACTORIZATION) {
+            ByteReader header(entry.data, std::min(entry.length, kFactorHeaderBytes));
+            header.get<uint64_t>();
+            header.get<uint64_t>();
+            uint64_t n = header.get<uint64_t>();
+            if (n == 0 || entry.length != kFactorHeaderBytes + n * n * sizeof(double)) {
+                throw std::invalid_argument("Corrupt factorization section");
+            }
+        }
+        entries.push_back(entry);
+    }
+}
+
+SnapshotInfo Snapshot::info() const {
+    SnapshotInfo info;
+    info.version = version;
+    info.bytes = mapping->size;
+    info.sobol_dimensions = 0;
+    info.factorizations = 0;
+    for (const Entry& entry : entries) {
+        switch (entry.type) {
+        case SnapshotSection::SOBOL_DIRECTIONS:
+            info.sobol_dimensions = entry.length / (SobolSequence::kSobolBits * sizeof(uint32_t));
+            break;
+        case SnapshotSection::FACTORIZATION:
+            ++info.factorizations;
+            break;
+        case SnapshotSection::REGIME_MODEL:
+            info.models.push_back(entry.key);
+            break;
+        case SnapshotSection::ESTIMATOR:
+            info.estimators.push_back(entry.key);
+            break;
+        }
+    }
+    return info;
+}
+
+void Snapshot::installProcessCaches() const {
+    for (const Entry& entry : entries) {
+        if (entry.type == SnapshotSection::SOBOL_DIRECTIONS) {
+            size_t rows = entry.length / (SobolSequence::kSobolBits * sizeof(uint32_t));
+            SobolSequence::installDirections(
+                std::shared_ptr<const uint32_t>(mapping, reinterpret_cast<const uint32_t*>(entry.data)), rows);
+        } else if (entry.type == SnapshotSection::FACTORIZATION) {
+            ByteReader header(entry.data, kFactorHeaderBytes);
+            CachedFactor factor;
+            factor.fingerprint.high = header.get<uint64_t>();
+            factor.fingerprint.low = header.get<uint64_t>();
+            factor.size = static_cast<size_t>(header.get<uint64_t>());
+            factor.lower = std::shared_ptr<const double>(
+                mapping, reinterpret_cast<const double*>(entry.data + kFactorHeaderBytes));
+            storeFactor(factor);
+        }
+    }
+}
+
+const Snapshot::Entry& Snapshot::find(SnapshotSection type, const std::string& key) const {
+    for (const Entry& entry : entries) {
+        if (entry.type == type && entry.key == key) return entry;
+    }
+    throw std::invalid_argument("Snapshot has no entry named '" + key + "'");
+}
+
+GaussianHMM Snapshot::model(const std::string& key) const {
+    const Entry& entry = find(SnapshotSection::REGIME_MODEL, key);
+    return deserializeModel(entry.data, entry.length);
+}
+
+std::unique_ptr<RealizedCovarianceEstimator> Snapshot::estimator(const std::string& key) const {
+    const Entry& entry = find(SnapshotSection::ESTIMATOR, key);
+    return RealizedCovarianceEstimator::deserialize(entry.data, entry.length);
+}
@@ -0,0 +1,85 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "regime.h"
+#include "realized_covariance.h"
+
+// Versioned snapshot of warm engine state for fast cold starts: the shared Sobol direction table,
+// cached correlation factorizations, fitted regime models and realized covariance estimators.
+// Sections are 64-byte aligned and checksummed; a new process maps the file read-only and the
+// direction table and factors are used in place, without copying or recomputing them.
+
+enum class SnapshotSection : uint32_t {
+    SOBOL_DIRECTIONS = 1, // rows x 32 direction numbers
+    FACTORIZATION = 2,    // Fingerprint, n and the n x n row-major Cholesky factor
+    REGIME_MODEL = 3,     // GaussianHMM, stored under a caller-chosen key
+    ESTIMATOR = 4         // RealizedCovarianceEstimator state, stored under a caller-chosen key
+};
+
+struct SnapshotInfo {
+    uint32_t version;
+    size_t bytes;
+    size_t sobol_dimensions;             // 0 when the snapshot holds no direction table
+    size_t factorizations;
+    std::vector<std::string> models;     // Keys of the regime models
+    std::vector<std::string> estimators; // Keys of the realized covariance estimators
+};
+
+class SnapshotWriter {
+private:
+    struct Section {
+        SnapshotSection type;
+        std::string key;
+        std::vector<uint8_t> header;       // Written first
+        std::shared_ptr<const void> body;  // Written after the header, without copying
+        size_t body_bytes;
+    };
+    std::vector<Section> sections;
+
+    void addSection(SnapshotSection type, const std::string& key, std::vector<uint8_t> header,
+                    std::shared_ptr<const void> body = nullptr, size_t body_bytes = 0);
+
+public:
+    // The current Sobol direction table (if built) and every cached factorization
+    void addProcessCaches();
+    void addModel(const std::string& key, const GaussianHMM& model);
+    void addEstimator(const std::string& key, const RealizedCovarianceEstimator& estimator);
+
+    // Written to a temporary file and renamed, so readers never see a partial snapshot
+    SnapshotInfo write(const std::string& path) const;
+};
+
+class Snapshot {
+private:
+    struct Mapping;
+    struct Entry {
+        SnapshotSection type;
+        std::string key;
+        const uint8_t* data;
+        size_t length;
+    };
+    std::shared_ptr<const Mapping> mapping; // Kept alive by every installed cache entry
+    std::vector<Entry> entries;
+    uint32_t version;
+
+    const Entry& find(SnapshotSection type, const std::string& key) const;
+
+public:
+    // Maps the file read-only and checks the header, layout and section checksums
+    explicit Snapshot(const std::string& path);
+
+    SnapshotInfo info() const;
+
+    // Point the process-wide Sobol table and factorization cache at the mapped sections
+    void installProcessCaches() const;
+
+    GaussianHMM model(const std::string& key) const;
+    std::unique_ptr<RealizedCovarianceEstimator> estimator(const std::string& key) const;
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,236 @@
+#include "sobol.h"
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+// Joe and Kuo (2008) initial direction numbers m_1..m_s for dimensions 2..21
+const uint32_t kInitialDirections[][7] = {
+    {1},
+    {1, 3},
+    {1, 3, 1},
+    {1, 1, 1},
+    {1, 1, 3, 3},
+    {1, 3, 5, 13},
+    {1, 1, 5, 5, 17},
+    {1, 1, 5, 5, 5},
+    {1, 1, 7, 11, 19},
+    {1, 1, 5, 1, 1},
+    {1, 1, 1, 3, 11},
+    {1, 3, 5, 5, 31},
+    {1, 3, 3, 9, 7, 49},
+    {1, 1, 1, 15, 21, 21},
+    {1, 3, 1, 13, 27, 49},
+    {1, 1, 1, 15, 7, 5},
+    {1, 3, 1, 15, 13, 25},
+    {1, 1, 5, 5, 19, 61},
+    {1, 3, 7, 11, 23, 15, 103},
+    {1, 3, 7, 13, 13, 15, 69},
+};
+const size_t kTabulatedDimensions = sizeof(kInitialDirections) / sizeof(kInitialDirections[0]) + 1;
+
+// Carry-less product of two polynomials over GF(2), reduced modulo `modulus` of degree `degree`
+uint64_t mulMod(uint64_t a, uint64_t b, uint64_t modulus, unsigned degree) {
+    uint64_t product = 0;
+    while (b) {
+        if (b & 1) product ^= a;
+        b >>= 1;
+        a <<= 1;
+        if (a >> degree) a ^= modulus;
+    }
+    return product;
+}
+
+uint64_t powMod(uint64_t base, uint64_t exponent, uint64_t modulus, unsigned degree) {
+    uint64_t result = 1;
+    while (exponent) {
+        if (exponent & 1) result = mulMod(result, base, modulus, degree);
+        base = mulMod(base, base, modulus, degree);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+// A degree-s polynomial is primitive when x has multiplicative order exactly 2^s - 1
+bool isPrimitive(uint64_t polynomial, unsigned degree) {
+    uint64_t order = (uint64_t(1) << degree) - 1;
+    uint64_t x = degree == 1 ? 1 : 2; // x mod (x + 1) = 1
+    if (powMod(x, order, polynomial, degree) != 1) return false;
+    uint64_t rest = order;
+    for (uint64_t q = 2; q * q <= rest; ++q) {
+        if (rest % q != 0) continue;
+        if (powMod(x, order / q, polynomial, degree) == 1) return false;
+        while (rest % q == 0) rest /= q;
+    }
+    if (rest > 1 && rest != order && powMod(x, order / rest, polynomial, degree) == 1) return false;
+    return true;
+}
+
+uint64_t splitMix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+const size_t kBits = SobolSequence::kSobolBits;
+
+// Rows are generated in a fixed order, so a table for d dimensions is a prefix of any larger one
+std::vector<uint32_t> buildDirections(size_t dims) {
+    std::vector<uint32_t> directions(dims * kBits, 0);
+
+    // First dimension: van der Corput sequence
+    for (size_t k = 0; k < kBits; ++k) {
+        directions[k] = uint32_t(1) << (kBits - 1 - k);
+    }
+
+    size_t dim = 1;
+    for (unsigned degree = 1; dim < dims; ++degree) {
+        for (uint64_t a = 0; a < (uint64_t(1) << (degree - 1)) && dim < dims; ++a) {
+            uint64_t polynomial = (uint64_t(1) << degree) | (a << 1) | 1;
+            if (!isPrimitive(polynomial, degree)) continue;
+
+            uint32_t* v = &directions[dim * kBits];
+            for (unsigned k = 0; k < degree && k < kBits; ++k) {
+                uint32_t m;
+                if (dim < kTabulatedDimensions) {
+                    m = kInitialDirections[dim - 1][k];
+                } else {
+                    m = static_cast<uint32_t>(splitMix(dim * 64 + k) & ((uint64_t(1) << (k + 1)) - 1)) | 1;
+                }
+                v[k] = m << (kBits - 1 - k);
+            }
+            for (size_t k = degree; k < kBits; ++k) {
+                uint32_t value = v[k - degree] ^ (v[k - degree] >> degree);
+                for (unsigned j = 1; j < degree; ++j) {
+                    if ((a >> (degree - 1 - j)) & 1) value ^= v[k - j];
+                }
+                v[k] = value;
+            }
+            ++dim;
+        }
+    }
+    return directions;
+}
+
+std::shared_ptr<const uint32_t> shared_directions;
+size_t shared_rows = 0;
+
+// Table with at least `dims` rows, grown (never shrunk) on demand
+std::shared_ptr<const uint32_t> directionTable(size_t dims) {
+    std::lock_guard<std::mutex> lock(SobolSequence::directionMutex());
+    if (!shared_directions || shared_rows < dims) {
+        auto table = std::make_shared<const std::vector<uint32_t>>(buildDirections(dims));
+        shared_directions = std::shared_ptr<const uint32_t>(table, table->data());
+        shared_rows = dims;
+    }
+    return shared_directions;
+}
+
+} // namespace
+
+const size_t SobolSequence::kSobolBits;
+const size_t SobolSequence::kMaxDimensions;
+
+SobolSequence::SobolSequence(size_t dimensions, uint64_t seed)
+    : dims(dimensions), index(0), offset(seed == 0 ? 1 : 0) {
+
+    if (dims == 0 || dims > kMaxDimensions) {
+        throw std::invalid_argument("Sobol dimension must be between 1 and 21201");
+    }
+
+    table = directionTable(dims);
+    directions = table.get();
+    state.assign(dims, 0);
+    shift.assign(dims, 0);
+
+    if (seed != 0) {
+        std::mt19937_64 gen(seed);
+        for (auto& s : shift) {
+            s = static_cast<uint32_t>(gen() >> 32);
+        }
+    }
+    skipTo(0);
+}
+
+void SobolSequence::precomputeDirections(size_t dimensions) {
+    if (dimensions > kMaxDimensions) {
+        throw std::invalid_argument("Sobol dimension must be between 1 and 21201");
+    }
+    if (dimensions > 0) directionTable(dimensions);
+}
+
+size_t SobolSequence::precomputedDimensions() {
+    std::lock_guard<std::mutex> lock(directionMutex());
+    return shared_directions ? shared_rows : 0;
+}
+
+void SobolSequence::releaseDirections() {
+    // Live sequences keep their own reference to the table
+    std::lock_guard<std::mutex> lock(directionMutex());
+    shared_directions.reset();
+    shared_rows = 0;
+}
+
+std::shared_ptr<const uint32_t> SobolSequence::sharedDirections(size_t& rows) {
+    std::lock_guard<std::mutex> lock(directionMutex());
+    rows = shared_directions ? shared_rows : 0;
+    return shared_directions;
+}
+
+void SobolSequence::installDirections(std::shared_ptr<const uint32_t> directions, size_t rows) {
+    if (!directions || rows == 0 || rows > kMaxDimensions) {
+        throw std::invalid_argument("Sobol direction table must have between 1 and 21201 rows");
+    }
+    // Cheap guard against a table from a different construction
+    std::vector<uint32_t> leading = buildDirections(std::min<size_t>(rows, 64));
+    if (!std::equal(leading.begin(), leading.end(), directions.get())) {
+        throw std::invalid_argument("Sobol direction table does not match this build");
+    }
+    std::lock_guard<std::mutex> lock(directionMutex());
+    if (shared_directions && shared_rows >= rows) return;
+    shared_directions = std::move(directions);
+    shared_rows = rows;
+}
+
+std::mutex& SobolSequence::directionMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+void SobolSequence::skipTo(uint64_t point) {
+    index = point + offset;
+    if (index >= (uint64_t(1) << kSobolBits) - 1) {
+        throw std::invalid_argument("Sobol sequence exhausted (2^32 - 1 points)");
+    }
+    uint64_t gray = index ^ (index >> 1);
+    for (size_t d = 0; d < dims; ++d) {
+        const uint32_t* v = &directions[d * kSobolBits];
+        uint32_t x = 0;
+        for (size_t k = 0; k < kSobolBits; ++k) {
+            if ((gray >> k) & 1) x ^= v[k];
+        }
+        state[d] = x;
+    }
+}
+
+void SobolSequence::next(double* point) {
+    const double kScale = 1.0 / 4294967296.0;
+    for (size_t d = 0; d < dims; ++d) {
+        point[d] = (static_cast<double>(state[d] ^ shift[d]) + 0.5) * kScale;
+    }
+
+    // Gray-code update: flip the direction number of the lowest zero bit of the index
+    uint64_t bits = index + 1;
+    if (bits >= (uint64_t(1) << kSobolBits)) {
+        throw std::invalid_argument("Sobol sequence exhausted (2^32 - 1 points)");
+    }
+    size_t c = 0;
+    while (!((bits >> c) & 1)) ++c;
+    const uint32_t* v = &directions[c];
+    for (size_t d = 0; d < dims; ++d) {
+        state[d] ^= v[d * kSobolBits];
+    }
+    ++index;
+}
@@ -0,0 +1,55 @@
+#ifndef SOBOL_H
+#define SOBOL_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// Gray-code Sobol low-discrepancy sequence in base 2 with 32-bit resolution.
+// Primitive polynomials are enumerated in the Joe and Kuo (2008) order; initial direction
+// numbers follow their table for the first 21 dimensions and are odd pseudo-random values
+// beyond that. A non-zero seed applies a random digital shift, giving an unbiased randomized
+// QMC estimator whose error can be measured across seeds.
+// Direction numbers are computed once per process and shared read-only by every sequence.
+class SobolSequence {
+private:
+    size_t dims;
+    std::shared_ptr<const uint32_t> table; // Process-wide direction numbers, >= dims rows
+    const uint32_t* directions;       // dims x kSobolBits direction numbers within the table
+    std::vector<uint32_t> shift;      // Digital shift per dimension (zero when unscrambled)
+    std::vector<uint32_t> state;      // Current point as integers
+    uint64_t index;                   // Sequence index of the current point
+    uint64_t offset;                  // 1 when unscrambled: the all-zero point is skipped
+
+public:
+    static const size_t kSobolBits = 32;
+    static const size_t kMaxDimensions = 21201;
+
+    explicit SobolSequence(size_t dimensions, uint64_t seed = 0);
+
+    // Fill the shared direction table up front (e.g. before forking workers, so they all map
+    // the parent's copy-on-write pages instead of each building their own)
+    static void precomputeDirections(size_t dimensions = kMaxDimensions);
+    static size_t precomputedDimensions();
+    static void releaseDirections();
+
+    // Snapshot access: the current table and its row count, or a table to use from now on
+    // (rows must follow the same construction, e.g. a table saved by another process)
+    static std::shared_ptr<const uint32_t> sharedDirections(size_t& rows);
+    static void installDirections(std::shared_ptr<const uint32_t> directions, size_t rows);
+
+    // Guards the shared table; held across fork() so a child never inherits it locked
+    static std::mutex& directionMutex();
+
+    size_t dimensions() const { return dims; }
+
+    // Position the sequence so that the next call to next() returns point `point`
+    void skipTo(uint64_t point);
+
+    // Fill `point` with dimensions() coordinates in (0, 1)
+    void next(double* point);
+};
+
+#endif // SOBOL_H
@@ -0,0 +1,408 @@
+#include "streaming.h"
+#include "linalg.h"
+#include "vecmath.h"
+#include "lifecycle.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <omp.h>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+// Portfolios re-derive x' Sigma x from scratch after this many incremental updates
+const uint64_t kRenormalizeInterval = 1024;
+
+// Upper bound on ticks coalesced into one consumer pass
+const size_t kDrainBatch = 1 << 16;
+
+} // namespace
+
+StreamingRiskService::StreamingRiskService(const std::vector<double>& mu,
+                                           const std::vector<double>& volatilities,
+                                           const std::vector<std::vector<double>>& correlation,
+                                           const std::vector<double>& initial_prices,
+                                           const StreamingRiskConfig& cfg)
+    : n(mu.size()), expected_returns(mu), prices(initial_prices), config(cfg),
+      ticks(cfg.queue_capacity), running(false), next_refresh(0),
+      ticks_received(0), ticks_dropped(0), ticks_processed(0), batches(0), mc_refreshes(0) {
+
+    if (n == 0) {
+        throw std::invalid_argument("Asset universe cannot be empty");
+    }
+    if (volatilities.size() != n || initial_prices.size() != n || correlation.size() != n) {
+        throw std::invalid_argument("Expected returns, volatilities, prices and correlation must have matching sizes");
+    }
+    if (config.confidence <= 0.5 || config.confidence >= 1.0) {
+        throw std::invalid_argument("Confidence level must be between 0.5 and 1");
+    }
+    if (config.horizon <= 0.0 || config.mc_simulations <= 0 || config.mc_refresh_seconds <= 0.0) {
+        throw std::invalid_argument("Horizon, simulation count and refresh interval must be positive");
+    }
+    for (double price : initial_prices) {
+        if (price <= 0.0) {
+            throw std::invalid_argument("Initial prices must be positive");
+        }
+    }
+
+    covariance.assign(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        if (correlation[i].size() != n) {
+            throw std::invalid_argument("Correlation matrix must be square");
+        }
+        for (size_t j = 0; j < n; ++j) {
+            covariance[i * n + j] = volatilities[i] * volatilities[j] * correlation[i][j];
+        }
+    }
+    cholesky = covariance;
+    if (!choleskyFactor(cholesky, n)) {
+        throw std::invalid_argument("Covariance matrix must be positive definite");
+    }
+    z_score = vecmath::normInv(config.confidence);
+}
+
+StreamingRiskService::~StreamingRiskService() {
+    stop();
+}
+
+void StreamingRiskService::initializePortfolio(PortfolioState& state,
+                                               const std::vector<double>& quantities) const {
+    if (quantities.size() != n) {
+        throw std::invalid_argument("Quantities must match the asset universe");
+    }
+    std::vector<double> exposure(n);
+    state.quantities = quantities;
+    state.value = 0.0;
+    state.expected_pnl = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        exposure[i] = quantities[i] * prices[i];
+        state.value += exposure[i];
+        state.expected_pnl += expected_returns[i] * exposure[i];
+    }
+    state.sigma_exposure.assign(n, 0.0);
+    matrixVectorProduct(covariance, n, exposure, state.sigma_exposure);
+    state.variance = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        state.variance += exposure[i] * state.sigma_exposure[i];
+    }
+}
+
+double StreamingRiskService::deltaNormalVaR(const PortfolioState& state) const {
+    double variance = std::max(state.variance, 0.0);
+    return z_score * std::sqrt(variance * config.horizon) - state.expected_pnl * config.horizon;
+}
+
+size_t StreamingRiskService::addPortfolio(const std::vector<double>& quantities) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    PortfolioState state;
+    initializePortfolio(state, quantities);
+    state.monte_carlo_var = 0.0;
+    state.monte_carlo_valid = false;
+    state.updates = 0;
+    state.generation = 0;
+    portfolios.push_back(std::move(state));
+    return portfolios.size() - 1;
+}
+
+void StreamingRiskService::setPositions(size_t portfolio, const std::vector<double>& quantities) {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (portfolio >= portfolios.size()) {
+            throw std::invalid_argument("Unknown portfolio id");
+        }
+        initializePortfolio(portfolios[portfolio], quantities);
+        portfolios[portfolio].monte_carlo_valid = false;
+        ++portfolios[portfolio].generation;
+        repositioned.push_back(portfolio);
+    }
+}
+
+bool StreamingRiskService::pushTick(uint32_t asset, double price, uint64_t timestamp) {
+    if (asset >= n || !(price > 0.0) || !ticks.push(PriceTick{asset, price, timestamp})) {
+        ticks_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ticks_received.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t StreamingRiskService::pushTicks(const std::vector<PriceTick>& batch) {
+    size_t accepted = 0;
+    for (const auto& tick : batch) {
+        if (pushTick(tick.asset, tick.price, tick.timestamp)) ++accepted;
+    }
+    return accepted;
+}
+
+size_t StreamingRiskService::subscribe(size_t portfolio, double threshold, AlertCallback callback) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (portfolio >= portfolios.size()) {
+        throw std::invalid_argument("Unknown portfolio id");
+    }
+    bool breached = deltaNormalVaR(portfolios[portfolio]) > threshold;
+    subscriptions.push_back(Subscription{portfolio, threshold, std::move(callback), breached});
+    return subscriptions.size() - 1;
+}
+
+size_t StreamingRiskService::drain(size_t max_ticks) {
+    // Coalesce the pending ticks: only the latest price per asset matters for the update
+    std::vector<double> latest(n, 0.0);
+    std::vector<char> seen(n, 0);
+    std::vector<uint32_t> seen_assets;
+    PriceTick tick;
+    size_t drained = 0;
+    while (drained < max_ticks && ticks.pop(tick)) {
+        if (!seen[tick.asset]) {
+            seen[tick.asset] = 1;
+            seen_assets.push_back(tick.asset);
+        }
+        latest[tick.asset] = tick.price;
+        ++drained;
+    }
+    if (drained == 0) {
+        // No prices moved, but positions may have been replaced since the last pass
+        std::vector<size_t> touched;
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            touched.swap(repositioned);
+        }
+        notify(touched);
+        return 0;
+    }
+    ticks_processed.fetch_add(drained, std::memory_order_relaxed);
+    batches.fetch_add(1, std::memory_order_relaxed);
+
+    std::vector<size_t> touched;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        touched.swap(repositioned);
+        std::vector<uint32_t> changed;
+        std::vector<double> price_moves;
+        for (uint32_t asset : seen_assets) {
+            double move = latest[asset] - prices[asset];
+            if (move != 0.0) {
+                changed.push_back(asset);
+                price_moves.push_back(move);
+                prices[asset] = latest[asset];
+            }
+        }
+
+        std::vector<char> is_touched(portfolios.size(), 0);
+        long num_portfolios = static_cast<long>(portfolios.size());
+        // Each changed asset costs O(n) per holding portfolio: Sigma x moves along one covariance row
+        #pragma omp parallel for schedule(dynamic, 64) if (portfolios.size() * changed.size() > 4096) num_threads(parallelThreads())
+        for (long p = 0; p < num_portfolios; ++p) {
+            PortfolioState& state = portfolios[p];
+            double* sigma_x = state.sigma_exposure.data();
+            uint64_t previous_updates = state.updates;
+            for (size_t c = 0; c < changed.size(); ++c) {
+                size_t asset = changed[c];
+                double quantity = state.quantities[asset];
+                if (quantity == 0.0) continue;
+                double delta = quantity * price_moves[c];
+                const double* row = &covariance[asset * n];
+                state.variance += delta * (2.0 * sigma_x[asset] + delta * row[asset]);
+                #pragma omp simd
+                for (size_t j = 0; j < n; ++j) {
+                    sigma_x[j] += delta * row[j];
+                }
+                state.value += delta;
+                state.expected_pnl += expected_returns[asset] * delta;
+                ++state.updates;
+                is_touched[p] = 1;
+            }
+            if (state.updates / kRenormalizeInterval != previous_updates / kRenormalizeInterval) {
+                // Bound the rounding drift of the running Sigma x and variance
+                std::vector<double> quantities = std::move(state.quantities);
+                initializePortfolio(state, quantities);
+            }
+        }
+        for (size_t p = 0; p < portfolios.size(); ++p) {
+            if (is_touched[p]) touched.push_back(p);
+        }
+    }
+    notify(touched);
+    return drained;
+}
+
+void StreamingRiskService::notify(const std::vector<size_t>& touched) {
+    if (touched.empty()) return;
+    std::vector<std::pair<AlertCallback, RiskAlert>> alerts;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (subscriptions.empty()) return;
+        std::vector<char> is_touched(portfolios.size(), 0);
+        for (size_t p : touched) is_touched[p] = 1;
+        for (auto& subscription : subscriptions) {
+            if (!is_touched[subscription.portfolio]) continue;
+            double var = deltaNormalVaR(portfolios[subscription.portfolio]);
+            bool breached = var > subscription.threshold;
+            if (breached != subscription.breached) {
+                subscription.breached = breached;
+                alerts.emplace_back(subscription.callback,
+                                    RiskAlert{subscription.portfolio, var, subscription.threshold, breached});
+            }
+        }
+    }
+    // Callbacks run without the state lock so they may query the service
+    for (const auto& alert : alerts) {
+        try {
+            alert.first(alert.second);
+        } catch (const std::exception&) {
+            // A failing subscriber must not take down the consumer thread
+        }
+    }
+}
+
+size_t StreamingRiskService::refreshMonteCarlo(size_t max_portfolios) {
+    std::vector<size_t> ids;
+    std::vector<uint64_t> generations;
+    std::vector<double> exposures;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        size_t count = std::min(max_portfolios, portfolios.size());
+        for (size_t k = 0; k < count; ++k) {
+            size_t p = (next_refresh + k) % portfolios.size();
+            ids.push_back(p);
+            generations.push_back(portfolios[p].generation);
+            for (size_t i = 0; i < n; ++i) {
+                exposures.push_back(portfolios[p].quantities[i] * prices[i]);
+            }
+        }
+        if (!portfolios.empty()) {
+            next_refresh = (next_refresh + count) % portfolios.size();
+        }
+    }
+    if (ids.empty()) return 0;
+
+    // One shared scenario set per refresh, generated as in MonteCarloRiskEngine
+    size_t simulations = static_cast<size_t>(config.mc_simulations);
+    std::vector<double> scenarios(simulations * n);
+    double sqrt_horizon = std::sqrt(config.horizon);
+    #pragma omp parallel num_threads(parallelThreads())
+    {
+        std::mt19937 gen(std::random_device{}() + omp_get_thread_num());
+        std::normal_distribution<double> normal_dist(0.0, 1.0);
+        std::vector<double> z(n);
+        #pragma omp for schedule(static)
+        for (long s = 0; s < static_cast<long>(simulations); ++s) {
+            for (size_t i = 0; i < n; ++i) z[i] = normal_dist(gen);
+            double* row = &scenarios[s * n];
+            for (size_t i = 0; i < n; ++i) {
+                const double* l = &cholesky[i * n];
+                double shock = 0.0;
+                for (size_t j = 0; j <= i; ++j) shock += l[j] * z[j];
+                row[i] = expected_returns[i] * config.horizon + sqrt_horizon * shock;
+            }
+        }
+    }
+
+    std::vector<double> vars(ids.size());
+    size_t index = std::min(static_cast<size_t>((1.0 - config.confidence) * simulations), simulations - 1);
+    #pragma omp parallel num_threads(parallelThreads())
+    {
+        std::vector<double> pnl(simulations);
+        #pragma omp for schedule(dynamic)
+        for (long k = 0; k < static_cast<long>(ids.size()); ++k) {
+            const double* x = &exposures[k * n];
+            for (size_t s = 0; s < simulations; ++s) {
+                const double* r = &scenarios[s * n];
+                double total = 0.0;
+                #pragma omp simd reduction(+:total)
+                for (size_t i = 0; i < n; ++i) total += x[i] * r[i];
+                pnl[s] = total;
+            }
+            std::nth_element(pnl.begin(), pnl.begin() + index, pnl.end());
+            vars[k] = -pnl[index];
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        for (size_t k = 0; k < ids.size(); ++k) {
+            // Positions replaced while the scenarios ran leave the VaR invalid until the next pass
+            if (ids[k] < portfolios.size() && portfolios[ids[k]].generation == generations[k]) {
+                portfolios[ids[k]].monte_carlo_var = vars[k];
+                portfolios[ids[k]].monte_carlo_valid = true;
+            }
+        }
+    }
+    mc_refreshes.fetch_add(ids.size(), std::memory_order_relaxed);
+    return ids.size();
+}
+
+void StreamingRiskService::consumerLoop() {
+    while (running.load(std::memory_order_acquire)) {
+        if (drain(kDrainBatch) == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+void StreamingRiskService::monteCarloLoop() {
+    auto interval = std::chrono::duration<double>(config.mc_refresh_seconds);
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake.wait_for(lock, interval, [this] { return !running.load(); });
+        }
+        if (!running.load()) break;
+        refreshMonteCarlo(config.mc_portfolios_per_refresh);
+    }
+}
+
+void StreamingRiskService::start() {
+    if (running.exchange(true)) return;
+    consumer_thread = std::thread(&StreamingRiskService::consumerLoop, this);
+    monte_carlo_thread = std::thread(&StreamingRiskService::monteCarloLoop, this);
+}
+
+void StreamingRiskService::stop() {
+    if (!running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+    }
+    wake.notify_all();
+    consumer_thread.join();
+    monte_carlo_thread.join();
+    // Apply whatever was queued before the stop
+    while (drain(kDrainBatch) > 0) {}
+}
+
+size_t StreamingRiskService::processPending() {
+    if (running.load()) {
+        throw std::runtime_error("Ticks are consumed by the service thread while it is running");
+    }
+    size_t total = 0;
+    size_t drained;
+    while ((drained = drain(kDrainBatch)) > 0) total += drained;
+    return total;
+}
+
+PortfolioRiskSnapshot StreamingRiskService::getRisk(size_t portfolio) const {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (portfolio >= portfolios.size()) {
+        throw std::invalid_argument("Unknown portfolio id");
+    }
+    const PortfolioState& state = portfolios[portfolio];
+    return PortfolioRiskSnapshot{state.value, deltaNormalVaR(state), state.monte_carlo_var,
+                                 state.monte_carlo_valid, state.updates};
+}
+
+std::vector<PortfolioRiskSnapshot> StreamingRiskService::getAllRisk() const {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    std::vector<PortfolioRiskSnapshot> snapshots;
+    snapshots.reserve(portfolios.size());
+    for (const auto& state : portfolios) {
+        snapshots.push_back(PortfolioRiskSnapshot{state.value, deltaNormalVaR(state), state.monte_carlo_var,
+                                                  state.monte_carlo_valid, state.updates});
+    }
+    return snapshots;
+}
+
+StreamingRiskStats StreamingRiskService::getStats() const {
+    return StreamingRiskStats{ticks_received.load(), ticks_dropped.load(), ticks_processed.load(),
+                              batches.load(), mc_refreshes.load()};
+}
@@ -0,0 +1,212 @@
+#ifndef STREAMING_H
+#define STREAMING_H
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+struct PriceTick {
+    uint32_t asset;     // Index into the service's asset universe
+    double price;       // Latest traded price
+    uint64_t timestamp; // Producer timestamp (informational)
+};
+
+// Bounded multi-producer single-consumer queue (Vyukov). Producers claim a slot with one CAS;
+// the consumer never blocks them. push() fails instead of waiting when the buffer is full.
+template <typename T>
+class MpscRingBuffer {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueue_pos;
+    alignas(64) size_t dequeue_pos;
+
+public:
+    explicit MpscRingBuffer(size_t capacity) : enqueue_pos(0), dequeue_pos(0) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t k = 0; k < size; ++k) {
+            cells[k].sequence.store(k, std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    bool push(const T& value) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Single consumer only
+    bool pop(T& value) {
+        Cell& cell = cells[dequeue_pos & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeue_pos + 1) {
+            return false;
+        }
+        value = cell.value;
+        cell.sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+        ++dequeue_pos;
+        return true;
+    }
+};
+
+struct StreamingRiskConfig {
+    double confidence;               // VaR confidence level
+    double horizon;                  // Risk horizon in years
+    size_t queue_capacity;           // Tick buffer size (rounded up to a power of two)
+    int mc_simulations;              // Scenarios per background Monte Carlo refresh
+    double mc_refresh_seconds;       // Interval between background refreshes
+    size_t mc_portfolios_per_refresh; // Portfolios revalued per refresh, round robin
+
+    StreamingRiskConfig()
+        : confidence(0.99), horizon(1.0 / 252.0), queue_capacity(1 << 20), mc_simulations(10000),
+          mc_refresh_seconds(1.0), mc_portfolios_per_refresh(256) {}
+};
+
+struct PortfolioRiskSnapshot {
+    double value;            // Current market value
+    double delta_normal_var; // Incrementally maintained delta-normal VaR (currency)
+    double monte_carlo_var;  // VaR from the last background refresh (currency)
+    bool monte_carlo_valid;  // False until the portfolio has been refreshed once
+    uint64_t updates;        // Price changes applied to this portfolio
+};
+
+struct RiskAlert {
+    size_t portfolio;  // Portfolio id
+    double var;        // Delta-normal VaR that crossed the threshold
+    double threshold;  // Subscription threshold
+    bool breached;     // True when rising above the threshold, false when falling back below
+};
+
+struct StreamingRiskStats {
+    uint64_t ticks_received;  // Ticks accepted into the buffer
+    uint64_t ticks_dropped;   // Ticks rejected because the buffer was full or the asset is unknown
+    uint64_t ticks_processed; // Ticks drained by the consumer
+    uint64_t batches;         // Consumer drain passes that applied at least one tick
+    uint64_t mc_refreshes;    // Portfolio Monte Carlo revaluations
+};
+
+class StreamingRiskService {
+public:
+    using AlertCallback = std::function<void(const RiskAlert&)>;
+
+private:
+    struct PortfolioState {
+        std::vector<double> quantities;     // Units held per asset
+        std::vector<double> sigma_exposure; // Sigma x for the exposure x = quantities * prices
+        double value;
+        double expected_pnl;                // mu' x, annual
+        double variance;                    // x' Sigma x, annual
+        double monte_carlo_var;
+        bool monte_carlo_valid;
+        uint64_t updates;
+        uint64_t generation;                // Bumped by setPositions; stale refreshes are discarded
+    };
+    struct Subscription {
+        size_t portfolio;
+        double threshold;
+        AlertCallback callback;
+        bool breached;
+    };
+
+    size_t n;
+    std::vector<double> expected_returns;
+    std::vector<double> covariance;      // Row-major n x n annual covariance
+    std::vector<double> cholesky;        // Lower-triangular factor of the covariance
+    std::vector<double> prices;          // Consumer-owned latest prices
+    StreamingRiskConfig config;
+    double z_score;
+
+    MpscRingBuffer<PriceTick> ticks;
+    std::vector<PortfolioState> portfolios;
+    std::vector<Subscription> subscriptions;
+    std::vector<size_t> repositioned;    // Portfolios whose positions were replaced since the last drain
+    mutable std::mutex state_mutex;      // Guards portfolios, subscriptions, repositioned and prices
+
+    std::atomic<bool> running;
+    std::thread consumer_thread;
+    std::thread monte_carlo_thread;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    size_t next_refresh;
+
+    std::atomic<uint64_t> ticks_received;
+    std::atomic<uint64_t> ticks_dropped;
+    std::atomic<uint64_t> ticks_processed;
+    std::atomic<uint64_t> batches;
+    std::atomic<uint64_t> mc_refreshes;
+
+    // Helper methods
+    void initializePortfolio(PortfolioState& state, const std::vector<double>& quantities) const;
+    double deltaNormalVaR(const PortfolioState& state) const;
+    size_t drain(size_t max_ticks);
+    void notify(const std::vector<size_t>& touched);
+    void consumerLoop();
+    void monteCarloLoop();
+
+public:
+    StreamingRiskService(const std::vector<double>& expected_returns,
+                         const std::vector<double>& volatilities,
+                         const std::vector<std::vector<double>>& correlation,
+                         const std::vector<double>& initial_prices,
+                         const StreamingRiskConfig& config = StreamingRiskConfig());
+    ~StreamingRiskService();
+
+    StreamingRiskService(const StreamingRiskService&) = delete;
+    StreamingRiskService& operator=(const StreamingRiskService&) = delete;
+
+    // Portfolios hold units of each asset; returns the portfolio id. New positions are checked
+    // against the portfolio's alert thresholds on the next consumer pass.
+    size_t addPortfolio(const std::vector<double>& quantities);
+    void setPositions(size_t portfolio, const std::vector<double>& quantities);
+
+    // Lock-free, callable from any number of producer threads
+    bool pushTick(uint32_t asset, double price, uint64_t timestamp = 0);
+    size_t pushTicks(const std::vector<PriceTick>& batch);
+
+    // Threshold alerts on delta-normal VaR, delivered on the consumer thread (by processPending()
+    // or stop() while it is not running); returns subscription id
+    size_t subscribe(size_t portfolio, double threshold, AlertCallback callback);
+
+    // Background consumer and Monte Carlo refresh threads
+    void start();
+    void stop();
+    bool isRunning() const { return running.load(); }
+
+    // Synchronous processing when the background threads are stopped
+    size_t processPending();
+    size_t refreshMonteCarlo(size_t max_portfolios);
+
+    PortfolioRiskSnapshot getRisk(size_t portfolio) const;
+    std::vector<PortfolioRiskSnapshot> getAllRisk() const;
+    StreamingRiskStats getStats() const;
+};
+
+#endif // STREAMING_H
@@ -0,0 +1,89 @@
+#include "validation.h"
+#include <cmath>
+#include <string>
+
+namespace {
+
+std::string entry(size_t i, size_t j) {
+    return "[" + std::to_string(i) + "][" + std::to_string(j) + "]";
+}
+
+CorrelationCheck issue(CorrelationIssue kind, long row, long column, double value, std::string message) {
+    CorrelationCheck check;
+    check.issue = kind;
+    check.row = row;
+    check.column = column;
+    check.value = value;
+    check.message = std::move(message);
+    return check;
+}
+
+} // namespace
+
+CorrelationCheck checkCorrelationMatrix(const std::vector<std::vector<double>>& matrix, size_t expected_size,
+                                        double symmetry_tolerance, double diagonal_tolerance,
+                                        std::vector<std::vector<double>>* factor) {
+    size_t n = expected_size;
+    if (matrix.size() != n) {
+        return issue(CorrelationIssue::SHAPE, -1, -1, 0.0,
+                     "Correlation matrix dimensions must match portfolio size: expected " +
+                     std::to_string(n) + " rows, got " + std::to_string(matrix.size()));
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (matrix[i].size() != n) {
+            return issue(CorrelationIssue::SHAPE, static_cast<long>(i), -1, 0.0,
+                         "Correlation matrix dimensions must match portfolio size: row " + std::to_string(i) +
+                         " has " + std::to_string(matrix[i].size()) + " elements, expected " + std::to_string(n));
+        }
+    }
+
+    std::vector<std::vector<double>> L(n, std::vector<double>(n, 0.0));
+    for (size_t i = 0; i < n; ++i) {
+        const double* row = matrix[i].data();
+        double* li = L[i].data();
+        for (size_t j = 0; j < i; ++j) {
+            double value = row[j], mirror = matrix[j][i];
+            if (!std::isfinite(value) || !std::isfinite(mirror)) {
+                bool lower = !std::isfinite(value);
+                return issue(CorrelationIssue::NOT_FINITE, static_cast<long>(lower ? i : j),
+                             static_cast<long>(lower ? j : i), lower ? value : mirror,
+                             "Correlation matrix entry " + (lower ? entry(i, j) : entry(j, i)) + " is not finite");
+            }
+            if (std::abs(value - mirror) > symmetry_tolerance) {
+                return issue(CorrelationIssue::ASYMMETRIC, static_cast<long>(i), static_cast<long>(j), value,
+                             "Correlation matrix must be symmetric: " + entry(i, j) + " != " + entry(j, i));
+            }
+            if (std::abs(value) > 1.0) {
+                return issue(CorrelationIssue::OUT_OF_RANGE, static_cast<long>(i), static_cast<long>(j), value,
+                             "Correlation values must be between -1 and 1, got " + std::to_string(value) +
+                             " at " + entry(i, j));
+            }
+            const double* lj = L[j].data();
+            double sum = 0.0;
+            for (size_t k = 0; k < j; ++k) sum += li[k] * lj[k];
+            li[j] = (value - sum) / lj[j];
+        }
+        double diagonal = row[i];
+        if (!std::isfinite(diagonal)) {
+            return issue(CorrelationIssue::NOT_FINITE, static_cast<long>(i), static_cast<long>(i), diagonal,
+                         "Correlation matrix entry " + entry(i, i) + " is not finite");
+        }
+        if (std::abs(diagonal - 1.0) > diagonal_tolerance) {
+            return issue(CorrelationIssue::DIAGONAL, static_cast<long>(i), static_cast<long>(i), diagonal,
+                         "Diagonal elements of correlation matrix should be 1, got " + std::to_string(diagonal) +
+                         " at " + entry(i, i));
+        }
+        double sum = 0.0;
+        for (size_t k = 0; k < i; ++k) sum += li[k] * li[k];
+        double pivot = diagonal - sum;
+        if (!(pivot > 0.0)) {
+            return issue(CorrelationIssue::NOT_POSITIVE_DEFINITE, static_cast<long>(i), static_cast<long>(i), pivot,
+                         "Correlation matrix is not positive definite: pivot " + std::to_string(pivot) +
+                         " at row " + std::to_string(i));
+        }
+        li[i] = std::sqrt(pivot);
+    }
+
+    if (factor) *factor = std::move(L);
+    return CorrelationCheck();
+}
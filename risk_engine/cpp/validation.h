@@ -0,0 +1,38 @@
+#ifndef VALIDATION_H
+#define VALIDATION_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+enum class CorrelationIssue {
+    NONE,
+    SHAPE,                 // Wrong number of rows or a ragged row
+    NOT_FINITE,            // NaN or infinite entry
+    OUT_OF_RANGE,          // Off-diagonal entry outside [-1, 1]
+    DIAGONAL,              // Diagonal entry not 1 within tolerance
+    ASYMMETRIC,            // Entry differs from its mirror beyond tolerance
+    NOT_POSITIVE_DEFINITE  // Cholesky pivot <= 0
+};
+
+struct CorrelationCheck {
+    CorrelationIssue issue;
+    long row;            // Offending entry (-1 when the issue is not tied to one)
+    long column;
+    double value;        // Offending entry, or the failed pivot for NOT_POSITIVE_DEFINITE
+    std::string message; // Empty when valid
+
+    CorrelationCheck() : issue(CorrelationIssue::NONE), row(-1), column(-1), value(0.0) {}
+
+    bool valid() const { return issue == CorrelationIssue::NONE; }
+};
+
+// Validates a correlation matrix in the same sweep as its Cholesky factorization: while row i of
+// the factor is formed, each lower-triangle entry is checked against its mirror, the range and
+// the unit diagonal, and a non-positive pivot reports the matrix as not positive definite. The
+// first issue in row order is returned. On success `factor` (if given) holds the n x n lower factor.
+CorrelationCheck checkCorrelationMatrix(const std::vector<std::vector<double>>& matrix, size_t expected_size,
+                                        double symmetry_tolerance, double diagonal_tolerance,
+                                        std::vector<std::vector<double>>* factor = nullptr);
+
+#endif // VALIDATION_H
@@ -0,0 +1,37 @@
+"""
+Gunicorn settings for serving the API from pre-forked workers:
+
+    gunicorn -c gunicorn_conf.py main:app
+
+The master preloads the app, builds the engine's shared tables once and then forks the
+workers, which map those pages copy-on-write. With RISK_ENGINE_SNAPSHOT set, the master maps
+the saved tables instead of rebuilding them. The master stays single-threaded so no OpenMP
+thread pool exists at fork time; each worker then gets its share of the cores.
+"""
+
+import multiprocessing
+import os
+
+import risk_engine_cpp
+from risk_wrapper import initialize_engine_runtime
+
+bind = os.environ.get("RISK_ENGINE_BIND", "0.0.0.0:8000")
+workers = int(os.environ.get("RISK_ENGINE_WORKERS", multiprocessing.cpu_count()))
+worker_class = "uvicorn.workers.UvicornWorker"
+preload_app = True
+
+
+def on_starting(server):
+    status = initialize_engine_runtime(preload=True,
+                                       snapshot_path=os.environ.get("RISK_ENGINE_SNAPSHOT"))
+    server.log.info(f"Engine runtime ready for forking: {status}")
+
+
+def post_fork(server, worker):
+    threads = max(1, multiprocessing.cpu_count() // max(1, server.cfg.workers))
+    status = risk_engine_cpp.initialize_runtime(num_threads=threads)
+    server.log.info(f"Worker {worker.pid} engine runtime: {status}")
+
+
+def worker_exit(server, worker):
+    risk_engine_cpp.shutdown_runtime()
@@ -8,10 +8,19 @@ from fastapi.responses import JSONResponse
 from pydantic import BaseModel, validator
 from typing import List, Optional, Dict, Any
 import logging
+import os
+import sqlite3
 import time
 from contextlib import asynccontextmanager
 
-from risk_wrapper import RiskEngineWrapper, PortfolioAsset, calculate_portfolio_risk
+from risk_wrapper import (RiskEngineWrapper, PortfolioAsset, CardinalityOptimizationResult,
+                          RebalanceAccountResult, RebalanceWarmStart,
+                          calculate_portfolio_risk, validate_correlation_matrix,
+                          initialize_engine_runtime, save_engine_snapshot,
+                          PositionStoreSync, record_prices, ASSET_TYPES,
+                          measure_portfolio_performance, attribute_by_asset_type,
+                          calibrate_sentiment)
+import risk_engine_cpp
 
 # Configure logging
 logging.basicConfig(level=logging.INFO)
@@ -20,20 +29,49 @@ logger = logging.getLogger(__name__)
 # Global risk engine instance
 risk_engine = None
 
+# Positions and latest prices of the platform database, held in native columns
+position_store = risk_engine_cpp.PositionStore()
+
+# Keeps this worker's store current with the database (None when no database is configured)
+position_sync = None
+
+# Warm-state snapshot mapped at startup and rewritten at shutdown (unset = disabled)
+SNAPSHOT_PATH = os.environ.get("RISK_ENGINE_SNAPSHOT")
+
+# Platform SQLite database the position store is loaded from (unset = store starts empty)
+DATABASE_PATH = os.environ.get("RISK_ENGINE_DATABASE")
+
 @asynccontextmanager
 async def lifespan(app: FastAPI):
     """Application lifespan manager"""
-    global risk_engine
+    global risk_engine, position_sync
     
     # Startup
     logger.info("Starting Risk Engine API...")
+    if not risk_engine_cpp.runtime_status().initialized:
+        # Pre-forked workers were already set up by their master (see gunicorn_conf.py)
+        initialize_engine_runtime(snapshot_path=SNAPSHOT_PATH)
     risk_engine = RiskEngineWrapper(num_simulations=100000, time_horizon_days=1)
-    logger.info("Risk Engine initialized successfully")
+    logger.info(f"Risk Engine initialized successfully ({risk_engine_cpp.runtime_status()})")
+    if DATABASE_PATH:
+        position_sync = PositionStoreSync(DATABASE_PATH, position_store)
+        try:
+            position_sync.reload()
+            logger.info(f"Loaded position store from {DATABASE_PATH} ({position_store.stats()})")
+        except Exception as e:
+            logger.warning(f"Could not load position store: {e}")
     
     yield
     
     # Shutdown
     logger.info("Shutting down Risk Engine API...")
+    if SNAPSHOT_PATH:
+        try:
+            info = save_engine_snapshot(SNAPSHOT_PATH)
+            logger.info(f"Saved engine snapshot to {SNAPSHOT_PATH} ({info})")
+        except (OSError, RuntimeError, ValueError) as e:
+            logger.warning(f"Could not save engine snapshot: {e}")
+    risk_engine_cpp.shutdown_runtime()
 
 # Create FastAPI application
 app = FastAPI(
@@ -76,8 +114,14 @@ class RiskCalculationRequest(BaseModel):
     """Request model for risk calculations"""
     assets: List[AssetInput]
     correlation_matrix: Optional[List[List[float]]] = None
+    benchmark_weights: Optional[List[float]] = None
     num_simulations: Optional[int] = Query(default=100000, ge=1000, le=1000000)
     time_horizon_days: Optional[int] = Query(default=1, ge=1, le=252)
+    pca_retained_variance: Optional[float] = Query(default=None, gt=0.0, le=1.0)
+    average_daily_volume: Optional[List[float]] = None
+    portfolio_value: Optional[float] = Query(default=None, gt=0.0)
+    sentiment_loadings: Optional[List[float]] = None  # From POST /sentiment/calibrate, per asset
+    sentiment_drift: Optional[List[float]] = None
     
     @validator('assets')
     def validate_assets(cls, v):
@@ -98,29 +142,51 @@ class RiskCalculationRequest(BaseModel):
         if v is None:
             return v
         
-        assets = values.get('assets', [])
-        n = len(assets)
+        # Native pass: shape, range, diagonal, symmetry and positive definiteness
+        validate_correlation_matrix(v, len(values.get('assets', [])))
+        return v
+    
+    @validator('benchmark_weights')
+    def validate_benchmark_weights(cls, v, values):
+        if v is None:
+            return v
         
+        n = len(values.get('assets', []))
         if len(v) != n:
-            raise ValueError(f'Correlation matrix must be {n}x{n}, got {len(v)} rows')
+            raise ValueError(f'Benchmark weights must have {n} elements, got {len(v)}')
+        if abs(sum(v) - 1.0) > 1e-6:
+            raise ValueError(f'Benchmark weights must sum to 1.0, got {sum(v):.6f}')
         
-        for i, row in enumerate(v):
-            if len(row) != n:
-                raise ValueError(f'Correlation matrix row {i} must have {n} elements, got {len(row)}')
-            
-            # Check diagonal elements
-            if abs(row[i] - 1.0) > 1e-6:
-                raise ValueError(f'Diagonal element [{i}][{i}] must be 1.0, got {row[i]}')
-            
-            # Check symmetry
-            for j, val in enumerate(row):
-                if abs(val - v[j][i]) > 1e-6:
-                    raise ValueError(f'Correlation matrix must be symmetric: [{i}][{j}] != [{j}][{i}]')
-                
-                if abs(val) > 1.0:
-                    raise ValueError(f'Correlation values must be between -1 and 1, got {val}')
+        return v
+    
+    @validator('average_daily_volume')
+    def validate_average_daily_volume(cls, v, values):
+        if v is None:
+            return v
+        
+        n = len(values.get('assets', []))
+        if len(v) != n:
+            raise ValueError(f'Average daily volumes must have {n} elements, got {len(v)}')
+        if any(volume <= 0 for volume in v):
+            raise ValueError('Average daily volumes must be positive')
         
         return v
+    
+    @validator('portfolio_value', always=True)
+    def validate_portfolio_value(cls, v, values):
+        if values.get('average_daily_volume') is not None and v is None:
+            raise ValueError('portfolio_value is required with average_daily_volume')
+        return v
+    
+    @validator('sentiment_loadings', 'sentiment_drift')
+    def validate_sentiment(cls, v, values):
+        if v is None:
+            return v
+        
+        n = len(values.get('assets', []))
+        if len(v) != n:
+            raise ValueError(f'Sentiment vectors must have {n} elements, got {len(v)}')
+        return v
 
 class RiskCalculationResponse(BaseModel):
     """Response model for risk calculations"""
@@ -134,6 +200,113 @@ class RiskCalculationResponse(BaseModel):
     time_horizon_days: int
     calculation_time_ms: float
     simulation_summary: Dict[str, float]
+    tracking_error: Optional[float] = None
+    active_var_95: Optional[float] = None
+    active_var_99: Optional[float] = None
+    analytic_active_var_95: Optional[float] = None
+    analytic_active_var_99: Optional[float] = None
+    pca_factors: Optional[int] = None
+    pca_retained_variance: Optional[float] = None
+    pca_truncation_error: Optional[float] = None
+    liquidity_var_95: Optional[float] = None
+    liquidity_var_99: Optional[float] = None
+    liquidation_cost: Optional[float] = None
+    liquidation_days: Optional[List[float]] = None
+
+class CardinalityOptimizationRequest(BaseModel):
+    """Request model for cardinality-constrained optimization"""
+    assets: List[str]
+    expected_returns: List[float]
+    volatilities: List[float]
+    correlation_matrix: Optional[List[List[float]]] = None
+    prices: Optional[List[float]] = None
+    portfolio_value: float = 0.0
+    max_assets: int = Query(default=10, ge=1, le=200)
+    min_weight: float = Query(default=0.0, ge=0, le=1)
+    max_weight: float = Query(default=1.0, gt=0, le=1)
+    risk_aversion: float = Query(default=1.0, ge=0)
+    time_limit_seconds: float = Query(default=5.0, gt=0, le=60)
+    
+    @validator('assets')
+    def validate_assets(cls, v):
+        if not v:
+            raise ValueError('At least one asset is required')
+        if len(v) > 500:
+            raise ValueError('Maximum 500 assets allowed')
+        return v
+
+class RebalanceRequest(BaseModel):
+    """Request model for a transaction-cost-aware rebalance of many accounts"""
+    expected_returns: List[float]
+    volatilities: List[float]
+    account_weights: List[List[float]]
+    correlation_matrix: Optional[List[List[float]]] = None
+    linear_costs: Optional[List[float]] = None
+    impact_costs: Optional[List[float]] = None
+    no_trade_bands: Optional[List[float]] = None
+    risk_aversion: float = Query(default=1.0, ge=0)
+    turnover_penalty: float = Query(default=0.0, ge=0)
+    max_weight: float = Query(default=1.0, gt=0, le=1)
+    warm_starts: Optional[List[Optional[RebalanceWarmStart]]] = None  # From the previous response
+    
+    @validator('account_weights')
+    def validate_accounts(cls, v):
+        if not v:
+            raise ValueError('At least one account is required')
+        return v
+
+class PositionRefreshRequest(BaseModel):
+    """Assets written in the platform database since the store last saw them"""
+    asset_ids: List[int]
+
+class PriceInput(BaseModel):
+    """One price tick for a held asset"""
+    asset_id: int
+    price: float
+    price_date: str = ""
+
+class PriceUpdateRequest(BaseModel):
+    """Request model for bulk price ticks"""
+    prices: List[PriceInput]
+
+class ValuationRequest(BaseModel):
+    """Request model for bulk portfolio valuation"""
+    portfolio_ids: List[int] = []  # Empty values every portfolio holding positions
+    include_positions: bool = False
+
+class PortfolioValuationResponse(BaseModel):
+    """Value and allocation of one portfolio at the latest stored prices"""
+    portfolio_id: int
+    total_value: float
+    allocation: Dict[str, float]            # Percent of value by asset type, as the platform reports it
+    weights: Optional[Dict[int, float]] = None  # Weight per asset id
+
+class CashFlowInput(BaseModel):
+    """External flow into (+) or out of (-) a portfolio"""
+    portfolio_id: int
+    date: str
+    amount: float
+
+class PerformanceRequest(BaseModel):
+    """Request model for nightly performance measurement"""
+    portfolio_ids: List[int] = []  # Empty returns every portfolio with snapshots
+    flows: List[CashFlowInput] = []
+
+class AttributionPeriod(BaseModel):
+    """One period of weights and returns keyed by asset type"""
+    portfolio_weights: Dict[str, float]
+    portfolio_returns: Dict[str, float]
+    benchmark_weights: Dict[str, float]
+    benchmark_returns: Dict[str, float]
+
+class AttributionRequest(BaseModel):
+    """Request model for Brinson attribution of many portfolios"""
+    portfolios: List[List[AttributionPeriod]]
+
+class SentimentCalibrationRequest(BaseModel):
+    """Sentiment service responses keyed by ticker"""
+    responses: Dict[str, Dict[str, Any]]
+    drift_shrinkage: float = Query(default=0.5, ge=0.0, le=1.0)
 
 class HealthResponse(BaseModel):
     """Health check response"""
@@ -201,7 +374,13 @@ async def calculate_risk(request: RiskCalculationRequest):
             assets=portfolio_assets,
             correlation_matrix=request.correlation_matrix,
             num_simulations=request.num_simulations,
-            time_horizon_days=request.time_horizon_days
+            time_horizon_days=request.time_horizon_days,
+            benchmark_weights=request.benchmark_weights,
+            pca_retained_variance=request.pca_retained_variance,
+            average_daily_volume=request.average_daily_volume,
+            portfolio_value=request.portfolio_value,
+            sentiment_loadings=request.sentiment_loadings,
+            sentiment_drift=request.sentiment_drift
         )
         
         calculation_time = (time.time() - start_time) * 1000  # Convert to milliseconds
@@ -219,7 +398,19 @@ async def calculate_risk(request: RiskCalculationRequest):
             num_simulations=result.num_simulations,
             time_horizon_days=result.time_horizon_days,
             calculation_time_ms=calculation_time,
-            simulation_summary=result.simulation_summary
+            simulation_summary=result.simulation_summary,
+            tracking_error=result.tracking_error,
+            active_var_95=result.active_var_95,
+            active_var_99=result.active_var_99,
+            analytic_active_var_95=result.analytic_active_var_95,
+            analytic_active_var_99=result.analytic_active_var_99,
+            pca_factors=result.pca_factors,
+            pca_retained_variance=result.pca_retained_variance,
+            pca_truncation_error=result.pca_truncation_error,
+            liquidity_var_95=result.liquidity_var_95,
+            liquidity_var_99=result.liquidity_var_99,
+            liquidation_cost=result.liquidation_cost,
+            liquidation_days=result.liquidation_days
         )
         
     except ValueError as e:
@@ -235,6 +426,105 @@ async def calculate_risk(request: RiskCalculationRequest):
             detail=f"Risk calculation failed: {str(e)}"
         )
 
+@app.post("/optimize-cardinality", response_model=CardinalityOptimizationResult)
+async def optimize_cardinality(request: CardinalityOptimizationRequest):
+    """
+    Mean-variance optimization with a cardinality limit and whole-share quantities
+    
+    Runs a parallel branch-and-bound over asset inclusion in C++. If the time limit is hit
+    the best portfolio found so far is returned together with the proven lower bound.
+    
+    Args:
+        request: Asset universe, constraints and optional prices for whole-share rounding
+        
+    Returns:
+        Optimal (or best found) weights, share quantities and search statistics
+    """
+    start_time = time.time()
+    
+    try:
+        result = risk_engine.optimize_cardinality(
+            asset_names=request.assets,
+            expected_returns=request.expected_returns,
+            volatilities=request.volatilities,
+            correlation_matrix=request.correlation_matrix,
+            max_assets=request.max_assets,
+            min_weight=request.min_weight,
+            max_weight=request.max_weight,
+            risk_aversion=request.risk_aversion,
+            prices=request.prices,
+            portfolio_value=request.portfolio_value,
+            time_limit_seconds=request.time_limit_seconds
+        )
+        
+        calculation_time = (time.time() - start_time) * 1000
+        logger.info(f"Cardinality optimization completed in {calculation_time:.2f}ms for "
+                   f"{len(request.assets)} assets, {result.nodes_explored} nodes")
+        
+        return result
+        
+    except ValueError as e:
+        logger.error(f"Validation error: {str(e)}")
+        raise HTTPException(
+            status_code=400,
+            detail=f"Invalid input parameters: {str(e)}"
+        )
+    except Exception as e:
+        logger.error(f"Cardinality optimization error: {str(e)}")
+        raise HTTPException(
+            status_code=500,
+            detail=f"Optimization failed: {str(e)}"
+        )
+
+@app.post("/rebalance", response_model=List[RebalanceAccountResult])
+async def rebalance(request: RebalanceRequest):
+    """
+    Mean-variance rebalance of many accounts net of linear, impact and no-trade costs
+    
+    Every account is solved in parallel in C++ against one factorized system. Send each
+    result's warm_start back in warm_starts on the next rebalance to start from it.
+    
+    Args:
+        request: Asset universe, per-account current weights, costs and previous warm starts
+        
+    Returns:
+        Target weights, trades, costs and the warm start of each account, in input order
+    """
+    start_time = time.time()
+    
+    try:
+        results = risk_engine.rebalance(
+            expected_returns=request.expected_returns,
+            volatilities=request.volatilities,
+            account_weights=request.account_weights,
+            correlation_matrix=request.correlation_matrix,
+            linear_costs=request.linear_costs,
+            impact_costs=request.impact_costs,
+            no_trade_bands=request.no_trade_bands,
+            risk_aversion=request.risk_aversion,
+            turnover_penalty=request.turnover_penalty,
+            max_weight=request.max_weight,
+            warm_starts=request.warm_starts
+        )
+        
+        calculation_time = (time.time() - start_time) * 1000
+        logger.info(f"Rebalanced {len(results)} accounts in {calculation_time:.2f}ms")
+        
+        return results
+        
+    except ValueError as e:
+        logger.error(f"Validation error: {str(e)}")
+        raise HTTPException(
+            status_code=400,
+            detail=f"Invalid input parameters: {str(e)}"
+        )
+    except Exception as e:
+        logger.error(f"Rebalance error: {str(e)}")
+        raise HTTPException(
+            status_code=500,
+            detail=f"Rebalance failed: {str(e)}"
+        )
+
 @app.get("/sample-portfolio", response_model=Dict[str, Any])
 async def get_sample_portfolio():
     """
@@ -311,6 +601,125 @@ async def quick_risk_calculation(
             detail=f"Quick risk calculation failed: {str(e)}"
         )
 
+def _sync_positions():
+    """Bring this worker's store up to date before serving from it"""
+    if position_sync is None:
+        return
+    try:
+        position_sync.sync()
+    except sqlite3.Error as e:
+        logger.error(f"Position store sync failed: {e}")
+        raise HTTPException(status_code=503, detail="Position store could not be synchronized")
+
+@app.post("/positions/reload", response_model=Dict[str, int])
+async def reload_positions():
+    """Reload every position and latest price from the platform database"""
+    if position_sync is None:
+        raise HTTPException(status_code=409, detail="RISK_ENGINE_DATABASE is not configured")
+    stats = position_sync.reload()
+    return {"positions": stats.positions, "portfolios": stats.portfolios}
+
+@app.post("/positions/refresh", response_model=Dict[str, int])
+async def refresh_position_store(request: PositionRefreshRequest):
+    """
+    Catch up after the platform wrote assets (insert, update, delete or new price)
+    
+    Every worker catches up on its own before its next valuation, so this only spares the
+    worker that receives it the check; it applies everything committed, not just asset_ids.
+    """
+    if position_sync is None:
+        raise HTTPException(status_code=409, detail="RISK_ENGINE_DATABASE is not configured")
+    _sync_positions()
+    stats = position_store.stats()
+    return {"positions": stats.positions, "portfolios": stats.portfolios}
+
+@app.post("/prices", response_model=Dict[str, int])
+async def update_prices(request: PriceUpdateRequest):
+    """
+    Apply price ticks to held assets; ticks older than the stored price are ignored
+    
+    With a database configured the ticks are written to asset_prices, so every worker sees them.
+    """
+    try:
+        if position_sync is not None:
+            applied = record_prices(DATABASE_PATH, [(p.asset_id, p.price, p.price_date) for p in request.prices])
+            _sync_positions()
+        else:
+            applied = position_store.load_prices([
+                risk_engine_cpp.PriceRecord(asset_id=p.asset_id, price=p.price, price_date=p.price_date)
+                for p in request.prices
+            ])
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    except sqlite3.Error as e:
+        logger.error(f"Could not record price ticks: {e}")
+        raise HTTPException(status_code=503, detail="Price ticks could not be recorded")
+    return {"applied": applied, "ignored": len(request.prices) - applied}
+
+@app.post("/portfolios/valuation", response_model=List[PortfolioValuationResponse])
+async def value_portfolios(request: ValuationRequest):
+    """
+    Value many portfolios in one native pass over the position store
+    
+    Allocation matches the platform's per-portfolio calculation (capitalized type, percent,
+    two decimals); weights are current market weights and can be fed to /calculate-risk.
+    """
+    _sync_positions()
+    valuations = position_store.value_portfolios(request.portfolio_ids)
+    type_names = [name.capitalize() for name in ASSET_TYPES]
+    return [
+        PortfolioValuationResponse(
+            portfolio_id=v.portfolio_id,
+            total_value=v.total_value,
+            allocation={name: round(share * 100, 2)
+                        for name, share in zip(type_names, v.allocation) if share != 0.0},
+            weights=dict(zip(v.asset_ids, v.weights)) if request.include_positions else None
+        )
+        for v in valuations
+    ]
+
+@app.post("/performance", response_model=Dict[int, Dict[str, Optional[float]]])
+async def portfolio_performance(request: PerformanceRequest):
+    """
+    Time-weighted and money-weighted returns from the portfolio_snapshots history
+    
+    All portfolios are measured in one native batch; money_weighted_return is null when the
+    IRR has no root in range.
+    """
+    if not DATABASE_PATH:
+        raise HTTPException(status_code=409, detail="RISK_ENGINE_DATABASE is not configured")
+    try:
+        results = measure_portfolio_performance(
+            DATABASE_PATH, [(f.portfolio_id, f.date, f.amount) for f in request.flows]
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    if request.portfolio_ids:
+        results = {p: results[p] for p in request.portfolio_ids if p in results}
+    return results
+
+@app.post("/performance/attribution", response_model=List[Dict[str, Any]])
+async def performance_attribution(request: AttributionRequest):
+    """Brinson allocation, selection and interaction effects by asset type, linked across periods"""
+    try:
+        return attribute_by_asset_type([[period.dict() for period in periods]
+                                        for periods in request.portfolios])
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+
+@app.post("/sentiment/calibrate", response_model=Dict[str, Any])
+async def sentiment_calibration(request: SentimentCalibrationRequest):
+    """
+    Sentiment factor loadings and drift tilts for every ticker in one native regression
+    
+    Pass the loadings and tilts of the portfolio's assets to /calculate-risk as
+    sentiment_loadings and sentiment_drift.
+    """
+    try:
+        return calibrate_sentiment(request.responses, request.drift_shrinkage)
+    except (ValueError, KeyError) as e:
+        raise HTTPException(status_code=400, detail=str(e))
+
 # Custom exception handlers
 @app.exception_handler(HTTPException)
 async def http_exception_handler(request, exc):
@@ -2,6 +2,12 @@
 Python wrapper for the C++ Monte Carlo Risk Engine
 """
 
+import os
+import re
+import sqlite3
+import threading
+from contextlib import closing
+from datetime import date
 import numpy as np
 from typing import List, Dict, Any, Optional, Tuple
 from pydantic import BaseModel, validator
@@ -28,6 +34,466 @@ class PortfolioAsset(BaseModel):
         return v
 
 
+class CorrelationMatrixError(ValueError):
+    """Invalid correlation matrix, carrying the native check's location of the problem"""
+    
+    def __init__(self, check):
+        super().__init__(check.message)
+        self.issue = check.issue.name.lower()
+        self.row = check.row if check.row >= 0 else None
+        self.column = check.column if check.column >= 0 else None
+        self.value = check.value
+
+
+def validate_correlation_matrix(matrix: List[List[float]], size: int, tolerance: float = 1e-6) -> None:
+    """
+    Validate shape, range, unit diagonal, symmetry and positive definiteness in one native pass
+    
+    Raises:
+        CorrelationMatrixError: describing the first problem found
+    """
+    check = risk_engine_cpp.check_correlation_matrix(matrix, size, tolerance, tolerance)
+    if not check.valid:
+        raise CorrelationMatrixError(check)
+
+
+def initialize_engine_runtime(num_threads: int = 0, preload: bool = False, warmup: bool = True,
+                              snapshot_path: Optional[str] = None):
+    """
+    Prepare the native engine in this process
+    
+    Installs the at-fork handlers that keep OpenMP usable in forked workers and, with warmup,
+    builds the shared read-only tables. A master that forks workers passes preload=True
+    before running any simulation, so it never starts OpenMP threads of its own. When
+    snapshot_path names an existing snapshot, its tables are mapped first and warmup only
+    builds what the snapshot lacks.
+    
+    Returns:
+        risk_engine_cpp.RuntimeStatus of this process
+    """
+    status = risk_engine_cpp.initialize_runtime(num_threads=num_threads, preload=preload)
+    if snapshot_path and os.path.exists(snapshot_path):
+        load_engine_snapshot(snapshot_path)
+    if warmup:
+        status = risk_engine_cpp.warmup_runtime()
+    return status
+
+
+def save_engine_snapshot(path: str, models: Optional[Dict[str, Any]] = None,
+                         estimators: Optional[Dict[str, Any]] = None):
+    """
+    Write this process's warm state to a versioned snapshot file
+    
+    Includes the Sobol direction table and cached correlation factorizations, plus any
+    fitted GaussianHMM models and RealizedCovarianceEstimators passed by key.
+    
+    Returns:
+        risk_engine_cpp.SnapshotInfo describing the written file
+    """
+    writer = risk_engine_cpp.SnapshotWriter()
+    writer.add_process_caches()
+    for key, model in (models or {}).items():
+        writer.add_model(key, model)
+    for key, estimator in (estimators or {}).items():
+        writer.add_estimator(key, estimator)
+    return writer.write(path)
+
+
+def load_engine_snapshot(path: str):
+    """
+    Map a snapshot read-only and serve the process-wide caches from it
+    
+    Returns:
+        risk_engine_cpp.Snapshot, for restoring its models and estimators by key
+    """
+    snapshot = risk_engine_cpp.Snapshot(path)
+    snapshot.install_process_caches()
+    return snapshot
+
+
+# Latest price per asset in one statement; equal dates resolve to the last inserted row
+_LATEST_PRICES_SQL = """
+    SELECT p.asset_id, p.price, p.price_date
+    FROM asset_prices p
+    JOIN (SELECT asset_id, MAX(price_date) AS price_date FROM asset_prices GROUP BY asset_id) latest
+      ON p.asset_id = latest.asset_id AND p.price_date = latest.price_date
+    {where}
+    ORDER BY p.id
+"""
+
+_ISO_DATE = re.compile(r"^\d{4}-\d{2}-\d{2}")
+
+
+def _position_records(rows):
+    return [
+        risk_engine_cpp.PositionRecord(
+            asset_id=row[0], portfolio_id=row[1], symbol=row[2] or "",
+            type=risk_engine_cpp.parse_asset_type(row[3]),
+            quantity=float(row[4]), purchase_price=float(row[5])
+        )
+        for row in rows
+    ]
+
+
+def _price_records(rows):
+    # Free-form dates still count as a price, just without ordering against later ticks
+    return [
+        risk_engine_cpp.PriceRecord(
+            asset_id=row[0], price=float(row[1]),
+            price_date=row[2] if isinstance(row[2], str) and _ISO_DATE.match(row[2]) else ""
+        )
+        for row in rows
+    ]
+
+
+def load_position_store(database_path: str, store=None):
+    """
+    Bulk-load every position and its latest price from the platform database
+    
+    Two queries in total, however many assets there are. An existing store is reloaded in place,
+    positions and prices in one swap.
+    
+    Returns:
+        risk_engine_cpp.PositionStore
+    """
+    store = store if store is not None else risk_engine_cpp.PositionStore()
+    with closing(sqlite3.connect(f"file:{database_path}?mode=ro", uri=True)) as conn:
+        positions = _position_records(conn.execute(
+            "SELECT id, portfolio_id, symbol, type, quantity, purchase_price FROM assets ORDER BY id"
+        ))
+        prices = _price_records(conn.execute(_LATEST_PRICES_SQL.format(where="")))
+    store.load_snapshot(positions, prices)
+    return store
+
+
+def refresh_positions(store, database_path: str, asset_ids: List[int]) -> Dict[str, int]:
+    """
+    Re-read the given assets after a write: rows still present are upserted with their latest
+    price, deleted rows are dropped from the store, all in one swap
+    
+    Returns:
+        Counts of upserted and removed positions
+    """
+    asset_ids = sorted(set(int(a) for a in asset_ids))
+    if not asset_ids:
+        return {"upserted": 0, "removed": 0}
+    placeholders = ",".join("?" * len(asset_ids))
+    with closing(sqlite3.connect(f"file:{database_path}?mode=ro", uri=True)) as conn:
+        positions = _position_records(conn.execute(
+            "SELECT id, portfolio_id, symbol, type, quantity, purchase_price FROM assets "
+            f"WHERE id IN ({placeholders}) ORDER BY id", asset_ids
+        ))
+        prices = _price_records(conn.execute(
+            _LATEST_PRICES_SQL.format(where=f"WHERE p.asset_id IN ({placeholders})"), asset_ids
+        ))
+    removed = store.refresh_assets(asset_ids, positions, prices)
+    return {"upserted": len(positions), "removed": removed}
+
+
+class PositionStoreSync:
+    """
+    Keeps one process's position store in step with the platform database
+    
+    Pre-forked workers each hold their own store, and a refresh or price tick posted to the API
+    reaches only the worker that serves it. sync() therefore compares SQLite's data_version, which
+    moves whenever another connection commits, with the one the store was loaded at. On a mismatch
+    it re-reads the assets table and the price rows added since, and swaps both into the store at
+    once, so every worker converges whichever one was notified.
+    """
+    
+    def __init__(self, database_path: str, store=None):
+        self.database_path = database_path
+        self.store = store if store is not None else risk_engine_cpp.PositionStore()
+        self._lock = threading.Lock()
+        self._conn = None
+        self._pid = None
+        self._data_version = None
+        self._last_price_id = 0
+    
+    def _connection(self):
+        # SQLite connections must not cross a fork, so each worker opens its own
+        if self._conn is None or self._pid != os.getpid():
+            self._conn = sqlite3.connect(f"file:{self.database_path}?mode=ro", uri=True,
+                                         isolation_level=None, check_same_thread=False)
+            self._pid = os.getpid()
+            self._data_version = None
+        return self._conn
+    
+    def _load(self, conn, incremental: bool):
+        # data_version is read first: a commit racing the queries is picked up by the next sync
+        version = conn.execute("PRAGMA data_version").fetchone()[0]
+        conn.execute("BEGIN")
+        try:
+            positions = _position_records(conn.execute(
+                "SELECT id, portfolio_id, symbol, type, quantity, purchase_price FROM assets ORDER BY id"
+            ))
+            if incremental:
+                prices = _price_records(conn.execute(
+                    "SELECT asset_id, price, price_date FROM asset_prices WHERE id > ? ORDER BY id",
+                    (self._last_price_id,)
+                ))
+            else:
+                prices = _price_records(conn.execute(_LATEST_PRICES_SQL.format(where="")))
+            last_price_id = conn.execute("SELECT COALESCE(MAX(id), 0) FROM asset_prices").fetchone()[0]
+        finally:
+            conn.execute("COMMIT")
+        self.store.load_snapshot(positions, prices)
+        self._data_version, self._last_price_id = version, last_price_id
+    
+    def reload(self):
+        """Re-read every position and latest price"""
+        with self._lock:
+            self._load(self._connection(), incremental=False)
+        return self.store.stats()
+    
+    def sync(self) -> bool:
+        """
+        Catch up with everything committed since the last load
+        
+        Returns:
+            True if the database had changed and the store was updated
+        """
+        with self._lock:
+            conn = self._connection()
+            if self._data_version is None:
+                self._load(conn, incremental=False)
+                return True
+            if conn.execute("PRAGMA data_version").fetchone()[0] == self._data_version:
+                return False
+            self._load(conn, incremental=True)
+            return True
+
+
+def record_prices(database_path: str, ticks: List[Tuple[int, float, str]]) -> int:
+    """
+    Append price ticks to the platform's asset_prices table, where every worker's store (and the
+    platform itself) picks them up
+    
+    As in the store, ticks for assets that are not held or older than the latest stored price are
+    skipped. Undated ticks are stamped with today's date.
+    
+    Returns:
+        Number of ticks written
+    """
+    rows = []
+    for asset_id, price, price_date in ticks:
+        if not np.isfinite(price) or price < 0:
+            raise ValueError("Price must be finite and non-negative")
+        if price_date and not _ISO_DATE.match(price_date):
+            raise ValueError(f"Price date must be YYYY-MM-DD: {price_date}")
+        price_date = price_date or date.today().isoformat()
+        rows.append((int(asset_id), float(price), price_date, int(asset_id), price_date, int(asset_id)))
+    if not rows:
+        return 0
+    with closing(sqlite3.connect(database_path, timeout=10.0)) as conn:
+        with conn:
+            cursor = conn.executemany(
+                "INSERT INTO asset_prices (asset_id, price, price_date) SELECT ?, ?, ? "
+                "WHERE EXISTS (SELECT 1 FROM assets WHERE id = ?) "
+                "AND ? >= COALESCE((SELECT MAX(price_date) FROM asset_prices WHERE asset_id = ?), '')",
+                rows
+            )
+            return cursor.rowcount
+
+
+def store_portfolio_assets(valuation, assumptions: Dict[str, Tuple[float, float]]) -> List[PortfolioAsset]:
+    """
+    Engine inputs for a valued portfolio: current market weights from the position store with
+    (expected_return, volatility) assumptions keyed by symbol
+    
+    Positions of the same symbol are merged.
+    """
+    weights: Dict[str, float] = {}
+    for symbol, weight in zip(valuation.symbols, valuation.weights):
+        weights[symbol] = weights.get(symbol, 0.0) + weight
+    missing = [symbol for symbol in weights if symbol not in assumptions]
+    if missing:
+        raise ValueError(f"No return and volatility assumptions for: {', '.join(missing)}")
+    return [
+        PortfolioAsset(asset_name=symbol, weight=min(max(weight, 0.0), 1.0),
+                       expected_return=assumptions[symbol][0], volatility=assumptions[symbol][1])
+        for symbol, weight in weights.items()
+    ]
+
+
+# Julian day number of date.toordinal() == 0, so SQLite's julianday() and Python dates agree
+_JULIAN_DAY_OFFSET = 1721424.5
+_DAYS_PER_YEAR = 365.25
+
+
+def load_value_histories(database_path: str, flows: Optional[List[Tuple[int, str, float]]] = None):
+    """
+    Value history of every portfolio from portfolio_snapshots, in one query
+    
+    Args:
+        database_path: Platform SQLite database
+        flows: External (portfolio_id, YYYY-MM-DD, amount) flows, + for deposits; each is booked on
+            the portfolio's first snapshot on or after its date
+        
+    Returns:
+        Tuple of (portfolio_ids, risk_engine_cpp.ValueHistories); the last snapshot of a day wins
+    """
+    with closing(sqlite3.connect(f"file:{database_path}?mode=ro", uri=True)) as conn:
+        rows = conn.execute("""
+            SELECT s.portfolio_id, julianday(s.snapshot_date), s.total_value
+            FROM portfolio_snapshots s
+            JOIN (SELECT MAX(id) AS id FROM portfolio_snapshots GROUP BY portfolio_id, snapshot_date) last
+              ON s.id = last.id
+            ORDER BY s.portfolio_id, s.snapshot_date
+        """).fetchall()
+    data = np.array(rows, dtype=float).reshape(-1, 3)
+    ids = data[:, 0].astype(np.int64)
+    starts = np.concatenate(([0], np.flatnonzero(np.diff(ids)) + 1))
+    offsets = np.concatenate((starts, [len(ids)])).astype(np.int64)
+    times = data[:, 1] / _DAYS_PER_YEAR
+    portfolio_ids = ids[starts].tolist() if len(ids) else []
+    
+    booked = np.zeros(len(ids))
+    slot = {portfolio_id: p for p, portfolio_id in enumerate(portfolio_ids)}
+    for portfolio_id, flow_date, amount in flows or []:
+        p = slot.get(int(portfolio_id))
+        if p is None:
+            continue
+        flow_time = (date.fromisoformat(flow_date[:10]).toordinal() + _JULIAN_DAY_OFFSET) / _DAYS_PER_YEAR
+        i = offsets[p] + np.searchsorted(times[offsets[p]:offsets[p + 1]], flow_time - 1e-9)
+        if i < offsets[p + 1]:
+            booked[i] += amount
+    
+    histories = risk_engine_cpp.ValueHistories()
+    histories.offsets = offsets.tolist()
+    histories.times = times.tolist()
+    histories.values = data[:, 2].tolist()
+    histories.flows = booked.tolist() if flows else []
+    return portfolio_ids, histories
+
+
+def measure_portfolio_performance(database_path: str,
+                                  flows: Optional[List[Tuple[int, str, float]]] = None) -> Dict[int, Dict[str, Any]]:
+    """
+    Time-weighted and money-weighted returns of every portfolio with snapshots
+    
+    Returns:
+        Dictionary keyed by portfolio id
+    """
+    portfolio_ids, histories = load_value_histories(database_path, flows)
+    results = risk_engine_cpp.measure_performance(histories)
+    return {
+        portfolio_id: {
+            "time_weighted_return": r.time_weighted_return,
+            "annualized_twr": r.annualized_twr,
+            "money_weighted_return": r.money_weighted_return if r.irr_converged else None,
+            "years": r.years
+        }
+        for portfolio_id, r in zip(portfolio_ids, results)
+    }
+
+
+ASSET_TYPES = [risk_engine_cpp.asset_type_name(risk_engine_cpp.AssetType(t))
+               for t in range(len(risk_engine_cpp.AssetType.__members__))]
+
+
+def attribute_by_asset_type(portfolios: List[List[Dict[str, Dict[str, float]]]]) -> List[Dict[str, Any]]:
+    """
+    Brinson attribution by assets.type for many portfolios
+    
+    Args:
+        portfolios: Per portfolio, a list of periods; each period maps portfolio_weights,
+            portfolio_returns, benchmark_weights and benchmark_returns to {type: value}
+            (missing types are zero)
+        
+    Returns:
+        Per portfolio, compounded returns and allocation/selection/interaction keyed by type
+    """
+    inputs = risk_engine_cpp.AttributionInputs()
+    inputs.num_classes = len(ASSET_TYPES)
+    offsets = [0]
+    columns = {key: [] for key in ("portfolio_weights", "portfolio_returns",
+                                   "benchmark_weights", "benchmark_returns")}
+    for periods in portfolios:
+        for period in periods:
+            for key, column in columns.items():
+                unknown = set(period.get(key, {})) - set(ASSET_TYPES)
+                if unknown:
+                    raise ValueError(f"Unknown asset types: {', '.join(sorted(unknown))}")
+                column.extend(period.get(key, {}).get(t, 0.0) for t in ASSET_TYPES)
+        offsets.append(offsets[-1] + len(periods))
+    inputs.offsets = offsets
+    for key, column in columns.items():
+        setattr(inputs, key, column)
+    
+    return [
+        {
+            "portfolio_return": r.portfolio_return,
+            "benchmark_return": r.benchmark_return,
+            "excess_return": r.excess_return,
+            "allocation": dict(zip(ASSET_TYPES, r.allocation)),
+            "selection": dict(zip(ASSET_TYPES, r.selection)),
+            "interaction": dict(zip(ASSET_TYPES, r.interaction))
+        }
+        for r in risk_engine_cpp.attribute_performance(inputs)
+    ]
+
+
+def load_sentiment_histories(responses: Dict[str, Dict[str, Any]]):
+    """
+    Flatten sentiment service responses into one batch of score and price histories
+    
+    Args:
+        responses: Sentiment response per ticker; scores come from sentiment_history and prices
+            from sentiment_price_correlation.series.price
+        
+    Returns:
+        Tuple of (tickers, risk_engine_cpp.SentimentHistories) with days since 1970-01-01
+    """
+    tickers = list(responses)
+    score_series = [responses[t].get("sentiment_history") or [] for t in tickers]
+    price_series = [((responses[t].get("sentiment_price_correlation") or {}).get("series") or {}).get("price") or []
+                    for t in tickers]
+    scores = [point for series in score_series for point in series]
+    prices = [point for series in price_series for point in series]
+    
+    histories = risk_engine_cpp.SentimentHistories()
+    histories.score_offsets = np.cumsum([0] + [len(series) for series in score_series]).tolist()
+    histories.score_days = np.array([p["date"][:10] for p in scores], dtype="datetime64[D]").astype(float).tolist()
+    histories.scores = [float(p["score"]) for p in scores]
+    histories.price_offsets = np.cumsum([0] + [len(series) for series in price_series]).tolist()
+    histories.price_days = np.array([p["date"][:10] for p in prices], dtype="datetime64[D]").astype(float).tolist()
+    histories.prices = [float(p["price"]) for p in prices]
+    return tickers, histories
+
+
+def calibrate_sentiment(responses: Dict[str, Dict[str, Any]], drift_shrinkage: float = 0.5) -> Dict[str, Any]:
+    """
+    Sentiment factor loadings and drift tilts for many tickers in one native call
+    
+    Returns:
+        Per-ticker loading, drift tilt, residual volatility and fit, plus the pooled drift slope,
+        its t-statistic and the correlation of the sentiment shock with the equal-weighted market return
+    """
+    tickers, histories = load_sentiment_histories(responses)
+    settings = risk_engine_cpp.SentimentCalibrationSettings()
+    settings.drift_shrinkage = drift_shrinkage
+    calibration = risk_engine_cpp.calibrate_sentiment_factors(histories, settings)
+    model = calibration.model
+    return {
+        "tickers": {
+            ticker: {
+                "loading": model.loadings[i],
+                "drift_tilt": model.drift_tilt[i],
+                "residual_volatility": calibration.residual_volatility[i],
+                "r_squared": calibration.r_squared[i],
+                "current_sentiment": calibration.current_sentiment[i],
+                "observations": calibration.observations[i]
+            }
+            for i, ticker in enumerate(tickers)
+        },
+        "drift_slope": calibration.drift_slope,
+        "drift_t_stat": calibration.drift_t_stat,
+        "market_correlation": calibration.market_correlation,
+        "intervals": calibration.num_intervals
+    }
+
+
 class RiskMetrics(BaseModel):
     """Risk metrics output"""
     var_95: float
@@ -39,6 +505,51 @@ class RiskMetrics(BaseModel):
     num_simulations: int
     time_horizon_days: float
     simulation_summary: Optional[Dict[str, float]] = None
+    tracking_error: Optional[float] = None
+    active_var_95: Optional[float] = None
+    active_var_99: Optional[float] = None
+    analytic_active_var_95: Optional[float] = None
+    analytic_active_var_99: Optional[float] = None
+    pca_factors: Optional[int] = None
+    pca_retained_variance: Optional[float] = None
+    pca_truncation_error: Optional[float] = None
+    liquidity_var_95: Optional[float] = None
+    liquidity_var_99: Optional[float] = None
+    liquidation_cost: Optional[float] = None
+    liquidation_days: Optional[List[float]] = None
+
+
+class CardinalityOptimizationResult(BaseModel):
+    """Cardinality-constrained optimization output"""
+    weights: Dict[str, float]
+    quantities: Optional[Dict[str, float]] = None
+    cash_residual: float
+    objective: float
+    lower_bound: float
+    expected_return: float
+    portfolio_vol: float
+    nodes_explored: int
+    proven_optimal: bool
+    timed_out: bool
+    rounded: bool = False
+
+
+class RebalanceWarmStart(BaseModel):
+    """ADMM iterates of one account; pass them back with the next day's rebalance"""
+    z: List[float]
+    u: List[float]
+
+
+class RebalanceAccountResult(BaseModel):
+    """Transaction-cost-aware rebalance of one account"""
+    weights: List[float]
+    trades: List[float]
+    objective: float
+    transaction_cost: float
+    turnover: float
+    iterations: int
+    converged: bool
+    warm_start: RebalanceWarmStart
 
 
 class RiskEngineWrapper:
@@ -83,7 +594,13 @@ class RiskEngineWrapper:
         assets: List[PortfolioAsset],
         correlation_matrix: Optional[List[List[float]]] = None,
         num_simulations: Optional[int] = None,
-        time_horizon_days: Optional[int] = None
+        time_horizon_days: Optional[int] = None,
+        benchmark_weights: Optional[List[float]] = None,
+        pca_retained_variance: Optional[float] = None,
+        average_daily_volume: Optional[List[float]] = None,
+        portfolio_value: Optional[float] = None,
+        sentiment_loadings: Optional[List[float]] = None,
+        sentiment_drift: Optional[List[float]] = None
     ) -> RiskMetrics:
         """
         Calculate VaR and CVaR for a given portfolio
@@ -93,6 +610,12 @@ class RiskEngineWrapper:
             correlation_matrix: Asset correlation matrix (optional, defaults to identity)
             num_simulations: Number of simulations (optional, uses instance default)
             time_horizon_days: Time horizon in days (optional, uses instance default)
+            benchmark_weights: Benchmark weights per asset for active risk (optional)
+            pca_retained_variance: Simulate on principal components retaining this share of variance (optional)
+            average_daily_volume: Traded value per day of each asset, for liquidity-adjusted VaR (optional)
+            portfolio_value: Portfolio value in the currency of the volumes (required with volumes)
+            sentiment_loadings: Annual return vol per unit sentiment shock of each asset (optional)
+            sentiment_drift: Annual expected-return tilt from today's sentiment per asset (optional)
             
         Returns:
             RiskMetrics object containing calculated risk measures
@@ -113,6 +636,20 @@ class RiskEngineWrapper:
         if len(correlation_matrix) != len(assets) or len(correlation_matrix[0]) != len(assets):
             raise ValueError("Correlation matrix dimensions must match number of assets")
         
+        if benchmark_weights is not None and len(benchmark_weights) != len(assets):
+            raise ValueError("Benchmark weights must match number of assets")
+        
+        if average_daily_volume is not None:
+            if len(average_daily_volume) != len(assets):
+                raise ValueError("Average daily volumes must match number of assets")
+            if portfolio_value is None or portfolio_value <= 0:
+                raise ValueError("A positive portfolio value is required for liquidity-adjusted VaR")
+        
+        if sentiment_loadings is not None and len(sentiment_loadings) != len(assets):
+            raise ValueError("Sentiment loadings must match number of assets")
+        if sentiment_drift is not None and (sentiment_loadings is None or len(sentiment_drift) != len(assets)):
+            raise ValueError("Sentiment drift needs loadings and must match number of assets")
+        
         # Extract asset data for C++ function
         asset_names = [asset.asset_name for asset in assets]
         weights = [asset.weight for asset in assets]
@@ -128,7 +665,13 @@ class RiskEngineWrapper:
                 volatilities=volatilities,
                 correlation_matrix=correlation_matrix,
                 num_simulations=sims,
-                time_horizon=horizon_years
+                time_horizon=horizon_years,
+                benchmark_weights=benchmark_weights or [],
+                pca_retained_variance=pca_retained_variance or 0.0,
+                average_daily_volume=average_daily_volume or [],
+                portfolio_value=portfolio_value or 0.0,
+                sentiment_loadings=sentiment_loadings or [],
+                sentiment_drift=sentiment_drift or []
             )
             
             # Calculate simulation summary statistics
@@ -152,12 +695,228 @@ class RiskEngineWrapper:
                 portfolio_vol=cpp_result.portfolio_vol,
                 num_simulations=sims,
                 time_horizon_days=horizon_days,
-                simulation_summary=simulation_summary
+                simulation_summary=simulation_summary,
+                tracking_error=cpp_result.tracking_error if benchmark_weights else None,
+                active_var_95=cpp_result.active_var_95 if benchmark_weights else None,
+                active_var_99=cpp_result.active_var_99 if benchmark_weights else None,
+                analytic_active_var_95=cpp_result.analytic_active_var_95 if benchmark_weights else None,
+                analytic_active_var_99=cpp_result.analytic_active_var_99 if benchmark_weights else None,
+                pca_factors=cpp_result.pca_factors if pca_retained_variance else None,
+                pca_retained_variance=cpp_result.pca_retained_variance if pca_retained_variance else None,
+                pca_truncation_error=cpp_result.pca_truncation_error if pca_retained_variance else None,
+                liquidity_var_95=cpp_result.liquidity_var_95 if average_daily_volume else None,
+                liquidity_var_99=cpp_result.liquidity_var_99 if average_daily_volume else None,
+                liquidation_cost=cpp_result.liquidation_cost if average_daily_volume else None,
+                liquidation_days=cpp_result.liquidation_days if average_daily_volume else None
             )
             
         except Exception as e:
             raise RuntimeError(f"Risk calculation failed: {str(e)}")
     
+    def optimize_cardinality(
+        self,
+        asset_names: List[str],
+        expected_returns: List[float],
+        volatilities: List[float],
+        correlation_matrix: Optional[List[List[float]]] = None,
+        max_assets: int = 10,
+        min_weight: float = 0.0,
+        max_weight: float = 1.0,
+        risk_aversion: float = 1.0,
+        prices: Optional[List[float]] = None,
+        portfolio_value: float = 0.0,
+        time_limit_seconds: float = 5.0
+    ) -> CardinalityOptimizationResult:
+        """
+        Mean-variance optimization with at most max_assets holdings and whole-share quantities
+        
+        Args:
+            asset_names: Asset identifiers
+            expected_returns: Expected annual returns
+            volatilities: Annual volatilities
+            correlation_matrix: Asset correlation matrix (optional, defaults to identity)
+            max_assets: Maximum number of holdings (K)
+            min_weight: Minimum weight of any held asset
+            max_weight: Maximum weight of any single asset
+            risk_aversion: Mean-variance risk aversion
+            prices: Per-asset prices, required when portfolio_value is set
+            portfolio_value: Portfolio value used to round to whole shares (0 disables rounding)
+            time_limit_seconds: Search budget; the best portfolio found so far is returned when exceeded
+            
+        Returns:
+            CardinalityOptimizationResult with weights keyed by asset name
+        """
+        n = len(asset_names)
+        if len(expected_returns) != n or len(volatilities) != n:
+            raise ValueError("All asset vectors must have the same size")
+        if correlation_matrix is None:
+            correlation_matrix = self.create_identity_correlation_matrix(n)
+        if portfolio_value > 0 and (prices is None or len(prices) != n):
+            raise ValueError("Prices for every asset are required for whole-share rounding")
+        
+        constraints = risk_engine_cpp.CardinalityConstraints()
+        constraints.max_assets = max_assets
+        constraints.min_weight = min_weight
+        constraints.max_weight = max_weight
+        constraints.risk_aversion = risk_aversion
+        constraints.portfolio_value = portfolio_value
+        constraints.time_limit_seconds = time_limit_seconds
+        
+        optimizer = risk_engine_cpp.CardinalityConstrainedOptimizer(
+            expected_returns, volatilities, correlation_matrix, prices or []
+        )
+        result = optimizer.optimize(constraints)
+        
+        quantities = None
+        if result.quantities:
+            quantities = {name: q for name, q in zip(asset_names, result.quantities) if q > 0}
+        
+        return CardinalityOptimizationResult(
+            weights={name: w for name, w in zip(asset_names, result.weights) if w > 0},
+            quantities=quantities,
+            cash_residual=result.cash_residual,
+            objective=result.objective,
+            lower_bound=result.lower_bound,
+            expected_return=result.expected_return,
+            portfolio_vol=result.portfolio_vol,
+            nodes_explored=result.nodes_explored,
+            proven_optimal=result.proven_optimal,
+            timed_out=result.timed_out,
+            rounded=result.rounded
+        )
+    
+    def minimize_tracking_error(
+        self,
+        assets: List[PortfolioAsset],
+        benchmark_weights: List[float],
+        account_weights: List[List[float]],
+        correlation_matrix: Optional[List[List[float]]] = None,
+        max_turnover: float = 0.2,
+        max_weight: float = 1.0
+    ) -> List[Dict[str, Any]]:
+        """
+        Minimum tracking-error rebalance for a batch of accounts against one benchmark
+        
+        All accounts share the engine's cached Cholesky factor, so the batch is solved
+        in parallel in C++ without refactoring the covariance per account.
+        
+        Args:
+            assets: Asset universe (weights are ignored, only returns and volatilities are used)
+            benchmark_weights: Benchmark weights per asset
+            account_weights: Current weights of each account
+            correlation_matrix: Asset correlation matrix (optional, defaults to identity)
+            max_turnover: Maximum sum of absolute weight changes per account
+            max_weight: Maximum weight of any single asset
+            
+        Returns:
+            List of dictionaries with optimized weights, tracking error and turnover per account
+        """
+        if len(benchmark_weights) != len(assets):
+            raise ValueError("Benchmark weights must match number of assets")
+        if correlation_matrix is None:
+            correlation_matrix = self.create_identity_correlation_matrix(len(assets))
+        
+        cpp_assets = [
+            risk_engine_cpp.create_portfolio_asset(
+                asset.asset_name, bench, asset.expected_return, asset.volatility
+            )
+            for asset, bench in zip(assets, benchmark_weights)
+        ]
+        engine = risk_engine_cpp.MonteCarloRiskEngine(
+            cpp_assets, correlation_matrix, self.num_simulations, self.time_horizon
+        )
+        engine.set_benchmark_weights(benchmark_weights)
+        results = engine.minimize_tracking_error_batch(account_weights, max_turnover, max_weight)
+        
+        return [
+            {
+                "weights": result.weights,
+                "tracking_error": result.tracking_error,
+                "turnover": result.turnover
+            }
+            for result in results
+        ]
+    
+    def rebalance(
+        self,
+        expected_returns: List[float],
+        volatilities: List[float],
+        account_weights: List[List[float]],
+        correlation_matrix: Optional[List[List[float]]] = None,
+        linear_costs: Optional[List[float]] = None,
+        impact_costs: Optional[List[float]] = None,
+        no_trade_bands: Optional[List[float]] = None,
+        risk_aversion: float = 1.0,
+        turnover_penalty: float = 0.0,
+        max_weight: float = 1.0,
+        warm_starts: Optional[List[Optional[RebalanceWarmStart]]] = None
+    ) -> List[RebalanceAccountResult]:
+        """
+        Mean-variance rebalance of a batch of accounts net of transaction costs
+        
+        The accounts share one factorized ADMM system and are solved in parallel in C++.
+        Each result carries the account's final iterates; passing them back as warm_starts
+        on the next rebalance starts from that solution and typically converges in a
+        fraction of the iterations.
+        
+        Args:
+            expected_returns: Expected annual returns
+            volatilities: Annual volatilities
+            account_weights: Current weights of each account
+            correlation_matrix: Asset correlation matrix (optional, defaults to identity)
+            linear_costs: Per-asset cost per unit of weight traded (optional, defaults to zero)
+            impact_costs: Per-asset quadratic market-impact coefficient (optional, defaults to zero)
+            no_trade_bands: Per-asset band inside which trades are suppressed (optional, defaults to zero)
+            risk_aversion: Mean-variance risk aversion
+            turnover_penalty: Uniform L1 turnover penalty added to the linear costs
+            max_weight: Maximum weight of any single asset
+            warm_starts: Previous iterates per account; None entries start cold
+            
+        Returns:
+            List of RebalanceAccountResult, one per account in input order
+        """
+        n = len(expected_returns)
+        if correlation_matrix is None:
+            correlation_matrix = self.create_identity_correlation_matrix(n)
+        if warm_starts is not None and len(warm_starts) != len(account_weights):
+            raise ValueError("One warm start (or None) is required per account")
+        
+        costs = risk_engine_cpp.RebalanceCosts()
+        costs.linear = linear_costs if linear_costs is not None else [0.0] * n
+        costs.impact = impact_costs if impact_costs is not None else [0.0] * n
+        costs.no_trade = no_trade_bands if no_trade_bands is not None else [0.0] * n
+        settings = risk_engine_cpp.RebalanceSettings()
+        settings.risk_aversion = risk_aversion
+        settings.turnover_penalty = turnover_penalty
+        settings.max_weight = max_weight
+        
+        solver = risk_engine_cpp.RebalanceSolver(
+            expected_returns, volatilities, correlation_matrix, costs, settings
+        )
+        states = []
+        for k in range(len(account_weights)):
+            state = risk_engine_cpp.RebalanceState()
+            previous = warm_starts[k] if warm_starts is not None else None
+            if previous is not None:
+                state.z = previous.z
+                state.u = previous.u
+            states.append(state)
+        results = solver.solve_batch(account_weights, states)
+        
+        return [
+            RebalanceAccountResult(
+                weights=result.weights,
+                trades=result.trades,
+                objective=result.objective,
+                transaction_cost=result.transaction_cost,
+                turnover=result.turnover,
+                iterations=result.iterations,
+                converged=result.converged,
+                warm_start=RebalanceWarmStart(z=state.z, u=state.u)
+            )
+            for result, state in zip(results, states)
+        ]
+    
     def _calculate_skewness(self, data: List[float]) -> float:
         """Calculate skewness of simulation results"""
         data_array = np.array(data)
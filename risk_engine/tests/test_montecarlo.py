@@ -14,6 +14,7 @@ sys.path.append('../python')
 
 from main import app
 from risk_wrapper import RiskEngineWrapper, PortfolioAsset, calculate_portfolio_risk
+import risk_engine_cpp
 
 # Create test client
 client = TestClient(app)
@@ -259,6 +260,25 @@ class TestFastAPIEndpoints:
         response = client.post("/calculate-risk", json=request_data)
         assert response.status_code == 422  # Validation error
     
+    def test_calculate_risk_endpoint_indefinite_correlation(self):
+        """Pairwise-valid correlations that are jointly inconsistent are rejected"""
+        request_data = {
+            "assets": [
+                {"asset_name": "A", "weight": 0.4, "expected_return": 0.1, "volatility": 0.2},
+                {"asset_name": "B", "weight": 0.3, "expected_return": 0.1, "volatility": 0.2},
+                {"asset_name": "C", "weight": 0.3, "expected_return": 0.1, "volatility": 0.2}
+            ],
+            "correlation_matrix": [
+                [1.0, 0.9, -0.9],
+                [0.9, 1.0, 0.9],
+                [-0.9, 0.9, 1.0]
+            ]
+        }
+        
+        response = client.post("/calculate-risk", json=request_data)
+        assert response.status_code == 422
+        assert "positive definite" in response.text
+    
     def test_extreme_parameters(self):
         """Test with extreme but valid parameters"""
         request_data = {
@@ -321,6 +341,1388 @@ class TestEdgeCases:
         assert result.portfolio_vol < 0.175  # Should be less than average of individual volatilities
 
 
+
+class TestCardinalityOptimizer:
+    """Test the cardinality- and lot-constrained optimizer"""
+    
+    def setup_method(self):
+        self.engine = RiskEngineWrapper()
+        self.names = [f"A{i}" for i in range(8)]
+        self.expected_returns = [0.05 + 0.01 * i for i in range(8)]
+        self.volatilities = [0.15 + 0.02 * i for i in range(8)]
+        self.correlation = [[1.0 if i == j else 0.3 for j in range(8)] for i in range(8)]
+    
+    def test_respects_cardinality(self):
+        """At most max_assets holdings, fully invested, within weight bounds"""
+        result = self.engine.optimize_cardinality(
+            self.names, self.expected_returns, self.volatilities, self.correlation,
+            max_assets=3, min_weight=0.05, max_weight=0.6, risk_aversion=3.0
+        )
+        
+        assert len(result.weights) <= 3
+        assert abs(sum(result.weights.values()) - 1.0) < 1e-6
+        assert all(0.05 - 1e-6 <= w <= 0.6 + 1e-6 for w in result.weights.values())
+        assert result.proven_optimal
+        assert result.lower_bound <= result.objective + 1e-9
+    
+    def test_whole_share_quantities(self):
+        """Whole-share rounding never spends more than the portfolio value"""
+        prices = [10.0 + 7.0 * i for i in range(8)]
+        result = self.engine.optimize_cardinality(
+            self.names, self.expected_returns, self.volatilities, self.correlation,
+            max_assets=4, risk_aversion=3.0, prices=prices, portfolio_value=10000.0
+        )
+        
+        assert result.quantities is not None
+        assert all(q == int(q) for q in result.quantities.values())
+        assert result.cash_residual >= 0
+        assert sum(result.weights.values()) <= 1.0 + 1e-9
+    
+    def test_rounding_keeps_bounds(self):
+        """Coarse lots stay within the weight bounds and are not reported as proven optimal"""
+        prices = [900.0 + 130.0 * i for i in range(8)]
+        result = self.engine.optimize_cardinality(
+            self.names, self.expected_returns, self.volatilities, self.correlation,
+            max_assets=4, min_weight=0.15, max_weight=0.4, risk_aversion=3.0,
+            prices=prices, portfolio_value=10000.0
+        )
+        
+        assert result.rounded
+        assert not result.proven_optimal
+        assert len(result.weights) <= 4
+        assert all(0.15 - 1e-9 <= w <= 0.4 + 1e-9 for w in result.weights.values())
+        assert result.cash_residual >= 0
+    
+    def test_infeasible_constraints(self):
+        """max_assets * max_weight < 1 cannot be fully invested"""
+        with pytest.raises(ValueError):
+            self.engine.optimize_cardinality(
+                self.names, self.expected_returns, self.volatilities, self.correlation,
+                max_assets=2, max_weight=0.3
+            )
+
+
+
+class TestTrackingError:
+    """Test benchmark-relative risk and the min-tracking-error optimizer"""
+    
+    def setup_method(self):
+        self.engine = RiskEngineWrapper(num_simulations=20000)
+        self.assets = [
+            PortfolioAsset(asset_name="Asset1", weight=0.5, expected_return=0.10, volatility=0.20),
+            PortfolioAsset(asset_name="Asset2", weight=0.3, expected_return=0.08, volatility=0.15),
+            PortfolioAsset(asset_name="Asset3", weight=0.2, expected_return=0.06, volatility=0.10)
+        ]
+        self.correlation = [[1.0, 0.4, 0.2], [0.4, 1.0, 0.3], [0.2, 0.3, 1.0]]
+    
+    def test_active_risk_metrics(self):
+        """Monte Carlo active VaR agrees with the analytic delta-normal value"""
+        result = self.engine.calculate_risk_metrics(
+            self.assets, self.correlation, benchmark_weights=[0.3, 0.3, 0.4]
+        )
+        
+        assert result.tracking_error > 0
+        assert result.active_var_95 == pytest.approx(result.analytic_active_var_95, rel=0.1)
+        assert result.active_var_99 > result.active_var_95
+    
+    def test_no_benchmark(self):
+        """Active metrics are omitted without a benchmark"""
+        result = self.engine.calculate_risk_metrics(self.assets, self.correlation)
+        assert result.tracking_error is None
+    
+    def test_minimize_tracking_error_batch(self):
+        """Optimized accounts respect turnover and weight bounds and reduce tracking error"""
+        benchmark = np.array([0.3, 0.3, 0.4])
+        accounts = [[0.5, 0.3, 0.2], [0.2, 0.2, 0.6], [0.3, 0.3, 0.4]]
+        results = self.engine.minimize_tracking_error(
+            self.assets, list(benchmark), accounts, self.correlation, max_turnover=0.1, max_weight=0.55
+        )
+        
+        vols = np.array([asset.volatility for asset in self.assets])
+        covariance = np.outer(vols, vols) * np.array(self.correlation)
+        
+        def tracking_error(weights):
+            active = np.array(weights) - benchmark
+            return float(np.sqrt(active @ covariance @ active))
+        
+        assert len(results) == 3
+        for account, result in zip(accounts, results):
+            weights = np.array(result["weights"])
+            assert abs(weights.sum() - 1.0) < 1e-8
+            assert np.all(weights >= -1e-9) and np.all(weights <= 0.55 + 1e-9)
+            assert result["turnover"] <= 0.1 + 1e-8
+            assert np.abs(weights - np.array(account)).sum() == pytest.approx(result["turnover"], abs=1e-8)
+        for index in (0, 1):
+            assert tracking_error(results[index]["weights"]) < tracking_error(accounts[index]) - 1e-4
+        assert results[2]["tracking_error"] == pytest.approx(0.0, abs=1e-9)
+
+
+
+class TestRebalanceSolver:
+    """Test the turnover- and transaction-cost-aware rebalancing solver"""
+    
+    def setup_method(self):
+        n = 4
+        self.expected_returns = [0.06, 0.08, 0.10, 0.12]
+        self.volatilities = [0.10, 0.15, 0.20, 0.25]
+        self.correlation = [[1.0 if i == j else 0.2 for j in range(n)] for i in range(n)]
+        self.current = [0.25, 0.25, 0.25, 0.25]
+    
+    def make_solver(self, linear_cost, no_trade=0.0):
+        costs = risk_engine_cpp.RebalanceCosts()
+        costs.linear = [linear_cost] * 4
+        costs.impact = [0.01] * 4
+        costs.no_trade = [no_trade] * 4
+        settings = risk_engine_cpp.RebalanceSettings()
+        settings.risk_aversion = 3.0
+        return risk_engine_cpp.RebalanceSolver(
+            self.expected_returns, self.volatilities, self.correlation, costs, settings
+        )
+    
+    def test_costs_reduce_turnover(self):
+        """Higher linear costs never increase turnover"""
+        cheap = self.make_solver(0.0).solve(self.current, risk_engine_cpp.RebalanceState())
+        costly = self.make_solver(0.05).solve(self.current, risk_engine_cpp.RebalanceState())
+        
+        assert cheap.converged and costly.converged
+        assert abs(sum(cheap.weights) - 1.0) < 1e-9
+        assert costly.turnover <= cheap.turnover + 1e-9
+    
+    def test_no_trade_zone(self):
+        """Trades inside the no-trade band are suppressed"""
+        result = self.make_solver(0.001, no_trade=0.5).solve(self.current, risk_engine_cpp.RebalanceState())
+        assert result.turnover == pytest.approx(0.0, abs=1e-9)
+    
+    def test_warm_started_batch(self):
+        """Batch solves update per-account state and warm starts converge faster"""
+        solver = self.make_solver(0.002)
+        accounts = [self.current, [0.4, 0.3, 0.2, 0.1]]
+        states = [risk_engine_cpp.RebalanceState() for _ in accounts]
+        
+        cold = solver.solve_batch(accounts, states)
+        assert all(len(state.z) == 4 for state in states)
+        warm = solver.solve_batch(accounts, states)
+        
+        for c, w in zip(cold, warm):
+            assert w.iterations <= c.iterations
+            assert w.weights == pytest.approx(c.weights, abs=1e-5)
+    
+    def test_wrapper_and_endpoint_carry_warm_starts(self):
+        """Warm starts returned by one rebalance cut the iterations of the next, in Python and over HTTP"""
+        accounts = [self.current, [0.4, 0.3, 0.2, 0.1]]
+        kwargs = dict(expected_returns=self.expected_returns, volatilities=self.volatilities,
+                      account_weights=accounts, correlation_matrix=self.correlation,
+                      linear_costs=[0.002] * 4, impact_costs=[0.01] * 4, risk_aversion=3.0)
+        wrapper = RiskEngineWrapper()
+        cold = wrapper.rebalance(**kwargs)
+        warm = wrapper.rebalance(warm_starts=[result.warm_start for result in cold], **kwargs)
+        
+        for c, w in zip(cold, warm):
+            assert c.converged and w.converged
+            assert w.iterations <= c.iterations
+            assert w.weights == pytest.approx(c.weights, abs=1e-5)
+        
+        response = client.post("/rebalance", json=kwargs)
+        assert response.status_code == 200
+        first = response.json()
+        assert len(first) == 2
+        assert first[0]["weights"] == pytest.approx(cold[0].weights, abs=1e-9)
+        response = client.post("/rebalance", json=dict(kwargs, warm_starts=[r["warm_start"] for r in first]))
+        assert response.status_code == 200
+        assert [r["iterations"] for r in response.json()] == [w.iterations for w in warm]
+        
+        response = client.post("/rebalance", json=dict(kwargs, linear_costs=[0.002] * 3))
+        assert response.status_code == 400
+
+
+
+class TestOptionPositions:
+    """Test Black-Scholes pricing and option revaluation in the engine"""
+    
+    def make_option(self, is_call=True, quantity=100.0):
+        option = risk_engine_cpp.EuropeanOption()
+        option.name = "AAPL_C100"
+        option.underlying = 0
+        option.is_call = is_call
+        option.spot = 100.0
+        option.strike = 100.0
+        option.maturity = 1.0
+        option.volatility = 0.2
+        option.rate = 0.05
+        option.quantity = quantity
+        return option
+    
+    def test_black_scholes_reference_prices(self):
+        """Prices match the textbook at-the-money values and put-call parity"""
+        call = risk_engine_cpp.black_scholes_greeks(self.make_option(True))
+        put = risk_engine_cpp.black_scholes_greeks(self.make_option(False))
+        
+        assert call.price == pytest.approx(10.4506, abs=1e-4)
+        assert put.price == pytest.approx(5.5735, abs=1e-4)
+        assert call.price - put.price == pytest.approx(100.0 - 100.0 * np.exp(-0.05), abs=1e-10)
+        assert call.delta - put.delta == pytest.approx(1.0, abs=1e-12)
+    
+    def test_revaluation_modes_agree_for_short_horizon(self):
+        """Delta-gamma and full revaluation give similar 1-day VaR"""
+        assets = [
+            risk_engine_cpp.create_portfolio_asset("AAPL", 0.6, 0.10, 0.25),
+            risk_engine_cpp.create_portfolio_asset("BOND", 0.4, 0.03, 0.05)
+        ]
+        engine = risk_engine_cpp.MonteCarloRiskEngine(assets, [[1.0, 0.1], [0.1, 1.0]], 50000)
+        linear = engine.run_simulation()
+        
+        options = [self.make_option(False, quantity=200.0)]
+        engine.set_option_positions(options, 100000.0, risk_engine_cpp.OptionRevaluation.DELTA_GAMMA)
+        delta_gamma = engine.run_simulation()
+        engine.set_option_positions(options, 100000.0, risk_engine_cpp.OptionRevaluation.FULL)
+        full = engine.run_simulation()
+        
+        # Protective puts reduce the loss tail
+        assert full.var_99 < linear.var_99
+        assert delta_gamma.var_99 == pytest.approx(full.var_99, rel=0.05)
+
+
+class TestYieldCurveFactors:
+    """Test bond positions driven by Nelson-Siegel curve factors"""
+    
+    def make_model(self, bonds):
+        model = risk_engine_cpp.YieldCurveFactorModel()
+        model.factor_volatilities = [0.01, 0.0, 0.0]
+        model.factor_correlation = [[1.0, 0.0, 0.0], [0.0, 1.0, 0.0], [0.0, 0.0, 1.0]]
+        model.asset_correlation = [[-0.3, 0.0, 0.0]]
+        model.decay = 2.0
+        model.key_rate_tenors = [2.0, 5.0, 10.0]
+        model.bonds = bonds
+        return model
+    
+    def make_bond(self, duration, key_rate_durations=()):
+        bond = risk_engine_cpp.BondPosition()
+        bond.name = "UST10"
+        bond.weight = 1.0
+        bond.maturity = 10.0
+        bond.yield_to_maturity = 0.0
+        bond.duration = duration
+        bond.convexity = 0.0
+        bond.key_rate_durations = list(key_rate_durations)
+        return bond
+    
+    def test_duration_var_matches_parallel_shift(self):
+        """A pure level shock gives VaR of z * duration * rate vol"""
+        assets = [risk_engine_cpp.create_portfolio_asset("EQ", 0.0, 0.05, 0.2)]
+        engine = risk_engine_cpp.MonteCarloRiskEngine(assets, [[1.0]], 200000, 1.0)
+        engine.set_yield_curve_model(self.make_model([self.make_bond(5.0)]))
+        metrics = engine.run_simulation()
+        
+        assert metrics.portfolio_vol == pytest.approx(0.05, rel=1e-9)
+        assert metrics.var_99 == pytest.approx(2.3263 * 0.05, rel=0.03)
+        
+        # Key-rate durations summing to the same total see the same level shock
+        engine.set_yield_curve_model(self.make_model([self.make_bond(0.0, [1.0, 1.0, 3.0])]))
+        assert engine.run_simulation().portfolio_vol == pytest.approx(0.05, rel=1e-9)
+    
+    def test_invalid_joint_correlation(self):
+        """Inconsistent asset-factor correlations are rejected"""
+        assets = [risk_engine_cpp.create_portfolio_asset("EQ", 1.0, 0.05, 0.2)]
+        engine = risk_engine_cpp.MonteCarloRiskEngine(assets, [[1.0]], 1000)
+        model = self.make_model([self.make_bond(5.0)])
+        model.asset_correlation = [[0.9, 0.9, 0.9]]
+        with pytest.raises(ValueError):
+            engine.set_yield_curve_model(model)
+        engine.run_simulation()
+
+
+class TestStreamingRiskService:
+    """Test incremental delta-normal VaR on streamed price ticks"""
+    
+    def make_service(self):
+        return risk_engine_cpp.StreamingRiskService(
+            [0.10, 0.05], [0.30, 0.20], [[1.0, 0.4], [0.4, 1.0]], [100.0, 50.0])
+    
+    def expected_var(self, exposures):
+        x = np.array(exposures)
+        vols = np.array([0.30, 0.20])
+        cov = np.outer(vols, vols) * np.array([[1.0, 0.4], [0.4, 1.0]])
+        mean = np.dot([0.10, 0.05], x) / 252.0
+        return 2.3263478740408408 * np.sqrt(x @ cov @ x / 252.0) - mean
+    
+    def test_incremental_var_matches_recompute(self):
+        """Thousands of incremental updates agree with the closed form"""
+        service = self.make_service()
+        portfolio = service.add_portfolio([10.0, 20.0])
+        for k in range(3000):
+            service.push_tick(0, 100.0 + k % 7)
+            service.push_tick(1, 50.0 + k % 3)
+            service.process_pending()
+        
+        risk = service.get_risk(portfolio)
+        exposures = [10.0 * (100.0 + 2999 % 7), 20.0 * (50.0 + 2999 % 3)]
+        assert risk.value == pytest.approx(sum(exposures), rel=1e-12)
+        assert risk.delta_normal_var == pytest.approx(self.expected_var(exposures), rel=1e-9)
+        
+        service.refresh_monte_carlo(1)
+        refreshed = service.get_risk(portfolio)
+        assert refreshed.monte_carlo_valid
+        assert refreshed.monte_carlo_var == pytest.approx(refreshed.delta_normal_var, rel=0.1)
+    
+    def test_threshold_alerts_and_dropped_ticks(self):
+        """Subscribers hear about crossings in both directions; bad ticks are dropped"""
+        service = self.make_service()
+        portfolio = service.add_portfolio([10.0, 20.0])
+        alerts = []
+        service.subscribe(portfolio, 80.0, alerts.append)
+        
+        service.push_tick(0, 200.0)
+        service.process_pending()
+        service.push_tick(0, 100.0)
+        service.process_pending()
+        
+        assert [alert.breached for alert in alerts] == [True, False]
+        
+        # Position changes are checked on the next consumer pass, not on the caller's thread
+        service.set_positions(portfolio, [20.0, 40.0])
+        assert len(alerts) == 2
+        service.process_pending()
+        assert [alert.breached for alert in alerts] == [True, False, True]
+        assert not service.push_tick(5, 10.0)
+        assert not service.push_tick(0, -1.0)
+        assert service.get_stats().ticks_dropped == 2
+    
+    def test_background_threads(self):
+        """Ticks pushed while running are applied by the consumer thread"""
+        service = self.make_service()
+        portfolio = service.add_portfolio([10.0, 20.0])
+        service.start()
+        ticks = [risk_engine_cpp.PriceTick(k % 2, 100.0 + k % 5 if k % 2 == 0 else 50.0) for k in range(10000)]
+        assert service.push_ticks(ticks) == len(ticks)
+        service.stop()
+        
+        assert service.get_stats().ticks_processed == len(ticks)
+        assert service.get_risk(portfolio).value == pytest.approx(10.0 * 103.0 + 20.0 * 50.0)
+    
+    def test_reposition_during_refresh_discards_stale_var(self):
+        """A refresh that raced a position change does not mark the new positions as revalued"""
+        import threading
+        config = risk_engine_cpp.StreamingRiskConfig()
+        config.mc_simulations = 2000000
+        service = risk_engine_cpp.StreamingRiskService(
+            [0.10, 0.05], [0.30, 0.20], [[1.0, 0.4], [0.4, 1.0]], [100.0, 50.0], config)
+        portfolio = service.add_portfolio([10.0, 20.0])
+        
+        refresh = threading.Thread(target=service.refresh_monte_carlo, args=(1,))
+        refresh.start()
+        # Reposition until the refresh returns, so the last change follows its snapshot
+        while refresh.is_alive():
+            service.set_positions(portfolio, [1000.0, 2000.0])
+        refresh.join()
+        assert not service.get_risk(portfolio).monte_carlo_valid
+        
+        service.refresh_monte_carlo(1)
+        refreshed = service.get_risk(portfolio)
+        assert refreshed.monte_carlo_valid
+        assert refreshed.monte_carlo_var == pytest.approx(refreshed.delta_normal_var, rel=0.1)
+
+
+class TestRealizedCovariance:
+    """Test realized covariance estimation from intraday bars"""
+    
+    def simulate_bars(self, noise, num_bars=23400, seed=7):
+        rng = np.random.default_rng(seed)
+        daily_vols = np.array([0.02, 0.01, 0.015])
+        corr = np.array([[1.0, 0.5, 0.5], [0.5, 1.0, 0.5], [0.5, 0.5, 1.0]])
+        shocks = rng.multivariate_normal(np.zeros(3), corr, size=num_bars) * daily_vols / np.sqrt(num_bars)
+        log_prices = np.vstack([np.zeros(3), np.cumsum(shocks, axis=0)])
+        return 100.0 * np.exp(log_prices + noise * rng.standard_normal(log_prices.shape)), daily_vols
+    
+    def test_refresh_time_recovers_covariance(self):
+        """Clean synchronous bars give the true volatilities and a usable correlation matrix"""
+        bars, daily_vols = self.simulate_bars(noise=0.0)
+        settings = risk_engine_cpp.RealizedCovarianceSettings()
+        settings.annualization = 1.0
+        estimator = risk_engine_cpp.RealizedCovarianceEstimator(3, settings)
+        estimator.add_bars(bars.tolist())
+        result = estimator.estimate()
+        
+        assert result.observations == 23400
+        np.testing.assert_allclose(result.volatilities, daily_vols, rtol=0.05)
+        assert result.correlation[0][1] == pytest.approx(0.5, abs=0.05)
+        assert np.all(np.linalg.eigvalsh(np.array(result.correlation)) > 0.0)
+    
+    def test_pre_averaging_removes_noise_bias(self):
+        """Microstructure noise inflates refresh-time variance but not the pre-averaged estimate"""
+        bars, daily_vols = self.simulate_bars(noise=0.0005)
+        settings = risk_engine_cpp.RealizedCovarianceSettings()
+        settings.annualization = 1.0
+        naive = risk_engine_cpp.RealizedCovarianceEstimator(3, settings)
+        naive.add_bars(bars.tolist())
+        settings.method = risk_engine_cpp.RealizedCovarianceMethod.PRE_AVERAGED
+        settings.pre_averaging_window = 90
+        robust = risk_engine_cpp.RealizedCovarianceEstimator(3, settings)
+        robust.add_bars(bars.tolist())
+        
+        assert naive.estimate().volatilities[1] > 5.0 * daily_vols[1]
+        np.testing.assert_allclose(robust.estimate().volatilities, daily_vols, rtol=0.15)
+    
+    def test_rank_deficient_window_is_shrunk(self):
+        """Fewer bars than assets still yields a positive definite correlation matrix"""
+        rng = np.random.default_rng(3)
+        prices = 100.0 * np.exp(np.cumsum(0.001 * rng.standard_normal((11, 30)), axis=0))
+        estimator = risk_engine_cpp.RealizedCovarianceEstimator(30)
+        estimator.add_bars(prices.tolist())
+        result = estimator.estimate()
+        
+        assert result.shrinkage > 0.0
+        assert np.min(np.linalg.eigvalsh(np.array(result.correlation))) >= 1e-6 * 0.99
+        risk_engine_cpp.MonteCarloRiskEngine(
+            [risk_engine_cpp.create_portfolio_asset(str(i), 1.0 / 30, 0.05, v)
+             for i, v in enumerate(result.volatilities)],
+            result.correlation, 1000).run_simulation()
+
+
+class TestFactorSimulation:
+    """Test the symmetric eigensolver and principal-component simulation"""
+    
+    def test_symmetric_eigen(self):
+        """Eigenpairs match numpy and the requested vectors are orthonormal"""
+        rng = np.random.default_rng(11)
+        x = rng.standard_normal((60, 40))
+        matrix = (x.T @ x / 60.0).tolist()
+        values, vectors = risk_engine_cpp.symmetric_eigen(matrix, 5)
+        
+        np.testing.assert_allclose(values, np.sort(np.linalg.eigvalsh(matrix))[::-1], atol=1e-10)
+        v = np.array(vectors)
+        assert v.shape == (40, 5)
+        np.testing.assert_allclose(v.T @ v, np.eye(5), atol=1e-10)
+        np.testing.assert_allclose(np.array(matrix) @ v, v * np.array(values[:5]), atol=1e-10)
+    
+    def test_factor_mode_reports_truncation(self):
+        """A one-factor market is captured by few components with small truncation error"""
+        n = 50
+        corr = np.full((n, n), 0.6)
+        np.fill_diagonal(corr, 1.0)
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 1.0 / n, 0.08, 0.25) for i in range(n)]
+        engine = risk_engine_cpp.MonteCarloRiskEngine(assets, corr.tolist(), 50000)
+        full = engine.run_simulation()
+        
+        engine.set_factor_simulation(0.6)
+        reduced = engine.run_simulation()
+        
+        assert full.pca_factors == 0
+        assert reduced.pca_factors == 1
+        assert reduced.pca_retained_variance == pytest.approx(0.608, abs=1e-9)
+        # The residual term keeps each asset's variance; only the off-diagonal loss shows up
+        assert 0.0 < reduced.pca_truncation_error < 0.01 * full.var_99
+        assert reduced.var_99 == pytest.approx(full.var_99, rel=0.05)
+    
+    def test_truncation_error_includes_option_deltas(self):
+        """The truncation error is measured on the delta-adjusted book, not the equity weights alone"""
+        rho = 0.6
+        assets = [risk_engine_cpp.create_portfolio_asset("A", 0.5, 0.08, 0.2),
+                  risk_engine_cpp.create_portfolio_asset("B", 0.5, 0.05, 0.3)]
+        engine = risk_engine_cpp.MonteCarloRiskEngine(assets, [[1.0, rho], [rho, 1.0]], 20000)
+        option = risk_engine_cpp.EuropeanOption()
+        option.underlying = 0
+        option.is_call = True
+        option.spot = 100.0
+        option.strike = 100.0
+        option.maturity = 1.0
+        option.volatility = 0.2
+        option.rate = 0.05
+        option.quantity = -2000.0
+        engine.set_option_positions([option], 100000.0, risk_engine_cpp.OptionRevaluation.DELTA_GAMMA)
+        engine.set_factor_simulation(0.5)
+        metrics = engine.run_simulation()
+        
+        # One factor of a 2x2 equicorrelation: loadings sqrt((1 + rho) / 2), residual variance (1 - rho) / 2
+        delta = risk_engine_cpp.black_scholes_greeks(option).delta
+        x = np.array([(0.5 + option.quantity * delta * option.spot / 100000.0) * 0.2, 0.5 * 0.3])
+        full = x @ np.array([[1.0, rho], [rho, 1.0]]) @ x
+        truncated = (1 + rho) / 2 * x.sum() ** 2 + (1 - rho) / 2 * (x @ x)
+        expected = 2.3263478740408408 * np.sqrt(1 / 252.0) * abs(np.sqrt(truncated) - np.sqrt(full))
+        assert metrics.pca_factors == 1
+        assert metrics.pca_truncation_error == pytest.approx(expected, rel=1e-9)
+
+
+
+class TestPathSimulation:
+    """Test multi-step path simulation with Sobol points and the Brownian bridge"""
+    
+    def _engine(self):
+        assets = [
+            risk_engine_cpp.create_portfolio_asset("A", 0.5, 0.08, 0.20),
+            risk_engine_cpp.create_portfolio_asset("B", 0.3, 0.05, 0.30),
+            risk_engine_cpp.create_portfolio_asset("C", 0.2, 0.10, 0.25),
+        ]
+        corr = [[1.0, 0.3, 0.2], [0.3, 1.0, 0.5], [0.2, 0.5, 1.0]]
+        return risk_engine_cpp.MonteCarloRiskEngine(assets, corr, 1000)
+    
+    def test_sobol_bridge_mean_return(self):
+        """Randomized Sobol paths built by bridge hit the compounded drift closely"""
+        engine = self._engine()
+        settings = risk_engine_cpp.PathSimulationSettings()
+        settings.num_paths = 4096
+        settings.num_steps = 16
+        settings.horizon = 16 / 252.0
+        settings.sampler = risk_engine_cpp.PathSampler.SOBOL
+        settings.brownian_bridge = True
+        settings.seed = 3
+        result = engine.simulate_paths(settings)
+        
+        step_drift = (0.5 * 0.08 + 0.3 * 0.05 + 0.2 * 0.10) / 252.0
+        assert result.expected_return == pytest.approx((1.0 + step_drift) ** 16 - 1.0, abs=2e-4)
+        assert len(result.path_returns) == 4096
+        assert 0.0 < result.expected_max_drawdown < result.max_drawdown_95
+        assert result.cvar_95 >= result.var_95 > 0.0
+        # Seeded runs are reproducible
+        assert engine.simulate_paths(settings).path_returns == result.path_returns
+    
+    def test_single_step_bridge_is_identity(self):
+        """With one step the bridge leaves the pseudo-random draws unchanged"""
+        engine = self._engine()
+        settings = risk_engine_cpp.PathSimulationSettings()
+        settings.num_paths = 1000
+        settings.num_steps = 1
+        settings.seed = 9
+        incremental = engine.simulate_paths(settings)
+        settings.brownian_bridge = True
+        bridged = engine.simulate_paths(settings)
+        
+        assert bridged.path_returns == incremental.path_returns
+
+
+
+class TestMultilevelMonteCarlo:
+    """Test the multilevel Monte Carlo driver on long-horizon path metrics"""
+    
+    def _engine(self):
+        assets = [
+            risk_engine_cpp.create_portfolio_asset("Equity", 0.6, 0.07, 0.18),
+            risk_engine_cpp.create_portfolio_asset("Bonds", 0.4, 0.03, 0.06),
+        ]
+        return risk_engine_cpp.MonteCarloRiskEngine(assets, [[1.0, 0.2], [0.2, 1.0]], 1000)
+    
+    def test_terminal_wealth_matches_continuous_limit(self):
+        """The level corrections remove the Euler bias of E[W_T] = exp(mu T)"""
+        settings = risk_engine_cpp.MultilevelSettings()
+        settings.target_rmse = 5e-3
+        settings.base_steps = 8
+        settings.seed = 7
+        result = self._engine().estimate_path_metric(risk_engine_cpp.PathMetric.TERMINAL_WEALTH, 30.0, settings)
+        
+        assert result.converged
+        assert result.estimate == pytest.approx(np.exp(0.054 * 30.0), abs=4 * 5e-3)
+        # Sample counts fall with the level as the coupled corrections shrink
+        assert result.samples[0] > result.samples[-1]
+        assert result.single_level_cost > 10 * result.total_cost
+    
+    def test_drawdown_levels(self):
+        """Drawdown estimates converge with few levels and stay a valid fraction"""
+        settings = risk_engine_cpp.MultilevelSettings()
+        settings.target_rmse = 4e-3
+        settings.seed = 3
+        result = self._engine().estimate_path_metric(risk_engine_cpp.PathMetric.MAX_DRAWDOWN, 30.0, settings)
+        
+        assert result.converged
+        assert 0.2 < result.estimate < 0.5
+        assert len(result.level_means) == len(result.samples) >= 3
+        assert result.standard_error < 4e-3
+
+
+
+class TestStratifiedSampling:
+    """Test stratification along the loss direction with the Philox stream"""
+    
+    def _engine(self):
+        n = 20
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 1.0 / n, 0.08, 0.15 + 0.01 * i) for i in range(n)]
+        corr = np.full((n, n), 0.3)
+        np.fill_diagonal(corr, 1.0)
+        return risk_engine_cpp.MonteCarloRiskEngine(assets, corr.tolist(), 20000)
+    
+    def test_philox_stream_is_reproducible(self):
+        """A fixed Philox key reproduces every scenario"""
+        engine = self._engine()
+        settings = risk_engine_cpp.ScenarioSamplingSettings()
+        settings.rng = risk_engine_cpp.ScenarioRng.PHILOX
+        settings.seed = 5
+        engine.set_scenario_sampling(settings)
+        
+        first = engine.run_simulation()
+        second = engine.run_simulation()
+        assert first.simulation_results == second.simulation_results
+        assert first.scenario_weights == []
+        assert first.var_99_std_error == 0.0
+        
+        # Plain Monte Carlo only estimates standard errors on request, without moving the VaR
+        settings.standard_errors = True
+        engine.set_scenario_sampling(settings)
+        third = engine.run_simulation()
+        assert third.var_99 == first.var_99
+        assert third.var_99_std_error > 0.0
+    
+    def test_tail_allocation_reduces_error(self):
+        """Tail-heavy strata give a weighted VaR consistent with plain MC but a smaller error"""
+        engine = self._engine()
+        settings = risk_engine_cpp.ScenarioSamplingSettings()
+        settings.standard_errors = True
+        engine.set_scenario_sampling(settings)
+        plain = engine.run_simulation()
+        
+        settings.rng = risk_engine_cpp.ScenarioRng.PHILOX
+        settings.seed = 11
+        settings.num_strata = 50
+        settings.tail_fraction = 0.04
+        settings.tail_allocation = 0.3
+        engine.set_scenario_sampling(settings)
+        stratified = engine.run_simulation()
+        
+        assert sum(stratified.scenario_weights) == pytest.approx(1.0, rel=1e-12)
+        tolerance = 4 * np.hypot(plain.var_99_std_error, stratified.var_99_std_error)
+        assert stratified.var_99 == pytest.approx(plain.var_99, abs=tolerance)
+        assert stratified.var_99_std_error < 0.5 * plain.var_99_std_error
+        assert stratified.cvar_99_std_error < plain.cvar_99_std_error
+
+
+class TestBlockCorrelation:
+    """Test sector-block correlation models"""
+    
+    def _sector_correlation(self, n, sectors):
+        sector = np.arange(n) % sectors
+        corr = 0.4 + 0.3 * (sector[:, None] == sector[None, :])
+        np.fill_diagonal(corr, 1.0)
+        return corr, sector
+    
+    def test_block_model_matches_dense(self):
+        """A block model of the same matrix gives the dense engine's volatility and VaR"""
+        n, sectors = 60, 6
+        corr, sector = self._sector_correlation(n, sectors)
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 1.0 / n, 0.08, 0.15 + 0.002 * i) for i in range(n)]
+        
+        model = risk_engine_cpp.BlockCorrelationModel()
+        model.blocks = [np.flatnonzero(sector == k).tolist() for k in range(sectors)]
+        model.block_correlations = [corr[np.ix_(b, b)].tolist() for b in model.blocks]
+        model.cross_loadings = [[np.sqrt(0.4)] for _ in range(n)]
+        
+        dense = risk_engine_cpp.MonteCarloRiskEngine(assets, corr.tolist(), 50000).run_simulation()
+        block = risk_engine_cpp.MonteCarloRiskEngine(assets, model, 50000).run_simulation()
+        assert block.portfolio_vol == pytest.approx(dense.portfolio_vol, rel=1e-10)
+        assert block.var_95 == pytest.approx(dense.var_95, rel=0.05)
+    
+    def test_detection_recovers_sectors(self):
+        """Residual correlation after the market factor splits assets into their sectors"""
+        corr, sector = self._sector_correlation(40, 4)
+        model = risk_engine_cpp.detect_block_structure(corr.tolist(), threshold=0.1, cross_rank=1)
+        
+        assert len(model.blocks) == 4
+        for block in model.blocks:
+            assert len(set(sector[block])) == 1
+        assert len(model.cross_loadings) == 40
+
+
+class TestRegimeSwitching:
+    """Test hidden-Markov regime fitting and regime-switching paths"""
+    
+    def _two_regime_returns(self, num_obs=1500, n=5, seed=3):
+        rng = np.random.default_rng(seed)
+        states = np.zeros(num_obs, dtype=int)
+        for t in range(1, num_obs):
+            stay = 0.99 if states[t - 1] == 0 else 0.97
+            states[t] = states[t - 1] if rng.random() < stay else 1 - states[t - 1]
+        vols = np.where(states == 1, 0.025, 0.01)
+        market = rng.standard_normal(num_obs)
+        noise = rng.standard_normal((num_obs, n))
+        returns = vols[:, None] * (np.sqrt(0.4) * market[:, None] + np.sqrt(0.6) * noise)
+        return returns, states
+    
+    def test_fit_recovers_regimes(self):
+        """Baum-Welch separates the calm and turbulent regimes of a simulated history"""
+        returns, states = self._two_regime_returns()
+        settings = risk_engine_cpp.HmmFitSettings()
+        settings.seed = 1
+        fit = risk_engine_cpp.fit_gaussian_hmm(returns.tolist(), settings)
+        
+        assert fit.model.num_regimes == 2
+        vols = [np.sqrt(cov[0][0]) for cov in fit.model.covariances]
+        assert vols[0] == pytest.approx(0.01, rel=0.1)
+        assert vols[1] == pytest.approx(0.025, rel=0.1)
+        turbulent = np.array(fit.regime_probabilities)[:, 1] > 0.5
+        assert np.mean(turbulent == (states == 1)) > 0.95
+        for row in fit.model.transition:
+            assert sum(row) == pytest.approx(1.0)
+    
+    def test_turbulent_start_widens_path_var(self):
+        """Paths starting in the turbulent regime carry more risk and visit it more often"""
+        returns, _ = self._two_regime_returns()
+        settings = risk_engine_cpp.HmmFitSettings()
+        settings.seed = 1
+        model = risk_engine_cpp.fit_gaussian_hmm(returns.tolist(), settings).model
+        
+        n = 5
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 1.0 / n, 0.05, 0.2) for i in range(n)]
+        corr = np.full((n, n), 0.4)
+        np.fill_diagonal(corr, 1.0)
+        engine = risk_engine_cpp.MonteCarloRiskEngine(assets, corr.tolist())
+        path_settings = risk_engine_cpp.PathSimulationSettings()
+        path_settings.num_paths = 20000
+        path_settings.seed = 4
+        
+        engine.set_regime_model(model, [1.0, 0.0])
+        calm = engine.simulate_paths(path_settings)
+        engine.set_regime_model(model, [0.0, 1.0])
+        turbulent = engine.simulate_paths(path_settings)
+        
+        assert sum(calm.regime_occupancy) == pytest.approx(1.0)
+        assert turbulent.regime_occupancy[1] > calm.regime_occupancy[1]
+        assert turbulent.var_95 > 1.5 * calm.var_95
+
+
+class TestConditionalTail:
+    """Test conditional Monte Carlo over Gaussian mixing variables"""
+    
+    horizon = 10.0 / 252.0
+    
+    def _engine(self):
+        n = 10
+        self.vols = 0.15 + 0.01 * np.arange(n)
+        self.corr = np.full((n, n), 0.35)
+        np.fill_diagonal(self.corr, 1.0)
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 1.0 / n, 0.06, self.vols[i]) for i in range(n)]
+        return risk_engine_cpp.MonteCarloRiskEngine(assets, self.corr.tolist(), 50000, self.horizon)
+    
+    def test_no_jumps_is_exact_gaussian(self):
+        """Without jumps every component is the same normal, so VaR and CVaR are closed form"""
+        settings = risk_engine_cpp.ConditionalTailSettings()
+        settings.mixing = risk_engine_cpp.MixingDistribution.JUMP
+        settings.jump_intensity = 0.0
+        settings.seed = 1
+        tail = self._engine().estimate_conditional_tail(settings)
+        
+        z = 2.3263478740408408
+        mean, vol = tail.expected_return, tail.portfolio_vol
+        assert tail.var_99 == pytest.approx(-mean + z * vol, rel=1e-9)
+        assert tail.cvar_99 == pytest.approx(-mean + vol * np.exp(-0.5 * z * z) / np.sqrt(2 * np.pi) / 0.01, rel=1e-9)
+        assert tail.cvar_99_std_error < 1e-9
+    
+    def test_student_t_matches_brute_force(self):
+        """Student-t mixing agrees with plain simulation of the t return at a much smaller error"""
+        engine = self._engine()
+        settings = risk_engine_cpp.ConditionalTailSettings()
+        settings.degrees_of_freedom = 5.0
+        settings.num_draws = 10000
+        settings.seed = 2
+        tail = engine.estimate_conditional_tail(settings)
+        
+        exposure = self.vols / len(self.vols)
+        vol = np.sqrt(exposure @ self.corr @ exposure * self.horizon)
+        rng = np.random.default_rng(0)
+        num = 2_000_000
+        scale = np.sqrt(3.0 / rng.chisquare(5.0, num))
+        losses = -(0.06 * self.horizon + vol * scale * rng.standard_normal(num))
+        var_99 = np.quantile(losses, 0.99)
+        cvar_99 = losses[losses >= var_99].mean()
+        
+        assert tail.var_99 == pytest.approx(var_99, abs=4 * tail.var_99_std_error + 2e-4)
+        assert tail.cvar_99 == pytest.approx(cvar_99, abs=4 * tail.cvar_99_std_error + 4e-4)
+        assert tail.cvar_99_std_error < 0.02 * tail.cvar_99
+
+
+class TestLiquidityAdjustedVaR:
+    """Test liquidity-adjusted VaR with position-dependent exit horizons"""
+    
+    def _engine(self):
+        n = 4
+        self.vols = np.array([0.2, 0.3, 0.6, 0.8])
+        self.corr = np.full((n, n), 0.3)
+        np.fill_diagonal(self.corr, 1.0)
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 0.25, 0.05, self.vols[i]) for i in range(n)]
+        return risk_engine_cpp.MonteCarloRiskEngine(assets, self.corr.tolist(), 200000)
+    
+    def test_liquid_book_only_pays_impact(self):
+        """Positions that clear in a day keep the VaR horizon and add only their impact cost"""
+        engine = self._engine()
+        profile = risk_engine_cpp.LiquidityProfile()
+        profile.portfolio_value = 1e8
+        profile.average_daily_volume = [1e12] * 4
+        engine.set_liquidity_profile(profile)
+        sampling = risk_engine_cpp.ScenarioSamplingSettings()
+        sampling.standard_errors = True
+        engine.set_scenario_sampling(sampling)
+        metrics = engine.run_simulation()
+        
+        assert metrics.liquidation_days == [1.0] * 4
+        assert metrics.liquidity_var_99 == pytest.approx(metrics.var_99 + metrics.liquidation_cost,
+                                                         abs=3 * metrics.var_99_std_error)
+    
+    def test_identity_adjustment_reproduces_var(self):
+        """Free, one-day exits leave every scenario unchanged, so both tails match the plain estimator"""
+        engine = self._engine()
+        sampling = risk_engine_cpp.ScenarioSamplingSettings()
+        sampling.rng = risk_engine_cpp.ScenarioRng.PHILOX
+        sampling.seed = 7
+        engine.set_scenario_sampling(sampling)
+        profile = risk_engine_cpp.LiquidityProfile()
+        profile.portfolio_value = 1e8
+        profile.average_daily_volume = [1e18] * 4
+        profile.impact_coefficient = 0.0
+        engine.set_liquidity_profile(profile)
+        metrics = engine.run_simulation()
+        
+        assert metrics.liquidation_cost == 0.0
+        assert metrics.liquidity_var_95 == metrics.var_95
+        assert metrics.liquidity_var_99 == metrics.var_99
+        assert metrics.liquidity_cvar_95 == pytest.approx(metrics.cvar_95, rel=1e-12)
+        assert metrics.liquidity_cvar_99 == pytest.approx(metrics.cvar_99, rel=1e-12)
+    
+    def test_illiquid_positions_stretch_horizon(self):
+        """Unwinding over many days matches the delta-normal VaR over the stretched horizons"""
+        engine = self._engine()
+        profile = risk_engine_cpp.LiquidityProfile()
+        profile.portfolio_value = 1e8
+        profile.average_daily_volume = [5e9, 1e9, 5e7, 2e7]
+        engine.set_liquidity_profile(profile)
+        metrics = engine.run_simulation()
+        
+        days = np.maximum(1.0, 0.25e8 / (0.1 * np.array(profile.average_daily_volume)))
+        assert metrics.liquidation_days == pytest.approx(days.tolist())
+        variance_days = np.maximum(1.0, (days + 1) * (2 * days + 1) / (6 * days))
+        drift_days = np.maximum(1.0, (days + 1) / 2)
+        exposure = 0.25 * self.vols * np.sqrt(variance_days / 252.0)
+        mean = np.sum(0.25 * 0.05 * drift_days / 252.0)
+        analytic = -mean + metrics.liquidation_cost + 2.3263478740408408 * np.sqrt(exposure @ self.corr @ exposure)
+        assert metrics.liquidity_var_99 == pytest.approx(analytic, rel=0.02)
+        assert metrics.liquidity_var_99 > 2 * metrics.var_99
+
+
+class TestCorrelationValidation:
+    """Test the native correlation check fused with the Cholesky factorization"""
+    
+    def test_reports_first_issue_with_location(self):
+        """Each kind of problem comes back with its entry"""
+        base = [[1.0, 0.5, 0.2], [0.5, 1.0, 0.3], [0.2, 0.3, 1.0]]
+        assert risk_engine_cpp.check_correlation_matrix(base, 3).valid
+        
+        asymmetric = [row[:] for row in base]
+        asymmetric[0][2] = 0.25
+        check = risk_engine_cpp.check_correlation_matrix(asymmetric, 3)
+        assert check.issue == risk_engine_cpp.CorrelationIssue.ASYMMETRIC
+        assert (check.row, check.column) == (2, 0)
+        
+        diagonal = [row[:] for row in base]
+        diagonal[1][1] = 1.1
+        check = risk_engine_cpp.check_correlation_matrix(diagonal, 3)
+        assert check.issue == risk_engine_cpp.CorrelationIssue.DIAGONAL
+        assert check.value == pytest.approx(1.1)
+        
+        check = risk_engine_cpp.check_correlation_matrix(base, 4)
+        assert check.issue == risk_engine_cpp.CorrelationIssue.SHAPE
+    
+    def test_engine_rejects_indefinite_matrix(self):
+        """The engine constructor now refuses matrices without a Cholesky factor"""
+        indefinite = [[1.0, 0.9, -0.9], [0.9, 1.0, 0.9], [-0.9, 0.9, 1.0]]
+        check = risk_engine_cpp.check_correlation_matrix(indefinite, 3)
+        assert check.issue == risk_engine_cpp.CorrelationIssue.NOT_POSITIVE_DEFINITE
+        assert check.row == 2 and check.value < 0
+        
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 1.0 / 3, 0.1, 0.2) for i in range(3)]
+        with pytest.raises(ValueError, match="not positive definite"):
+            risk_engine_cpp.MonteCarloRiskEngine(assets, indefinite)
+
+
+
+class TestConcurrentRequests:
+    """Test one engine shared by request threads (truly parallel on free-threaded Python)"""
+    
+    @staticmethod
+    def _stratified_engine(seed):
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 0.25, 0.08, 0.2 + 0.05 * i) for i in range(4)]
+        correlation = [[1.0 if i == j else 0.3 for j in range(4)] for i in range(4)]
+        engine = risk_engine_cpp.MonteCarloRiskEngine(assets, correlation, 20000)
+        settings = risk_engine_cpp.ScenarioSamplingSettings()
+        settings.rng = risk_engine_cpp.ScenarioRng.PHILOX
+        settings.seed = seed
+        settings.num_strata = 20
+        engine.set_scenario_sampling(settings)
+        return engine
+    
+    def test_parallel_runs_match_serial_run(self):
+        """Stratification plans are per call, so concurrent seeded runs reproduce the serial result"""
+        from concurrent.futures import ThreadPoolExecutor
+        engine = self._stratified_engine(seed=17)
+        serial = engine.run_simulation()
+        with ThreadPoolExecutor(max_workers=8) as pool:
+            results = list(pool.map(lambda _: engine.run_simulation(), range(16)))
+        for result in results:
+            assert result.var_95 == serial.var_95
+            assert result.cvar_99 == serial.cvar_99
+    
+    def test_setters_interleave_with_runs(self):
+        """A run sees the engine either before or after a concurrent horizon change, never a mix"""
+        import threading
+        engine = self._stratified_engine(seed=23)
+        one_day = engine.run_simulation().var_95
+        engine.set_time_horizon(10.0 / 252.0)
+        ten_days = engine.run_simulation().var_95
+        
+        stop = threading.Event()
+        def toggle():
+            while not stop.is_set():
+                engine.set_time_horizon(1.0 / 252.0)
+                engine.set_time_horizon(10.0 / 252.0)
+        toggler = threading.Thread(target=toggle)
+        toggler.start()
+        try:
+            observed = [engine.run_simulation().var_95 for _ in range(20)]
+        finally:
+            stop.set()
+            toggler.join()
+        assert all(v in (one_day, ten_days) for v in observed)
+
+
+
+class TestRuntimeLifecycle:
+    """Test the fork-safety hooks and the shared-table warmup"""
+    
+    def test_forked_child_survives_parent_thread_pool(self):
+        """A child forked after a multi-threaded run falls back to one thread instead of deadlocking"""
+        import os
+        risk_engine_cpp.initialize_runtime(num_threads=2)
+        try:
+            assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 0.25, 0.08, 0.2) for i in range(4)]
+            correlation = [[1.0 if i == j else 0.3 for j in range(4)] for i in range(4)]
+            engine = risk_engine_cpp.MonteCarloRiskEngine(assets, correlation, 20000)
+            engine.run_simulation()
+            
+            read_end, write_end = os.pipe()
+            pid = os.fork()
+            if pid == 0:
+                status = risk_engine_cpp.runtime_status()
+                var_95 = engine.run_simulation().var_95
+                os.write(write_end, f"{status.forked_child},{status.inherited_pool},"
+                                    f"{status.num_threads},{var_95 > 0}".encode())
+                os._exit(0)
+            os.close(write_end)
+            _, exit_status = os.waitpid(pid, 0)
+            report = os.read(read_end, 256).decode()
+            os.close(read_end)
+            assert exit_status == 0
+            assert report == "True,True,1,True"
+            assert not risk_engine_cpp.runtime_status().forked_child
+        finally:
+            risk_engine_cpp.shutdown_runtime()
+    
+    def test_warmup_builds_shared_tables(self):
+        """Warmup fills the Sobol direction table that later sequences reuse"""
+        status = risk_engine_cpp.warmup_runtime(sobol_dimensions=512)
+        assert status.sobol_dimensions >= 512
+        
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 0.25, 0.08, 0.2) for i in range(4)]
+        correlation = [[1.0 if i == j else 0.3 for j in range(4)] for i in range(4)]
+        engine = risk_engine_cpp.MonteCarloRiskEngine(assets, correlation)
+        settings = risk_engine_cpp.PathSimulationSettings()
+        settings.sampler = risk_engine_cpp.PathSampler.SOBOL
+        settings.num_paths = 1024
+        settings.num_steps = 10
+        settings.horizon = 10 / 252
+        settings.seed = 3
+        first = engine.simulate_paths(settings)
+        
+        risk_engine_cpp.shutdown_runtime()
+        assert risk_engine_cpp.runtime_status().sobol_dimensions == 0
+        assert engine.simulate_paths(settings).var_95 == first.var_95
+
+
+class TestSnapshot:
+    """Test saving and mapping warm engine state"""
+    
+    def test_round_trip_restores_caches_models_and_estimators(self, tmp_path):
+        """A mapped snapshot serves the factor cache and restores models and estimators exactly"""
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 0.25, 0.08, 0.2) for i in range(4)]
+        correlation = [[1.0 if i == j else 0.3 for j in range(4)] for i in range(4)]
+        risk_engine_cpp.MonteCarloRiskEngine(assets, correlation)
+        risk_engine_cpp.warmup_runtime(sobol_dimensions=256)
+        
+        model = risk_engine_cpp.GaussianHMM()
+        model.initial_probabilities = [0.6, 0.4]
+        model.transition = [[0.95, 0.05], [0.1, 0.9]]
+        model.means = [[0.001, 0.0005], [-0.002, -0.001]]
+        model.covariances = [[[1e-4, 2e-5], [2e-5, 1e-4]], [[4e-4, 1e-4], [1e-4, 4e-4]]]
+        estimator = risk_engine_cpp.RealizedCovarianceEstimator(2)
+        rng = np.random.default_rng(5)
+        estimator.add_bars((100 * np.exp(np.cumsum(rng.normal(0, 0.01, (200, 2)), axis=0))).tolist())
+        
+        writer = risk_engine_cpp.SnapshotWriter()
+        writer.add_process_caches()
+        writer.add_model("regimes", model)
+        writer.add_estimator("intraday", estimator)
+        path = str(tmp_path / "engine.snap")
+        info = writer.write(path)
+        assert info.factorizations >= 1 and info.sobol_dimensions >= 256
+        
+        risk_engine_cpp.shutdown_runtime()
+        assert risk_engine_cpp.factor_cache_bytes() == 0
+        snapshot = risk_engine_cpp.Snapshot(path)
+        snapshot.install_process_caches()
+        assert risk_engine_cpp.factor_cache_bytes() > 0
+        assert risk_engine_cpp.runtime_status().sobol_dimensions >= 256
+        
+        assert snapshot.model("regimes").covariances == model.covariances
+        restored = snapshot.estimator("intraday")
+        assert restored.num_observations() == estimator.num_observations()
+        assert restored.estimate().covariance == estimator.estimate().covariance
+        risk_engine_cpp.shutdown_runtime()
+    
+    def test_corrupt_snapshot_is_rejected(self, tmp_path):
+        """Flipped or missing bytes fail the checks instead of loading bad state"""
+        writer = risk_engine_cpp.SnapshotWriter()
+        writer.add_estimator("intraday", risk_engine_cpp.RealizedCovarianceEstimator(3))
+        path = tmp_path / "engine.snap"
+        writer.write(str(path))
+        data = bytearray(path.read_bytes())
+        
+        data[130] ^= 0xFF  # Inside the first section, after the header and directory
+        path.write_bytes(bytes(data))
+        with pytest.raises(ValueError):
+            risk_engine_cpp.Snapshot(str(path))
+        
+        path.write_bytes(bytes(data[:100]))
+        with pytest.raises(ValueError):
+            risk_engine_cpp.Snapshot(str(path))
+
+
+class TestHugePageBuffers:
+    """Test huge page backed result buffers and streaming stores"""
+    
+    def _engine(self, scenarios):
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 0.25, 0.08, 0.2) for i in range(4)]
+        correlation = [[1.0 if i == j else 0.3 for j in range(4)] for i in range(4)]
+        engine = risk_engine_cpp.MonteCarloRiskEngine(assets, correlation, scenarios)
+        sampling = risk_engine_cpp.ScenarioSamplingSettings()
+        sampling.rng = risk_engine_cpp.ScenarioRng.PHILOX
+        sampling.seed = 11
+        engine.set_scenario_sampling(sampling)
+        return engine
+    
+    def test_results_independent_of_memory_settings(self):
+        """Page size and store type change where results live, never their values"""
+        engine = self._engine(600000)
+        results = []
+        try:
+            for mode in (risk_engine_cpp.HugePageMode.OFF, risk_engine_cpp.HugePageMode.TRANSPARENT,
+                         risk_engine_cpp.HugePageMode.EXPLICIT):
+                for streaming in (False, True):
+                    settings = risk_engine_cpp.MemorySettings()
+                    settings.huge_pages = mode
+                    settings.streaming_stores = streaming
+                    risk_engine_cpp.set_memory_settings(settings)
+                    result = engine.run_simulation()
+                    results.append((result.var_99, result.cvar_99, result.simulation_results[-1]))
+        finally:
+            risk_engine_cpp.set_memory_settings(risk_engine_cpp.MemorySettings())
+        assert all(r == results[0] for r in results)
+    
+    def test_large_results_are_mapped_separately(self):
+        """Result vectors of a huge page or more get their own mapping, released with the result"""
+        engine = self._engine(600000)
+        before = risk_engine_cpp.memory_stats()
+        result = engine.run_simulation()
+        during = risk_engine_cpp.memory_stats()
+        assert during.mapped_bytes - before.mapped_bytes >= 600000 * 8
+        assert during.mapped_bytes % during.huge_page_size == 0
+        del result
+        assert risk_engine_cpp.memory_stats().mapped_bytes == before.mapped_bytes
+
+
+class TestReproducibleReductions:
+    """Test that seeded results are bit-identical for any thread count"""
+    
+    def _engine(self):
+        assets = [risk_engine_cpp.create_portfolio_asset(f"A{i}", 1 / 6, 0.05 + 0.01 * i, 0.15 + 0.02 * i)
+                  for i in range(6)]
+        correlation = [[1.0 if i == j else 0.4 for j in range(6)] for i in range(6)]
+        return risk_engine_cpp.MonteCarloRiskEngine(assets, correlation, 200000, 10 / 252)
+    
+    def _across_threads(self, run):
+        results = []
+        try:
+            for threads in (1, 2, 3, 8, 32):
+                risk_engine_cpp.initialize_runtime(num_threads=threads)
+                results.append(run())
+        finally:
+            risk_engine_cpp.shutdown_runtime()
+        return results
+    
+    def test_tail_estimates_identical_across_threads(self):
+        """Philox scenarios, stratified tails and path moments reduce the same way on every team size"""
+        engine = self._engine()
+        sampling = risk_engine_cpp.ScenarioSamplingSettings()
+        sampling.rng = risk_engine_cpp.ScenarioRng.PHILOX
+        sampling.seed = 17
+        sampling.num_strata = 8
+        engine.set_scenario_sampling(sampling)
+        paths = risk_engine_cpp.PathSimulationSettings()
+        paths.num_paths = 20000
+        paths.seed = 5
+        
+        def run():
+            metrics = engine.run_simulation()
+            path_metrics = engine.simulate_paths(paths)
+            return (metrics.var_99, metrics.cvar_99, metrics.var_99_std_error, metrics.cvar_95_std_error,
+                    path_metrics.expected_return, path_metrics.cvar_95, path_metrics.probability_of_loss)
+        
+        results = self._across_threads(run)
+        assert all(r == results[0] for r in results)
+    
+    def test_estimators_identical_across_threads(self):
+        """Multilevel level sums and conditional mixture sums do not depend on the thread count"""
+        engine = self._engine()
+        multilevel = risk_engine_cpp.MultilevelSettings()
+        multilevel.seed = 3
+        multilevel.target_rmse = 2e-3
+        conditional = risk_engine_cpp.ConditionalTailSettings()
+        conditional.seed = 4
+        conditional.num_draws = 100000
+        
+        def run():
+            estimate = engine.estimate_path_metric(risk_engine_cpp.PathMetric.MAX_DRAWDOWN, 0.25, multilevel)
+            tail = engine.estimate_conditional_tail(conditional)
+            return estimate.estimate, estimate.standard_error, tail.var_99, tail.cvar_99
+        
+        results = self._across_threads(run)
+        assert all(r == results[0] for r in results)
+
+
+class TestPositionStore:
+    """Test the in-memory position and price store"""
+    
+    @staticmethod
+    def _write_database(path):
+        import sqlite3
+        conn = sqlite3.connect(path)
+        conn.executescript("""
+            CREATE TABLE assets (id INTEGER PRIMARY KEY, portfolio_id INTEGER, name TEXT, symbol TEXT,
+                                 type TEXT, quantity REAL, purchase_price REAL, purchase_date DATE);
+            CREATE TABLE asset_prices (id INTEGER PRIMARY KEY, asset_id INTEGER, price REAL, price_date DATE);
+            INSERT INTO assets VALUES (1, 10, 'Apple', 'AAPL', 'stock', 10, 100, '2024-01-02'),
+                                      (2, 10, 'Treasury ETF', 'TLT', 'bond', 5, 200, '2024-01-02'),
+                                      (3, 11, 'Bitcoin', 'BTC', 'crypto', 0.5, 40000, '2024-01-02');
+            INSERT INTO asset_prices (asset_id, price, price_date) VALUES (1, 100, '2024-01-02'),
+                                                                         (1, 150, '2024-03-01'),
+                                                                         (2, 190, '2024-02-01');
+        """)
+        conn.commit()
+        conn.close()
+    
+    def test_bulk_valuation_matches_per_asset_calculation(self, tmp_path):
+        """Values, weights and allocation use the latest price, or the purchase price when unpriced"""
+        from risk_wrapper import load_position_store
+        path = str(tmp_path / "portfolio.db")
+        self._write_database(path)
+        store = load_position_store(path)
+        assert store.stats().positions == 3 and store.stats().priced_positions == 2
+        
+        first, second, unknown = store.value_portfolios([10, 11, 99])
+        assert first.total_value == pytest.approx(10 * 150 + 5 * 190)
+        assert first.asset_ids == [1, 2]
+        assert first.weights == pytest.approx([1500 / 2450, 950 / 2450])
+        assert first.allocation[int(risk_engine_cpp.AssetType.STOCK)] == pytest.approx(1500 / 2450)
+        assert second.total_value == pytest.approx(20000)
+        assert unknown.total_value == 0.0 and unknown.asset_ids == []
+        assert len(store.value_portfolios()) == 2
+    
+    def test_writes_update_the_store(self, tmp_path):
+        """Refreshing after inserts, updates and deletes tracks the database; stale ticks are ignored"""
+        import sqlite3
+        from risk_wrapper import load_position_store, refresh_positions
+        path = str(tmp_path / "portfolio.db")
+        self._write_database(path)
+        store = load_position_store(path)
+        
+        conn = sqlite3.connect(path)
+        conn.execute("UPDATE assets SET quantity = 20 WHERE id = 1")
+        conn.execute("DELETE FROM assets WHERE id = 2")
+        conn.execute("INSERT INTO assets VALUES (4, 10, 'Cash', 'USD', 'cash', 500, 1, '2024-03-01')")
+        conn.commit()
+        conn.close()
+        assert refresh_positions(store, path, [1, 2, 4]) == {"upserted": 2, "removed": 1}
+        assert store.value_portfolios([10])[0].total_value == pytest.approx(20 * 150 + 500)
+        
+        assert store.update_price(risk_engine_cpp.PriceRecord(1, 160.0, "2024-03-02"))
+        assert not store.update_price(risk_engine_cpp.PriceRecord(1, 90.0, "2024-01-01"))
+        assert store.price(1) == 160.0
+        
+        response = client.post("/prices", json={"prices": [{"asset_id": 1, "price": 1.0, "price_date": "not a date"}]})
+        assert response.status_code == 400
+    
+    def test_workers_converge_on_database_changes(self, tmp_path):
+        """A tick or write seen by one worker's store reaches every other store on its next sync"""
+        import sqlite3
+        from risk_wrapper import PositionStoreSync, record_prices
+        path = str(tmp_path / "portfolio.db")
+        self._write_database(path)
+        first, second = PositionStoreSync(path), PositionStoreSync(path)
+        assert first.sync() and second.sync()
+        assert not first.sync()
+        
+        assert record_prices(path, [(1, 160.0, "2024-03-02"), (1, 90.0, "2024-01-01"), (9, 1.0, "")]) == 1
+        conn = sqlite3.connect(path)
+        conn.execute("DELETE FROM assets WHERE id = 2")
+        conn.commit()
+        conn.close()
+        
+        for sync in (first, second):
+            assert sync.sync()
+            assert sync.store.price(1) == 160.0
+            assert sync.store.value_portfolios([10])[0].total_value == pytest.approx(10 * 160)
+        assert first.reload().positions == 2
+
+
+class TestPerformance:
+    """Test batched TWR, IRR and Brinson attribution"""
+    
+    def test_returns_from_snapshots_with_flows(self, tmp_path):
+        """A mid-year deposit is removed from TWR but weighted into the IRR"""
+        import sqlite3
+        from risk_wrapper import load_value_histories
+        path = str(tmp_path / "portfolio.db")
+        conn = sqlite3.connect(path)
+        conn.executescript("""
+            CREATE TABLE portfolio_snapshots (id INTEGER PRIMARY KEY, portfolio_id INTEGER,
+                                              total_value REAL, snapshot_date DATE);
+            INSERT INTO portfolio_snapshots (portfolio_id, total_value, snapshot_date) VALUES
+                (1, 100, '2023-01-01'), (1, 110, '2024-01-01'),
+                (2, 100, '2023-01-01'), (2, 150, '2023-07-02'), (2, 165, '2024-01-01');
+        """)
+        conn.commit()
+        conn.close()
+        
+        portfolio_ids, histories = load_value_histories(path, flows=[(2, "2023-07-02", 50.0)])
+        assert portfolio_ids == [1, 2]
+        plain, funded = risk_engine_cpp.measure_performance(histories)
+        assert plain.time_weighted_return == pytest.approx(0.10)
+        assert plain.money_weighted_return == pytest.approx(1.1 ** (365.25 / 365) - 1, rel=1e-9)
+        assert funded.time_weighted_return == pytest.approx(0.10)
+        
+        # -100 - 50 (1 + r)^-t + 165 (1 + r)^-T = 0 at the solved rate
+        t, horizon = 182 / 365.25, 365 / 365.25
+        r = funded.money_weighted_return
+        assert funded.irr_converged
+        assert -100 - 50 * (1 + r) ** -t + 165 * (1 + r) ** -horizon == pytest.approx(0.0, abs=1e-8)
+        assert r > 0.11  # The deposit missed the first half's flat return
+    
+    def test_total_loss_annualizes_to_minus_one(self):
+        """A TWR at or below -100% reports -100% a year instead of NaN"""
+        histories = risk_engine_cpp.ValueHistories()
+        histories.offsets = [0, 3, 5]
+        histories.times = [0.0, 1.0, 2.0, 0.0, 3.0]
+        histories.values = [100.0, 50.0, 10.0, 100.0, 0.0]
+        histories.flows = [0.0, 80.0, 0.0, 0.0, 0.0]  # The deposit is worth less than nothing
+        beyond, wiped_out = risk_engine_cpp.measure_performance(histories)
+        assert beyond.time_weighted_return == pytest.approx(-0.3 * 0.2 - 1.0)
+        assert beyond.annualized_twr == -1.0
+        assert wiped_out.time_weighted_return == pytest.approx(-1.0)
+        assert wiped_out.annualized_twr == -1.0
+    
+    def test_attribution_effects_sum_to_excess_return(self):
+        """Carino-linked effects reproduce the geometric excess return over several periods"""
+        from risk_wrapper import attribute_by_asset_type
+        periods = [
+            {"portfolio_weights": {"stock": 0.7, "bond": 0.3}, "portfolio_returns": {"stock": 0.05, "bond": 0.01},
+             "benchmark_weights": {"stock": 0.6, "bond": 0.4}, "benchmark_returns": {"stock": 0.04, "bond": 0.012}},
+            {"portfolio_weights": {"stock": 0.5, "cash": 0.5}, "portfolio_returns": {"stock": -0.03, "cash": 0.001},
+             "benchmark_weights": {"stock": 0.6, "bond": 0.4}, "benchmark_returns": {"stock": -0.02, "bond": 0.004}},
+        ]
+        result, = attribute_by_asset_type([periods])
+        effects = sum(sum(result[key].values()) for key in ("allocation", "selection", "interaction"))
+        assert effects == pytest.approx(result["excess_return"], abs=1e-12)
+        assert result["portfolio_return"] == pytest.approx((1 + 0.038) * (1 - 0.0145) - 1)
+        
+        response = client.post("/performance/attribution", json={"portfolios": [[{
+            "portfolio_weights": {"etf": 1.0}, "portfolio_returns": {},
+            "benchmark_weights": {"stock": 1.0}, "benchmark_returns": {}}]]})
+        assert response.status_code == 400
+
+
+
+class TestSentimentFactor:
+    """Test sentiment factor calibration and simulation"""
+    
+    def test_batch_calibration_recovers_loadings(self):
+        """Loadings regressed on the common shock match the ones the histories were built with"""
+        from risk_wrapper import calibrate_sentiment
+        rng = np.random.default_rng(11)
+        days = np.arange(np.datetime64("2024-01-01"), np.datetime64("2024-01-01") + 400)
+        shock = rng.standard_normal(len(days))
+        true_loadings = {f"T{i}": 0.05 + 0.02 * i for i in range(12)}
+        responses = {}
+        for i, (ticker, loading) in enumerate(true_loadings.items()):
+            scores = 3.0 + np.cumsum(0.1 * (shock + 0.3 * rng.standard_normal(len(days))))
+            log_returns = (loading * shock + 0.15 * rng.standard_normal(len(days))) / np.sqrt(365.25)
+            prices = 100 * np.exp(np.cumsum(log_returns))
+            responses[ticker] = {
+                "overall_sentiment": {"score": float(scores[-1])},
+                "sentiment_history": [{"date": str(d), "score": float(x)} for d, x in zip(days, scores)],
+                "sentiment_price_correlation": {"series": {
+                    "price": [{"date": str(d), "price": float(p)} for d, p in zip(days[i:], prices[i:])]}}
+            }
+        
+        result = calibrate_sentiment(responses)
+        assert result["intervals"] == len(days) - 1
+        assert result["market_correlation"] > 0.9
+        for ticker, loading in true_loadings.items():
+            fitted = result["tickers"][ticker]
+            assert fitted["loading"] == pytest.approx(loading, abs=0.03)
+            assert fitted["residual_volatility"] == pytest.approx(0.15, abs=0.03)
+        
+        # Too short to regress: no loading and no tilt
+        responses["NEW"] = {"sentiment_history": responses["T0"]["sentiment_history"][:3],
+                            "sentiment_price_correlation": {"series": {"price": [
+                                {"date": "2024-01-01", "price": 10.0}, {"date": "2024-01-02", "price": 11.0}]}}}
+        fitted = calibrate_sentiment(responses)["tickers"]["NEW"]
+        assert fitted["loading"] == 0.0 and fitted["drift_tilt"] == 0.0
+    
+    def test_sentiment_factor_in_cholesky_system(self):
+        """The extra factor adds its variance and drift to the simulated returns"""
+        assets = [risk_engine_cpp.create_portfolio_asset(name, w, 0.08, 0.2)
+                  for name, w in (("A", 0.5), ("B", 0.5))]
+        engine = risk_engine_cpp.MonteCarloRiskEngine(assets, [[1.0, 0.3], [0.3, 1.0]], 200000, 1.0)
+        base = engine.run_simulation()
+        
+        model = risk_engine_cpp.SentimentFactorModel()
+        model.loadings = [0.1, 0.2]
+        model.asset_correlation = [0.25, 0.0]
+        model.drift_tilt = [0.02, -0.01]
+        engine.set_sentiment_factor(model)
+        tilted = engine.run_simulation()
+        variance = base.portfolio_vol ** 2 + 0.15 ** 2 + 2 * 0.5 * 0.2 * 0.15 * 0.25
+        assert tilted.portfolio_vol == pytest.approx(np.sqrt(variance))
+        assert tilted.expected_return == pytest.approx(0.08 + 0.005)
+        assert np.std(tilted.simulation_results) == pytest.approx(tilted.portfolio_vol, rel=0.02)
+        assert tilted.var_95 > base.var_95
+        
+        model.asset_correlation = [0.99, -0.99]
+        with pytest.raises(ValueError):
+            engine.set_sentiment_factor(model)
+        with pytest.raises(ValueError):
+            engine.set_factor_simulation(0.9)
+        engine.set_sentiment_factor(risk_engine_cpp.SentimentFactorModel())
+        assert engine.run_simulation().portfolio_vol == pytest.approx(base.portfolio_vol)
+    
+    def test_rejected_correlation_update_keeps_state(self):
+        """A matrix that is valid alone but not jointly with the factor leaves the engine unchanged"""
+        assets = [risk_engine_cpp.create_portfolio_asset(name, 0.5, 0.08, 0.2) for name in ("A", "B")]
+        engine = risk_engine_cpp.MonteCarloRiskEngine(assets, [[1.0, 0.5], [0.5, 1.0]], 50000, 1.0)
+        model = risk_engine_cpp.SentimentFactorModel()
+        model.loadings = [0.1, 0.1]
+        model.asset_correlation = [0.7, 0.7]
+        engine.set_sentiment_factor(model)
+        before = engine.run_simulation()
+        
+        with pytest.raises(ValueError):
+            engine.update_correlation_matrix([[1.0, -0.5], [-0.5, 1.0]])
+        after = engine.run_simulation()
+        assert after.portfolio_vol == before.portfolio_vol
+        assert np.std(after.simulation_results) == pytest.approx(after.portfolio_vol, rel=0.03)
+
+
 if __name__ == "__main__":
     # Run tests
     pytest.main([__file__, "-v"])
\ No newline at end of file
@@ -149,6 +149,7 @@ export const initializeDatabase = () => {
       db.run(`CREATE INDEX IF NOT EXISTS idx_assets_portfolio_id ON assets (portfolio_id)`);
       db.run(`CREATE INDEX IF NOT EXISTS idx_asset_prices_asset_id ON asset_prices (asset_id)`);
       db.run(`CREATE INDEX IF NOT EXISTS idx_asset_prices_date ON asset_prices (price_date)`);
+      db.run(`CREATE INDEX IF NOT EXISTS idx_asset_prices_asset_date ON asset_prices (asset_id, price_date)`);
       db.run(`CREATE INDEX IF NOT EXISTS idx_portfolio_snapshots_portfolio_id ON portfolio_snapshots (portfolio_id)`);
       db.run(`CREATE INDEX IF NOT EXISTS idx_risk_metrics_portfolio_id ON risk_metrics (portfolio_id)`);
     });
@@ -1,4 +1,5 @@
 import { dbGet, dbRun, dbAll } from '../database/database.js';
+import { notifyPositionsChanged } from '../services/positionSync.js';
 
 export class Asset {
   constructor(id, portfolio_id, name, symbol, type, quantity, purchase_price, purchase_date, created_at, updated_at) {
@@ -27,6 +28,7 @@ export class Asset {
         'INSERT INTO asset_prices (asset_id, price, price_date) VALUES (?, ?, ?)',
         [result.id, purchase_price, purchase_date]
       );
+      notifyPositionsChanged([result.id]);
 
       return await Asset.findById(result.id);
     } catch (error) {
@@ -95,6 +97,7 @@ export class Asset {
         );
       }
 
+      notifyPositionsChanged([this.id]);
       this.updated_at = new Date().toISOString();
       return this;
     } catch (error) {
@@ -106,6 +109,7 @@ export class Asset {
   async delete() {
     try {
       await dbRun('DELETE FROM assets WHERE id = ?', [this.id]);
+      notifyPositionsChanged([this.id]);
       return true;
     } catch (error) {
       throw error;
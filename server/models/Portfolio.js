@@ -1,4 +1,5 @@
 import { dbGet, dbRun, dbAll } from '../database/database.js';
+import { notifyPositionsChanged } from '../services/positionSync.js';
 
 export class Portfolio {
   constructor(id, user_id, name, description, is_default, created_at, updated_at) {
@@ -93,7 +94,9 @@ export class Portfolio {
   // Delete portfolio
   async delete() {
     try {
+      const assets = await dbAll('SELECT id FROM assets WHERE portfolio_id = ?', [this.id]);
       await dbRun('DELETE FROM portfolios WHERE id = ?', [this.id]);
+      notifyPositionsChanged(assets.map(a => a.id));
       return true;
     } catch (error) {
       throw error;
@@ -110,24 +113,28 @@ export class Portfolio {
     }
   }
 
+  // Get portfolio assets with their latest price (purchase price when never priced), in one query
+  async getValuedAssets() {
+    try {
+      const assets = await dbAll(
+        `SELECT a.*, COALESCE(
+           (SELECT p.price FROM asset_prices p WHERE p.asset_id = a.id ORDER BY p.price_date DESC, p.id DESC LIMIT 1),
+           a.purchase_price
+         ) AS current_price
+         FROM assets a WHERE a.portfolio_id = ? ORDER BY a.created_at DESC`,
+        [this.id]
+      );
+      return assets;
+    } catch (error) {
+      throw error;
+    }
+  }
+
   // Get portfolio value
   async getCurrentValue() {
     try {
-      const assets = await this.getAssets();
-      let totalValue = 0;
-
-      for (const asset of assets) {
-        // Get latest price for the asset
-        const latestPrice = await dbGet(
-          'SELECT price FROM asset_prices WHERE asset_id = ? ORDER BY price_date DESC LIMIT 1',
-          [asset.id]
-        );
-        
-        const currentPrice = latestPrice ? latestPrice.price : asset.purchase_price;
-        totalValue += asset.quantity * currentPrice;
-      }
-
-      return totalValue;
+      const assets = await this.getValuedAssets();
+      return assets.reduce((total, asset) => total + asset.quantity * asset.current_price, 0);
     } catch (error) {
       throw error;
     }
@@ -136,21 +143,15 @@ export class Portfolio {
   // Calculate asset allocation
   async calculateAllocation() {
     try {
-      const assets = await this.getAssets();
-      const totalValue = await this.getCurrentValue();
+      const assets = await this.getValuedAssets();
+      const totalValue = assets.reduce((total, asset) => total + asset.quantity * asset.current_price, 0);
       
       if (totalValue === 0) return {};
 
       const allocation = {};
 
       for (const asset of assets) {
-        const latestPrice = await dbGet(
-          'SELECT price FROM asset_prices WHERE asset_id = ? ORDER BY price_date DESC LIMIT 1',
-          [asset.id]
-        );
-        
-        const currentPrice = latestPrice ? latestPrice.price : asset.purchase_price;
-        const assetValue = asset.quantity * currentPrice;
+        const assetValue = asset.quantity * asset.current_price;
         const assetType = asset.type.charAt(0).toUpperCase() + asset.type.slice(1);
 
         if (allocation[assetType]) {
@@ -2,6 +2,7 @@ import express from 'express';
 import { authenticate } from '../middleware/auth.js';
 import Portfolio from '../models/Portfolio.js';
 import { dbRun, dbGet, dbAll } from '../database/database.js';
+import { notifyPositionsChanged } from '../services/positionSync.js';
 
 const router = express.Router();
 
@@ -69,10 +70,11 @@ router.post('/:id/assets', async (req, res) => {
     }
     
     // Insert the asset
-    await dbRun(
+    const result = await dbRun(
       'INSERT INTO assets (portfolio_id, name, symbol, type, quantity, purchase_price, purchase_date) VALUES (?, ?, ?, ?, ?, ?, ?)',
       [req.params.id, name, symbol, type, quantity, purchase_price, purchase_date]
     );
+    notifyPositionsChanged([result.id]);
     
     // Return updated portfolio with assets
     const assets = await dbAll('SELECT * FROM assets WHERE portfolio_id = ? ORDER BY created_at DESC', [req.params.id]);
@@ -105,6 +107,7 @@ router.put('/:portfolioId/assets/:assetId', async (req, res) => {
       'UPDATE assets SET name = ?, symbol = ?, type = ?, quantity = ?, purchase_price = ?, purchase_date = ?, updated_at = CURRENT_TIMESTAMP WHERE id = ? AND portfolio_id = ?',
       [name, symbol, type, quantity, purchase_price, purchase_date, assetId, portfolioId]
     );
+    notifyPositionsChanged([assetId]);
     
     // Return updated portfolio with assets
     const assets = await dbAll('SELECT * FROM assets WHERE portfolio_id = ? ORDER BY created_at DESC', [portfolioId]);
@@ -170,6 +173,7 @@ router.put('/:portfolioId/weights', async (req, res) => {
         [newQuantity, assetId, portfolioId]
       );
     }
+    notifyPositionsChanged(Object.keys(weights));
 
     // Return updated portfolio with assets
     const updatedAssets = await dbAll(
@@ -207,6 +211,7 @@ router.delete('/:portfolioId/assets/:assetId', async (req, res) => {
     
     // Delete the asset
     await dbRun('DELETE FROM assets WHERE id = ? AND portfolio_id = ?', [assetId, portfolioId]);
+    notifyPositionsChanged([assetId]);
     
     // Return updated portfolio with assets
     const assets = await dbAll('SELECT * FROM assets WHERE portfolio_id = ? ORDER BY created_at DESC', [portfolioId]);
@@ -0,0 +1,24 @@
+// Tells the risk engine about writes to the assets and asset_prices tables, so the worker that
+// receives the call updates its position store at once. Notifications are best effort. Each engine
+// worker also notices commits through SQLite's data_version before it values portfolios, so
+// failures are logged and never fail the request that wrote.
+const RISK_ENGINE_URL = process.env.RISK_ENGINE_URL || 'http://localhost:8000';
+
+export const notifyPositionsChanged = (assetIds) => {
+  const ids = assetIds.map(Number).filter(Number.isInteger);
+  if (ids.length === 0) return;
+
+  fetch(`${RISK_ENGINE_URL}/positions/refresh`, {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/json' },
+    body: JSON.stringify({ asset_ids: ids })
+  })
+    .then(res => {
+      if (!res.ok) console.warn(`Position refresh rejected by risk engine: HTTP ${res.status}`);
+    })
+    .catch(err => {
+      console.warn('Risk engine unreachable for position refresh:', err.message);
+    });
+};
+
+export default notifyPositionsChanged;